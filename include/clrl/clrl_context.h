@@ -0,0 +1,206 @@
+#ifndef CLRL_CONTEXT_H
+#define CLRL_CONTEXT_H
+
+#include <stddef.h>
+
+/**
+ * Embedding API
+ *
+ * A context is an independent calculator: it owns its variable table
+ * (with the arena behind it), its division precision, and the results
+ * and error messages of its last call. Nothing is printed; results come
+ * back through buffers and status codes. Contexts share no mutable state,
+ * so any number of threads can evaluate in their own contexts at the same
+ * time. A single context must not be used by two threads at once.
+ *
+ * The REPL and script runner keep using the global variable table and
+ * print as before; they go through the same error reporting, which falls
+ * back to stderr when no context is collecting messages.
+ */
+
+/**
+ * @brief Result of a library call (first error reported while it ran)
+ */
+typedef enum {
+    CLRL_OK = 0,
+    CLRL_ERROR_SYNTAX,            // Source could not be compiled
+    CLRL_ERROR_UNDEFINED,         // Variable is not defined
+    CLRL_ERROR_TYPE,              // Precise value where a larnum is required
+    CLRL_ERROR_DIVISION_BY_ZERO,  // Division or remainder by zero
+    CLRL_ERROR_MEMORY,            // Memory allocation failed
+    CLRL_ERROR_IO,                // File could not be read or written
+    CLRL_ERROR_ARGUMENT,          // Invalid argument or setting
+    CLRL_ERROR_BUFFER,            // Caller's buffer is too small
+    CLRL_ERROR_RUNTIME            // Any other failure
+} ClrlStatus;
+
+// ===================== Error reporting =====================
+
+/**
+ * @brief Error messages collected on one thread instead of being printed
+ */
+typedef struct {
+    ClrlStatus status;   // Status of the first message (CLRL_OK = none yet)
+    char* text;          // "Error: ..." lines (NUL-terminated once non-empty)
+    size_t len;
+    size_t capacity;
+} ClrlErrorLog;
+
+/**
+ * @brief Report an error ("Error: ..." line) with its status
+ *
+ * Goes to the calling thread's error log if one is installed, otherwise
+ * straight to stderr.
+ */
+void clrl_error(ClrlStatus status, const char* format, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+/**
+ * @brief Collect this thread's error messages in log instead of printing them
+ *
+ * @param log Log to append to (NULL = print to stderr again)
+ * @return ClrlErrorLog* The log that was active before
+ */
+ClrlErrorLog* clrl_error_capture(ClrlErrorLog* log);
+
+/**
+ * @brief Report the messages of log again, on the calling thread
+ *
+ * Used to hand errors collected on a worker over to the thread that
+ * started the work, in the order the work was issued.
+ */
+void clrl_error_replay(const ClrlErrorLog* log);
+
+/**
+ * @brief Empty a log and free its text
+ */
+void clrl_error_log_free(ClrlErrorLog* log);
+
+/**
+ * @brief Short description of a status ("division by zero", ...)
+ */
+const char* clrl_status_string(ClrlStatus status);
+
+// ===================== Contexts =====================
+
+typedef struct ClrlContext ClrlContext;
+
+/**
+ * @brief Create an empty context (division precision DEFAULT_DIVISION_PRECISION)
+ *
+ * @return ClrlContext* New context, NULL if out of memory
+ */
+ClrlContext* clrl_context_create(void);
+
+/**
+ * @brief Free a context with all of its variables (NULL is ignored)
+ */
+void clrl_context_destroy(ClrlContext* context);
+
+/**
+ * @brief Compile and run CLRL source in a context
+ *
+ * Same language as scripts (see clrl_compile). The text written by return
+ * statements is kept until the next call and read with
+ * clrl_context_output; error messages are read with clrl_context_error.
+ * As in scripts, a statement that fails is skipped and the rest still run.
+ *
+ * @param source Source text (does not need to be null-terminated)
+ * @param len Length of the source
+ * @return ClrlStatus CLRL_OK, or the status of the first error
+ */
+ClrlStatus clrl_context_eval(ClrlContext* context, const char* source, size_t len);
+
+/**
+ * @brief Write the decimal value of a variable into buffer
+ *
+ * @param buffer Destination (may be NULL if size is 0)
+ * @param size Size of buffer in bytes
+ * @param needed If non-NULL, receives the size the text needs (with its NUL)
+ * @return ClrlStatus CLRL_OK, CLRL_ERROR_UNDEFINED, or CLRL_ERROR_BUFFER
+ *         if the text does not fit (buffer is left untouched)
+ */
+ClrlStatus clrl_context_get(ClrlContext* context, const char* name, char* buffer, size_t size, size_t* needed);
+
+/**
+ * @brief Check whether a variable holds a precise value
+ *
+ * @return int 1 for precise, 0 for larnum, -1 if it is not defined
+ */
+int clrl_context_is_precise(const ClrlContext* context, const char* name);
+
+/**
+ * @brief Drop every variable of a context
+ */
+void clrl_context_clear(ClrlContext* context);
+
+/**
+ * @brief Set the context's division precision (what system:precision changes)
+ */
+void clrl_context_set_precision(ClrlContext* context, size_t digits);
+
+/**
+ * @brief Get the context's division precision
+ */
+size_t clrl_context_get_precision(const ClrlContext* context);
+
+/**
+ * @brief Output of the return statements of the last clrl_context_eval
+ *
+ * @param len If non-NULL, receives the length of the text
+ * @return const char* NUL-terminated text ("" if there was none), valid
+ *         until the next call on the context
+ */
+const char* clrl_context_output(const ClrlContext* context, size_t* len);
+
+/**
+ * @brief Error messages of the last call on the context
+ *
+ * @return const char* NUL-terminated "Error: ..." lines ("" if it succeeded),
+ *         valid until the next call on the context
+ */
+const char* clrl_context_error(const ClrlContext* context);
+
+/**
+ * @brief Free the buffers the calling thread keeps cached between calls
+ *
+ * Freed number buffers and statement temporaries are kept per thread for
+ * reuse. Call this before a thread that evaluated in contexts exits.
+ */
+void clrl_context_thread_release(void);
+
+// ===================== Server =====================
+
+/**
+ * @brief Serve framed evaluation requests (clrlc --serve)
+ *
+ * A request is a header line "<id> <length>" followed by length bytes of
+ * CLRL source; its response is "<id> <status> <output length> <error
+ * length>" followed by the return output and the error text. Each
+ * connection evaluates in its own context, in order, and may send any
+ * number of requests without waiting for the responses. Requests are
+ * evaluated by a fixed pool of worker threads. A malformed header, a
+ * request over 64 MiB or one cut off by the end of the input is answered
+ * with a last response of id "*" holding the error, and closes that
+ * connection.
+ *
+ * @param socket_path Unix domain socket to listen on, or NULL to serve a
+ *        single client on stdin/stdout until its input ends
+ * @param workers Evaluation threads (0 = clrl_get_thread_count())
+ * @return int 0 once stopped, -1 on error (message printed); on stdin a
+ *         broken stream is an error too, on a socket it only closes the
+ *         client's connection
+ */
+int clrl_serve(const char* socket_path, size_t workers);
+
+/**
+ * @brief Make a running clrl_serve finish (safe to call from a signal handler)
+ *
+ * Requests already received are still answered.
+ */
+void clrl_serve_stop(void);
+
+#endif // CLRL_CONTEXT_H
@@ -0,0 +1,305 @@
+#ifndef CLRL_LARNUM_H
+#define CLRL_LARNUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Single machine word ("limb") of an arbitrary-precision integer
+ *
+ * 32-bit limbs keep every double-limb product inside a portable uint64_t
+ */
+typedef uint32_t LarnumLimb;
+typedef uint64_t LarnumDoubleLimb;
+
+#define LARNUM_LIMB_BITS 32
+#define LARNUM_LIMB_MAX  0xFFFFFFFFu
+
+/**
+ * @brief Structure for arbitrary-precision integers (larnum)
+ *
+ * Sign-magnitude binary representation: the magnitude is a little-endian
+ * array of limbs (limbs[0] is the least significant word).
+ * Decimal text is only produced when a value is parsed or printed.
+ * Limb buffers come from the runtime heap pool (see clrl_memory.h). A
+ * capacity of 0 with non-NULL limbs marks borrowed, read-only storage that
+ * larnum_free leaves alone and larnum_reserve copies before growing.
+ */
+typedef struct {
+    LarnumLimb* limbs;   // Magnitude limbs (NULL until first allocation)
+    size_t size;         // Number of limbs in use (0 means the value is zero)
+    size_t capacity;     // Number of limbs allocated (0 for borrowed storage)
+    int negative;        // 1 if the value is negative (zero is never negative)
+} Larnum;
+
+/**
+ * @brief Crossover points (in limbs) of the multiplication engine
+ *
+ * Operands smaller than karatsuba_threshold use schoolbook multiplication,
+ * then Karatsuba up to toom3_threshold, Toom-3 up to ntt_threshold and
+ * the number-theoretic transform above that.
+ */
+typedef struct {
+    size_t karatsuba_threshold;
+    size_t toom3_threshold;
+    size_t ntt_threshold;
+} LarnumMulThresholds;
+
+// ===================== Function Declarations =====================
+
+/**
+ * @brief Initialize a larnum to zero without allocating memory
+ *
+ * @param x Larnum to initialize (non-NULL)
+ */
+void larnum_init(Larnum* x);
+
+/**
+ * @brief Release the limb buffer of a larnum and reset it to zero
+ *
+ * @param x Larnum to free (can be NULL)
+ */
+void larnum_free(Larnum* x);
+
+/**
+ * @brief Make sure a larnum can hold at least `limbs` limbs
+ *
+ * @param x Larnum to grow (non-NULL)
+ * @param limbs Required capacity in limbs
+ * @return int 0 on success, -1 on allocation failure
+ */
+int larnum_reserve(Larnum* x, size_t limbs);
+
+/**
+ * @brief Deep copy src into dst (dst must be initialized)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int larnum_copy(Larnum* dst, const Larnum* src);
+
+/**
+ * @brief Set a larnum from a native signed integer
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int larnum_set_int(Larnum* x, long long value);
+
+/**
+ * @brief Parse a decimal string into a larnum
+ *
+ * Accepts an optional leading '+' or '-' followed by decimal digits.
+ *
+ * @param x Destination larnum (must be initialized)
+ * @param str Decimal text (does not need to be null-terminated)
+ * @param len Number of characters to read from str
+ * @return int 0 on success, -1 on invalid syntax or allocation failure
+ */
+int larnum_from_string(Larnum* x, const char* str, size_t len);
+
+/**
+ * @brief Convert a larnum to decimal text
+ *
+ * @param x Larnum to convert (non-NULL)
+ * @return char* Newly allocated null-terminated string (caller frees), NULL on failure
+ */
+char* larnum_to_string(const Larnum* x);
+
+/**
+ * @brief Check whether a larnum is zero
+ */
+int larnum_is_zero(const Larnum* x);
+
+/**
+ * @brief Compare two larnums
+ *
+ * @return int negative if a < b, 0 if a == b, positive if a > b
+ */
+int larnum_cmp(const Larnum* a, const Larnum* b);
+
+/**
+ * @brief Compare the absolute values of two larnums
+ *
+ * @return int negative if |a| < |b|, 0 if |a| == |b|, positive if |a| > |b|
+ */
+int larnum_cmp_abs(const Larnum* a, const Larnum* b);
+
+/**
+ * @brief r = a + b (r may alias a or b)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int larnum_add(Larnum* r, const Larnum* a, const Larnum* b);
+
+/**
+ * @brief r = a - b (r may alias a or b)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int larnum_sub(Larnum* r, const Larnum* a, const Larnum* b);
+
+/**
+ * @brief r = a * b (r may alias a or b)
+ *
+ * Dispatches to schoolbook, Karatsuba, Toom-3 or NTT by operand size and
+ * switches to the squaring kernels when a and b are the same number.
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int larnum_mul(Larnum* r, const Larnum* a, const Larnum* b);
+
+/**
+ * @brief r = a * a (r may alias a)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int larnum_sqr(Larnum* r, const Larnum* a);
+
+/**
+ * @brief Read the current multiplication crossover points
+ */
+void larnum_get_mul_thresholds(LarnumMulThresholds* out);
+
+/**
+ * @brief Tune the multiplication crossover points (NULL restores defaults)
+ *
+ * @return int 0 on success, -1 if a threshold is too small to be valid
+ */
+int larnum_set_mul_thresholds(const LarnumMulThresholds* thresholds);
+
+/**
+ * @brief Truncated division: q = a / b, r = a % b (C semantics)
+ *
+ * Either q or r can be NULL when that result is not needed.
+ * The remainder takes the sign of the dividend. Large operands are divided
+ * through a Newton reciprocal on top of the fast multiplication engine.
+ *
+ * @return int 0 on success, -1 on division by zero or allocation failure
+ */
+int larnum_divmod(Larnum* q, Larnum* r, const Larnum* a, const Larnum* b);
+
+/**
+ * @brief Fixed-point quotient: q = trunc(a * 10^digits / b)
+ *
+ * q is the quotient with `digits` decimal places, scaled to an integer.
+ *
+ * @return int 0 on success, -1 on division by zero or allocation failure
+ */
+int larnum_div_scaled(Larnum* q, const Larnum* a, const Larnum* b, size_t digits);
+
+/**
+ * @brief r = a ^ e for e >= 0 (0 ^ 0 = 1; r may alias a or e)
+ *
+ * Sliding-window exponentiation on the squaring kernels.
+ *
+ * @return int 0 on success, -1 if e is negative, the result is too large
+ *         to represent, or on allocation failure
+ */
+int larnum_pow(Larnum* r, const Larnum* a, const Larnum* e);
+
+/**
+ * @brief r = (a ^ e) % m without forming a ^ e (r may alias any operand)
+ *
+ * The result has the sign (a ^ e) % m would have. Intermediates stay
+ * below m^2: Montgomery reduction for odd moduli, Barrett otherwise.
+ *
+ * @return int 0 on success, -1 if m is zero, e is negative, or on
+ *         allocation failure
+ */
+int larnum_powmod(Larnum* r, const Larnum* a, const Larnum* e, const Larnum* m);
+
+/**
+ * @brief r = a^(1/n) truncated towards zero (r may alias a)
+ *
+ * Newton iteration with precision doubling; see clrl_root.c.
+ *
+ * @param n Degree, 1 <= n < 2^32 (a negative a needs an odd n)
+ * @return int 0 on success, -1 on an invalid degree, an even root of a
+ *         negative number, or allocation failure
+ */
+int larnum_root(Larnum* r, const Larnum* a, const Larnum* n);
+
+/**
+ * @brief Read the size (in limbs) above which Newton division is used
+ */
+size_t larnum_get_div_threshold(void);
+
+/**
+ * @brief Tune the Newton division crossover (divisor and quotient limbs)
+ *
+ * @return int 0 on success, -1 if the threshold is invalid
+ */
+int larnum_set_div_threshold(size_t limbs);
+
+/**
+ * @brief Read the size (in limbs) above which decimal conversion splits recursively
+ */
+size_t larnum_get_radix_threshold(void);
+
+/**
+ * @brief Tune the divide-and-conquer radix conversion crossover
+ *
+ * @return int 0 on success, -1 if the threshold is invalid
+ */
+int larnum_set_radix_threshold(size_t limbs);
+
+/**
+ * @brief Name of the vector kernels in use ("avx2", "sse4.1" or "scalar")
+ */
+const char* larnum_get_simd(void);
+
+/**
+ * @brief Restrict the vector kernels to an instruction set the CPU supports
+ *
+ * Defaults to the best one available, capped by $CLRL_SIMD if set.
+ *
+ * @return int 0 on success, -1 if the name is unknown or unsupported
+ */
+int larnum_set_simd(const char* name);
+
+/**
+ * @brief Name of the arithmetic backend in use ("native" or "gmp")
+ */
+const char* larnum_get_backend(void);
+
+/**
+ * @brief Comma-separated names of the backends compiled in
+ */
+const char* larnum_get_backend_names(void);
+
+/**
+ * @brief Run large-operand arithmetic on another library
+ *
+ * Defaults to $CLRL_BACKEND if set, otherwise "native". "gmp" needs a
+ * build with CLRL_WITH_GMP. Results do not depend on the backend.
+ *
+ * @return int 0 on success, -1 if the name is unknown or not compiled in
+ */
+int larnum_set_backend(const char* name);
+
+/**
+ * @brief Number of significant bits of |x| (0 for zero)
+ */
+size_t larnum_bit_length(const Larnum* x);
+
+/**
+ * @brief r = a * 2^bits (r may alias a)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int larnum_shl(Larnum* r, const Larnum* a, size_t bits);
+
+/**
+ * @brief r = trunc(a / 2^bits), sign kept (r may alias a)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int larnum_shr(Larnum* r, const Larnum* a, size_t bits);
+
+/**
+ * @brief r = 10^exponent
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int larnum_pow10(Larnum* r, size_t exponent);
+
+#endif // CLRL_LARNUM_H
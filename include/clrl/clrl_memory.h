@@ -0,0 +1,156 @@
+#ifndef CLRL_MEMORY_H
+#define CLRL_MEMORY_H
+
+#include <stddef.h>
+
+/**
+ * @brief Number of power-of-two size classes used by arena pools (16 B .. 1 GiB)
+ */
+#define CLRL_POOL_CLASSES 27
+
+/**
+ * @brief Allocator statistics (all values in bytes except the counters)
+ */
+typedef struct {
+    size_t live_bytes;      // Bytes currently handed out to callers
+    size_t peak_bytes;      // High-water mark of live_bytes
+    size_t reserved_bytes;  // Bytes currently obtained from the system
+    size_t alloc_count;     // Allocations served so far
+    size_t alloc_bytes;     // Bytes handed out by those allocations
+    size_t reuse_count;     // Allocations served from a free list
+} ClrlMemStats;
+
+/**
+ * @brief Memory block owned by an arena
+ */
+typedef struct ClrlArenaBlock ClrlArenaBlock;
+
+/**
+ * @brief Region allocator with size-class free lists
+ *
+ * Memory is bump-allocated from large blocks. Pool allocations are rounded
+ * to a power-of-two class and can be returned to the arena's free list for
+ * reuse; everything else lives until the arena is reset. Resetting drops
+ * all allocations at once and keeps the largest block for reuse.
+ * An arena is not thread-safe; give each thread or context its own.
+ */
+typedef struct {
+    ClrlArenaBlock* blocks;                  // Newest (largest) block first
+    void* free_lists[CLRL_POOL_CLASSES];     // Returned pool chunks per class
+    ClrlMemStats stats;                      // Usage statistics
+} ClrlArena;
+
+/**
+ * @brief Position in an arena, for releasing temporaries with clrl_arena_rewind
+ */
+typedef struct {
+    ClrlArenaBlock* block;  // Block that was current when the mark was taken
+    size_t used;            // Bytes used in that block
+    size_t live_bytes;      // Arena live bytes at the mark
+} ClrlArenaMark;
+
+// ===================== Heap Pool =====================
+
+/**
+ * @brief Allocate memory from the runtime's size-class heap pool
+ *
+ * Small and medium requests are served from per-thread free lists of
+ * power-of-two classes; large requests go straight to malloc.
+ *
+ * @param bytes Requested size in bytes
+ * @return void* Memory aligned like malloc (NULL on allocation failure)
+ */
+void* clrl_mem_alloc(size_t bytes);
+
+/**
+ * @brief Return memory obtained from clrl_mem_alloc
+ *
+ * Any thread may free a block; it is cached by the freeing thread.
+ *
+ * @param ptr Block to free (can be NULL)
+ */
+void clrl_mem_free(void* ptr);
+
+/**
+ * @brief Usable size of a block from clrl_mem_alloc (at least the requested size)
+ */
+size_t clrl_mem_usable_size(const void* ptr);
+
+/**
+ * @brief Give the calling thread's cached free blocks back to the system
+ */
+void clrl_mem_trim(void);
+
+/**
+ * @brief Snapshot the heap pool statistics (shared by all threads)
+ */
+void clrl_mem_get_stats(ClrlMemStats* stats);
+
+/**
+ * @brief Heap pool allocations made by the calling thread so far (count and bytes)
+ */
+void clrl_mem_get_thread_allocs(size_t* count, size_t* bytes);
+
+// ===================== Arena =====================
+
+/**
+ * @brief Initialize an empty arena (no memory is allocated)
+ */
+void clrl_arena_init(ClrlArena* arena);
+
+/**
+ * @brief Bump-allocate memory that lives until the arena is reset or rewound
+ *
+ * @return void* 16-byte aligned memory (NULL on allocation failure)
+ */
+void* clrl_arena_alloc(ClrlArena* arena, size_t bytes);
+
+/**
+ * @brief Allocate a size-class chunk that can be returned with clrl_arena_pool_free
+ *
+ * @return void* Chunk of clrl_arena_pool_size(bytes) bytes (NULL on allocation failure)
+ */
+void* clrl_arena_pool_alloc(ClrlArena* arena, size_t bytes);
+
+/**
+ * @brief Return a chunk to the arena's free list for its size class
+ *
+ * @param bytes The size passed to clrl_arena_pool_alloc
+ */
+void clrl_arena_pool_free(ClrlArena* arena, void* ptr, size_t bytes);
+
+/**
+ * @brief Size of the chunk clrl_arena_pool_alloc hands out for `bytes`
+ */
+size_t clrl_arena_pool_size(size_t bytes);
+
+/**
+ * @brief Record the current position of an arena
+ */
+ClrlArenaMark clrl_arena_mark(const ClrlArena* arena);
+
+/**
+ * @brief Release every bump allocation made since `mark`
+ *
+ * Pool chunks must not have been freed into the arena since the mark.
+ */
+void clrl_arena_rewind(ClrlArena* arena, ClrlArenaMark mark);
+
+/**
+ * @brief Drop all allocations at once, keeping the largest block for reuse
+ */
+void clrl_arena_reset(ClrlArena* arena);
+
+/**
+ * @brief Give all memory of an arena back to the system
+ */
+void clrl_arena_release(ClrlArena* arena);
+
+/**
+ * @brief Per-thread scratch arena for temporaries of the current statement
+ *
+ * Reset with clrl_arena_reset once the statement is done.
+ */
+ClrlArena* clrl_scratch_arena(void);
+
+#endif // CLRL_MEMORY_H
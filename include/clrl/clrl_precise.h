@@ -0,0 +1,121 @@
+#ifndef CLRL_PRECISE_H
+#define CLRL_PRECISE_H
+
+#include "clrl_larnum.h"
+
+/**
+ * @brief Structure for precise decimal numbers (precise)
+ *
+ * Scaled-integer representation: value = coefficient * 10^exponent.
+ * 0.123 is stored as coefficient 123 and exponent -3, so +/- is a scale
+ * alignment plus an integer add and * is an integer multiply plus an
+ * exponent add. The scale of the inputs is kept (0.10 + 0.20 = 0.30).
+ */
+typedef struct {
+    Larnum coefficient;  // Signed unscaled digits (e.g., 123 for 0.123)
+    int64_t exponent;    // Decimal exponent (e.g., -3 for 0.123)
+} Precise;
+
+// ===================== Function Declarations =====================
+
+/**
+ * @brief Initialize a precise value to zero without allocating memory
+ */
+void precise_init(Precise* x);
+
+/**
+ * @brief Release the coefficient of a precise value and reset it to zero
+ *
+ * @param x Value to free (can be NULL)
+ */
+void precise_free(Precise* x);
+
+/**
+ * @brief Deep copy src into dst (dst must be initialized)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int precise_copy(Precise* dst, const Precise* src);
+
+/**
+ * @brief Set a precise value from a larnum (exponent 0)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int precise_from_larnum(Precise* x, const Larnum* value);
+
+/**
+ * @brief Parse decimal text such as "-12.345", "0.1" or "7"
+ *
+ * @param x Destination (must be initialized)
+ * @param str Decimal text (does not need to be null-terminated)
+ * @param len Number of characters to read from str
+ * @return int 0 on success, -1 on invalid syntax or allocation failure
+ */
+int precise_from_string(Precise* x, const char* str, size_t len);
+
+/**
+ * @brief Convert a precise value to decimal text
+ *
+ * @return char* Newly allocated null-terminated string (caller frees), NULL on failure
+ */
+char* precise_to_string(const Precise* x);
+
+/**
+ * @brief Compare two precise values by numeric value
+ *
+ * @return int negative if a < b, 0 if a == b, positive if a > b (-2 on allocation failure)
+ */
+int precise_cmp(const Precise* a, const Precise* b);
+
+/**
+ * @brief r = a + b (r may alias a or b)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int precise_add(Precise* r, const Precise* a, const Precise* b);
+
+/**
+ * @brief r = a - b (r may alias a or b)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int precise_sub(Precise* r, const Precise* a, const Precise* b);
+
+/**
+ * @brief r = a * b (r may alias a or b)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int precise_mul(Precise* r, const Precise* a, const Precise* b);
+
+/**
+ * @brief r = a / b truncated to `digits` fractional digits (r may alias a or b)
+ *
+ * @return int 0 on success, -1 on division by zero or allocation failure
+ */
+int precise_div(Precise* r, const Precise* a, const Precise* b, size_t digits);
+
+/**
+ * @brief r = a ^ e for an integer e >= 0 (r may alias a)
+ *
+ * The coefficient is raised to e and the exponent multiplied by it, so
+ * the result is exact.
+ *
+ * @return int 0 on success, -1 if e is negative, the result is too large,
+ *         or on allocation failure
+ */
+int precise_pow(Precise* r, const Precise* a, const Larnum* e);
+
+/**
+ * @brief r = a^(1/n) truncated to digits fractional digits (r may alias a)
+ *
+ * The digits are exact: this is the integer root of the coefficient
+ * scaled by 10^(n * digits), see larnum_root.
+ *
+ * @return int 0 on success, -1 on the errors of larnum_root or on
+ *         allocation failure
+ */
+int precise_root(Precise* r, const Precise* a, const Larnum* n, size_t digits);
+
+#endif // CLRL_PRECISE_H
@@ -0,0 +1,129 @@
+#ifndef CLRL_PROFILE_H
+#define CLRL_PROFILE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Statement profiler and arithmetic counters
+ *
+ * While profiling is on, every compiled statement gets an entry keyed by
+ * its origin, line and text; the interpreter adds the wall time and the
+ * number buffer allocations of each run to it. Allocations are counted on
+ * the thread that runs the statement, so statements running at the same
+ * time are kept apart; pieces of a large multiplication or conversion
+ * handed to other pool threads are not included. The larnum kernels count
+ * their calls per algorithm with operand sizes and time. While profiling
+ * is off every hook is a single load and branch.
+ */
+
+/**
+ * @brief Arithmetic kernel and the algorithm it picked
+ */
+typedef enum {
+    CLRL_PROFILE_MUL_SCHOOLBOOK,
+    CLRL_PROFILE_MUL_KARATSUBA,
+    CLRL_PROFILE_MUL_TOOM3,
+    CLRL_PROFILE_MUL_NTT,
+    CLRL_PROFILE_SQR_SCHOOLBOOK,
+    CLRL_PROFILE_SQR_KARATSUBA,
+    CLRL_PROFILE_SQR_TOOM3,
+    CLRL_PROFILE_SQR_NTT,
+    CLRL_PROFILE_DIV_SCHOOLBOOK,
+    CLRL_PROFILE_DIV_NEWTON,
+    CLRL_PROFILE_POWMOD_MONTGOMERY,
+    CLRL_PROFILE_POWMOD_BARRETT,
+    CLRL_PROFILE_ROOT_NEWTON,
+    CLRL_PROFILE_PARSE_BASECASE,
+    CLRL_PROFILE_PARSE_RECURSIVE,
+    CLRL_PROFILE_PRINT_BASECASE,
+    CLRL_PROFILE_PRINT_RECURSIVE,
+    CLRL_PROFILE_OP_COUNT
+} ClrlProfileOp;
+
+// Non-zero while profiling is on (read through clrl_profiling)
+extern int clrl_profile_enabled;
+
+/**
+ * @brief Check whether profiling is on (the only cost of a hook while it is off)
+ */
+#define clrl_profiling() __atomic_load_n(&clrl_profile_enabled, __ATOMIC_RELAXED)
+
+// ===================== Control =====================
+
+/**
+ * @brief Turn profiling on or off (collected data is kept)
+ */
+void clrl_profile_set_enabled(int enabled);
+
+/**
+ * @brief Drop all collected statement and operation data
+ */
+void clrl_profile_reset(void);
+
+// ===================== Recording =====================
+
+/**
+ * @brief Monotonic clock in nanoseconds
+ */
+uint64_t clrl_profile_now(void);
+
+/**
+ * @brief Find or create the entry of a statement (called by the compiler)
+ *
+ * @param origin File name, or NULL for REPL input
+ * @param line Source line
+ * @param text Statement text (not NUL-terminated)
+ * @param len Length of text
+ * @return uint32_t Entry id, 0 if profiling is off or no memory is left
+ */
+uint32_t clrl_profile_statement(const char* origin, size_t line, const char* text, size_t len);
+
+/**
+ * @brief Snapshot taken before a statement runs
+ */
+typedef struct {
+    uint64_t start_ns;
+    size_t alloc_count;
+    size_t alloc_bytes;
+} ClrlProfileMark;
+
+/**
+ * @brief Start timing a run of a profiled statement
+ */
+void clrl_profile_begin(ClrlProfileMark* mark);
+
+/**
+ * @brief Add one run of statement id, started at mark, to its entry
+ *
+ * Allocations are read from the shared number-buffer statistics, so runs
+ * that overlap with concurrently executing statements share their counts.
+ */
+void clrl_profile_end(uint32_t id, const ClrlProfileMark* mark);
+
+/**
+ * @brief Count one kernel call started at start_ns
+ *
+ * @param an Limbs of the first (or only) operand
+ * @param bn Limbs of the second operand (0 for unary kernels)
+ */
+void clrl_profile_op(ClrlProfileOp op, size_t an, size_t bn, uint64_t start_ns);
+
+// ===================== Reports =====================
+
+/**
+ * @brief Write statements (slowest first), kernel counters and memory use
+ *
+ * @return int 0 on success, -1 if writing failed
+ */
+int clrl_profile_report(FILE* out);
+
+/**
+ * @brief Write the report to a file
+ *
+ * @return int 0 on success, -1 on error (message printed)
+ */
+int clrl_profile_dump(const char* path);
+
+#endif // CLRL_PROFILE_H
@@ -5,6 +5,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include "clrl_larnum.h"
+#include "clrl_precise.h"
+#include "clrl_memory.h"
+
+/**
+ * @brief Runtime version (part of the compiled-binary cache key)
+ */
+#define CLRL_VERSION_STRING "1.0.0"
+
+/**
+ * @brief Default number of fractional digits produced by larnum '/'
+ */
+#define DEFAULT_DIVISION_PRECISION 10
 
 /**
  * @brief Variable type enumeration
@@ -18,50 +31,190 @@ typedef enum {
 } VarType;
 
 /**
- * @brief Structure for arbitrary-precision integers (larnum)
- * 
- * Store large integers as strings to avoid overflow issues
+ * @brief Value payload of a variable (interpreted according to its VarType)
  */
-typedef struct {
-    char* value;  // String representation of large integer (e.g., "12345678901234567890")
-} Larnum;
+typedef union {
+    Larnum larnum_val;    // Value for larnum type variable
+    Precise precise_val;  // Value for precise type variable
+} VarValue;
 
 /**
- * @brief Structure for precise decimal numbers (precise)
- * 
- * Split into integer and decimal parts to avoid floating-point errors
+ * @brief Snapshot file loaded by clrl_snapshot_load (see clrl_vm.h)
+ *
+ * Loaded values point straight into the file's mapping, which stays
+ * alive while any variable still refers to it.
  */
-typedef struct {
-    char* integer_part;  // Integer part (e.g., "0" for 0.123)
-    char* decimal_part;  // Decimal part (e.g., "123" for 0.123)
-} Precise;
+typedef struct VarSnapshot VarSnapshot;
+
+// Values of at most this many limbs (128 bits) are stored inside their node
+#define VAR_SMALL_LIMBS 4
 
 /**
- * @brief Linked list node structure for storing variables
+ * @brief Variable node structure
+ * 
+ * Each node represents a defined variable in the CLRL runtime. Nodes are
+ * indexed by the variable table's hash slots and chained through `next`
+ * in definition order. Small values keep their limbs in the node itself;
+ * larger ones get a chunk of the table's arena.
  * 
- * Each node represents a defined variable in the CLRL runtime
+ * Variables defined in the REPL also keep their defining statement and
+ * the variables it read. Redefining a variable marks everything computed
+ * from it (transitively) as stale; stale values are recomputed from their
+ * formula the next time they are read.
  */
 typedef struct VarNode {
-    char* name;          // Variable name (e.g., "a", "big_num")
+    char* name;          // Interned variable name (owned by the variable table)
+    size_t hash;         // Hash of the name (cached for probing and rehashing)
     VarType type;        // Variable type (VAR_LARNUM / VAR_PRECISE)
-    union {
-        Larnum larnum_val;    // Value for larnum type variable
-        Precise precise_val;  // Value for precise type variable
-    } value;             // Union to save memory for different variable types
-    struct VarNode* next; // Pointer to next variable node in linked list
+    VarValue value;      // Union to save memory for different variable types
+    struct VarNode* next; // Next variable in definition order
+
+    char* formula;                // Defining statement (NULL = plain value)
+    size_t formula_len;
+    struct VarNode** inputs;      // Variables the formula reads
+    size_t input_count;
+    struct VarNode** dependents;  // Variables whose formula reads this one
+    size_t dependent_count;
+    size_t dependent_capacity;
+    int stale;                    // Value is out of date with its inputs
+    size_t visited;               // Stamp of the last graph walk that reached this node
+    VarSnapshot* snapshot;        // Snapshot the value's limbs live in (NULL = table arena)
+    LarnumLimb small[VAR_SMALL_LIMBS]; // Limbs of a value that fits 128 bits (no arena chunk)
 } VarNode;
 
 /**
- * @brief Global variable list head node
+ * @brief Hash-indexed variable table
+ * 
+ * Open addressing with linear probing over a power-of-two slot array, so
+ * define and lookup are amortized O(1). Nodes, interned names and value
+ * limbs all live in the table's arena, so clearing the table is a single
+ * arena reset regardless of how many variables were defined.
+ */
+typedef struct {
+    VarNode** slots;     // Hash slots (NULL = empty), capacity is a power of two
+    size_t capacity;     // Number of slots
+    size_t count;        // Number of defined variables
+    VarNode* head;       // First variable in definition order
+    VarNode* tail;       // Last variable in definition order
+    ClrlArena arena;     // Storage for nodes, names and values
+    size_t visit_stamp;  // Stamp of the most recent dependency walk
+    VarSnapshot* snapshots; // Loaded snapshots that values still point into
+} VarTable;
+
+/**
+ * @brief Global variable table
  * 
- * All defined variables are stored in this linked list
+ * All variables defined in the REPL are stored in this table
  */
-extern VarNode* var_list;
+extern VarTable var_table;
 
 // ===================== Function Declarations =====================
 
 /**
- * @brief Find a variable by name in the global variable list
+ * @brief Initialize an empty variable table (no memory is allocated)
+ * 
+ * @param table Table to initialize (non-NULL)
+ */
+void var_table_init(VarTable* table);
+
+/**
+ * @brief Drop every variable of a table at once and leave it empty
+ * 
+ * The arena keeps its largest block, so refilling the table is cheap.
+ * 
+ * @param table Table to clear (non-NULL)
+ */
+void var_table_clear(VarTable* table);
+
+/**
+ * @brief Clear a table and give all of its memory back to the system
+ * 
+ * @param table Table to release (non-NULL)
+ */
+void var_table_release(VarTable* table);
+
+/**
+ * @brief Hash of a variable name as used by the variable table
+ */
+size_t var_table_hash(const char* name, size_t len);
+
+/**
+ * @brief Look up a variable by name
+ * 
+ * @param table Table to search (non-NULL)
+ * @param name Variable name (does not need to be null-terminated)
+ * @param len Length of the name
+ * @return VarNode* Variable node (NULL if not defined)
+ */
+VarNode* var_table_find(const VarTable* table, const char* name, size_t len);
+
+/**
+ * @brief Add a new variable node with an interned copy of name
+ * 
+ * The caller must make sure the name is not defined yet. The new node holds
+ * the larnum 0 until var_table_assign is called.
+ * 
+ * @return VarNode* New node appended in definition order (NULL on allocation failure)
+ */
+VarNode* var_table_insert(VarTable* table, const char* name, size_t len);
+
+/**
+ * @brief Store a copy of value in a variable, replacing its old value
+ * 
+ * The copy lives in the table's arena as borrowed (read-only) limbs; the
+ * old value's limbs go back to the arena's size-class pool.
+ * 
+ * @param table Table that owns the node (non-NULL)
+ * @param node Variable to update (non-NULL)
+ * @param type Type of the new value (VAR_LARNUM / VAR_PRECISE)
+ * @param value Larnum* or Precise* matching type (non-NULL)
+ * @return int 0 on success, -1 on allocation failure (old value is kept)
+ */
+int var_table_assign(VarTable* table, VarNode* node, VarType type, const void* value);
+
+/**
+ * @brief Make a variable refer to limbs that live in a loaded snapshot
+ *
+ * Like var_table_assign, but value's limbs are not copied: the variable
+ * keeps pointing into the snapshot until it is redefined or the table is
+ * cleared. The caller holds one snapshot reference for the variable.
+ */
+void var_table_attach(VarTable* table, VarNode* node, VarType type, const void* value, VarSnapshot* snapshot);
+
+/**
+ * @brief Drop one variable's reference to a snapshot (unmapped when none is left)
+ */
+void var_snapshot_release(VarTable* table, VarSnapshot* snapshot);
+
+/**
+ * @brief Unmap every snapshot of a table whose variables are being dropped
+ */
+void var_snapshot_release_all(VarTable* table);
+
+/**
+ * @brief Set or drop the formula of a variable
+ * 
+ * The node is unlinked from the dependents of its old inputs and linked
+ * to the new ones. A formula that would make the variable depend on
+ * itself (directly or through its inputs) is not kept: the variable
+ * becomes a plain value.
+ * 
+ * @param formula Statement source (NULL = plain value)
+ * @param inputs Variables the statement reads
+ * @return int 0 on success, -1 on allocation failure (variable becomes a plain value)
+ */
+int var_table_set_formula(VarTable* table, VarNode* node, const char* formula, size_t len,
+                          VarNode* const* inputs, size_t input_count);
+
+/**
+ * @brief Mark every variable computed from node (transitively) as stale
+ * 
+ * @return int 0 on success, -1 on allocation failure
+ */
+int var_table_invalidate(VarTable* table, VarNode* node);
+
+/**
+ * @brief Find a variable by name in the global variable table
  * 
  * @param var_name Name of the variable to find (non-NULL)
  * @return VarNode* Pointer to found variable node (NULL if not defined)
@@ -69,9 +222,10 @@ extern VarNode* var_list;
 VarNode* find_variable(const char* var_name);
 
 /**
- * @brief Free memory allocated for a single variable node
+ * @brief Free the value held by a single variable node
  * 
- * Prevents memory leaks when redefining or clearing variables
+ * Only heap-owned values are released; values stored by var_table_assign
+ * belong to the table's arena, as do the node and its name.
  * 
  * @param node Pointer to the variable node to free (can be NULL)
  */
@@ -81,7 +235,7 @@ void free_variable(VarNode* node);
  * @brief Define or redefine a variable in CLRL runtime
  * 
  * If variable exists: free old value and overwrite with new value
- * If variable does not exist: create new node and add to linked list
+ * If variable does not exist: create new node and add it to the variable table
  * 
  * @param var_name Name of the variable to define (non-NULL)
  * @param type Type of the variable (VAR_LARNUM / VAR_PRECISE)
@@ -94,13 +248,35 @@ int define_variable(const char* var_name, VarType type, void* new_value);
  * @brief Parse variable definition commands from user input (REPL mode)
  * 
  * Supports syntax: 
- * - larnum <var_name> = <value>
- * - precise <var_name> = <value>
+ * - larnum <var_name> = <expr> [@ <digits>]   (op: + - * / // %)
+ * - precise <var_name> = <expr> [@ <digits>]  (op: + - * /)
+ * 
+ * Expressions follow the usual precedence and may use parentheses and
+ * unary minus. Operands are decimal literals or variable names; larnum
+ * definitions only accept integer literals and larnum variables.
+ * `/` keeps the division precision (global or "@ <digits>") as fractional
+ * digits and gives a precise value; with precision 0, `/` and `//` give
+ * the truncated integer quotient and `%` the remainder.
+ * The input goes through the bytecode compiler (see clrl_vm.h).
  * 
  * @param input User input string from REPL (non-NULL)
  */
 void parse_variable_definition(const char* input);
 
+/**
+ * @brief Set the number of fractional digits produced by larnum '/'
+ * 
+ * @param digits Fractional digits (0 = truncated integer quotient)
+ */
+void set_division_precision(size_t digits);
+
+/**
+ * @brief Get the number of fractional digits produced by larnum '/'
+ * 
+ * @return size_t Current division precision
+ */
+size_t get_division_precision(void);
+
 /**
  * @brief Execute return command to display variable values
  * 
@@ -113,10 +289,17 @@ void execute_return_command(const char* input);
 /**
  * @brief Clear all defined variables (called by system:clear)
  * 
- * Frees memory for all variable nodes and resets global list
+ * Resets the variable table's arena in one step and empties the global table
  */
 void clear_all_variables();
 
+/**
+ * @brief Print allocator statistics (called by system:memory)
+ * 
+ * Shows the heap pool used for number buffers and the variable table arena
+ */
+void print_memory_stats(void);
+
 /**
  * @brief Free memory for all variables (called on program exit)
  * 
@@ -0,0 +1,102 @@
+#ifndef CLRL_THREAD_H
+#define CLRL_THREAD_H
+
+#include <stddef.h>
+
+// Storage class of per-thread runtime state
+#if defined(_MSC_VER)
+#define CLRL_THREAD_LOCAL __declspec(thread)
+#else
+#define CLRL_THREAD_LOCAL __thread
+#endif
+
+/**
+ * @brief Fork-join task (lives on the stack of the thread that forks it)
+ */
+typedef struct {
+    void (*run)(void* arg);  // Task body
+    void* arg;               // Argument passed to run
+    int done;                // Set (atomically) once run has returned
+} ClrlTask;
+
+/**
+ * @brief Body of a parallel loop: handles indices [begin, end)
+ */
+typedef void (*ClrlRangeFn)(void* ctx, size_t begin, size_t end);
+
+/**
+ * @brief Spin lock for short critical sections (zero-initialized = unlocked)
+ */
+typedef struct {
+    int locked;
+} ClrlLock;
+
+// ===================== Configuration =====================
+
+/**
+ * @brief Number of threads used by large-operand kernels (1 = serial)
+ *
+ * Defaults to $CLRL_THREADS if set, otherwise the number of online CPUs.
+ */
+size_t clrl_get_thread_count(void);
+
+/**
+ * @brief Set the number of threads (0 = number of online CPUs)
+ *
+ * Worker threads are started lazily by the first parallel kernel. Must not
+ * be called while a computation is running.
+ *
+ * @return int 0 on success, -1 on error
+ */
+int clrl_set_thread_count(size_t threads);
+
+/**
+ * @brief Stop the worker threads (they restart on demand)
+ */
+void clrl_thread_shutdown(void);
+
+// ===================== Tasks =====================
+
+/**
+ * @brief Check whether work of this size should be split across threads
+ *
+ * @param work Size of the work (caller's unit, compared against min_work)
+ * @param min_work Smallest size worth the fork/join overhead
+ * @return int Non-zero if more than one thread is configured and work >= min_work
+ */
+int clrl_parallel_worthwhile(size_t work, size_t min_work);
+
+/**
+ * @brief Make task available to other threads (runs inline if no pool)
+ *
+ * Every forked task must be joined before its storage goes away; tasks may
+ * also be forked from inside other tasks and joined by a different thread.
+ */
+void clrl_task_fork(ClrlTask* task, void (*run)(void* arg), void* arg);
+
+/**
+ * @brief Wait for a forked task
+ *
+ * Meanwhile the caller only runs tasks it forked itself, never those of
+ * another thread (which may belong to another context).
+ */
+void clrl_task_join(ClrlTask* task);
+
+/**
+ * @brief Run body over [0, count) split into chunks of at least grain indices
+ */
+void clrl_parallel_for(size_t count, size_t grain, ClrlRangeFn body, void* ctx);
+
+// ===================== Locks =====================
+
+/**
+ * @brief Acquire lock (spins, then yields the CPU while it is contended)
+ */
+void clrl_lock_acquire(ClrlLock* lock);
+
+/**
+ * @brief Release lock
+ */
+void clrl_lock_release(ClrlLock* lock);
+
+#endif // CLRL_THREAD_H
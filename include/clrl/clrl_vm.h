@@ -0,0 +1,511 @@
+#ifndef CLRL_VM_H
+#define CLRL_VM_H
+
+#include "clrl_runtime.h"
+#include "clrl_thread.h"
+
+/**
+ * @brief Bytecode instruction set
+ *
+ * Three-address register code: every arithmetic instruction reads operands
+ * a and b and writes register dst. Operands are tagged (see CLRL_OPERAND)
+ * and name a register, a constant of the program or a variable slot, so
+ * literals are parsed once at compile time and variables never need a
+ * name lookup while the program runs.
+ */
+typedef enum {
+    CLRL_OP_ADD,            // dst = a + b
+    CLRL_OP_SUB,            // dst = a - b
+    CLRL_OP_MUL,            // dst = a * b
+    CLRL_OP_DIV,            // dst = a / b with imm fractional digits
+    CLRL_OP_IDIV,           // dst = a // b (truncated integer quotient)
+    CLRL_OP_MOD,            // dst = a % b
+    CLRL_OP_NEG,            // dst = -a
+    CLRL_OP_POW,            // dst = a ^ b (imm fractional digits if b < 0)
+    CLRL_OP_POWMOD,         // dst = powmod(a, b, imm) (imm is an operand: the modulus)
+    CLRL_OP_ROOT,           // dst = b-th root of a (imm fractional digits)
+    CLRL_OP_STORE,          // variable slot dst = a
+    CLRL_OP_RETURN,         // print variable slot a
+    CLRL_OP_SET_PRECISION   // division precision = imm
+} ClrlOpcode;
+
+// Operand tags (top two bits of an operand)
+#define CLRL_OPERAND_REG   0u
+#define CLRL_OPERAND_CONST 1u
+#define CLRL_OPERAND_VAR   2u
+
+#define CLRL_OPERAND(kind, index) (((uint32_t)(kind) << 30) | (uint32_t)(index))
+#define CLRL_OPERAND_KIND(x)      ((uint32_t)(x) >> 30)
+#define CLRL_OPERAND_INDEX(x)     ((uint32_t)(x) & 0x3FFFFFFFu)
+
+// Instruction flags
+#define CLRL_FLAG_LARNUM_ONLY 0x01u   // Variable operands must hold larnum values
+#define CLRL_FLAG_TO_PRECISE  0x02u   // STORE converts the value to precise
+
+// imm value of CLRL_OP_DIV that selects the session division precision
+#define CLRL_PRECISION_GLOBAL UINT32_MAX
+
+// clrl_optimize flags
+#define CLRL_OPTIMIZE_CLOSED 0x01u    // Nothing reads the variables after the program
+
+/**
+ * @brief One bytecode instruction
+ */
+typedef struct {
+    uint8_t op;          // ClrlOpcode
+    uint8_t flags;       // CLRL_FLAG_* bits
+    uint32_t dst;        // Destination register (variable slot for STORE)
+    uint32_t a;          // First operand
+    uint32_t b;          // Second operand
+    uint32_t imm;        // Immediate (division/root precision; third operand of CLRL_OP_POWMOD)
+} ClrlInsn;
+
+/**
+ * @brief Source statement: a run of instructions that succeeds or fails as a unit
+ */
+typedef struct {
+    size_t first;        // Index of the first instruction
+    size_t count;        // Number of instructions
+    size_t line;         // Source line (for error messages)
+    uint32_t profile;    // Profiler entry (0 = not profiled, see clrl_profile.h)
+} ClrlStatement;
+
+/**
+ * @brief Tagged value held by a register or a constant
+ */
+typedef struct {
+    VarType type;
+    VarValue value;
+} ClrlValue;
+
+/**
+ * @brief Compiled CLRL program
+ */
+typedef struct {
+    ClrlInsn* code;               // Instructions of all statements
+    size_t code_count;
+    size_t code_capacity;
+    ClrlStatement* statements;    // Statements in source order
+    size_t statement_count;
+    size_t statement_capacity;
+    ClrlValue* constants;         // Literals, parsed at compile time
+    size_t constant_count;
+    size_t constant_capacity;
+    char** slot_names;            // Variable name of each slot
+    size_t slot_count;
+    size_t slot_capacity;
+    size_t register_count;        // Registers needed by the largest expression
+} ClrlProgram;
+
+/**
+ * @brief Execution state of the interpreter (registers and variable bindings)
+ *
+ * A VM can run many programs, one after the other; registers keep their
+ * buffers between runs so repeated evaluation does not reallocate.
+ */
+typedef struct {
+    ClrlValue* registers;
+    size_t register_count;
+    VarNode** bindings;           // Variable node of each slot (NULL = undefined)
+    size_t binding_count;
+    int recomputing;              // Running a stored formula: stores keep formulas and dependents
+    size_t* precision;            // Division precision to use and update (NULL = the session's, see set_division_precision)
+    ClrlLock* table_lock;         // Held around table updates while statements run concurrently (NULL = serial)
+} ClrlVm;
+
+/**
+ * @brief Output of one statement, collected while other statements run
+ */
+typedef struct {
+    char* text;
+    size_t len;
+    size_t capacity;
+} ClrlOutputCapture;
+
+/**
+ * @brief Run one statement with the given registers and division precision
+ *
+ * @return int 0 on success, -1 if the statement failed (error printed)
+ */
+typedef int (*ClrlStatementFn)(void* ctx, size_t statement, ClrlValue* registers, size_t precision);
+
+/**
+ * @brief Data-dependency DAG of the statements of a program
+ *
+ * Statement j depends on an earlier statement i if j reads a variable i
+ * writes (read after write), writes one i reads (write after read) or
+ * writes one i writes too (write after write). system:precision
+ * statements are chained among themselves; divisions get the precision in
+ * effect at their position up front instead of depending on them.
+ * Successor lists are stored CSR-style: the successors of statement i are
+ * successors[successor_start[i] .. successor_start[i + 1]).
+ */
+typedef struct {
+    size_t statement_count;
+    size_t register_count;            // Registers one statement needs
+    const uint32_t* precision;        // Precision of the last system:precision before each statement (CLRL_PRECISION_GLOBAL = none)
+    const uint32_t* predecessor_count;
+    const uint32_t* successor_start;  // statement_count + 1 entries
+    const uint32_t* successors;
+} ClrlSchedule;
+
+/**
+ * @brief Read-only contents of a script file
+ */
+typedef struct {
+    const char* data;             // File contents (not null-terminated)
+    size_t len;                   // Length in bytes
+    int mapped;                   // 1 = memory-mapped view, 0 = heap copy
+} ClrlSourceFile;
+
+// ===================== Compiler =====================
+
+/**
+ * @brief Initialize an empty program
+ */
+void clrl_program_init(ClrlProgram* program);
+
+/**
+ * @brief Free the code, constants and slot names of a program
+ */
+void clrl_program_free(ClrlProgram* program);
+
+/**
+ * @brief Compile CLRL source into bytecode (appended to program)
+ *
+ * Statements are separated by newlines; '#' starts a comment. Supported:
+ * - larnum|precise <name> = <expr> [@ <digits>]
+ * - return <name>, <name>, ...
+ * - system:precision <digits>
+ *
+ * Expressions use + - * / // % with the usual precedence, unary minus,
+ * right-associative ^ (binding tighter than unary minus) and parentheses.
+ * The functions sqrt(x) and root(x, n) take the precision of '/';
+ * powmod(a, e, m) is available in larnum definitions. Errors are printed
+ * with their line number.
+ *
+ * @param program Program to compile into (initialized)
+ * @param source Source text (does not need to be null-terminated)
+ * @param len Length of the source
+ * @param origin Name used in error messages (NULL for REPL input)
+ * @return int 0 on success, -1 if any statement failed to compile
+ */
+int clrl_compile(ClrlProgram* program, const char* source, size_t len, const char* origin);
+
+// ===================== Optimizer =====================
+
+/**
+ * @brief Simplify a compiled program before it runs
+ *
+ * Subexpressions of literals are folded into constants (each is computed
+ * once, and only if a statement that is kept needs it), a value computed
+ * earlier in a statement or already held by a variable is reused, and
+ * stores are dropped if the variable already holds the value or nothing
+ * reads it before it is overwritten. Results and error messages are the
+ * same as without optimization: statements that may fail are never
+ * removed.
+ *
+ * @param program Compiled program (rewritten in place)
+ * @param flags CLRL_OPTIMIZE_CLOSED also drops stores nothing in the
+ *        program reads (compiled binaries, the last script of a run)
+ * @return int 0 on success, -1 on allocation failure (program unchanged)
+ */
+int clrl_optimize(ClrlProgram* program, unsigned flags);
+
+// ===================== Output =====================
+
+/**
+ * @brief Append text to the result buffer (written to stdout in large blocks)
+ */
+void clrl_output_write(const char* text, size_t len);
+
+/**
+ * @brief Write out buffered results
+ *
+ * Does nothing while the calling thread's output is being captured.
+ */
+void clrl_output_flush(void);
+
+/**
+ * @brief Collect this thread's output in capture instead of writing it
+ *
+ * @param capture Buffer to append to (NULL = write to stdout again)
+ * @return ClrlOutputCapture* The capture that was active before
+ */
+ClrlOutputCapture* clrl_output_capture(ClrlOutputCapture* capture);
+
+// ===================== Statement scheduling =====================
+
+/**
+ * @brief Build the dependency DAG of a compiled program
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int clrl_schedule_build(ClrlSchedule* schedule, const ClrlProgram* program);
+
+/**
+ * @brief Free a schedule built by clrl_schedule_build
+ */
+void clrl_schedule_free(ClrlSchedule* schedule);
+
+/**
+ * @brief Run every statement of a schedule
+ *
+ * With more than one thread, independent statements run concurrently on
+ * the thread pool as soon as the statements they depend on are done.
+ * Each statement writes its output into its own capture, and the captures
+ * go to stdout strictly in statement order, so results and return output
+ * are the same as for serial execution. Statements that fail are reported
+ * and skipped like in serial execution; the errors of each statement are
+ * collected the same way and reported after its output.
+ *
+ * @param run Statement body (called once per statement, possibly concurrently)
+ * @return int 0 if every statement succeeded, -1 otherwise
+ */
+int clrl_schedule_run(const ClrlSchedule* schedule, ClrlStatementFn run, void* ctx);
+
+// ===================== Interpreter =====================
+
+/**
+ * @brief Initialize an empty VM
+ */
+void clrl_vm_init(ClrlVm* vm);
+
+/**
+ * @brief Free the registers and bindings of a VM
+ */
+void clrl_vm_free(ClrlVm* vm);
+
+/**
+ * @brief Execute a compiled program against a variable table
+ *
+ * Variable slots are bound to table nodes once, before the first
+ * instruction. A statement that fails prints its error and is skipped;
+ * the following statements still run. Programs with several statements
+ * run through clrl_schedule_run when more than one thread is configured.
+ *
+ * Divisions use vm->precision (the session precision if NULL), and
+ * system:precision statements update it.
+ *
+ * Stale variables the program reads before writing them are recomputed
+ * from their formulas first. Storing a variable drops its formula and
+ * marks the variables computed from it as stale.
+ *
+ * @return int 0 if every statement succeeded, -1 otherwise (or if a stale
+ *         input could not be recomputed, in which case nothing runs)
+ */
+int clrl_vm_run(ClrlVm* vm, const ClrlProgram* program, VarTable* table);
+
+/**
+ * @brief Bind the variable slots of a program to the nodes of a table
+ *
+ * The first step of clrl_vm_run, for callers that run one program many
+ * times against the same table (see clrl_batch_run).
+ *
+ * @return int 0 on success, -1 on allocation failure (message printed)
+ */
+int clrl_vm_bind(ClrlVm* vm, const ClrlProgram* program, VarTable* table);
+
+/**
+ * @brief Run a program whose slots are already bound, one statement after the other
+ *
+ * Unlike clrl_vm_run, nothing is looked up, stale inputs are not
+ * recomputed and statements never run concurrently, so every run costs
+ * only its instructions.
+ *
+ * @return int 0 if every statement succeeded, -1 otherwise
+ */
+int clrl_vm_run_bound(ClrlVm* vm, const ClrlProgram* program, VarTable* table);
+
+/**
+ * @brief Remember a REPL definition as the formula of its variable
+ *
+ * Call after program (one "larnum|precise name = expr" statement compiled
+ * from source) ran successfully. Definitions that read other variables
+ * are recomputed from source whenever one of those is redefined and the
+ * variable is read again.
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int clrl_vm_record_formula(const ClrlProgram* program, VarTable* table, const char* source, size_t len);
+
+/**
+ * @brief Recompute a stale variable (and its stale inputs) from its formula
+ *
+ * @return int 0 if the value is up to date, -1 if it could not be recomputed (message printed)
+ */
+int clrl_vm_refresh(VarTable* table, VarNode* node);
+
+/**
+ * @brief Compile, optimize and run source against the global variable table
+ *
+ * @param flags clrl_optimize flags
+ * @return int 0 on success, -1 on compile or runtime errors
+ */
+int clrl_execute_source(const char* source, size_t len, const char* origin, unsigned flags);
+
+/**
+ * @brief Open a script file for compilation
+ *
+ * Regular files are memory-mapped; anything that cannot be mapped is read
+ * into memory instead. There is no limit on line or literal length.
+ *
+ * @return int 0 on success, -1 on error (message printed)
+ */
+int clrl_source_open(ClrlSourceFile* file, const char* path);
+
+/**
+ * @brief Release a script opened with clrl_source_open
+ */
+void clrl_source_close(ClrlSourceFile* file);
+
+/**
+ * @brief Compile and run a script file against the global variable table
+ *
+ * @param flags clrl_optimize flags
+ * @return int 0 on success, -1 on read, compile or runtime errors
+ */
+int clrl_execute_file(const char* path, unsigned flags);
+
+// ===================== Batch mode =====================
+
+/**
+ * @brief Evaluate a script once per row of a CSV or TSV table (clrlc --batch)
+ *
+ * The input's first line names its columns (tab-separated if it has a
+ * tab, comma-separated otherwise); each column defines the script variable
+ * of the same name in every row. The script is compiled and optimized
+ * once; rows are evaluated concurrently on the thread pool, each in its
+ * own variable table, starting from the session's division precision.
+ * The output is a table with the same separator and one column per
+ * variable named by the script's return statements, one line per input
+ * row in input order. Errors are reported with the row's line number.
+ *
+ * @param origin Script name used in compile errors
+ * @return int 0 if every row succeeded, -1 on compile, read or row errors
+ */
+int clrl_batch_run(const char* source, size_t len, const char* origin, FILE* input, FILE* output);
+
+// ===================== Snapshots =====================
+
+/**
+ * @brief Write every variable of a table to a binary snapshot file
+ *
+ * The file holds each variable's name, type, sign, exponent and raw limbs
+ * (see clrl_snapshot.c for the layout). Stale variables are recomputed
+ * first. The snapshot is written next to path and renamed over it, so a
+ * failed save leaves an older file intact.
+ *
+ * @return int 0 on success, -1 on error (message printed)
+ */
+int clrl_snapshot_save(VarTable* table, const char* path);
+
+/**
+ * @brief Define the variables stored in a snapshot file
+ *
+ * The file is memory-mapped and values point into the mapping instead of
+ * being copied, so loading costs little more than reading the index.
+ * Existing variables of the same name are redefined (their formulas are
+ * dropped and the variables computed from them go stale).
+ *
+ * @return int 0 on success, -1 on error (message printed; a file that is
+ *         not a valid snapshot defines nothing)
+ */
+int clrl_snapshot_load(VarTable* table, const char* path);
+
+// ===================== C code generation =====================
+
+/**
+ * @brief Interface between generated code and the library (part of the
+ *        compiled-binary cache key)
+ *
+ * Bump it with every change to what generated code links against: the
+ * clrl_value_* helpers, ClrlValue, the opcodes or the schedule tables.
+ */
+#define CLRL_ABI_VERSION 1
+
+/**
+ * @brief Translate a compiled program into a standalone C program
+ *
+ * The generated code links against the clrl library and calls the
+ * clrl_value_* helpers below directly, one call per instruction. Every
+ * statement becomes a function, and the dependency DAG is emitted as
+ * static tables for clrl_schedule_run. Its first command-line argument
+ * sets the initial division precision.
+ *
+ * @param program Compiled program
+ * @param origin Script name written into the header comment (NULL for REPL)
+ * @param out Destination file
+ * @return int 0 on success, -1 on error
+ */
+int clrl_codegen_c(const ClrlProgram* program, const char* origin, FILE* out);
+
+/**
+ * @brief Run source as a compiled binary, building it on a cache miss
+ *
+ * Binaries are cached in $CLRL_CACHE_DIR (default .clrl_cache) under a hash
+ * of the normalized source, CLRL_VERSION_STRING and CLRL_ABI_VERSION (and
+ * the size of the structures generated code uses); a hit runs the binary
+ * without parsing the script. The compiler is $CLRL_CC (default gcc) with
+ * headers from $CLRL_INCLUDE_DIR and the library from $CLRL_LIBRARY_DIR.
+ *
+ * @return int 0 on success, -1 on compile, build or runtime errors
+ */
+int clrl_run_compiled(const char* source, size_t len, const char* origin);
+
+// ===================== Compiled code support =====================
+// Used by the C code that system:compile generates: registers, constants
+// and variables of a compiled script are plain ClrlValue arrays.
+
+/**
+ * @brief Initialize value from a literal ("123", "-0.50")
+ *
+ * @return int 0 on success, -1 on invalid text
+ */
+int clrl_value_parse(ClrlValue* value, VarType type, const char* text);
+
+/**
+ * @brief Free the buffer of a value
+ */
+void clrl_value_free(ClrlValue* value);
+
+/**
+ * @brief Check that a variable may be read (prints the error if not)
+ *
+ * @param name Variable name (for the error message)
+ * @param defined Non-zero if the variable has been assigned
+ * @param value Current value
+ * @param larnum_only Non-zero if the statement requires a larnum
+ * @return int 0 if usable, -1 otherwise
+ */
+int clrl_value_check(const char* name, int defined, const ClrlValue* value, int larnum_only);
+
+/**
+ * @brief dst = a <op> b with the same typing rules as the interpreter
+ *
+ * @param op Arithmetic opcode (CLRL_OP_ADD .. CLRL_OP_POW, or CLRL_OP_ROOT;
+ *        NEG ignores b)
+ * @param precision Fractional digits of CLRL_OP_DIV and CLRL_OP_ROOT (and
+ *        of CLRL_OP_POW with a negative exponent)
+ * @return int 0 on success, -1 on error (division by zero, type error)
+ */
+int clrl_value_arith(uint8_t op, ClrlValue* dst, const ClrlValue* a, const ClrlValue* b, size_t precision);
+
+/**
+ * @brief dst = powmod(a, e, m) with the same checks as the interpreter
+ *
+ * @return int 0 on success, -1 on error (zero modulus, negative exponent, type error)
+ */
+int clrl_value_powmod(ClrlValue* dst, const ClrlValue* a, const ClrlValue* e, const ClrlValue* m);
+
+/**
+ * @brief dst = src (deep copy), optionally converting a larnum to precise
+ */
+int clrl_value_assign(ClrlValue* dst, const ClrlValue* src, int to_precise);
+
+/**
+ * @brief Print "name: value"
+ */
+void clrl_value_print(const char* name, const ClrlValue* value);
+
+#endif // CLRL_VM_H
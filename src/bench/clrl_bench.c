@@ -0,0 +1,755 @@
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "../../include/clrl/clrl_runtime.h"
+#include "../../include/clrl/clrl_vm.h"
+#include "../../include/clrl/clrl_thread.h"
+#include "../../include/clrl/clrl_context.h"
+
+/**
+ * CLRL benchmark driver
+ *
+ * Sweeps operand sizes (in decimal digits) through the arithmetic, parsing
+ * and printing kernels, measures variable table throughput and whole
+ * scripts, and writes the timings as JSON to stdout. Each measurement is a
+ * set of samples; a sample repeats the kernel often enough to be well
+ * above the timer resolution and reports the time of one call.
+ *
+ * --verify NAME runs the differential checks instead: every operation on
+ * the same operands, in all sign combinations, under the native backend
+ * and under NAME, with the results (and errors) compared exactly.
+ */
+
+#define DEFAULT_MIN_DIGITS 10
+#define DEFAULT_MAX_DIGITS 10000000
+#define DEFAULT_SAMPLES 21
+#define DEFAULT_BUDGET_MS 2000      // Per measurement; at least one sample is always taken
+#define MIN_SAMPLE_NS 200000        // Calls are batched until a sample takes this long
+#define MAX_VARIABLES 1000000
+#define VERIFY_MAX_DIGITS 100000    // --verify default: the native side runs every check too
+
+/**
+ * @brief Operands shared by the number kernels of one size
+ */
+typedef struct {
+    Larnum a, b, wide;       // n-digit operands and a 2n-digit dividend
+    Larnum r, q;             // Results
+    Precise pa, pb, pr;      // Precise operands with different scales, and result
+    char* text;              // Decimal text of a (parse input)
+    size_t digits;
+} Operands;
+
+typedef int (*KernelFn)(Operands* ops);
+
+typedef struct {
+    const char* name;
+    KernelFn run;
+} Kernel;
+
+typedef struct {
+    size_t min_digits;
+    size_t max_digits;
+    size_t samples;
+    uint64_t budget_ns;
+    const char* only;        // Run only kernels whose name contains this (NULL = all)
+    int first_result;        // No result has been written yet (JSON commas)
+} BenchConfig;
+
+// ===================== Timing =====================
+
+static uint64_t now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static size_t heap_allocations(void) {
+    ClrlMemStats stats;
+    clrl_mem_get_stats(&stats);
+    return stats.alloc_count;
+}
+
+static int compare_double(const void* x, const void* y) {
+    double a = *(const double*)x;
+    double b = *(const double*)y;
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief Timings of one measurement
+ */
+typedef struct {
+    size_t samples;
+    size_t calls;            // Calls per sample
+    double median_ns;        // Per call
+    double p99_ns;
+    double min_ns;
+    double allocs;           // Heap allocations per call
+} Measurement;
+
+/**
+ * @brief Time fn(ctx) until config->samples samples or the time budget are used up
+ *
+ * @param per_call Operations done by one call (per-operation results)
+ * @return int 0 on success, -1 if the kernel failed
+ */
+static int measure(const BenchConfig* config, int (*fn)(void* ctx), void* ctx, size_t per_call, Measurement* out) {
+    double* times = (double*)malloc(config->samples * sizeof(double));
+    if (times == NULL) return -1;
+
+    // Warm up (caches, thread pool, pow10 tables) and find the batch size
+    size_t calls = 1;
+    uint64_t start = now_ns();
+    if (fn(ctx) != 0) {
+        free(times);
+        return -1;
+    }
+    uint64_t elapsed = now_ns() - start;
+    while (elapsed < MIN_SAMPLE_NS && calls < ((size_t)1 << 30)) {
+        calls *= (elapsed == 0) ? 16 : (MIN_SAMPLE_NS / elapsed) + 1;
+        start = now_ns();
+        for (size_t i = 0; i < calls; i++) {
+            if (fn(ctx) != 0) {
+                free(times);
+                return -1;
+            }
+        }
+        elapsed = now_ns() - start;
+    }
+
+    size_t count = 0;
+    size_t allocations = 0;
+    uint64_t deadline = now_ns() + config->budget_ns;
+    while (count < config->samples && (count == 0 || now_ns() < deadline)) {
+        size_t allocs_before = heap_allocations();
+        start = now_ns();
+        for (size_t i = 0; i < calls; i++) {
+            if (fn(ctx) != 0) {
+                free(times);
+                return -1;
+            }
+        }
+        elapsed = now_ns() - start;
+        allocations += heap_allocations() - allocs_before;
+        times[count++] = (double)elapsed / (double)(calls * per_call);
+    }
+
+    qsort(times, count, sizeof(double), compare_double);
+    out->samples = count;
+    out->calls = calls;
+    out->median_ns = (count % 2 == 1) ? times[count / 2] : (times[count / 2 - 1] + times[count / 2]) / 2;
+    out->p99_ns = times[(99 * count + 99) / 100 - 1];   // Nearest rank: ceil(0.99 * count)
+    out->min_ns = times[0];
+    out->allocs = (double)allocations / (double)(count * calls * per_call);
+    free(times);
+    return 0;
+}
+
+// ===================== JSON output =====================
+
+static void write_json_string(const char* text) {
+    putchar('"');
+    for (const char* p = text; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            printf("\\%c", *p);
+        } else if ((unsigned char)*p < 0x20) {
+            printf("\\u%04x", (unsigned)(unsigned char)*p);
+        } else {
+            putchar(*p);
+        }
+    }
+    putchar('"');
+}
+
+/**
+ * @brief Write one result object
+ *
+ * @param size_key Name of the size field ("digits", "variables"; NULL = none)
+ */
+static void write_result(BenchConfig* config, const char* kernel, const char* size_key, size_t size,
+                         const char* script, const Measurement* m) {
+    printf("%s\n    {\"kernel\": ", config->first_result ? "" : ",");
+    config->first_result = 0;
+    write_json_string(kernel);
+    if (size_key != NULL) printf(", \"%s\": %zu", size_key, size);
+    if (script != NULL) {
+        printf(", \"script\": ");
+        write_json_string(script);
+    }
+    printf(", \"samples\": %zu, \"calls_per_sample\": %zu, \"median_ns\": %.1f, \"p99_ns\": %.1f, \"min_ns\": %.1f, \"allocs_per_op\": %.2f}",
+           m->samples, m->calls, m->median_ns, m->p99_ns, m->min_ns, m->allocs);
+    fflush(stdout);
+}
+
+static int selected(const BenchConfig* config, const char* kernel) {
+    return config->only == NULL || strstr(kernel, config->only) != NULL;
+}
+
+// ===================== Number kernels =====================
+
+static int kernel_larnum_add(Operands* ops) { return larnum_add(&ops->r, &ops->a, &ops->b); }
+static int kernel_larnum_sub(Operands* ops) { return larnum_sub(&ops->r, &ops->a, &ops->b); }
+static int kernel_larnum_mul(Operands* ops) { return larnum_mul(&ops->r, &ops->a, &ops->b); }
+static int kernel_larnum_div(Operands* ops) { return larnum_divmod(&ops->q, &ops->r, &ops->wide, &ops->b); }
+static int kernel_precise_add(Operands* ops) { return precise_add(&ops->pr, &ops->pa, &ops->pb); }
+static int kernel_precise_mul(Operands* ops) { return precise_mul(&ops->pr, &ops->pa, &ops->pb); }
+
+static int kernel_parse(Operands* ops) {
+    return larnum_from_string(&ops->r, ops->text, ops->digits);
+}
+
+static int kernel_print(Operands* ops) {
+    char* text = larnum_to_string(&ops->a);
+    if (text == NULL) return -1;
+    free(text);
+    return 0;
+}
+
+static const Kernel number_kernels[] = {
+    { "larnum_add", kernel_larnum_add },
+    { "larnum_sub", kernel_larnum_sub },
+    { "larnum_mul", kernel_larnum_mul },
+    { "larnum_div", kernel_larnum_div },   // 2n digits / n digits
+    { "precise_add", kernel_precise_add },
+    { "precise_mul", kernel_precise_mul },
+    { "parse", kernel_parse },             // n-digit decimal text -> larnum
+    { "print", kernel_print },             // n-digit larnum -> decimal text
+};
+
+typedef struct {
+    KernelFn run;
+    Operands* ops;
+} NumberCall;
+
+static int run_number_call(void* ctx) {
+    NumberCall* call = (NumberCall*)ctx;
+    return call->run(call->ops);
+}
+
+/**
+ * @brief Pseudo-random decimal digits (no leading zero; same for every run)
+ */
+static char* random_digits(size_t digits, uint64_t seed) {
+    char* text = (char*)malloc(digits + 1);
+    if (text == NULL) return NULL;
+    uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (size_t i = 0; i < digits; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        text[i] = (char)('0' + state % 10);
+    }
+    if (text[0] == '0') text[0] = '7';
+    text[digits] = '\0';
+    return text;
+}
+
+static void operands_free(Operands* ops) {
+    larnum_free(&ops->a);
+    larnum_free(&ops->b);
+    larnum_free(&ops->wide);
+    larnum_free(&ops->r);
+    larnum_free(&ops->q);
+    larnum_free(&ops->pa.coefficient);
+    larnum_free(&ops->pb.coefficient);
+    larnum_free(&ops->pr.coefficient);
+    free(ops->text);
+}
+
+static int operands_init(Operands* ops, size_t digits) {
+    memset(ops, 0, sizeof(*ops));
+    ops->digits = digits;
+    char* b_text = random_digits(digits, 2);
+    char* wide_text = random_digits(2 * digits, 3);
+    ops->text = random_digits(digits, 1);
+    int status = (ops->text == NULL || b_text == NULL || wide_text == NULL) ? -1 : 0;
+    if (status == 0) {
+        status |= larnum_from_string(&ops->a, ops->text, digits);
+        status |= larnum_from_string(&ops->b, b_text, digits);
+        status |= larnum_from_string(&ops->wide, wide_text, 2 * digits);
+        // Different scales, so additions have to align the operands
+        status |= larnum_copy(&ops->pa.coefficient, &ops->a);
+        status |= larnum_copy(&ops->pb.coefficient, &ops->b);
+        ops->pa.exponent = -(int64_t)(digits / 2);
+        ops->pb.exponent = -(int64_t)(digits / 3);
+    }
+    free(b_text);
+    free(wide_text);
+    if (status != 0) operands_free(ops);
+    return status;
+}
+
+static int bench_numbers(BenchConfig* config) {
+    int any = 0;
+    for (size_t k = 0; k < sizeof(number_kernels) / sizeof(number_kernels[0]); k++) {
+        any |= selected(config, number_kernels[k].name);
+    }
+    if (!any) return 0;
+
+    for (size_t digits = config->min_digits; digits <= config->max_digits; digits *= 10) {
+        Operands ops;
+        if (operands_init(&ops, digits) != 0) {
+            fprintf(stderr, "Error: Cannot create %zu-digit operands\n", digits);
+            return -1;
+        }
+        for (size_t k = 0; k < sizeof(number_kernels) / sizeof(number_kernels[0]); k++) {
+            const Kernel* kernel = &number_kernels[k];
+            if (!selected(config, kernel->name)) continue;
+            NumberCall call = { kernel->run, &ops };
+            Measurement m;
+            if (measure(config, run_number_call, &call, 1, &m) != 0) {
+                fprintf(stderr, "Error: Kernel %s failed at %zu digits\n", kernel->name, digits);
+                operands_free(&ops);
+                return -1;
+            }
+            write_result(config, kernel->name, "digits", digits, NULL, &m);
+        }
+        operands_free(&ops);
+        if (digits > SIZE_MAX / 10) break;
+    }
+    return 0;
+}
+
+// ===================== Variable table =====================
+
+typedef struct {
+    char (*names)[16];
+    size_t count;
+    Larnum value;
+} VariableCall;
+
+static int run_define(void* ctx) {
+    VariableCall* call = (VariableCall*)ctx;
+    var_table_clear(&var_table);
+    for (size_t i = 0; i < call->count; i++) {
+        if (define_variable(call->names[i], VAR_LARNUM, &call->value) != 0) return -1;
+    }
+    return 0;
+}
+
+static int run_find(void* ctx) {
+    VariableCall* call = (VariableCall*)ctx;
+    for (size_t i = 0; i < call->count; i++) {
+        if (find_variable(call->names[i]) == NULL) return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief define_variable / find_variable throughput with 10^2 .. 10^6 variables
+ */
+static int bench_variables(BenchConfig* config) {
+    if (!selected(config, "define_variable") && !selected(config, "find_variable")) return 0;
+    VariableCall call;
+    call.names = (char (*)[16])malloc(MAX_VARIABLES * sizeof(*call.names));
+    if (call.names == NULL) return -1;
+    larnum_init(&call.value);
+    for (size_t i = 0; i < MAX_VARIABLES; i++) snprintf(call.names[i], sizeof(call.names[i]), "var_%zu", i);
+    int status = larnum_set_int(&call.value, 1234567890123LL);
+
+    for (size_t count = 100; count <= MAX_VARIABLES && status == 0; count *= 10) {
+        call.count = count;
+        Measurement m;
+        if (selected(config, "define_variable")) {
+            status = measure(config, run_define, &call, count, &m);
+            if (status == 0) write_result(config, "define_variable", "variables", count, NULL, &m);
+        }
+        if (status == 0 && selected(config, "find_variable")) {
+            status = run_define(&call);
+            if (status == 0) status = measure(config, run_find, &call, count, &m);
+            if (status == 0) write_result(config, "find_variable", "variables", count, NULL, &m);
+        }
+    }
+    if (status != 0) fprintf(stderr, "Error: Variable table benchmark failed\n");
+    var_table_clear(&var_table);
+    larnum_free(&call.value);
+    free(call.names);
+    return status;
+}
+
+// ===================== Scripts =====================
+
+typedef struct {
+    ClrlSourceFile file;
+    const char* path;
+    ClrlOutputCapture output;    // Return output, discarded
+} ScriptCall;
+
+static int run_script(void* ctx) {
+    ScriptCall* call = (ScriptCall*)ctx;
+    var_table_clear(&var_table);
+    call->output.len = 0;
+    ClrlOutputCapture* previous = clrl_output_capture(&call->output);
+    // Like system:fast: every definition runs, none is skipped as unread
+    clrl_execute_source(call->file.data, call->file.len, call->path, 0);
+    clrl_output_capture(previous);
+    return 0;
+}
+
+static int bench_script(BenchConfig* config, const char* path) {
+    if (!selected(config, "script")) return 0;
+    ScriptCall call;
+    memset(&call, 0, sizeof(call));
+    call.path = path;
+    if (clrl_source_open(&call.file, path) != 0) return -1;
+    set_division_precision(DEFAULT_DIVISION_PRECISION);
+    Measurement m;
+    int status = measure(config, run_script, &call, 1, &m);
+    if (status == 0) write_result(config, "script", NULL, 0, path, &m);
+    clrl_source_close(&call.file);
+    free(call.output.text);
+    var_table_clear(&var_table);
+    return status;
+}
+
+// ===================== Backend verification =====================
+
+/**
+ * @brief Outcome of one check under one backend
+ */
+typedef struct {
+    Larnum q, r;
+    char* text;
+    ClrlStatus status;       // Error reported by the check (CLRL_OK = none)
+} VerifyResult;
+
+typedef int (*CheckFn)(Operands* ops, VerifyResult* out);
+
+typedef struct {
+    const char* name;
+    CheckFn run;
+} Check;
+
+static int check_add(Operands* ops, VerifyResult* out) { return larnum_add(&out->r, &ops->a, &ops->b); }
+static int check_sub(Operands* ops, VerifyResult* out) { return larnum_sub(&out->r, &ops->a, &ops->b); }
+static int check_mul(Operands* ops, VerifyResult* out) { return larnum_mul(&out->r, &ops->a, &ops->b); }
+static int check_sqr(Operands* ops, VerifyResult* out) { return larnum_sqr(&out->r, &ops->a); }
+static int check_divmod(Operands* ops, VerifyResult* out) { return larnum_divmod(&out->q, &out->r, &ops->wide, &ops->b); }
+
+static int check_cmp(Operands* ops, VerifyResult* out) {
+    return larnum_set_int(&out->r, 3 * larnum_cmp(&ops->a, &ops->b) + larnum_cmp(&ops->b, &ops->a));
+}
+
+static int check_pow(Operands* ops, VerifyResult* out) {
+    Larnum e;
+    larnum_init(&e);
+    int status = larnum_set_int(&e, 5);
+    if (status == 0) status = larnum_pow(&out->r, &ops->a, &e);
+    larnum_free(&e);
+    return status;
+}
+
+static int check_powmod(Operands* ops, VerifyResult* out) {
+    // A 64-bit exponent keeps the native side fast at large moduli
+    Larnum e;
+    larnum_init(&e);
+    size_t bits = larnum_bit_length(&ops->b);
+    int status = larnum_shr(&e, &ops->b, (bits > 64) ? bits - 64 : 0);
+    if (status == 0) {
+        e.negative = 0;
+        status = larnum_powmod(&out->r, &ops->a, &e, &ops->wide);
+    }
+    larnum_free(&e);
+    return status;
+}
+
+static int check_root(Operands* ops, VerifyResult* out, long long degree) {
+    Larnum n;
+    larnum_init(&n);
+    int status = larnum_set_int(&n, degree);
+    if (status == 0) status = larnum_root(&out->r, &ops->wide, &n);
+    larnum_free(&n);
+    return status;
+}
+
+static int check_sqrt(Operands* ops, VerifyResult* out) { return check_root(ops, out, 2); }
+static int check_cbrt(Operands* ops, VerifyResult* out) { return check_root(ops, out, 3); }
+
+static int check_parse(Operands* ops, VerifyResult* out) {
+    // Same sign as a, so the sign variants cover "-digits" too
+    size_t len = ops->digits + 1;
+    char* text = (char*)malloc(len + 1);
+    if (text == NULL) return -1;
+    text[0] = ops->a.negative ? '-' : '+';
+    memcpy(text + 1, ops->text, ops->digits + 1);
+    int status = larnum_from_string(&out->r, text, len);
+    free(text);
+    return status;
+}
+
+static int check_print(Operands* ops, VerifyResult* out) {
+    out->text = larnum_to_string(&ops->a);
+    return (out->text != NULL) ? 0 : -1;
+}
+
+static int check_precise_div(Operands* ops, VerifyResult* out) {
+    Precise r;
+    larnum_init(&r.coefficient);
+    r.exponent = 0;
+    int status = precise_div(&r, &ops->pa, &ops->pb, ops->digits);
+    if (status == 0) status = larnum_copy(&out->r, &r.coefficient);
+    if (status == 0) status = larnum_set_int(&out->q, (long long)r.exponent);
+    larnum_free(&r.coefficient);
+    return status;
+}
+
+static const Check checks[] = {
+    { "add", check_add },
+    { "sub", check_sub },
+    { "mul", check_mul },
+    { "sqr", check_sqr },
+    { "divmod", check_divmod },            // 2n digits / n digits
+    { "cmp", check_cmp },
+    { "pow", check_pow },                  // n digits ^ 5
+    { "powmod", check_powmod },            // n digits ^ 64 bits % 2n digits
+    { "sqrt", check_sqrt },                // Of 2n digits; fails for negative operands
+    { "root3", check_cbrt },
+    { "parse", check_parse },
+    { "print", check_print },
+    { "precise_div", check_precise_div },  // n digits kept
+};
+
+static void verify_result_free(VerifyResult* result) {
+    larnum_free(&result->q);
+    larnum_free(&result->r);
+    free(result->text);
+}
+
+static int same_larnum(const Larnum* x, const Larnum* y) {
+    return x->size == y->size && x->negative == y->negative &&
+           (x->size == 0 || memcmp(x->limbs, y->limbs, x->size * sizeof(LarnumLimb)) == 0);
+}
+
+/**
+ * @brief Run check under backend; errors are collected, not printed
+ */
+static int run_check(const Check* check, Operands* ops, const char* backend, VerifyResult* out) {
+    memset(out, 0, sizeof(*out));
+    if (larnum_set_backend(backend) != 0) return -1;
+    ClrlErrorLog log;
+    memset(&log, 0, sizeof(log));
+    ClrlErrorLog* previous = clrl_error_capture(&log);
+    int status = check->run(ops, out);
+    clrl_error_capture(previous);
+    out->status = (status == 0) ? CLRL_OK : (log.status != CLRL_OK) ? log.status : CLRL_ERROR_RUNTIME;
+    clrl_error_log_free(&log);
+    return 0;
+}
+
+/**
+ * @brief Run every check with the native backend and with backend, on all sign combinations
+ *
+ * Results (values, printed text and error status) must be identical.
+ *
+ * @return int 0 if all match, 1 on a mismatch, -1 on failure
+ */
+static int verify_backend(BenchConfig* config, const char* backend) {
+    static const char* const signs[] = { "++", "-+", "+-", "--" };
+    int mismatches = 0;
+
+    for (size_t digits = config->min_digits; digits <= config->max_digits; digits *= 10) {
+        Operands ops;
+        if (operands_init(&ops, digits) != 0) {
+            fprintf(stderr, "Error: Cannot create %zu-digit operands\n", digits);
+            return -1;
+        }
+        for (size_t k = 0; k < sizeof(checks) / sizeof(checks[0]); k++) {
+            const Check* check = &checks[k];
+            if (!selected(config, check->name)) continue;
+            for (size_t s = 0; s < 4; s++) {
+                // The dividend and radicand follow the sign of a
+                ops.a.negative = ops.pa.coefficient.negative = ops.wide.negative = (signs[s][0] == '-');
+                ops.b.negative = ops.pb.coefficient.negative = (signs[s][1] == '-');
+
+                VerifyResult expected, actual;
+                if (run_check(check, &ops, "native", &expected) != 0 || run_check(check, &ops, backend, &actual) != 0) {
+                    operands_free(&ops);
+                    return -1;
+                }
+                int match = expected.status == actual.status && same_larnum(&expected.q, &actual.q) &&
+                            same_larnum(&expected.r, &actual.r) &&
+                            (expected.text == NULL) == (actual.text == NULL) &&
+                            (expected.text == NULL || strcmp(expected.text, actual.text) == 0);
+                verify_result_free(&expected);
+                verify_result_free(&actual);
+
+                printf("%s\n    {\"kernel\": ", config->first_result ? "" : ",");
+                config->first_result = 0;
+                write_json_string(check->name);
+                printf(", \"digits\": %zu, \"signs\": \"%s\", \"match\": %s}", digits, signs[s], match ? "true" : "false");
+                fflush(stdout);
+                if (!match) {
+                    fprintf(stderr, "Error: Backend %s differs from native in %s at %zu digits (signs %s)\n",
+                            backend, check->name, digits, signs[s]);
+                    mismatches++;
+                }
+            }
+        }
+        operands_free(&ops);
+        if (digits > SIZE_MAX / 10) break;
+    }
+    larnum_set_backend("native");
+    return (mismatches == 0) ? 0 : 1;
+}
+
+// ===================== Main =====================
+
+static void print_usage(void) {
+    fprintf(stderr,
+            "Usage: clrl_bench [options] [script.clrl ...]\n"
+            "  --min-digits N   smallest operand size (default %d)\n"
+            "  --max-digits N   largest operand size (default %d); sizes step by 10x\n"
+            "  --samples N      samples per measurement (default %d)\n"
+            "  --budget-ms N    time limit per measurement (default %d)\n"
+            "  --only TEXT      run only kernels whose name contains TEXT\n"
+            "  --threads N      worker threads (0 = all CPUs)\n"
+            "  --simd NAME      vector kernels: avx2, sse4.1 or scalar (default: best available)\n"
+            "  --backend NAME   arithmetic backend: native or gmp (default: $CLRL_BACKEND or native)\n"
+            "  --verify NAME    instead of timing, check that backend NAME gives the same results\n"
+            "                   as native (sizes up to %d digits unless --max-digits is given)\n"
+            "  --karatsuba N, --toom3 N, --ntt N, --div N, --radix N\n"
+            "                   crossover thresholds in limbs\n",
+            DEFAULT_MIN_DIGITS, DEFAULT_MAX_DIGITS, DEFAULT_SAMPLES, DEFAULT_BUDGET_MS, VERIFY_MAX_DIGITS);
+}
+
+/**
+ * @brief Parse a non-negative integer option value
+ */
+static int parse_size(const char* text, size_t* value) {
+    char* end;
+    unsigned long long parsed = strtoull(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || *text == '-') {
+        fprintf(stderr, "Error: Invalid number '%s'\n", text);
+        return -1;
+    }
+    *value = (size_t)parsed;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config = { DEFAULT_MIN_DIGITS, DEFAULT_MAX_DIGITS, DEFAULT_SAMPLES,
+                           (uint64_t)DEFAULT_BUDGET_MS * 1000000u, NULL, 1 };
+    LarnumMulThresholds thresholds;
+    larnum_get_mul_thresholds(&thresholds);
+    int set_thresholds = 0;
+    const char* verify = NULL;
+    int max_digits_set = 0;
+    const char** scripts = (const char**)calloc((size_t)argc, sizeof(char*));
+    size_t script_count = 0;
+    if (scripts == NULL) return 1;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--", 2) != 0) {
+            scripts[script_count++] = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            print_usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        size_t n = 0;
+        if (strcmp(arg, "--only") == 0) {
+            config.only = value;
+            continue;
+        }
+        if (strcmp(arg, "--simd") == 0) {
+            if (larnum_set_simd(value) != 0) return 1;
+            continue;
+        }
+        if (strcmp(arg, "--backend") == 0) {
+            if (larnum_set_backend(value) != 0) return 1;
+            continue;
+        }
+        if (strcmp(arg, "--verify") == 0) {
+            // Fail here rather than after the first native check
+            if (larnum_set_backend(value) != 0) return 1;
+            verify = value;
+            continue;
+        }
+        if (parse_size(value, &n) != 0) return 1;
+        int status = 0;
+        if (strcmp(arg, "--min-digits") == 0) {
+            config.min_digits = (n > 0) ? n : 1;
+        } else if (strcmp(arg, "--max-digits") == 0) {
+            config.max_digits = n;
+            max_digits_set = 1;
+        } else if (strcmp(arg, "--samples") == 0) {
+            config.samples = (n > 0) ? n : 1;
+        } else if (strcmp(arg, "--budget-ms") == 0) {
+            config.budget_ns = (uint64_t)n * 1000000u;
+        } else if (strcmp(arg, "--threads") == 0) {
+            status = clrl_set_thread_count(n);
+        } else if (strcmp(arg, "--karatsuba") == 0) {
+            thresholds.karatsuba_threshold = n;
+            set_thresholds = 1;
+        } else if (strcmp(arg, "--toom3") == 0) {
+            thresholds.toom3_threshold = n;
+            set_thresholds = 1;
+        } else if (strcmp(arg, "--ntt") == 0) {
+            thresholds.ntt_threshold = n;
+            set_thresholds = 1;
+        } else if (strcmp(arg, "--div") == 0) {
+            status = larnum_set_div_threshold(n);
+        } else if (strcmp(arg, "--radix") == 0) {
+            status = larnum_set_radix_threshold(n);
+        } else {
+            print_usage();
+            return 1;
+        }
+        if (status != 0) {
+            fprintf(stderr, "Error: Invalid value for %s\n", arg);
+            return 1;
+        }
+    }
+    if (set_thresholds && larnum_set_mul_thresholds(&thresholds) != 0) {
+        fprintf(stderr, "Error: Invalid multiplication thresholds\n");
+        return 1;
+    }
+    larnum_get_mul_thresholds(&thresholds);
+
+    if (verify != NULL && !max_digits_set) config.max_digits = VERIFY_MAX_DIGITS;
+
+    printf("{\n  \"version\": \"%s\",\n  \"threads\": %zu,\n  \"simd\": \"%s\",\n",
+           CLRL_VERSION_STRING, clrl_get_thread_count(), larnum_get_simd());
+    if (verify != NULL) {
+        printf("  \"verify\": ");
+        write_json_string(verify);
+    } else {
+        printf("  \"backend\": ");
+        write_json_string(larnum_get_backend());
+    }
+    printf(",\n");
+    printf("  \"thresholds\": {\"karatsuba\": %zu, \"toom3\": %zu, \"ntt\": %zu, \"div\": %zu, \"radix\": %zu},\n",
+           thresholds.karatsuba_threshold, thresholds.toom3_threshold, thresholds.ntt_threshold,
+           larnum_get_div_threshold(), larnum_get_radix_threshold());
+    printf("  \"results\": [");
+
+    int status = 0;
+    if (verify != NULL) {
+        status = verify_backend(&config, verify);
+    } else {
+        status = bench_numbers(&config);
+        if (status == 0) status = bench_variables(&config);
+        for (size_t i = 0; i < script_count && status == 0; i++) status = bench_script(&config, scripts[i]);
+    }
+    printf("\n  ]\n}\n");
+
+    free(scripts);
+    free_all_variables();
+    clrl_thread_shutdown();
+    return (status == 0) ? 0 : 1;
+}
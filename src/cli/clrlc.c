@@ -1,51 +1,269 @@
+#include <signal.h>
 #include <stdio.h>
 #include <string.h>
 #include "../../include/clrl/clrl_runtime.h"
+#include "../../include/clrl/clrl_vm.h"
+#include "../../include/clrl/clrl_thread.h"
+#include "../../include/clrl/clrl_profile.h"
+#include "../../include/clrl/clrl_context.h"
+#include "../runtime/clrl_buffer.h"
 
-#define MAX_INPUT_LENGTH 2048
+#define INITIAL_LINE_CAPACITY 256
+
+// Statements entered in this REPL session (replayed by system:fast)
+static ClrlBuffer session = { NULL, 0, 0 };
+
+// Interpreter state reused by every REPL statement
+static ClrlVm repl_vm;
+
+// Profile report written on exit (clrlc --profile FILE)
+static const char* profile_path = NULL;
+
+/**
+ * @brief Append one statement line to the session script
+ */
+static void session_append(const char* line, size_t len) {
+    if (len > SIZE_MAX - 2 || clrl_buffer_reserve(&session, len + 2) != 0) {
+        fprintf(stderr, "Error: Memory allocation failed for the session script\n");
+        return;
+    }
+    clrl_buffer_append(&session, line, len);
+    session.data[session.len++] = '\n';
+    session.data[session.len] = '\0';
+}
+
+/**
+ * @brief Read one line of any length from a stream
+ *
+ * @param line Buffer (grown as needed, caller frees)
+ * @param capacity Capacity of the buffer
+ * @return long Length of the line without the newline, -1 at end of input
+ */
+static long read_line(char** line, size_t* capacity, FILE* stream) {
+    size_t used = 0;
+    int c;
+    while ((c = fgetc(stream)) != EOF && c != '\n') {
+        if (used + 1 >= *capacity) {
+            size_t grown_capacity = (*capacity == 0) ? INITIAL_LINE_CAPACITY : *capacity * 2;
+            char* grown = (char*)realloc(*line, grown_capacity);
+            if (grown == NULL) {
+                fprintf(stderr, "Error: Memory allocation failed for input line\n");
+                return -1;
+            }
+            *line = grown;
+            *capacity = grown_capacity;
+        }
+        (*line)[used++] = (char)c;
+    }
+    if (c == EOF && used == 0) return -1;
+    if (*line == NULL) {
+        *line = (char*)malloc(INITIAL_LINE_CAPACITY);
+        if (*line == NULL) return -1;
+        *capacity = INITIAL_LINE_CAPACITY;
+    }
+    (*line)[used] = '\0';
+    return (long)used;
+}
+
+/**
+ * @brief Compile source once and run the bytecode
+ *
+ * @return int 0 on success, -1 on compile or runtime errors
+ */
+static int run_fast(const char* source, size_t len, const char* origin) {
+    ClrlProgram program;
+    clrl_program_init(&program);
+    int status = clrl_compile(&program, source, len, origin);
+    if (status == 0) {
+        clrl_optimize(&program, 0);   // On failure the program runs as compiled
+        status = clrl_vm_run(&repl_vm, &program, &var_table);
+    }
+    clrl_program_free(&program);
+    return status;
+}
 
 /**
  * @brief Handle system commands (system:fast, system:compile, etc.)
- * 
+ *
+ * The command word after "system:" must match exactly; anything after it
+ * is the argument.
+ *
  * @param input User input string containing system command
  * @return int 1 if command handled, 0 if not a system command, -1 if typo detected
  */
 int handle_system_commands(const char* input) {
-    if (strstr(input, "system:clear") != NULL) {
+    while (isspace((unsigned char)*input)) input++;
+    if (strncmp(input, "system:", 7) != 0) return 0;
+
+    const char* word = input + 7;
+    size_t word_len = 0;
+    while (word[word_len] != '\0' && !isspace((unsigned char)word[word_len])) word_len++;
+    const char* arg = word + word_len;
+    while (isspace((unsigned char)*arg)) arg++;
+#define IS_COMMAND(name) (word_len == strlen(name) && strncmp(word, name, word_len) == 0)
+
+    if (IS_COMMAND("clear")) {
         clear_all_variables();
+        session.len = 0;
         return 1;
-    } else if (strstr(input, "system:exit") != NULL) {
+    } else if (IS_COMMAND("exit")) {
+        if (profile_path != NULL) clrl_profile_dump(profile_path);
+        clrl_vm_free(&repl_vm);
+        free(session.data);
         free_all_variables();
+        clrl_thread_shutdown();
         printf("Exiting CLRL REPL...\n");
         exit(0);
-    } else if (strstr(input, "system:help") != NULL) {
+    } else if (IS_COMMAND("help")) {
         printf("CLRL REPL Help:\n");
-        printf("  - Define variables: larnum <name>=<value> | precise <name>=<value>\n");
+        printf("  - Define variables: larnum <name>=<expr> | precise <name>=<expr>\n");
+        printf("  - Expressions: + - * / // %% with parentheses, e.g. larnum c=(a+b)*2\n");
         printf("  - Return values: return <var1>,<var2>,...\n");
-        printf("  - System commands: system:clear | system:exit | system:help\n");
+        printf("  - Division: larnum q=a/b keeps N decimals (system:precision N, or a/b @ N per statement)\n");
+        printf("  - Integer division: larnum q=a//b | larnum r=a%%b\n");
+        printf("  - Powers: larnum p=a^b | larnum r=powmod(a,e,m) computes a^e %% m with small intermediates\n");
+        printf("  - Roots: larnum s=sqrt(a) | larnum c=root(a,3) keep N decimals like /\n");
+        printf("  - Fast mode: system:fast [file] compiles the session (or a script) to bytecode and runs it\n");
+        printf("  - Compiled mode: system:compile [file] builds the session (or a script) into a cached C binary\n");
+        printf("  - System commands: system:clear | system:exit | system:help | system:precision [N] | system:threads [N] | system:memory\n");
+        printf("  - Backend: system:backend [native|gmp] shows or picks the library behind large-number arithmetic\n");
+        printf("  - Snapshots: system:save <file> writes all variables to a binary file, system:load <file> maps them back in\n");
+        printf("  - Profiling: system:profile on|off|reset times statements compiled while it is on; system:stats [file] reports them\n");
         printf("  - Redefine variables: Just re-define (e.g., larnum a=10 → larnum a=20)\n");
+        printf("  - Dependent variables: after larnum b=a*2, redefining a makes b recompute the next time it is used\n");
+        return 1;
+    } else if (IS_COMMAND("fast")) {
+        if (*arg != '\0') {
+            ClrlSourceFile script;
+            if (clrl_source_open(&script, arg) == 0) {
+                printf("Executing in fast mode...\n");
+                run_fast(script.data, script.len, arg);
+                clrl_source_close(&script);
+            }
+        } else {
+            printf("Executing in fast mode...\n");
+            if (session.len > 0) run_fast(session.data, session.len, "session");
+        }
         return 1;
-    } else if (strstr(input, "system:fast") != NULL) {
-        printf("Executing in fast mode...\n");
+    } else if (IS_COMMAND("compile")) {
+        if (*arg != '\0') {
+            ClrlSourceFile script;
+            if (clrl_source_open(&script, arg) == 0) {
+                printf("Compiling and executing...\n");
+                clrl_run_compiled(script.data, script.len, arg);
+                clrl_source_close(&script);
+            }
+        } else {
+            printf("Compiling and executing...\n");
+            if (session.len > 0) clrl_run_compiled(session.data, session.len, NULL);
+        }
+        return 1;
+    } else if (IS_COMMAND("precision")) {
+        char* end = NULL;
+        unsigned long digits = strtoul(arg, &end, 10);
+        if (end == arg) {
+            printf("Division precision: %zu digits\n", get_division_precision());
+        } else {
+            set_division_precision((size_t)digits);
+            session_append(input, strlen(input));
+            printf("Success: Division precision set to %lu digits\n", digits);
+        }
+        return 1;
+    } else if (IS_COMMAND("threads")) {
+        char* end = NULL;
+        unsigned long threads = strtoul(arg, &end, 10);
+        if (end == arg) {
+            printf("Threads: %zu\n", clrl_get_thread_count());
+        } else if (clrl_set_thread_count((size_t)threads) == 0) {
+            printf("Success: Using %zu threads for large numbers\n", clrl_get_thread_count());
+        }
+        return 1;
+    } else if (IS_COMMAND("backend")) {
+        if (*arg == '\0') {
+            printf("Arithmetic backend: %s (available: %s)\n", larnum_get_backend(), larnum_get_backend_names());
+        } else if (larnum_set_backend(arg) == 0) {
+            printf("Success: Using the %s arithmetic backend\n", larnum_get_backend());
+        }
+        return 1;
+    } else if (IS_COMMAND("memory")) {
+        print_memory_stats();
+        return 1;
+    } else if (IS_COMMAND("save")) {
+        if (*arg == '\0') {
+            fprintf(stderr, "Error: No file specified (e.g., 'system:save session.snap')\n");
+        } else if (clrl_snapshot_save(&var_table, arg) == 0) {
+            printf("Success: Saved %zu variables to '%s'\n", var_table.count, arg);
+        }
+        return 1;
+    } else if (IS_COMMAND("load")) {
+        if (*arg == '\0') {
+            fprintf(stderr, "Error: No file specified (e.g., 'system:load session.snap')\n");
+        } else if (clrl_snapshot_load(&var_table, arg) == 0) {
+            printf("Success: Loaded variables from '%s'\n", arg);
+        }
+        return 1;
+    } else if (IS_COMMAND("profile")) {
+        if (*arg == '\0') {
+            printf("Profiling: %s\n", clrl_profiling() ? "on" : "off");
+        } else if (strcmp(arg, "on") == 0 || strcmp(arg, "off") == 0) {
+            clrl_profile_set_enabled(arg[1] == 'n');
+            printf("Success: Profiling %s\n", arg);
+        } else if (strcmp(arg, "reset") == 0) {
+            clrl_profile_reset();
+            printf("Success: Profile data cleared\n");
+        } else {
+            fprintf(stderr, "Error: Unknown profile option '%s' (expected on, off or reset)\n", arg);
+        }
         return 1;
-    } else if (strstr(input, "system:compile") != NULL) {
-        printf("Compiling and executing...\n");
+    } else if (IS_COMMAND("stats")) {
+        if (*arg == '\0') {
+            clrl_profile_report(stdout);
+        } else if (clrl_profile_dump(arg) == 0) {
+            printf("Success: Statistics written to '%s'\n", arg);
+        }
         return 1;
-    } else if (strstr(input, "system:version") != NULL) {
+    } else if (IS_COMMAND("version")) {
         printf("CLRL v1.0.0 (MinGW GCC 15.2.0)\n");
         return 1;
-    } else if (strstr(input, "system:") != NULL) {
-        // Detected system: prefix but invalid command (typo)
-        return -1;
     }
-    return 0;
+#undef IS_COMMAND
+
+    // Detected system: prefix but invalid command (typo)
+    char command[64];
+    snprintf(command, sizeof(command), "system:%.*s", (int)word_len, word);
+    const char* suggestion = find_similar_command(command);
+    if (suggestion != NULL) {
+        fprintf(stderr, "Error: Unknown command '%s' - did you mean '%s'?\n", command, suggestion);
+    } else {
+        fprintf(stderr, "Error: Unknown command '%s' - type 'system:help' for valid commands\n", command);
+    }
+    return -1;
+}
+
+/**
+ * @brief Compile one REPL line and run it
+ */
+static void execute_statement(const char* input) {
+    ClrlProgram program;
+    clrl_program_init(&program);
+    // Only statements that ran cleanly are replayed by system:fast
+    if (clrl_compile(&program, input, strlen(input), NULL) == 0 &&
+        clrl_vm_run(&repl_vm, &program, &var_table) == 0) {
+        session_append(input, strlen(input));
+        // Definitions in terms of other variables follow them when those change
+        if (clrl_vm_record_formula(&program, &var_table, input, strlen(input)) != 0) {
+            fprintf(stderr, "Error: Memory allocation failed while recording a definition\n");
+        }
+    }
+    clrl_program_free(&program);
 }
 
 /**
  * @brief Main REPL loop for CLRL interpreter
  */
 void repl_loop() {
-    char input[MAX_INPUT_LENGTH];
+    char* input = NULL;
+    size_t capacity = 0;
     int command_count = 0;
 
     printf("CLRL Calculator Language REPL (v1.0.0)\n");
@@ -56,59 +274,119 @@ void repl_loop() {
         printf("clrl> (%d) ", ++command_count);
         fflush(stdout);
 
-        // Read user input
-        if (fgets(input, MAX_INPUT_LENGTH, stdin) == NULL) {
-            continue;
+        // Read user input (no length limit); end of input leaves the REPL
+        if (read_line(&input, &capacity, stdin) < 0) {
+            printf("\n");
+            break;
         }
 
-        // Remove newline character
-        input[strcspn(input, "\n")] = '\0';
-
         // Skip empty input
-        if (strlen(input) == 0) {
+        if (strspn(input, " \t\r") == strlen(input)) {
             command_count--;
             continue;
         }
 
-        // Handle system commands first
+        // Handle system commands first, everything else is a statement
         if (handle_system_commands(input)) {
             continue;
         }
+        execute_statement(input);
+    }
+    free(input);
+}
 
-        // Handle return command
-        if (strstr(input, "return") != NULL) {
-            execute_return_command(input);
-            continue;
-        }
+/**
+ * @brief clrlc --batch SCRIPT [INPUT|-] [OUTPUT]: input from stdin and output to stdout by default
+ *
+ * @return int 0 on success, -1 on errors (messages printed)
+ */
+static int run_batch(int argc, char* argv[]) {
+    if (argc < 1 || argc > 3) {
+        fprintf(stderr, "Error: Usage: clrlc --batch <script> [input.csv|-] [output.csv]\n");
+        return -1;
+    }
+    ClrlSourceFile script;
+    if (clrl_source_open(&script, argv[0]) != 0) return -1;
 
-        // Handle variable definition/redefinition
-        if (strstr(input, "larnum") != NULL || strstr(input, "precise") != NULL) {
-            parse_variable_definition(input);
-            continue;
-        }
+    FILE* input = stdin;
+    FILE* output = stdout;
+    int status = 0;
+    if (argc >= 2 && strcmp(argv[1], "-") != 0 && (input = fopen(argv[1], "rb")) == NULL) {
+        fprintf(stderr, "Error: Cannot open batch input '%s'\n", argv[1]);
+        status = -1;
+    }
+    if (status == 0 && argc == 3 && (output = fopen(argv[2], "wb")) == NULL) {
+        fprintf(stderr, "Error: Cannot create batch output '%s'\n", argv[2]);
+        status = -1;
+    }
+    if (status == 0) status = clrl_batch_run(script.data, script.len, argv[0], input, output);
 
-        // Invalid command
-        fprintf(stderr, "Error: Invalid command - type 'system:help' for valid syntax\n");
+    if (input != NULL && input != stdin) fclose(input);
+    if (output != NULL && output != stdout && fclose(output) != 0) {
+        fprintf(stderr, "Error: Failed to write batch output '%s'\n", argv[2]);
+        status = -1;
     }
+    clrl_source_close(&script);
+    return status;
+}
+
+/**
+ * @brief SIGINT/SIGTERM handler of --serve: finish the requests in flight, then exit
+ */
+static void stop_serving(int signal_number) {
+    (void)signal_number;
+    clrl_serve_stop();
 }
 
 /**
  * @brief Main function of CLRL interpreter
  */
-#define UNUSED(x) (void)(x)
 int main(int argc, char* argv[]) {
-    // REPL mode (no arguments)
-    UNUSED(argv);
-    if (argc == 1) {
+    int status = 0;
+    clrl_vm_init(&repl_vm);
+
+    // --profile FILE: profile from the start and write the report to FILE on exit
+    int first = 1;
+    if (argc >= 3 && strcmp(argv[1], "--profile") == 0) {
+        profile_path = argv[2];
+        clrl_profile_set_enabled(1);
+        first = 3;
+    }
+
+    // Server mode: clrlc --serve [SOCKET] (stdin/stdout without a socket)
+    if (first < argc && strcmp(argv[first], "--serve") == 0) {
+        const char* socket_path = (first + 1 < argc) ? argv[first + 1] : NULL;
+        if (socket_path != NULL) {
+            signal(SIGINT, stop_serving);
+            signal(SIGTERM, stop_serving);
+        }
+#ifdef SIGPIPE
+        signal(SIGPIPE, SIG_IGN);   // A client that disconnects early is not an error
+#endif
+        if (clrl_serve(socket_path, 0) != 0) status = 1;
+    }
+    // Batch mode: clrlc --batch SCRIPT [INPUT|-] [OUTPUT], one evaluation per input row
+    else if (first < argc && strcmp(argv[first], "--batch") == 0) {
+        if (run_batch(argc - first - 1, argv + first + 1) != 0) status = 1;
+    }
+    // REPL mode (no scripts)
+    else if (first == argc) {
         repl_loop();
-    } 
-    // File execution mode (with arguments)
+    }
+    // File execution mode: clrlc script.clrl [more.clrl ...], sharing variables
     else {
-        fprintf(stderr, "File execution mode not implemented yet\n");
-        return 1;
+        for (int i = first; i < argc; i++) {
+            // Variables of the last script are never read again
+            unsigned flags = (i == argc - 1) ? CLRL_OPTIMIZE_CLOSED : 0;
+            if (clrl_execute_file(argv[i], flags) != 0) status = 1;
+        }
     }
 
     // Cleanup on exit
+    if (profile_path != NULL && clrl_profile_dump(profile_path) != 0) status = 1;
+    clrl_vm_free(&repl_vm);
+    free(session.data);
     free_all_variables();
-    return 0;
-}
\ No newline at end of file
+    clrl_thread_shutdown();
+    return status;
+}
@@ -0,0 +1,73 @@
+#include "../../include/clrl/clrl_larnum.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_backend.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Backend selection
+ *
+ * The backend is picked once, at first use, from $CLRL_BACKEND (or set
+ * with larnum_set_backend); builds without CLRL_HAVE_GMP only have the
+ * native one.
+ */
+
+const LarnumBackend larnum_native_backend = {
+    "native", 0,
+    NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+static const LarnumBackend* const backends[] = {
+    &larnum_native_backend,
+#ifdef CLRL_HAVE_GMP
+    &larnum_gmp_backend,
+#endif
+};
+
+#define BACKEND_COUNT (sizeof(backends) / sizeof(backends[0]))
+
+const LarnumBackend* larnum_active_backend = NULL;
+
+static const LarnumBackend* backend_find(const char* name) {
+    for (size_t i = 0; i < BACKEND_COUNT; i++) {
+        if (strcmp(name, backends[i]->name) == 0) return backends[i];
+    }
+    return NULL;
+}
+
+const LarnumBackend* larnum_backend_detect(void) {
+    const char* env = getenv("CLRL_BACKEND");
+    const LarnumBackend* backend = (env != NULL) ? backend_find(env) : NULL;
+    if (backend == NULL) backend = &larnum_native_backend;
+    // A concurrent larnum_set_backend wins over the environment
+    const LarnumBackend* expected = NULL;
+    if (!__atomic_compare_exchange_n(&larnum_active_backend, &expected, backend, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        backend = expected;
+    }
+    return backend;
+}
+
+const char* larnum_get_backend(void) {
+    return larnum_backend()->name;
+}
+
+const char* larnum_get_backend_names(void) {
+#ifdef CLRL_HAVE_GMP
+    return "native, gmp";
+#else
+    return "native";
+#endif
+}
+
+int larnum_set_backend(const char* name) {
+    const LarnumBackend* backend = backend_find(name);
+    if (backend == NULL) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Unknown arithmetic backend '%s' (available: %s)\n",
+                   name, larnum_get_backend_names());
+        return -1;
+    }
+    __atomic_store_n(&larnum_active_backend, backend, __ATOMIC_RELEASE);
+    return 0;
+}
@@ -0,0 +1,72 @@
+#ifndef CLRL_BACKEND_H
+#define CLRL_BACKEND_H
+
+/**
+ * @brief Internal arithmetic backend interface
+ *
+ * A backend replaces some of the larnum operations with another library.
+ * The public larnum functions check the active backend first: an entry
+ * that is set handles operands of at least min_limbs limbs, everything
+ * else (and every NULL entry) runs the built-in kernels. The native
+ * backend has no entries at all. precise arithmetic is built on the
+ * larnum operations, so it follows the backend too.
+ *
+ * Entries return 0 on success and -1 on allocation failure, or
+ * LARNUM_BACKEND_DECLINED for operands they leave to the built-in kernels
+ * (invalid arguments, sizes they cannot represent), which then report the
+ * error exactly as without a backend. Results are the same as the
+ * built-in kernels' in every case.
+ */
+
+#include "../../include/clrl/clrl_larnum.h"
+
+#define LARNUM_BACKEND_DECLINED 1
+
+typedef struct {
+    const char* name;
+    size_t min_limbs;   // Smaller operands stay on the built-in kernels
+    int (*from_string)(Larnum* x, const char* str, size_t len);
+    char* (*to_string)(const Larnum* x);      // NULL result = allocation failure
+    int (*add)(Larnum* r, const Larnum* a, const Larnum* b);
+    int (*sub)(Larnum* r, const Larnum* a, const Larnum* b);
+    int (*mul)(Larnum* r, const Larnum* a, const Larnum* b);   // Also squares (a == b)
+    int (*divmod)(Larnum* q, Larnum* r, const Larnum* a, const Larnum* b);
+    int (*pow)(Larnum* r, const Larnum* a, const Larnum* e);
+    int (*powmod)(Larnum* r, const Larnum* a, const Larnum* e, const Larnum* m);
+    int (*root)(Larnum* r, const Larnum* a, const Larnum* n);
+    int (*cmp)(const Larnum* a, const Larnum* b);             // Cannot decline
+} LarnumBackend;
+
+extern const LarnumBackend larnum_native_backend;
+#ifdef CLRL_HAVE_GMP
+extern const LarnumBackend larnum_gmp_backend;   // clrl_gmp.c
+#endif
+
+// Backend in use (NULL until the first call picks one from $CLRL_BACKEND)
+extern const LarnumBackend* larnum_active_backend;
+
+/**
+ * @brief Pick the backend named by $CLRL_BACKEND (native if unset or unknown)
+ */
+const LarnumBackend* larnum_backend_detect(void);
+
+static inline const LarnumBackend* larnum_backend(void) {
+    const LarnumBackend* backend = __atomic_load_n(&larnum_active_backend, __ATOMIC_ACQUIRE);
+    return (backend != NULL) ? backend : larnum_backend_detect();
+}
+
+/**
+ * @brief Return the active backend's result for `op` if it takes operands of this size
+ *
+ * Used at the top of the public larnum function that implements op.
+ */
+#define LARNUM_BACKEND_CALL(op, limbs, ...)                                    \
+    do {                                                                       \
+        const LarnumBackend* backend_ = larnum_backend();                      \
+        if (backend_->op != NULL && (limbs) >= backend_->min_limbs) {          \
+            int status_ = backend_->op(__VA_ARGS__);                           \
+            if (status_ != LARNUM_BACKEND_DECLINED) return status_;            \
+        }                                                                      \
+    } while (0)
+
+#endif // CLRL_BACKEND_H
@@ -0,0 +1,541 @@
+#include "../../include/clrl/clrl_vm.h"
+#include "../../include/clrl/clrl_thread.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_buffer.h"
+
+/**
+ * Batch mode (clrlc --batch)
+ *
+ * One script is evaluated once per row of a CSV or TSV table. The first
+ * line of the table names its columns; a column whose name is a variable
+ * of the script defines that variable in every row (a field with a '.'
+ * is a precise value, anything else a larnum). The output is a table of
+ * the same kind with one column per variable named by a return statement
+ * (in order of first appearance) holding the value the variable has at
+ * the end of the row, and one line per input row in input order.
+ *
+ * The script is compiled and optimized once, before the first row, and
+ * its return statements are taken out of the bytecode. Rows are read in
+ * blocks; the rows of a block are split into chunks that the thread pool
+ * evaluates concurrently, each chunk with its own variable table and VM
+ * whose registers are reused from row to row. Every row starts from an
+ * empty table holding only its inputs, so a row never sees a value left
+ * by the row before it. A block's output is written in row order once
+ * the whole block is done, followed by the errors of its rows (prefixed
+ * with their line numbers); a failed row leaves empty fields for the
+ * values it did not compute.
+ */
+
+#define BATCH_BLOCK_ROWS 16384          // Rows read, evaluated and written together
+#define BATCH_CHUNK_ROWS 64             // Rows evaluated by one task with one variable table
+#define BATCH_READ_SIZE (64u << 10)
+#define BATCH_NO_SLOT UINT32_MAX        // Column the script does not read
+
+/**
+ * @brief Input table read in blocks of whole lines
+ */
+typedef struct {
+    FILE* stream;
+    ClrlBuffer buffer;      // Lines of the current block, then the start of the next
+    size_t pos;             // First byte not yet handed out
+    size_t line;            // Number of lines handed out so far
+    int eof;
+} BatchReader;
+
+/**
+ * @brief One input row: a line of the reader's buffer
+ */
+typedef struct {
+    size_t start;
+    size_t len;
+    size_t line;            // Line number in the input (1 = the header)
+} BatchRow;
+
+/**
+ * @brief Field of a line (quotes and surrounding blanks removed)
+ */
+typedef struct {
+    const char* text;
+    size_t len;
+} BatchField;
+
+/**
+ * @brief Everything the rows share (read-only while a block runs)
+ */
+typedef struct {
+    const ClrlProgram* program;
+    char delimiter;
+    size_t column_count;        // Fields per input line
+    uint32_t* column_slots;     // Slot each input column defines (BATCH_NO_SLOT = unused)
+    char** column_names;
+    uint32_t* output_slots;     // Slots written to the output, in column order
+    size_t output_count;
+    size_t precision;           // Division precision each row starts with
+} BatchJob;
+
+/**
+ * @brief Rows of one block and the results of its chunks
+ */
+typedef struct {
+    const BatchJob* job;
+    const char* text;           // Reader buffer the rows point into
+    const BatchRow* rows;
+    size_t row_count;
+    ClrlBuffer* outputs;        // Output lines of each chunk
+    ClrlErrorLog* errors;       // Error messages of each chunk
+    int* failed;                // Non-zero for chunks with a failed row
+} BatchBlock;
+
+// ===================== Input =====================
+
+/**
+ * @brief Read up to max_rows non-empty lines into rows
+ *
+ * Lines of earlier calls are dropped from the buffer first, so rows stay
+ * valid until the next call.
+ *
+ * @return long Number of rows read (0 at end of input), -1 on a read or allocation error
+ */
+static long reader_next(BatchReader* reader, BatchRow* rows, size_t max_rows) {
+    ClrlBuffer* buffer = &reader->buffer;
+    if (reader->pos > 0) {
+        memmove(buffer->data, buffer->data + reader->pos, buffer->len - reader->pos);
+        buffer->len -= reader->pos;
+        reader->pos = 0;
+    }
+
+    size_t count = 0;
+    size_t scanned = 0;    // Bytes after pos known not to hold a newline
+    while (count < max_rows) {
+        const char* start = buffer->data + reader->pos;
+        size_t available = buffer->len - reader->pos;
+        const char* newline = (available > scanned) ? (const char*)memchr(start + scanned, '\n', available - scanned) : NULL;
+        size_t len;
+        if (newline != NULL) {
+            len = (size_t)(newline - start);
+            reader->pos += len + 1;
+        } else if (!reader->eof) {
+            // Not a whole line yet: read more behind it
+            scanned = available;
+            if (clrl_buffer_reserve(buffer, BATCH_READ_SIZE) != 0) {
+                clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for batch input\n");
+                return -1;
+            }
+            size_t got = fread(buffer->data + buffer->len, 1, BATCH_READ_SIZE, reader->stream);
+            buffer->len += got;
+            if (got < BATCH_READ_SIZE) {
+                if (ferror(reader->stream)) {
+                    clrl_error(CLRL_ERROR_IO, "Error: Failed to read batch input\n");
+                    return -1;
+                }
+                reader->eof = 1;
+            }
+            continue;
+        } else if (available > 0) {
+            // Last line without a newline
+            len = available;
+            reader->pos += len;
+        } else {
+            break;
+        }
+        scanned = 0;
+        reader->line++;
+
+        if (len > 0 && start[len - 1] == '\r') len--;
+        size_t blank = 0;
+        while (blank < len && (start[blank] == ' ' || start[blank] == '\t')) blank++;
+        if (blank == len) continue;
+        rows[count].start = (size_t)(start - buffer->data);
+        rows[count].len = len;
+        rows[count].line = reader->line;
+        count++;
+    }
+    return (long)count;
+}
+
+/**
+ * @brief Split a line at delimiter into at most max fields
+ *
+ * @return size_t Number of fields on the line (may exceed max; only max are stored)
+ */
+static size_t split_fields(const char* text, size_t len, char delimiter, BatchField* fields, size_t max) {
+    size_t count = 0;
+    size_t pos = 0;
+    for (;;) {
+        size_t end = pos;
+        while (end < len && text[end] != delimiter) end++;
+        size_t first = pos;
+        size_t last = end;
+        while (first < last && isspace((unsigned char)text[first])) first++;
+        while (last > first && isspace((unsigned char)text[last - 1])) last--;
+        if (last - first >= 2 && text[first] == '"' && text[last - 1] == '"') {
+            first++;
+            last--;
+        }
+        if (count < max) {
+            fields[count].text = text + first;
+            fields[count].len = last - first;
+        }
+        count++;
+        if (end == len) return count;
+        pos = end + 1;
+    }
+}
+
+// ===================== Evaluation =====================
+
+/**
+ * @brief Report the messages a row collected again, each with the row's line number
+ */
+static void report_row_errors(const ClrlErrorLog* row_log, size_t line) {
+    const char* text = row_log->text;
+    const char* end = text + row_log->len;
+    while (text < end) {
+        const char* newline = (const char*)memchr(text, '\n', (size_t)(end - text));
+        size_t len = (newline != NULL) ? (size_t)(newline - text) : (size_t)(end - text);
+        const char* message = text;
+        size_t message_len = len;
+        if (message_len >= 7 && strncmp(message, "Error: ", 7) == 0) {
+            message += 7;
+            message_len -= 7;
+        }
+        clrl_error(row_log->status, "Error: Line %zu: %.*s\n", line, (int)message_len, message);
+        text += len + (newline != NULL);
+    }
+}
+
+/**
+ * @brief Define the inputs of a row in an empty table
+ *
+ * @return int 0 on success, -1 on a malformed line or number (message reported)
+ */
+static int bind_row(const BatchJob* job, ClrlVm* vm, VarTable* table, BatchField* fields,
+                    const char* text, const BatchRow* row, Precise* scratch) {
+    size_t count = split_fields(text + row->start, row->len, job->delimiter, fields, job->column_count);
+    if (count != job->column_count) {
+        clrl_error(CLRL_ERROR_SYNTAX, "Error: Found %zu fields, expected %zu\n", count, job->column_count);
+        return -1;
+    }
+    for (size_t c = 0; c < job->column_count; c++) {
+        uint32_t slot = job->column_slots[c];
+        if (slot == BATCH_NO_SLOT) continue;
+        const BatchField* field = &fields[c];
+        int precise = memchr(field->text, '.', field->len) != NULL;
+        int parsed = precise ? precise_from_string(scratch, field->text, field->len)
+                             : larnum_from_string(&scratch->coefficient, field->text, field->len);
+        if (parsed != 0) {
+            clrl_error(CLRL_ERROR_SYNTAX, "Error: Invalid number '%.*s' in column '%s'\n",
+                       (int)field->len, field->text, job->column_names[c]);
+            return -1;
+        }
+        const char* name = job->column_names[c];
+        VarNode* node = var_table_insert(table, name, strlen(name));
+        if (node == NULL ||
+            var_table_assign(table, node, precise ? VAR_PRECISE : VAR_LARNUM,
+                             precise ? (const void*)scratch : (const void*)&scratch->coefficient) != 0) {
+            clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for variable '%s'\n", name);
+            return -1;
+        }
+        vm->bindings[slot] = node;
+    }
+    return 0;
+}
+
+/**
+ * @brief Append the output line of a row (empty fields for undefined variables)
+ *
+ * @param vm VM that ran the row (NULL = a row that never ran)
+ */
+static int write_row(const BatchJob* job, const ClrlVm* vm, ClrlBuffer* out) {
+    for (size_t k = 0; k < job->output_count; k++) {
+        if (k > 0 && clrl_buffer_append(out, &job->delimiter, 1) != 0) return -1;
+        const VarNode* node = (vm != NULL) ? vm->bindings[job->output_slots[k]] : NULL;
+        if (node == NULL) continue;
+        char* text = (node->type == VAR_LARNUM) ? larnum_to_string(&node->value.larnum_val)
+                                                : precise_to_string(&node->value.precise_val);
+        if (text == NULL) return -1;
+        int status = clrl_buffer_append(out, text, strlen(text));
+        free(text);
+        if (status != 0) return -1;
+    }
+    return clrl_buffer_append(out, "\n", 1);
+}
+
+/**
+ * @brief Evaluate one chunk of a block's rows
+ */
+static void evaluate_chunk(BatchBlock* block, size_t chunk) {
+    const BatchJob* job = block->job;
+    const ClrlProgram* program = job->program;
+    size_t first = chunk * BATCH_CHUNK_ROWS;
+    size_t last = first + BATCH_CHUNK_ROWS;
+    if (last > block->row_count) last = block->row_count;
+
+    // Nothing a row does may reach stdout or stderr directly
+    ClrlOutputCapture discarded = { NULL, 0, 0 };
+    ClrlOutputCapture* previous_output = clrl_output_capture(&discarded);
+    ClrlErrorLog row_log = { CLRL_OK, NULL, 0, 0 };
+    ClrlErrorLog* previous_log = clrl_error_capture(&row_log);
+
+    VarTable table;
+    var_table_init(&table);
+    ClrlVm vm;
+    clrl_vm_init(&vm);
+    size_t precision = job->precision;
+    vm.precision = &precision;
+    Precise scratch;
+    precise_init(&scratch);
+    BatchField* fields = (BatchField*)malloc(job->column_count * sizeof(BatchField));
+    ClrlBuffer* out = &block->outputs[chunk];
+
+    int ready = fields != NULL && clrl_vm_bind(&vm, program, &table) == 0;
+    if (fields == NULL) clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for batch rows\n");
+    for (size_t r = first; r < last; r++) {
+        const BatchRow* row = &block->rows[r];
+        row_log.status = CLRL_OK;
+        row_log.len = 0;
+
+        int status = -1;
+        if (ready) {
+            // Each row starts from its inputs alone
+            var_table_clear(&table);
+            if (program->slot_count > 0) memset(vm.bindings, 0, program->slot_count * sizeof(VarNode*));
+            precision = job->precision;
+            status = bind_row(job, &vm, &table, fields, block->text, row, &scratch);
+            if (status == 0) status = clrl_vm_run_bound(&vm, program, &table);
+        }
+        if (write_row(job, ready ? &vm : NULL, out) != 0) {
+            clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for batch output\n");
+            status = -1;
+        }
+
+        if (status != 0 || row_log.len > 0) {
+            block->failed[chunk] = 1;
+            clrl_error_capture(&block->errors[chunk]);
+            if (row_log.len > 0) {
+                report_row_errors(&row_log, row->line);
+            } else {
+                clrl_error(CLRL_ERROR_RUNTIME, "Error: Line %zu: Row could not be evaluated\n", row->line);
+            }
+            clrl_error_capture(&row_log);
+        }
+    }
+
+    free(fields);
+    precise_free(&scratch);
+    clrl_vm_free(&vm);
+    var_table_release(&table);
+    clrl_error_capture(previous_log);
+    clrl_error_log_free(&row_log);
+    clrl_output_capture(previous_output);
+    free(discarded.text);
+}
+
+static void evaluate_chunks(void* ctx, size_t begin, size_t end) {
+    for (size_t chunk = begin; chunk < end; chunk++) evaluate_chunk((BatchBlock*)ctx, chunk);
+}
+
+// ===================== Setup =====================
+
+/**
+ * @brief Take the return statements out of a program, collecting the slots they name
+ *
+ * @return int 0 on success, -1 on allocation failure or if there is no return statement
+ */
+static int take_returns(ClrlProgram* program, BatchJob* job) {
+    job->output_slots = (uint32_t*)malloc((program->slot_count + 1) * sizeof(uint32_t));
+    if (job->output_slots == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for batch columns\n");
+        return -1;
+    }
+    unsigned char* listed = (unsigned char*)calloc(program->slot_count + 1, 1);
+    if (listed == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for batch columns\n");
+        return -1;
+    }
+
+    size_t kept = 0;
+    for (size_t s = 0; s < program->statement_count; s++) {
+        ClrlStatement* statement = &program->statements[s];
+        size_t first = kept;
+        for (size_t i = statement->first; i < statement->first + statement->count; i++) {
+            const ClrlInsn* insn = &program->code[i];
+            if (insn->op != CLRL_OP_RETURN) {
+                program->code[kept++] = *insn;
+                continue;
+            }
+            uint32_t slot = CLRL_OPERAND_INDEX(insn->a);
+            if (!listed[slot]) {
+                listed[slot] = 1;
+                job->output_slots[job->output_count++] = slot;
+            }
+        }
+        statement->first = first;
+        statement->count = kept - first;
+    }
+    program->code_count = kept;
+    free(listed);
+
+    if (job->output_count == 0) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Batch script has no return statement (nothing to output)\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read the header line: column names, delimiter and the slots they define
+ *
+ * @return int 0 on success, -1 on error (message reported)
+ */
+static int read_header(BatchReader* reader, const ClrlProgram* program, BatchJob* job) {
+    BatchRow header;
+    long got = reader_next(reader, &header, 1);
+    if (got <= 0) {
+        if (got == 0) clrl_error(CLRL_ERROR_ARGUMENT, "Error: Batch input has no header line\n");
+        return -1;
+    }
+    const char* text = reader->buffer.data + header.start;
+    job->delimiter = (memchr(text, '\t', header.len) != NULL) ? '\t' : ',';
+
+    size_t count = split_fields(text, header.len, job->delimiter, NULL, 0);
+    BatchField* fields = (BatchField*)malloc(count * sizeof(BatchField));
+    job->column_slots = (uint32_t*)malloc(count * sizeof(uint32_t));
+    job->column_names = (char**)calloc(count, sizeof(char*));
+    if (fields == NULL || job->column_slots == NULL || job->column_names == NULL) {
+        free(fields);
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for batch columns\n");
+        return -1;
+    }
+    split_fields(text, header.len, job->delimiter, fields, count);
+    job->column_count = count;
+
+    int status = 0;
+    for (size_t c = 0; c < count && status == 0; c++) {
+        job->column_names[c] = (char*)malloc(fields[c].len + 1);
+        if (job->column_names[c] == NULL) {
+            clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for batch columns\n");
+            status = -1;
+            break;
+        }
+        memcpy(job->column_names[c], fields[c].text, fields[c].len);
+        job->column_names[c][fields[c].len] = '\0';
+        for (size_t k = 0; k < c; k++) {
+            if (strcmp(job->column_names[k], job->column_names[c]) == 0) {
+                clrl_error(CLRL_ERROR_ARGUMENT, "Error: Column '%s' appears twice in the batch header\n",
+                           job->column_names[c]);
+                status = -1;
+            }
+        }
+        job->column_slots[c] = BATCH_NO_SLOT;
+        for (size_t s = 0; s < program->slot_count; s++) {
+            if (strcmp(program->slot_names[s], job->column_names[c]) == 0) job->column_slots[c] = (uint32_t)s;
+        }
+    }
+    free(fields);
+    return status;
+}
+
+static void job_free(BatchJob* job) {
+    for (size_t c = 0; c < job->column_count; c++) free(job->column_names[c]);
+    free(job->column_names);
+    free(job->column_slots);
+    free(job->output_slots);
+}
+
+/**
+ * @brief Write the output header: the names of the returned variables
+ */
+static int write_header(const BatchJob* job, FILE* output) {
+    for (size_t k = 0; k < job->output_count; k++) {
+        if (k > 0) fputc(job->delimiter, output);
+        fputs(job->program->slot_names[job->output_slots[k]], output);
+    }
+    fputc('\n', output);
+    if (ferror(output)) {
+        clrl_error(CLRL_ERROR_IO, "Error: Failed to write batch output\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Evaluate every row of the input table and write the results
+ */
+static int run_rows(BatchReader* reader, const BatchJob* job, FILE* output) {
+    size_t chunk_count = (BATCH_BLOCK_ROWS + BATCH_CHUNK_ROWS - 1) / BATCH_CHUNK_ROWS;
+    BatchRow* rows = (BatchRow*)malloc(BATCH_BLOCK_ROWS * sizeof(BatchRow));
+    ClrlBuffer* outputs = (ClrlBuffer*)calloc(chunk_count, sizeof(ClrlBuffer));
+    ClrlErrorLog* errors = (ClrlErrorLog*)calloc(chunk_count, sizeof(ClrlErrorLog));
+    int* failed = (int*)calloc(chunk_count, sizeof(int));
+    int status = 0;
+    int rows_failed = 0;
+    if (rows == NULL || outputs == NULL || errors == NULL || failed == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for batch rows\n");
+        status = -1;
+    }
+
+    while (status == 0) {
+        long count = reader_next(reader, rows, BATCH_BLOCK_ROWS);
+        if (count < 0) status = -1;
+        if (count <= 0) break;
+
+        BatchBlock block = { job, reader->buffer.data, rows, (size_t)count, outputs, errors, failed };
+        size_t chunks = ((size_t)count + BATCH_CHUNK_ROWS - 1) / BATCH_CHUNK_ROWS;
+        for (size_t k = 0; k < chunks; k++) {
+            outputs[k].len = 0;
+            errors[k].status = CLRL_OK;
+            errors[k].len = 0;
+            failed[k] = 0;
+        }
+        clrl_parallel_for(chunks, 1, evaluate_chunks, &block);
+
+        for (size_t k = 0; k < chunks; k++) {
+            if (outputs[k].len > 0 && fwrite(outputs[k].data, 1, outputs[k].len, output) != outputs[k].len) {
+                clrl_error(CLRL_ERROR_IO, "Error: Failed to write batch output\n");
+                status = -1;
+                break;
+            }
+        }
+        fflush(output);
+        for (size_t k = 0; k < chunks; k++) {
+            clrl_error_replay(&errors[k]);
+            if (failed[k]) rows_failed = 1;
+        }
+    }
+
+    for (size_t k = 0; outputs != NULL && k < chunk_count; k++) free(outputs[k].data);
+    for (size_t k = 0; errors != NULL && k < chunk_count; k++) clrl_error_log_free(&errors[k]);
+    free(outputs);
+    free(errors);
+    free(failed);
+    free(rows);
+    return (status == 0 && !rows_failed) ? 0 : -1;
+}
+
+int clrl_batch_run(const char* source, size_t len, const char* origin, FILE* input, FILE* output) {
+    ClrlProgram program;
+    clrl_program_init(&program);
+    BatchJob job;
+    memset(&job, 0, sizeof(job));
+    job.program = &program;
+    job.precision = get_division_precision();
+    BatchReader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.stream = input;
+
+    // Parsing and planning happen once, before the first row
+    int status = clrl_compile(&program, source, len, origin);
+    if (status == 0) {
+        clrl_optimize(&program, 0);   // On failure the program runs as compiled
+        status = take_returns(&program, &job);
+    }
+    if (status == 0) status = read_header(&reader, &program, &job);
+    if (status == 0) status = write_header(&job, output);
+    if (status == 0) status = run_rows(&reader, &job, output);
+
+    free(reader.buffer.data);
+    job_free(&job);
+    clrl_program_free(&program);
+    return status;
+}
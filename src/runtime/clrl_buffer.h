@@ -0,0 +1,66 @@
+#ifndef CLRL_BUFFER_H
+#define CLRL_BUFFER_H
+
+/**
+ * @brief Internal growable byte buffer shared by the runtime modules and clrlc
+ *
+ * Header-only, so the command-line tools can use it without it becoming
+ * part of the library's interface.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CLRL_BUFFER_MIN_CAPACITY 256
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t capacity;
+} ClrlBuffer;
+
+/**
+ * @brief Grow an allocation to hold at least needed bytes (capacity doubles)
+ *
+ * Takes the fields separately for structures that keep their own, such as
+ * ClrlOutputCapture.
+ *
+ * @return int 0 on success, -1 on allocation failure (buffer unchanged)
+ */
+static inline int clrl_buffer_grow(char** data, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) return 0;
+    size_t grown_capacity = (*capacity == 0) ? CLRL_BUFFER_MIN_CAPACITY : *capacity;
+    while (grown_capacity < needed) {
+        grown_capacity = (grown_capacity <= SIZE_MAX / 2) ? grown_capacity * 2 : needed;
+    }
+    char* grown = (char*)realloc(*data, grown_capacity);
+    if (grown == NULL) return -1;
+    *data = grown;
+    *capacity = grown_capacity;
+    return 0;
+}
+
+/**
+ * @brief Make room for extra more bytes after the buffer's contents
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+static inline int clrl_buffer_reserve(ClrlBuffer* buffer, size_t extra) {
+    if (extra > SIZE_MAX - buffer->len) return -1;
+    return clrl_buffer_grow(&buffer->data, &buffer->capacity, buffer->len + extra);
+}
+
+/**
+ * @brief Append len bytes to the buffer
+ *
+ * @return int 0 on success, -1 on allocation failure (buffer unchanged)
+ */
+static inline int clrl_buffer_append(ClrlBuffer* buffer, const void* data, size_t len) {
+    if (clrl_buffer_reserve(buffer, len) != 0) return -1;
+    if (len > 0) memcpy(buffer->data + buffer->len, data, len);
+    buffer->len += len;
+    return 0;
+}
+
+#endif // CLRL_BUFFER_H
@@ -0,0 +1,540 @@
+#include "../../include/clrl/clrl_vm.h"
+#include "../../include/clrl/clrl_context.h"
+#include <errno.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * C code generation and the compiled-binary cache
+ *
+ * A compiled program is translated statement by statement into straight
+ * C calls on the clrl_value_* helpers, so the generated binary has no
+ * parser and no dispatch loop. The statement DAG goes in as static tables,
+ * so independent statements of the binary run concurrently too. Binaries are cached under a key derived
+ * from the normalized script, the runtime version and the ABI: running an
+ * unchanged script again skips both parsing and the C compiler. The
+ * normalized script is stored next to its binary and compared before the
+ * binary is reused, so two scripts with the same hash never share one.
+ */
+
+// Defaults for locating the headers and the clrl library (overridable by environment)
+#ifndef CLRL_DEFAULT_INCLUDE_DIR
+#define CLRL_DEFAULT_INCLUDE_DIR "include"
+#endif
+#ifndef CLRL_DEFAULT_LIBRARY_DIR
+#define CLRL_DEFAULT_LIBRARY_DIR "bin"
+#endif
+#define CLRL_DEFAULT_CACHE_DIR ".clrl_cache"
+#define CLRL_DEFAULT_CC "gcc"
+// Cache slots tried after the one a script hashes to is taken by another script
+#define CLRL_CACHE_PROBES 8
+
+#ifdef _WIN32
+#define CLRL_EXE_SUFFIX ".exe"
+#else
+#define CLRL_EXE_SUFFIX ""
+#endif
+
+// ===================== Code generation =====================
+
+/**
+ * @brief Write text as a C string literal (escapes quotes and non-ASCII bytes)
+ */
+static void emit_c_string(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const unsigned char* p = (const unsigned char*)text; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if (*p < 0x20 || *p >= 0x7F) {
+            fprintf(out, "\\%03o", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+// Opcode names as spelled in the generated code (indexed by ClrlOpcode)
+static const char* const opcode_names[] = {
+    "CLRL_OP_ADD", "CLRL_OP_SUB", "CLRL_OP_MUL", "CLRL_OP_DIV", "CLRL_OP_IDIV", "CLRL_OP_MOD", "CLRL_OP_NEG",
+    "CLRL_OP_POW", "CLRL_OP_POWMOD", "CLRL_OP_ROOT"
+};
+
+/**
+ * @brief Write an operand as a pointer expression into r[], k[] or v[]
+ */
+static void emit_operand(FILE* out, uint32_t x) {
+    static const char arrays[] = { 'r', 'k', 'v' };
+    fprintf(out, "&%c[%u]", arrays[CLRL_OPERAND_KIND(x)], (unsigned)CLRL_OPERAND_INDEX(x));
+}
+
+/**
+ * @brief Emit the definedness/type check of a variable operand
+ */
+static void emit_check(FILE* out, const ClrlProgram* program, uint32_t x, int larnum_only) {
+    if (CLRL_OPERAND_KIND(x) != CLRL_OPERAND_VAR) return;
+    uint32_t slot = CLRL_OPERAND_INDEX(x);
+    fprintf(out, "    TRY(clrl_value_check(");
+    emit_c_string(out, program->slot_names[slot]);
+    fprintf(out, ", d[%u], &v[%u], %d));\n", (unsigned)slot, (unsigned)slot, larnum_only);
+}
+
+/**
+ * @brief Emit one instruction
+ */
+static void emit_insn(FILE* out, const ClrlProgram* program, const ClrlInsn* insn) {
+    int larnum_only = (insn->flags & CLRL_FLAG_LARNUM_ONLY) != 0;
+    switch (insn->op) {
+        case CLRL_OP_STORE:
+            emit_check(out, program, insn->a, larnum_only);
+            fprintf(out, "    TRY(clrl_value_assign(&v[%u], ", (unsigned)insn->dst);
+            emit_operand(out, insn->a);
+            fprintf(out, ", %d));\n    d[%u] = 1;\n",
+                    (insn->flags & CLRL_FLAG_TO_PRECISE) != 0, (unsigned)insn->dst);
+            return;
+
+        case CLRL_OP_RETURN: {
+            uint32_t slot = CLRL_OPERAND_INDEX(insn->a);
+            fprintf(out, "    if (clrl_value_check(");
+            emit_c_string(out, program->slot_names[slot]);
+            fprintf(out, ", d[%u], &v[%u], 0) == 0) clrl_value_print(", (unsigned)slot, (unsigned)slot);
+            emit_c_string(out, program->slot_names[slot]);
+            fprintf(out, ", &v[%u]);\n", (unsigned)slot);
+            return;
+        }
+
+        case CLRL_OP_SET_PRECISION:
+            fprintf(out, "    set_division_precision(%u);\n", (unsigned)insn->imm);
+            return;
+
+        case CLRL_OP_POWMOD:
+            emit_check(out, program, insn->a, larnum_only);
+            if (insn->b != insn->a) emit_check(out, program, insn->b, larnum_only);
+            if (insn->imm != insn->a && insn->imm != insn->b) emit_check(out, program, insn->imm, larnum_only);
+            fprintf(out, "    TRY(clrl_value_powmod(&r[%u], ", (unsigned)insn->dst);
+            emit_operand(out, insn->a);
+            fprintf(out, ", ");
+            emit_operand(out, insn->b);
+            fprintf(out, ", ");
+            emit_operand(out, insn->imm);
+            fprintf(out, "));\n");
+            return;
+
+        default:
+            emit_check(out, program, insn->a, larnum_only);
+            if (insn->b != insn->a) emit_check(out, program, insn->b, larnum_only);
+            fprintf(out, "    TRY(clrl_value_arith(%s, &r[%u], ", opcode_names[insn->op], (unsigned)insn->dst);
+            emit_operand(out, insn->a);
+            fprintf(out, ", ");
+            emit_operand(out, insn->b);
+            if (insn->imm == CLRL_PRECISION_GLOBAL) {
+                fprintf(out, ", precision));\n");
+            } else {
+                fprintf(out, ", %u));\n", (unsigned)insn->imm);
+            }
+            return;
+    }
+}
+
+/**
+ * @brief Write a uint32_t table as a static C array (one dummy entry if empty)
+ */
+static void emit_table(FILE* out, const char* name, const uint32_t* values, size_t count) {
+    fprintf(out, "static const uint32_t %s[] = {", name);
+    for (size_t i = 0; i < count; i++) {
+        fprintf(out, "%s%u,", (i % 16 == 0) ? "\n    " : " ", (unsigned)values[i]);
+    }
+    fprintf(out, "%s\n};\n", (count == 0) ? "\n    0" : "");
+}
+
+int clrl_codegen_c(const ClrlProgram* program, const char* origin, FILE* out) {
+    size_t constants = (program->constant_count > 0) ? program->constant_count : 1;
+    size_t slots = (program->slot_count > 0) ? program->slot_count : 1;
+
+    ClrlSchedule schedule;
+    if (clrl_schedule_build(&schedule, program) != 0) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed during code generation\n");
+        return -1;
+    }
+
+    fprintf(out, "/* Generated by clrlc %s from ", CLRL_VERSION_STRING);
+    emit_c_string(out, (origin != NULL) ? origin : "REPL session");
+    fprintf(out, " - do not edit */\n");
+    fprintf(out, "#include <clrl/clrl_vm.h>\n\n");
+    fprintf(out, "#define TRY(x) do { if ((x) != 0) return -1; } while (0)\n\n");
+    fprintf(out, "static ClrlValue k[%zu];   // Constants\n", constants);
+    fprintf(out, "static ClrlValue v[%zu];   // Variables\n", slots);
+    fprintf(out, "static int d[%zu];         // Variable defined flags\n", slots);
+
+    // One function per statement, run by clrl_schedule_run with its own registers r
+    for (size_t s = 0; s < program->statement_count; s++) {
+        const ClrlStatement* statement = &program->statements[s];
+        fprintf(out, "\n// line %zu\nstatic int statement_%zu(ClrlValue* r, size_t precision) {\n", statement->line, s);
+        for (size_t i = 0; i < statement->count; i++) {
+            emit_insn(out, program, &program->code[statement->first + i]);
+        }
+        fprintf(out, "    return 0;\n}\n");
+    }
+
+    fprintf(out, "\nstatic int (*const statements[])(ClrlValue*, size_t) = {");
+    for (size_t s = 0; s < program->statement_count; s++) {
+        fprintf(out, "%sstatement_%zu,", (s % 8 == 0) ? "\n    " : " ", s);
+    }
+    fprintf(out, "%s\n};\n\n", (program->statement_count == 0) ? "\n    NULL" : "");
+    fprintf(out, "static int run_statement(void* ctx, size_t statement, ClrlValue* r, size_t precision) {\n");
+    fprintf(out, "    return statements[statement](r, precision);\n}\n\n");
+
+    fprintf(out, "// Dependency DAG of the statements (see clrl_schedule_build)\n");
+    size_t count = schedule.statement_count;
+    emit_table(out, "statement_precision", schedule.precision, count);
+    emit_table(out, "predecessor_count", schedule.predecessor_count, count);
+    emit_table(out, "successor_start", schedule.successor_start, count + 1);
+    emit_table(out, "successors", schedule.successors, schedule.successor_start[count]);
+
+    fprintf(out, "\nint main(int argc, char* argv[]) {\n");
+    fprintf(out, "    // Initial division precision is passed in by the caller\n");
+    fprintf(out, "    if (argc > 1) set_division_precision((size_t)strtoul(argv[1], NULL, 10));\n");
+
+    int status = 0;
+    for (size_t i = 0; i < program->constant_count && status == 0; i++) {
+        const ClrlValue* constant = &program->constants[i];
+        char* text = (constant->type == VAR_LARNUM) ? larnum_to_string(&constant->value.larnum_val)
+                                                    : precise_to_string(&constant->value.precise_val);
+        if (text == NULL) {
+            clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed during code generation\n");
+            status = -1;
+            break;
+        }
+        fprintf(out, "    if (clrl_value_parse(&k[%zu], %s, \"%s\") != 0) return 1;\n",
+                i, (constant->type == VAR_LARNUM) ? "VAR_LARNUM" : "VAR_PRECISE", text);
+        free(text);
+    }
+
+    fprintf(out, "\n    ClrlSchedule schedule = { %zu, %zu, statement_precision, predecessor_count, successor_start, successors };\n",
+            count, schedule.register_count);
+    fprintf(out, "    int failed = clrl_schedule_run(&schedule, run_statement, NULL) != 0;\n\n");
+    fprintf(out, "    for (size_t i = 0; i < %zu; i++) clrl_value_free(&k[i]);\n", constants);
+    fprintf(out, "    for (size_t i = 0; i < %zu; i++) clrl_value_free(&v[i]);\n", slots);
+    fprintf(out, "    return failed;\n}\n");
+    clrl_schedule_free(&schedule);
+    if (status != 0) return -1;
+    return ferror(out) ? -1 : 0;
+}
+
+// ===================== Binary cache =====================
+
+/**
+ * @brief The script with comments, blank lines and redundant whitespace
+ *        removed, followed by a line naming the runtime version and ABI
+ *
+ * Whitespace runs collapse to one space because they can still separate
+ * tokens ("1 2" is not "12"). The last line starts with '#', which no
+ * normalized script line can. This text is what a cached binary was built
+ * from: it is hashed into the cache key and stored next to the binary.
+ *
+ * @return char* Newly allocated text (caller frees), NULL on allocation failure
+ */
+static char* normalize_script(const char* source, size_t len, size_t* out_len) {
+    // A binary built against another library layout must not be reused
+    char abi[256];
+    int abi_len = snprintf(abi, sizeof(abi), "#clrl %s %d %d %zu %zu %zu %zu\n", CLRL_VERSION_STRING,
+                           (int)CLRL_ABI_VERSION, (int)CLRL_OP_SET_PRECISION, sizeof(ClrlValue),
+                           sizeof(ClrlSchedule), sizeof(Larnum), sizeof(Precise));
+    char* text = (char*)malloc(len + 1 + (size_t)abi_len + 1);
+    if (text == NULL) return NULL;
+
+    size_t used = 0;
+    int pending_space = 0;
+    int line_has_text = 0;
+    int in_comment = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)source[i];
+        if (c == '\n') {
+            if (line_has_text) text[used++] = '\n';
+            pending_space = line_has_text = in_comment = 0;
+            continue;
+        }
+        if (in_comment) continue;
+        if (c == '#') {
+            in_comment = 1;
+            continue;
+        }
+        if (isspace(c)) {
+            pending_space = line_has_text;
+            continue;
+        }
+        if (pending_space) {
+            text[used++] = ' ';
+            pending_space = 0;
+        }
+        text[used++] = (char)c;
+        line_has_text = 1;
+    }
+    if (line_has_text) text[used++] = '\n';
+    memcpy(text + used, abi, (size_t)abi_len + 1);
+    *out_len = used + (size_t)abi_len;
+    return text;
+}
+
+/**
+ * @brief FNV-1a hash of the normalized script
+ */
+static uint64_t cache_key(const char* normalized, size_t len) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)normalized[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Environment variable, or a fallback if it is unset or empty
+ */
+static const char* env_or(const char* name, const char* fallback) {
+    const char* value = getenv(name);
+    return (value != NULL && value[0] != '\0') ? value : fallback;
+}
+
+/**
+ * @brief Create the cache directory if it does not exist yet
+ */
+static int ensure_directory(const char* path) {
+#ifdef _WIN32
+    int status = _mkdir(path);
+#else
+    int status = mkdir(path, 0755);
+#endif
+    if (status != 0 && errno != EEXIST) {
+        clrl_error(CLRL_ERROR_IO, "Error: Cannot create cache directory '%s'\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static int file_exists(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0;
+}
+
+/**
+ * @brief Check whether a file holds exactly len bytes of text
+ */
+static int file_matches(const char* path, const char* text, size_t len) {
+    FILE* in = fopen(path, "rb");
+    if (in == NULL) return 0;
+    char chunk[4096];
+    size_t offset = 0;
+    size_t got;
+    int same = 1;
+    while (same && (got = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        same = (got <= len - offset && memcmp(chunk, text + offset, got) == 0);
+        offset += got;
+    }
+    same = same && offset == len && !ferror(in);
+    fclose(in);
+    return same;
+}
+
+/**
+ * @brief Run a shell command (quoted for cmd.exe on Windows)
+ */
+static int run_command(const char* command) {
+    fflush(stdout);
+    fflush(stderr);
+#ifdef _WIN32
+    // cmd.exe strips the outer quotes of the command line
+    size_t len = strlen(command) + 3;
+    char* wrapped = (char*)malloc(len);
+    if (wrapped == NULL) return -1;
+    snprintf(wrapped, len, "\"%s\"", command);
+    int status = system(wrapped);
+    free(wrapped);
+    return status;
+#else
+    return system(command);
+#endif
+}
+
+/**
+ * @brief "<path>.<pid>.<n>.tmp<suffix>": private to this build, so builders
+ *        of the same script never write the same file
+ */
+static char* temp_path(const char* path, const char* suffix) {
+    static size_t counter = 0;
+    size_t n = __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED);
+    size_t len = strlen(path) + strlen(suffix) + 64;
+    char* temp = (char*)malloc(len);
+    if (temp != NULL) snprintf(temp, len, "%s.%ld.%zu.tmp%s", path, (long)getpid(), n, suffix);
+    return temp;
+}
+
+/**
+ * @brief Generate C for source and build it into binary
+ *
+ * The normalized script is stored at script_path; a cached binary is only
+ * reused when it matches (see clrl_run_compiled).
+ */
+static int build_binary(const char* source, size_t len, const char* origin, const char* c_path,
+                        const char* binary, const char* script_path, const char* normalized, size_t normalized_len) {
+    ClrlProgram program;
+    clrl_program_init(&program);
+    if (clrl_compile(&program, source, len, origin) != 0) {
+        clrl_program_free(&program);
+        return -1;
+    }
+    // The binary's variables die with it
+    clrl_optimize(&program, CLRL_OPTIMIZE_CLOSED);
+
+    // All files are built under private names and renamed into the cache
+    // once complete: an interrupted build never leaves a half-written
+    // binary, and concurrent builds of the same script do not collide
+    char* c_temp = temp_path(c_path, ".c");   // The compiler goes by the extension
+    char* temp = temp_path(binary, CLRL_EXE_SUFFIX);
+    char* script_temp = temp_path(script_path, "");
+    FILE* out = (c_temp != NULL && temp != NULL && script_temp != NULL) ? fopen(c_temp, "w") : NULL;
+    FILE* script = (out != NULL) ? fopen(script_temp, "wb") : NULL;
+    if (script == NULL) {
+        clrl_error(CLRL_ERROR_IO, "Error: Cannot write '%s'\n", (out == NULL) ? c_path : script_path);
+        if (out != NULL) {
+            fclose(out);
+            remove(c_temp);
+        }
+        clrl_program_free(&program);
+        free(c_temp);
+        free(temp);
+        free(script_temp);
+        return -1;
+    }
+    int status = clrl_codegen_c(&program, origin, out);
+    if (fclose(out) != 0) status = -1;
+    clrl_program_free(&program);
+    int script_status = (fwrite(normalized, 1, normalized_len, script) == normalized_len) ? 0 : -1;
+    if (fclose(script) != 0) script_status = -1;
+    if (status != 0 || script_status != 0) {
+        clrl_error(CLRL_ERROR_IO, "Error: Cannot write '%s'\n", (status != 0) ? c_path : script_path);
+        remove(c_temp);
+        remove(script_temp);
+        free(c_temp);
+        free(temp);
+        free(script_temp);
+        return -1;
+    }
+
+    const char* cc = env_or("CLRL_CC", CLRL_DEFAULT_CC);
+    const char* include_dir = env_or("CLRL_INCLUDE_DIR", CLRL_DEFAULT_INCLUDE_DIR);
+    const char* library_dir = env_or("CLRL_LIBRARY_DIR", CLRL_DEFAULT_LIBRARY_DIR);
+    size_t command_len = strlen(cc) + strlen(include_dir) + 2 * strlen(library_dir) +
+                         strlen(c_temp) + strlen(temp) + 128;
+    char* command = (char*)malloc(command_len);
+    if (command == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for the compiler command\n");
+        remove(c_temp);
+        remove(script_temp);
+        free(c_temp);
+        free(temp);
+        free(script_temp);
+        return -1;
+    }
+#ifdef _WIN32
+    snprintf(command, command_len, "%s -O2 -std=gnu99 -I\"%s\" -o \"%s\" \"%s\" -L\"%s\" -lclrl",
+             cc, include_dir, temp, c_temp, library_dir);
+#else
+    snprintf(command, command_len, "%s -O2 -std=gnu99 -I\"%s\" -o \"%s\" \"%s\" -L\"%s\" -lclrl -Wl,-rpath,\"%s\"",
+             cc, include_dir, temp, c_temp, library_dir, library_dir);
+#endif
+    status = run_command(command);
+    if (status != 0) {
+        clrl_error(CLRL_ERROR_RUNTIME, "Error: C compiler failed (%s)\n", command);
+        status = -1;
+    } else {
+        // The script goes in before the binary, so whoever finds the binary
+        // can check what it was built from. A concurrent build of the same
+        // script may have finished first (rename does not replace files on
+        // Windows); its files are just as good
+#ifdef _WIN32
+        if (!file_exists(binary)) remove(script_path);   // Left by a build that never finished
+#endif
+        if (rename(script_temp, script_path) != 0 && !file_matches(script_path, normalized, normalized_len)) {
+            status = -1;
+        } else if (rename(temp, binary) != 0 && !file_exists(binary)) {
+            status = -1;
+        }
+        if (status != 0) clrl_error(CLRL_ERROR_IO, "Error: Cannot write '%s'\n", binary);
+    }
+    remove(temp);          // Left over if another build won the race
+    remove(script_temp);
+    if (status != 0 || rename(c_temp, c_path) != 0) remove(c_temp);   // Kept for reading only
+    free(command);
+    free(c_temp);
+    free(temp);
+    free(script_temp);
+    return status;
+}
+
+int clrl_run_compiled(const char* source, size_t len, const char* origin) {
+    const char* cache_dir = env_or("CLRL_CACHE_DIR", CLRL_DEFAULT_CACHE_DIR);
+    if (ensure_directory(cache_dir) != 0) return -1;
+
+    size_t normalized_len = 0;
+    char* normalized = normalize_script(source, len, &normalized_len);
+    const char* library_dir = env_or("CLRL_LIBRARY_DIR", CLRL_DEFAULT_LIBRARY_DIR);
+    size_t path_len = strlen(cache_dir) + 64;
+    size_t command_len = path_len + strlen(library_dir) + 64;
+    char* c_path = (char*)malloc(path_len);
+    char* binary = (char*)malloc(path_len);
+    char* script_path = (char*)malloc(path_len);
+    char* command = (char*)malloc(command_len);
+    if (normalized == NULL || c_path == NULL || binary == NULL || script_path == NULL || command == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for the cache paths\n");
+        free(normalized);
+        free(c_path);
+        free(binary);
+        free(script_path);
+        free(command);
+        return -1;
+    }
+
+    // A slot whose stored script differs belongs to a script with the same
+    // hash: the next slot is tried, so a collision never runs the wrong binary
+    uint64_t key = cache_key(normalized, normalized_len);
+    int status = -1;
+    int probe;
+    for (probe = 0; probe < CLRL_CACHE_PROBES; probe++, key++) {
+        snprintf(c_path, path_len, "%s/clrl_%016llx.c", cache_dir, (unsigned long long)key);
+        snprintf(binary, path_len, "%s/clrl_%016llx%s", cache_dir, (unsigned long long)key, CLRL_EXE_SUFFIX);
+        snprintf(script_path, path_len, "%s/clrl_%016llx.clrl", cache_dir, (unsigned long long)key);
+        if (!file_exists(binary)) {
+            status = build_binary(source, len, origin, c_path, binary, script_path, normalized, normalized_len);
+            break;
+        }
+        if (file_matches(script_path, normalized, normalized_len)) {
+            status = 0;
+            break;
+        }
+    }
+    if (status == 0) {
+#ifdef _WIN32
+        // The binary finds libclrl.dll through PATH (cmd.exe expands %PATH%)
+        snprintf(command, command_len, "set \"PATH=%s;%%PATH%%\" && \"%s\" %zu",
+                 library_dir, binary, get_division_precision());
+#else
+        snprintf(command, command_len, "\"%s\" %zu", binary, get_division_precision());
+#endif
+        status = (run_command(command) == 0) ? 0 : -1;
+    } else if (probe == CLRL_CACHE_PROBES) {
+        clrl_error(CLRL_ERROR_IO, "Error: Cache slots of this script are all taken (clear '%s')\n", cache_dir);
+    }
+    free(normalized);
+    free(c_path);
+    free(binary);
+    free(script_path);
+    free(command);
+    return status;
+}
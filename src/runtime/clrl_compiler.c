@@ -0,0 +1,783 @@
+#include "../../include/clrl/clrl_vm.h"
+#include "../../include/clrl/clrl_profile.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_limbs.h"
+
+/**
+ * CLRL front end: tokenizer, recursive-descent parser and bytecode emitter
+ *
+ * The parser emits register code directly while it walks an expression.
+ * Temporaries use a stack discipline (an operator's result reuses the
+ * lowest register of its operands), so the register count of a program is
+ * the depth of its deepest expression. Literals become program constants
+ * and variable names become slots, both resolved once here.
+ */
+
+// ===================== Tokenizer =====================
+
+typedef enum {
+    TOK_EOF,
+    TOK_NEWLINE,
+    TOK_NUMBER,      // 123, 1.5, .5
+    TOK_IDENT,       // Names and keywords
+    TOK_SYSTEM,      // system:<word> (text is the word)
+    TOK_PLUS,
+    TOK_MINUS,
+    TOK_STAR,
+    TOK_SLASH,
+    TOK_SLASH_SLASH,
+    TOK_PERCENT,
+    TOK_CARET,
+    TOK_LPAREN,
+    TOK_RPAREN,
+    TOK_COMMA,
+    TOK_ASSIGN,
+    TOK_AT,
+    TOK_ERROR        // Unexpected character
+} TokenType;
+
+typedef struct {
+    TokenType type;
+    const char* text;
+    size_t len;
+    size_t line;
+} Token;
+
+typedef struct {
+    const char* pos;
+    const char* end;
+    size_t line;
+    Token current;       // Lookahead token
+} Lexer;
+
+static int is_name_start(unsigned char c) {
+    return isalpha(c) || c == '_' || c >= 0x80;   // Bytes >= 0x80 allow UTF-8 names
+}
+
+static int is_name_char(unsigned char c) {
+    return is_name_start(c) || isdigit(c);
+}
+
+/**
+ * @brief Scan the next token into lexer->current
+ */
+static void lexer_advance(Lexer* lexer) {
+    const char* p = lexer->pos;
+    const char* end = lexer->end;
+
+    // Skip blanks and comments (a comment runs to the end of the line)
+    while (p < end) {
+        if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\f' || *p == '\v') {
+            p++;
+        } else if (*p == '#') {
+            while (p < end && *p != '\n') p++;
+        } else {
+            break;
+        }
+    }
+
+    Token* tok = &lexer->current;
+    tok->text = p;
+    tok->len = 1;
+    tok->line = lexer->line;
+
+    if (p >= end) {
+        tok->type = TOK_EOF;
+        tok->len = 0;
+        lexer->pos = p;
+        return;
+    }
+
+    unsigned char c = (unsigned char)*p;
+    if (isdigit(c) || (c == '.' && p + 1 < end && isdigit((unsigned char)p[1]))) {
+        const char* start = p;
+        // Literals can be millions of digits long, so they are scanned in vector steps
+        p += decimal_span(p, (size_t)(end - p));
+        if (p < end && *p == '.') {
+            p++;
+            p += decimal_span(p, (size_t)(end - p));
+        }
+        tok->type = TOK_NUMBER;
+        tok->len = (size_t)(p - start);
+        lexer->pos = p;
+        return;
+    }
+
+    if (is_name_start(c)) {
+        const char* start = p;
+        while (p < end && is_name_char((unsigned char)*p)) p++;
+        size_t len = (size_t)(p - start);
+        if (len == 6 && memcmp(start, "system", 6) == 0 && p < end && *p == ':') {
+            // system:<word> is a single token carrying the command word
+            const char* word = ++p;
+            while (p < end && is_name_char((unsigned char)*p)) p++;
+            tok->type = TOK_SYSTEM;
+            tok->text = word;
+            tok->len = (size_t)(p - word);
+        } else {
+            tok->type = TOK_IDENT;
+            tok->len = len;
+        }
+        lexer->pos = p;
+        return;
+    }
+
+    p++;
+    switch (c) {
+        case '\n': tok->type = TOK_NEWLINE; lexer->line++; break;
+        case '+': tok->type = TOK_PLUS; break;
+        case '-': tok->type = TOK_MINUS; break;
+        case '*': tok->type = TOK_STAR; break;
+        case '%': tok->type = TOK_PERCENT; break;
+        case '^': tok->type = TOK_CARET; break;
+        case '(': tok->type = TOK_LPAREN; break;
+        case ')': tok->type = TOK_RPAREN; break;
+        case ',': tok->type = TOK_COMMA; break;
+        case '=': tok->type = TOK_ASSIGN; break;
+        case '@': tok->type = TOK_AT; break;
+        case '/':
+            if (p < end && *p == '/') {
+                p++;
+                tok->type = TOK_SLASH_SLASH;
+                tok->len = 2;
+            } else {
+                tok->type = TOK_SLASH;
+            }
+            break;
+        default: tok->type = TOK_ERROR; break;
+    }
+    lexer->pos = p;
+}
+
+static int token_is(const Token* tok, const char* keyword) {
+    size_t len = strlen(keyword);
+    return tok->type == TOK_IDENT && tok->len == len && memcmp(tok->text, keyword, len) == 0;
+}
+
+// ===================== Program buffers =====================
+
+void clrl_program_init(ClrlProgram* program) {
+    memset(program, 0, sizeof(*program));
+}
+
+void clrl_program_free(ClrlProgram* program) {
+    for (size_t i = 0; i < program->constant_count; i++) {
+        larnum_free(&program->constants[i].value.larnum_val);
+    }
+    for (size_t i = 0; i < program->slot_count; i++) {
+        free(program->slot_names[i]);
+    }
+    free(program->code);
+    free(program->statements);
+    free(program->constants);
+    free(program->slot_names);
+    clrl_program_init(program);
+}
+
+/**
+ * @brief Grow a program array so one more element fits
+ */
+static int grow_array(void** array, size_t* capacity, size_t count, size_t element) {
+    if (count < *capacity) return 0;
+    size_t new_capacity = (*capacity == 0) ? 16 : *capacity * 2;
+    void* grown = realloc(*array, new_capacity * element);
+    if (grown == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while compiling\n");
+        return -1;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return 0;
+}
+
+// ===================== Parser =====================
+
+// Deepest nesting of parentheses and function arguments: every level is a
+// few frames of C stack, and threads other than the main one often have
+// much less of it
+#define PARSER_MAX_DEPTH 256
+
+typedef struct {
+    Lexer lexer;
+    ClrlProgram* program;
+    const char* origin;
+    size_t next_register;    // First free temporary register
+    int larnum_statement;    // Current statement is a larnum definition
+    int failed;              // Error reported in the current statement
+    size_t depth;            // Expressions being parsed (nesting of '(' and calls)
+    size_t* slot_index;      // Open-addressing map name -> slot + 1 (0 = empty)
+    size_t slot_index_capacity;
+} Parser;
+
+static void parse_error(Parser* parser, const Token* tok, const char* message) {
+    if (parser->failed) return;   // Report only the first error of a statement
+    parser->failed = 1;
+    int at_end = (tok->type == TOK_NEWLINE || tok->type == TOK_EOF);
+    if (parser->origin != NULL && at_end) {
+        clrl_error(CLRL_ERROR_SYNTAX, "Error: %s:%zu: %s (at end of line)\n", parser->origin, tok->line, message);
+    } else if (parser->origin != NULL) {
+        clrl_error(CLRL_ERROR_SYNTAX, "Error: %s:%zu: %s (near '%.*s')\n",
+                   parser->origin, tok->line, message, (int)tok->len, tok->text);
+    } else if (at_end) {
+        clrl_error(CLRL_ERROR_SYNTAX, "Error: %s (at end of line)\n", message);
+    } else {
+        clrl_error(CLRL_ERROR_SYNTAX, "Error: %s (near '%.*s')\n", message, (int)tok->len, tok->text);
+    }
+}
+
+static int emit(Parser* parser, uint8_t op, uint8_t flags, uint32_t dst, uint32_t a, uint32_t b, uint32_t imm) {
+    ClrlProgram* program = parser->program;
+    if (grow_array((void**)&program->code, &program->code_capacity,
+                   program->code_count, sizeof(ClrlInsn)) != 0) {
+        parser->failed = 1;
+        return -1;
+    }
+    ClrlInsn* insn = &program->code[program->code_count++];
+    insn->op = op;
+    insn->flags = flags;
+    insn->dst = dst;
+    insn->a = a;
+    insn->b = b;
+    insn->imm = imm;
+    return 0;
+}
+
+/**
+ * @brief Rebuild the name index so `slots` names keep it at most half full
+ */
+static int reserve_slot_index(Parser* parser, size_t slots) {
+    ClrlProgram* program = parser->program;
+    if (slots * 2 <= parser->slot_index_capacity) return 0;
+
+    size_t capacity = (parser->slot_index_capacity == 0) ? 64 : parser->slot_index_capacity;
+    while (slots * 2 > capacity) capacity *= 2;
+    size_t* index = (size_t*)calloc(capacity, sizeof(size_t));
+    if (index == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while compiling\n");
+        return -1;
+    }
+    for (size_t s = 0; s < program->slot_count; s++) {
+        const char* n = program->slot_names[s];
+        size_t i = var_table_hash(n, strlen(n)) & (capacity - 1);
+        while (index[i] != 0) i = (i + 1) & (capacity - 1);
+        index[i] = s + 1;
+    }
+    free(parser->slot_index);
+    parser->slot_index = index;
+    parser->slot_index_capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief Slot of a variable name, added on first use
+ */
+static int resolve_slot(Parser* parser, const char* name, size_t len, uint32_t* slot) {
+    ClrlProgram* program = parser->program;
+    if (reserve_slot_index(parser, program->slot_count + 1) != 0) return -1;
+
+    size_t mask = parser->slot_index_capacity - 1;
+    size_t i = var_table_hash(name, len) & mask;
+    for (; parser->slot_index[i] != 0; i = (i + 1) & mask) {
+        const char* existing = program->slot_names[parser->slot_index[i] - 1];
+        if (strncmp(existing, name, len) == 0 && existing[len] == '\0') {
+            *slot = (uint32_t)(parser->slot_index[i] - 1);
+            return 0;
+        }
+    }
+
+    if (grow_array((void**)&program->slot_names, &program->slot_capacity,
+                   program->slot_count, sizeof(char*)) != 0) return -1;
+    char* copy = (char*)malloc(len + 1);
+    if (copy == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while compiling\n");
+        return -1;
+    }
+    memcpy(copy, name, len);
+    copy[len] = '\0';
+    program->slot_names[program->slot_count] = copy;
+    parser->slot_index[i] = program->slot_count + 1;
+    *slot = (uint32_t)program->slot_count++;
+    return 0;
+}
+
+/**
+ * @brief Parse a literal into a new program constant
+ */
+static int add_constant(Parser* parser, const Token* tok, int negative, uint32_t* index) {
+    ClrlProgram* program = parser->program;
+    int fractional = memchr(tok->text, '.', tok->len) != NULL;
+    if (fractional && parser->larnum_statement) {
+        parse_error(parser, tok, "Invalid larnum literal");
+        return -1;
+    }
+    if (grow_array((void**)&program->constants, &program->constant_capacity,
+                   program->constant_count, sizeof(ClrlValue)) != 0) {
+        parser->failed = 1;
+        return -1;
+    }
+
+    ClrlValue* value = &program->constants[program->constant_count];
+    int status;
+    if (fractional) {
+        value->type = VAR_PRECISE;
+        precise_init(&value->value.precise_val);
+        status = precise_from_string(&value->value.precise_val, tok->text, tok->len);
+    } else {
+        value->type = VAR_LARNUM;
+        larnum_init(&value->value.larnum_val);
+        status = larnum_from_string(&value->value.larnum_val, tok->text, tok->len);
+    }
+    if (status != 0) {
+        larnum_free(&value->value.larnum_val);
+        parse_error(parser, tok, "Invalid numeric literal");
+        return -1;
+    }
+    // The coefficient sits at the start of both union members
+    Larnum* magnitude = &value->value.larnum_val;
+    if (negative && magnitude->size > 0) magnitude->negative = 1;
+    *index = (uint32_t)program->constant_count++;
+    return 0;
+}
+
+static int parse_expression(Parser* parser, uint32_t* operand);
+
+/**
+ * @brief Register to hold the result of an operator over a, b and c
+ *
+ * Operand registers are the top of the temporary stack, so they are
+ * released and the result takes the lowest of them.
+ */
+static uint32_t result_register(Parser* parser, uint32_t a, uint32_t b, uint32_t c) {
+    size_t base = parser->next_register;
+    if (CLRL_OPERAND_KIND(a) == CLRL_OPERAND_REG && CLRL_OPERAND_INDEX(a) < base) base = CLRL_OPERAND_INDEX(a);
+    if (CLRL_OPERAND_KIND(b) == CLRL_OPERAND_REG && CLRL_OPERAND_INDEX(b) < base) base = CLRL_OPERAND_INDEX(b);
+    if (CLRL_OPERAND_KIND(c) == CLRL_OPERAND_REG && CLRL_OPERAND_INDEX(c) < base) base = CLRL_OPERAND_INDEX(c);
+    parser->next_register = base + 1;
+    if (parser->next_register > parser->program->register_count) {
+        parser->program->register_count = parser->next_register;
+    }
+    return (uint32_t)base;
+}
+
+static int parse_unary(Parser* parser, uint32_t* operand);
+static int emit_binary(Parser* parser, const Token* op_tok, uint32_t lhs, uint32_t rhs, uint32_t* operand);
+
+/**
+ * @brief call := NAME '(' expr { ',' expr } ')' (the name is already read)
+ *
+ * sqrt(x) and root(x, n) compile to CLRL_OP_ROOT (sqrt with a literal 2),
+ * powmod(a, e, m) to CLRL_OP_POWMOD.
+ */
+static int parse_call(Parser* parser, const Token* name, uint32_t* operand) {
+    Lexer* lexer = &parser->lexer;
+    uint8_t op = CLRL_OP_ROOT;
+    int count;
+    if (token_is(name, "sqrt")) {
+        count = 1;
+    } else if (token_is(name, "root")) {
+        count = 2;
+    } else if (token_is(name, "powmod")) {
+        op = CLRL_OP_POWMOD;
+        count = 3;
+    } else {
+        parse_error(parser, name, "Unknown function");
+        return -1;
+    }
+    if (op == CLRL_OP_POWMOD && !parser->larnum_statement) {
+        parse_error(parser, name, "Function is not supported for precise values");
+        return -1;
+    }
+
+    uint32_t args[3];
+    for (int i = 0; i < count; i++) {
+        // The '(' before the first argument, ',' before the others
+        lexer_advance(lexer);
+        if (parse_expression(parser, &args[i]) != 0) return -1;
+        TokenType expected = (i < count - 1) ? TOK_COMMA : TOK_RPAREN;
+        if (lexer->current.type != expected) {
+            parse_error(parser, &lexer->current, (i < count - 1) ? "Expected ','" : "Expected ')'");
+            return -1;
+        }
+    }
+    lexer_advance(lexer);
+    if (count == 1) {
+        Token two = { TOK_NUMBER, "2", 1, name->line };
+        uint32_t index;
+        if (add_constant(parser, &two, 0, &index) != 0) return -1;
+        args[1] = CLRL_OPERAND(CLRL_OPERAND_CONST, index);
+    }
+
+    uint32_t dst = result_register(parser, args[0], args[1], (op == CLRL_OP_POWMOD) ? args[2] : args[1]);
+    // A root's precision is patched in with the divisions' once the '@' suffix is known
+    uint32_t imm = (op == CLRL_OP_POWMOD) ? args[2] : CLRL_PRECISION_GLOBAL;
+    if (emit(parser, op, parser->larnum_statement ? CLRL_FLAG_LARNUM_ONLY : 0, dst, args[0], args[1], imm) != 0) return -1;
+    *operand = CLRL_OPERAND(CLRL_OPERAND_REG, dst);
+    return 0;
+}
+
+/**
+ * @brief primary := NUMBER | NAME | call | '(' expr ')'
+ */
+static int parse_primary(Parser* parser, uint32_t* operand) {
+    Lexer* lexer = &parser->lexer;
+    Token tok = lexer->current;
+
+    if (tok.type == TOK_NUMBER) {
+        uint32_t index;
+        if (add_constant(parser, &tok, 0, &index) != 0) return -1;
+        lexer_advance(lexer);
+        *operand = CLRL_OPERAND(CLRL_OPERAND_CONST, index);
+        return 0;
+    }
+
+    if (tok.type == TOK_IDENT) {
+        lexer_advance(lexer);
+        // A name followed by '(' can only be a function call
+        if (lexer->current.type == TOK_LPAREN) return parse_call(parser, &tok, operand);
+        uint32_t slot;
+        if (resolve_slot(parser, tok.text, tok.len, &slot) != 0) {
+            parser->failed = 1;
+            return -1;
+        }
+        *operand = CLRL_OPERAND(CLRL_OPERAND_VAR, slot);
+        return 0;
+    }
+
+    if (tok.type == TOK_LPAREN) {
+        lexer_advance(lexer);
+        if (parse_expression(parser, operand) != 0) return -1;
+        if (lexer->current.type != TOK_RPAREN) {
+            parse_error(parser, &lexer->current, "Expected ')'");
+            return -1;
+        }
+        lexer_advance(lexer);
+        return 0;
+    }
+
+    parse_error(parser, &tok, "Expected a number, variable or '('");
+    return -1;
+}
+
+/**
+ * @brief One operand of a '^' chain with the signs in front of it
+ */
+typedef struct {
+    Token caret;             // The '^' before this operand (unused for the first)
+    uint32_t operand;
+    int negate;              // Odd number of '-' left to apply
+} PowerLevel;
+
+/**
+ * @brief unary := ('-'|'+') unary | power, power := primary ['^' unary]
+ *
+ * '^' binds tighter than a sign and groups from the right: -2^2 is -(2^2)
+ * and a^-b^c is a^(-(b^c)). Runs of signs and '^' chains are read in a
+ * loop rather than by recursion, so their length is not limited by the
+ * C stack; the operators are emitted from the right afterwards, in the
+ * same order a recursive parse would.
+ */
+static int parse_unary(Parser* parser, uint32_t* operand) {
+    Lexer* lexer = &parser->lexer;
+    PowerLevel* levels = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    Token caret = lexer->current;
+    int status = 0;
+
+    for (;;) {
+        if (grow_array((void**)&levels, &capacity, count, sizeof(PowerLevel)) != 0) {
+            status = -1;
+            break;
+        }
+        PowerLevel* level = &levels[count++];
+        level->caret = caret;
+        level->negate = 0;
+        TokenType last_sign = TOK_EOF;
+        while (lexer->current.type == TOK_PLUS || lexer->current.type == TOK_MINUS) {
+            if (lexer->current.type == TOK_MINUS) level->negate ^= 1;
+            last_sign = lexer->current.type;
+            lexer_advance(lexer);
+        }
+        if (last_sign != TOK_EOF && lexer->current.type == TOK_NUMBER) {
+            Token number = lexer->current;
+            lexer_advance(lexer);
+            // A sign directly in front of a literal becomes part of the constant
+            int folded = lexer->current.type != TOK_CARET && last_sign == TOK_MINUS;
+            uint32_t index;
+            if (add_constant(parser, &number, folded, &index) != 0) {
+                status = -1;
+                break;
+            }
+            level->operand = CLRL_OPERAND(CLRL_OPERAND_CONST, index);
+            level->negate ^= folded;
+        } else if (parse_primary(parser, &level->operand) != 0) {
+            status = -1;
+            break;
+        }
+        if (lexer->current.type != TOK_CARET) break;
+        caret = lexer->current;
+        lexer_advance(lexer);
+    }
+
+    // levels[i] is negate_i(operand_i ^ levels[i + 1])
+    uint32_t value = 0;
+    for (size_t i = count; i-- > 0 && status == 0;) {
+        if (i + 1 < count) {
+            status = emit_binary(parser, &levels[i + 1].caret, levels[i].operand, value, &value);
+        } else {
+            value = levels[i].operand;
+        }
+        if (status == 0 && levels[i].negate) {
+            uint32_t dst = result_register(parser, value, value, value);
+            status = emit(parser, CLRL_OP_NEG, parser->larnum_statement ? CLRL_FLAG_LARNUM_ONLY : 0,
+                          dst, value, value, 0);
+            value = CLRL_OPERAND(CLRL_OPERAND_REG, dst);
+        }
+    }
+    free(levels);
+    if (status == 0) *operand = value;
+    return status;
+}
+
+/**
+ * @brief Emit dst = lhs <op> rhs
+ */
+static int emit_binary(Parser* parser, const Token* op_tok, uint32_t lhs, uint32_t rhs, uint32_t* operand) {
+    uint8_t op;
+    switch (op_tok->type) {
+        case TOK_PLUS: op = CLRL_OP_ADD; break;
+        case TOK_MINUS: op = CLRL_OP_SUB; break;
+        case TOK_STAR: op = CLRL_OP_MUL; break;
+        case TOK_SLASH: op = CLRL_OP_DIV; break;
+        case TOK_SLASH_SLASH: op = CLRL_OP_IDIV; break;
+        case TOK_CARET: op = CLRL_OP_POW; break;
+        default: op = CLRL_OP_MOD; break;
+    }
+    if ((op == CLRL_OP_IDIV || op == CLRL_OP_MOD) && !parser->larnum_statement) {
+        parse_error(parser, op_tok, "Operator is not supported for precise values");
+        return -1;
+    }
+    uint32_t dst = result_register(parser, lhs, rhs, rhs);
+    // Division precision (used by negative powers too) is patched in once the statement's '@' suffix is known
+    if (emit(parser, op, parser->larnum_statement ? CLRL_FLAG_LARNUM_ONLY : 0,
+             dst, lhs, rhs, CLRL_PRECISION_GLOBAL) != 0) return -1;
+    *operand = CLRL_OPERAND(CLRL_OPERAND_REG, dst);
+    return 0;
+}
+
+/**
+ * @brief term := unary { ('*' | '/' | '//' | '%') unary }
+ */
+static int parse_term(Parser* parser, uint32_t* operand) {
+    Lexer* lexer = &parser->lexer;
+    if (parse_unary(parser, operand) != 0) return -1;
+    while (lexer->current.type == TOK_STAR || lexer->current.type == TOK_SLASH ||
+           lexer->current.type == TOK_SLASH_SLASH || lexer->current.type == TOK_PERCENT) {
+        Token op_tok = lexer->current;
+        lexer_advance(lexer);
+        uint32_t rhs;
+        if (parse_unary(parser, &rhs) != 0) return -1;
+        if (emit_binary(parser, &op_tok, *operand, rhs, operand) != 0) return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief expr := term { ('+' | '-') term }
+ *
+ * Parentheses and function arguments come back here, so this is where
+ * the nesting depth is bounded.
+ */
+static int parse_expression(Parser* parser, uint32_t* operand) {
+    Lexer* lexer = &parser->lexer;
+    if (parser->depth >= PARSER_MAX_DEPTH) {
+        parse_error(parser, &lexer->current, "Expression is nested too deeply");
+        return -1;
+    }
+    parser->depth++;
+    int status = parse_term(parser, operand);
+    while (status == 0 && (lexer->current.type == TOK_PLUS || lexer->current.type == TOK_MINUS)) {
+        Token op_tok = lexer->current;
+        lexer_advance(lexer);
+        uint32_t rhs;
+        status = parse_term(parser, &rhs);
+        if (status == 0) status = emit_binary(parser, &op_tok, *operand, rhs, operand);
+    }
+    parser->depth--;
+    return status;
+}
+
+/**
+ * @brief Read a non-negative integer argument such as a precision
+ */
+static int parse_digits_argument(Parser* parser, uint32_t* value) {
+    Token tok = parser->lexer.current;
+    if (tok.type != TOK_NUMBER || memchr(tok.text, '.', tok.len) != NULL) {
+        parse_error(parser, &tok, "Expected a number of digits");
+        return -1;
+    }
+    uint64_t digits = 0;
+    for (size_t i = 0; i < tok.len; i++) {
+        digits = digits * 10 + (uint64_t)(tok.text[i] - '0');
+        if (digits >= CLRL_PRECISION_GLOBAL) {
+            parse_error(parser, &tok, "Precision is too large");
+            return -1;
+        }
+    }
+    lexer_advance(&parser->lexer);
+    *value = (uint32_t)digits;
+    return 0;
+}
+
+/**
+ * @brief decl := ('larnum' | 'precise') NAME '=' expr ['@' digits]
+ */
+static int parse_definition(Parser* parser, int larnum) {
+    Lexer* lexer = &parser->lexer;
+    size_t first = parser->program->code_count;
+    parser->larnum_statement = larnum;
+    lexer_advance(lexer);
+
+    Token name = lexer->current;
+    if (name.type != TOK_IDENT) {
+        parse_error(parser, &name, "Expected a variable name");
+        return -1;
+    }
+    uint32_t slot;
+    if (resolve_slot(parser, name.text, name.len, &slot) != 0) {
+        parser->failed = 1;
+        return -1;
+    }
+    lexer_advance(lexer);
+    if (lexer->current.type != TOK_ASSIGN) {
+        parse_error(parser, &lexer->current, "Expected '='");
+        return -1;
+    }
+    lexer_advance(lexer);
+
+    uint32_t value;
+    if (parse_expression(parser, &value) != 0) return -1;
+
+    if (lexer->current.type == TOK_AT) {
+        lexer_advance(lexer);
+        uint32_t precision;
+        if (parse_digits_argument(parser, &precision) != 0) return -1;
+        for (size_t i = first; i < parser->program->code_count; i++) {
+            uint8_t op = parser->program->code[i].op;
+            if (op == CLRL_OP_DIV || op == CLRL_OP_POW || op == CLRL_OP_ROOT) parser->program->code[i].imm = precision;
+        }
+    }
+
+    uint8_t flags = larnum ? CLRL_FLAG_LARNUM_ONLY : CLRL_FLAG_TO_PRECISE;
+    return emit(parser, CLRL_OP_STORE, flags, slot, value, value, 0);
+}
+
+/**
+ * @brief return := 'return' NAME { ',' [NAME] }
+ */
+static int parse_return(Parser* parser) {
+    Lexer* lexer = &parser->lexer;
+    lexer_advance(lexer);
+    int count = 0;
+    for (;;) {
+        if (lexer->current.type == TOK_IDENT) {
+            uint32_t slot;
+            if (resolve_slot(parser, lexer->current.text, lexer->current.len, &slot) != 0) {
+                parser->failed = 1;
+                return -1;
+            }
+            if (emit(parser, CLRL_OP_RETURN, 0, 0, CLRL_OPERAND(CLRL_OPERAND_VAR, slot), 0, 0) != 0) return -1;
+            count++;
+            lexer_advance(lexer);
+        }
+        // Empty entries (return a,,b) are skipped
+        if (lexer->current.type != TOK_COMMA) break;
+        lexer_advance(lexer);
+    }
+    if (count == 0) {
+        parse_error(parser, &lexer->current, "No variable specified (e.g., 'return a')");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Parse one statement and record its instruction range
+ */
+static void parse_statement(Parser* parser) {
+    Lexer* lexer = &parser->lexer;
+    ClrlProgram* program = parser->program;
+    Token start = lexer->current;
+    size_t first = program->code_count;
+    parser->failed = 0;
+    parser->next_register = 0;
+
+    if (token_is(&start, "larnum") || token_is(&start, "precise")) {
+        parse_definition(parser, token_is(&start, "larnum"));
+    } else if (token_is(&start, "return")) {
+        parse_return(parser);
+    } else if (start.type == TOK_SYSTEM && start.len == 9 && memcmp(start.text, "precision", 9) == 0) {
+        lexer_advance(lexer);
+        uint32_t digits;
+        if (parse_digits_argument(parser, &digits) == 0) {
+            emit(parser, CLRL_OP_SET_PRECISION, 0, 0, 0, 0, digits);
+        }
+    } else if (start.type == TOK_SYSTEM) {
+        parse_error(parser, &start, "System command is not allowed in a script");
+    } else {
+        parse_error(parser, &start, "Invalid statement (expected larnum, precise or return)");
+    }
+
+    if (!parser->failed && lexer->current.type != TOK_NEWLINE && lexer->current.type != TOK_EOF) {
+        parse_error(parser, &lexer->current, "Unexpected text after statement");
+    }
+
+    if (parser->failed) {
+        // Drop the partial statement and resynchronize at the next line
+        program->code_count = first;
+        while (lexer->current.type != TOK_NEWLINE && lexer->current.type != TOK_EOF) {
+            lexer_advance(lexer);
+        }
+        return;
+    }
+
+    if (grow_array((void**)&program->statements, &program->statement_capacity,
+                   program->statement_count, sizeof(ClrlStatement)) != 0) {
+        parser->failed = 1;
+        program->code_count = first;
+        return;
+    }
+    ClrlStatement* statement = &program->statements[program->statement_count++];
+    statement->first = first;
+    statement->count = program->code_count - first;
+    statement->line = start.line;
+    statement->profile = clrl_profile_statement(parser->origin, start.line, start.text,
+                                                (size_t)(lexer->current.text - start.text));
+}
+
+int clrl_compile(ClrlProgram* program, const char* source, size_t len, const char* origin) {
+    Parser parser;
+    memset(&parser, 0, sizeof(parser));
+    parser.program = program;
+    parser.origin = origin;
+    parser.lexer.pos = source;
+    parser.lexer.end = source + len;
+    parser.lexer.line = 1;
+
+    // Names already known to the program keep their slots
+    if (reserve_slot_index(&parser, program->slot_count) != 0) return -1;
+
+    int errors = 0;
+    lexer_advance(&parser.lexer);
+    while (parser.lexer.current.type != TOK_EOF) {
+        if (parser.lexer.current.type == TOK_NEWLINE) {
+            lexer_advance(&parser.lexer);
+            continue;
+        }
+        parse_statement(&parser);
+        if (parser.failed) errors++;
+    }
+
+    free(parser.slot_index);
+    return (errors > 0) ? -1 : 0;
+}
@@ -0,0 +1,255 @@
+#include "../../include/clrl/clrl_context.h"
+#include "../../include/clrl/clrl_vm.h"
+#include "../../include/clrl/clrl_thread.h"
+#include <stdarg.h>
+
+/**
+ * Embedding contexts and error reporting
+ *
+ * Every error of the library goes through clrl_error. Normally it prints
+ * to stderr; a context installs its own log on the calling thread for the
+ * duration of a call, so its messages and status never reach another
+ * context. Parallel statement runs collect the errors of each statement
+ * on the worker and replay them on the calling thread (see
+ * clrl_schedule_run).
+ */
+
+struct ClrlContext {
+    VarTable table;              // Variables (nodes, names and values live in its arena)
+    size_t precision;            // Division precision (system:precision changes it)
+    ClrlOutputCapture output;    // Return output of the last eval
+    ClrlErrorLog errors;         // Messages of the last call
+};
+
+// ===================== Error reporting =====================
+
+// Log of the call running on this thread (NULL = print to stderr)
+static CLRL_THREAD_LOCAL ClrlErrorLog* error_log = NULL;
+
+/**
+ * @brief Append text to a log (dropped if the log cannot grow)
+ */
+static void log_append(ClrlErrorLog* log, const char* text, size_t len) {
+    if (log->len + len + 1 > log->capacity) {
+        size_t capacity = (log->capacity == 0) ? 256 : log->capacity;
+        while (capacity < log->len + len + 1) capacity *= 2;
+        char* grown = (char*)realloc(log->text, capacity);
+        if (grown == NULL) return;
+        log->text = grown;
+        log->capacity = capacity;
+    }
+    memcpy(log->text + log->len, text, len);
+    log->len += len;
+    log->text[log->len] = '\0';
+}
+
+void clrl_error(ClrlStatus status, const char* format, ...) {
+    ClrlErrorLog* log = error_log;
+    va_list args;
+    va_start(args, format);
+    if (log == NULL) {
+        vfprintf(stderr, format, args);
+        va_end(args);
+        return;
+    }
+    if (log->status == CLRL_OK) log->status = status;
+
+    // Messages are short; only names quoted in them can make one long
+    char small[256];
+    va_list again;
+    va_copy(again, args);
+    int len = vsnprintf(small, sizeof(small), format, args);
+    va_end(args);
+    if (len >= 0 && (size_t)len < sizeof(small)) {
+        log_append(log, small, (size_t)len);
+    } else if (len >= 0) {
+        char* text = (char*)malloc((size_t)len + 1);
+        if (text != NULL) {
+            vsnprintf(text, (size_t)len + 1, format, again);
+            log_append(log, text, (size_t)len);
+            free(text);
+        } else {
+            log_append(log, small, sizeof(small) - 1);
+        }
+    }
+    va_end(again);
+}
+
+ClrlErrorLog* clrl_error_capture(ClrlErrorLog* log) {
+    ClrlErrorLog* previous = error_log;
+    error_log = log;
+    return previous;
+}
+
+void clrl_error_replay(const ClrlErrorLog* log) {
+    if (log->len == 0) return;
+    ClrlErrorLog* target = error_log;
+    if (target == NULL) {
+        fwrite(log->text, 1, log->len, stderr);
+        return;
+    }
+    if (target->status == CLRL_OK) target->status = log->status;
+    log_append(target, log->text, log->len);
+}
+
+void clrl_error_log_free(ClrlErrorLog* log) {
+    free(log->text);
+    memset(log, 0, sizeof(*log));
+}
+
+const char* clrl_status_string(ClrlStatus status) {
+    switch (status) {
+        case CLRL_OK: return "success";
+        case CLRL_ERROR_SYNTAX: return "syntax error";
+        case CLRL_ERROR_UNDEFINED: return "undefined variable";
+        case CLRL_ERROR_TYPE: return "type error";
+        case CLRL_ERROR_DIVISION_BY_ZERO: return "division by zero";
+        case CLRL_ERROR_MEMORY: return "out of memory";
+        case CLRL_ERROR_IO: return "input/output error";
+        case CLRL_ERROR_ARGUMENT: return "invalid argument";
+        case CLRL_ERROR_BUFFER: return "buffer too small";
+        default: return "runtime error";
+    }
+}
+
+// ===================== Contexts =====================
+
+/**
+ * @brief Start a call: forget the last call's messages and collect new ones
+ *
+ * @return ClrlErrorLog* Log to restore with call_end
+ */
+static ClrlErrorLog* call_begin(ClrlContext* context) {
+    context->errors.status = CLRL_OK;
+    context->errors.len = 0;
+    if (context->errors.text != NULL) context->errors.text[0] = '\0';
+    return clrl_error_capture(&context->errors);
+}
+
+/**
+ * @brief Finish a call
+ *
+ * @param fallback Status of a failure that reported no message
+ * @return ClrlStatus Status of the first error, CLRL_OK if there was none
+ */
+static ClrlStatus call_end(ClrlContext* context, ClrlErrorLog* previous, int failed, ClrlStatus fallback) {
+    clrl_error_capture(previous);
+    if (context->errors.status == CLRL_OK && failed) context->errors.status = fallback;
+    return context->errors.status;
+}
+
+ClrlContext* clrl_context_create(void) {
+    ClrlContext* context = (ClrlContext*)calloc(1, sizeof(ClrlContext));
+    if (context == NULL) return NULL;
+    var_table_init(&context->table);
+    context->precision = DEFAULT_DIVISION_PRECISION;
+    return context;
+}
+
+void clrl_context_destroy(ClrlContext* context) {
+    if (context == NULL) return;
+    var_table_release(&context->table);
+    free(context->output.text);
+    clrl_error_log_free(&context->errors);
+    free(context);
+}
+
+ClrlStatus clrl_context_eval(ClrlContext* context, const char* source, size_t len) {
+    if (context == NULL || (source == NULL && len > 0)) return CLRL_ERROR_ARGUMENT;
+    ClrlErrorLog* previous_log = call_begin(context);
+    context->output.len = 0;
+    ClrlOutputCapture* previous_output = clrl_output_capture(&context->output);
+
+    ClrlProgram program;
+    clrl_program_init(&program);
+    ClrlStatus fallback = CLRL_ERROR_SYNTAX;
+    int status = clrl_compile(&program, (source != NULL) ? source : "", len, NULL);
+    if (status == 0) {
+        clrl_optimize(&program, 0);   // On failure the program runs as compiled
+        ClrlVm vm;
+        clrl_vm_init(&vm);
+        vm.precision = &context->precision;
+        fallback = CLRL_ERROR_RUNTIME;
+        status = clrl_vm_run(&vm, &program, &context->table);
+        clrl_vm_free(&vm);
+    }
+    clrl_program_free(&program);
+
+    clrl_output_capture(previous_output);
+    // The output is handed out as a C string
+    ClrlOutputCapture* output = &context->output;
+    if (output->len == output->capacity) {
+        char* grown = (char*)realloc(output->text, output->capacity + 1);
+        if (grown == NULL) {
+            clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for statement output\n");
+            output->len = 0;
+        } else {
+            output->text = grown;
+            output->capacity++;
+        }
+    }
+    if (output->text != NULL) output->text[output->len] = '\0';
+    return call_end(context, previous_log, status != 0, fallback);
+}
+
+ClrlStatus clrl_context_get(ClrlContext* context, const char* name, char* buffer, size_t size, size_t* needed) {
+    if (context == NULL || name == NULL || (buffer == NULL && size > 0)) return CLRL_ERROR_ARGUMENT;
+    ClrlErrorLog* previous = call_begin(context);
+    int failed = 0;
+    VarNode* node = var_table_find(&context->table, name, strlen(name));
+    if (node == NULL) {
+        clrl_error(CLRL_ERROR_UNDEFINED, "Error: Variable '%s' is not defined\n", name);
+    } else {
+        char* text = (node->type == VAR_LARNUM) ? larnum_to_string(&node->value.larnum_val)
+                                                : precise_to_string(&node->value.precise_val);
+        failed = (text == NULL);
+        if (text != NULL) {
+            size_t text_size = strlen(text) + 1;
+            if (needed != NULL) *needed = text_size;
+            if (text_size > size) {
+                clrl_error(CLRL_ERROR_BUFFER, "Error: Value of '%s' needs %zu bytes (buffer has %zu)\n",
+                           name, text_size, size);
+            } else {
+                memcpy(buffer, text, text_size);
+            }
+            free(text);
+        }
+    }
+    return call_end(context, previous, failed, CLRL_ERROR_MEMORY);
+}
+
+int clrl_context_is_precise(const ClrlContext* context, const char* name) {
+    if (context == NULL || name == NULL) return -1;
+    const VarNode* node = var_table_find(&context->table, name, strlen(name));
+    if (node == NULL) return -1;
+    return node->type == VAR_PRECISE;
+}
+
+void clrl_context_clear(ClrlContext* context) {
+    if (context == NULL) return;
+    var_table_clear(&context->table);
+}
+
+void clrl_context_set_precision(ClrlContext* context, size_t digits) {
+    if (context != NULL) context->precision = digits;
+}
+
+size_t clrl_context_get_precision(const ClrlContext* context) {
+    return (context != NULL) ? context->precision : DEFAULT_DIVISION_PRECISION;
+}
+
+const char* clrl_context_output(const ClrlContext* context, size_t* len) {
+    int empty = (context == NULL || context->output.text == NULL);
+    if (len != NULL) *len = empty ? 0 : context->output.len;
+    return empty ? "" : context->output.text;
+}
+
+const char* clrl_context_error(const ClrlContext* context) {
+    if (context == NULL || context->errors.text == NULL) return "";
+    return context->errors.text;
+}
+
+void clrl_context_thread_release(void) {
+    clrl_mem_trim();
+    clrl_arena_release(clrl_scratch_arena());
+}
@@ -0,0 +1,279 @@
+#include "../../include/clrl/clrl_larnum.h"
+#include "../../include/clrl/clrl_profile.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_backend.h"
+#include "clrl_limbs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Larnum division subsystem
+ *
+ * Small divisors or short quotients use Knuth algorithm D. When both the
+ * divisor and the quotient are large, the quotient comes from a Newton-Raphson
+ * reciprocal built on the fast multiplication engine and is then corrected
+ * against the exact remainder, so the cost is a small multiple of M(n).
+ */
+
+// Divisor and quotient size (in limbs) above which Newton division is used
+#define DEFAULT_DIV_NEWTON_THRESHOLD 800
+
+// Reciprocals up to this many bits are computed directly with Knuth D
+#define RECIPROCAL_BASE_BITS 2048
+
+// Extra bits carried through every Newton step to keep the error bounded
+#define RECIPROCAL_GUARD_BITS 16
+
+static size_t div_newton_threshold = DEFAULT_DIV_NEWTON_THRESHOLD;
+
+size_t larnum_get_div_threshold(void) {
+    return div_newton_threshold;
+}
+
+int larnum_set_div_threshold(size_t limbs) {
+    if (limbs < 2) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Invalid division threshold\n");
+        return -1;
+    }
+    div_newton_threshold = limbs;
+    return 0;
+}
+
+/**
+ * @brief Magnitude division with Knuth D: q = |a| / |b|, r = |a| % |b| (|a| >= |b|)
+ */
+static int divmod_schoolbook(Larnum* q, Larnum* r, const Larnum* a, const Larnum* b) {
+    size_t an = a->size;
+    size_t bn = b->size;
+    if (larnum_reserve(q, an - bn + 1) != 0 || larnum_reserve(r, bn) != 0) return -1;
+
+    if (bn == 1) {
+        r->limbs[0] = limbs_divmod_1(q->limbs, a->limbs, an, b->limbs[0]);
+    } else if (limbs_divmod_basecase(q->limbs, r->limbs, a->limbs, an, b->limbs, bn) != 0) {
+        return -1;
+    }
+    q->size = limbs_normalize(q->limbs, an - bn + 1);
+    q->negative = 0;
+    r->size = limbs_normalize(r->limbs, bn);
+    r->negative = 0;
+    return 0;
+}
+
+/**
+ * @brief q = a / d, r = a % d for a single-limb divisor, without scratch buffers
+ *
+ * q and r may alias a; either can be NULL.
+ */
+static int divmod_limb(Larnum* q, Larnum* r, const Larnum* a, LarnumLimb d, int q_negative, int r_negative) {
+    size_t an = a->size;
+    LarnumLimb remainder;
+    uint64_t started = clrl_profiling() ? clrl_profile_now() : 0;
+    if (q != NULL) {
+        // reserve keeps the value, so q may be a itself
+        if (larnum_reserve(q, an) != 0) return -1;
+        if (q != a && an > 0) memcpy(q->limbs, a->limbs, an * sizeof(LarnumLimb));
+        remainder = limbs_divmod_1(q->limbs, q->limbs, an, d);
+        q->size = limbs_normalize(q->limbs, an);
+        q->negative = (q->size > 0) ? q_negative : 0;
+    } else {
+        LarnumDoubleLimb rem = 0;
+        for (size_t i = an; i > 0; i--) {
+            rem = ((rem << LARNUM_LIMB_BITS) | a->limbs[i - 1]) % d;
+        }
+        remainder = (LarnumLimb)rem;
+    }
+    if (started != 0) clrl_profile_op(CLRL_PROFILE_DIV_SCHOOLBOOK, an, 1, started);
+    if (r != NULL) return larnum_set_small(r, remainder, 0, r_negative);
+    return 0;
+}
+
+/**
+ * @brief x ~= floor(2^(m+p) / d) where m is the bit length of d (d > 0)
+ *
+ * Precision doubling: the reciprocal at p bits is one Newton step from the
+ * reciprocal at p/2 + guard bits. Only the top p + 32 bits of d are used.
+ * The result is within a couple of units of the exact value.
+ */
+static int reciprocal(Larnum* x, const Larnum* d, size_t p) {
+    size_t m = larnum_bit_length(d);
+    size_t cut = (m > p + 32) ? m - (p + 32) : 0;
+    size_t mt = m - cut;
+    Larnum dt, y, t;
+    larnum_init(&dt);
+    larnum_init(&y);
+    larnum_init(&t);
+    int status = -1;
+
+    if (larnum_shr(&dt, d, cut) != 0) goto done;
+    dt.negative = 0;
+
+    if (p <= RECIPROCAL_BASE_BITS) {
+        // Small enough for one exact schoolbook division
+        if (larnum_set_int(&t, 1) != 0 || larnum_shl(&t, &t, mt + p) != 0) goto done;
+        if (divmod_schoolbook(x, &y, &t, &dt) != 0) goto done;
+        status = 0;
+        goto done;
+    }
+
+    // y ~= 2^(mt+h) / dt, then x = 2y * 2^(p-h) - dt * y^2 / 2^(mt+2h-p)
+    size_t h = p / 2 + RECIPROCAL_GUARD_BITS;
+    if (reciprocal(&y, &dt, h) != 0) goto done;
+    if (larnum_sqr(&t, &y) != 0 ||
+        larnum_mul(&t, &t, &dt) != 0 ||
+        larnum_shr(&t, &t, mt + 2 * h - p) != 0) goto done;
+    if (larnum_shl(x, &y, p - h + 1) != 0 ||
+        larnum_sub(x, x, &t) != 0) goto done;
+    status = 0;
+
+done:
+    larnum_free(&dt);
+    larnum_free(&y);
+    larnum_free(&t);
+    return status;
+}
+
+/**
+ * @brief Magnitude division through a Newton reciprocal (|a| >= |b|)
+ *
+ * The estimate from the reciprocal is at most a few units off and is fixed
+ * up with the exact remainder r = a - q*b.
+ */
+static int divmod_newton(Larnum* q, Larnum* r, const Larnum* a, const Larnum* b) {
+    size_t abits = larnum_bit_length(a);
+    size_t m = larnum_bit_length(b);
+    size_t p = abits - m + 10;      // quotient bits plus guard bits
+    size_t cut = (abits > p + 32) ? abits - (p + 32) : 0;
+    Larnum x, t, one;
+    larnum_init(&x);
+    larnum_init(&t);
+    larnum_init(&one);
+    int status = -1;
+
+    if (reciprocal(&x, b, p) != 0) goto done;
+
+    // q = (a >> cut) * x >> (m + p - cut)
+    if (larnum_shr(&t, a, cut) != 0) goto done;
+    t.negative = 0;
+    if (larnum_mul(q, &t, &x) != 0 ||
+        larnum_shr(q, q, m + p - cut) != 0) goto done;
+
+    // r = a - q*b, then correct the estimate
+    if (larnum_mul(&t, q, b) != 0) goto done;
+    t.negative = 0;
+    if (larnum_copy(r, a) != 0) goto done;
+    r->negative = 0;
+    if (larnum_sub(r, r, &t) != 0 || larnum_set_int(&one, 1) != 0) goto done;
+    while (r->negative) {
+        if (larnum_sub(q, q, &one) != 0 || larnum_add(r, r, b) != 0) goto done;
+    }
+    while (larnum_cmp_abs(r, b) >= 0) {
+        if (larnum_add(q, q, &one) != 0 || larnum_sub(r, r, b) != 0) goto done;
+    }
+    status = 0;
+
+done:
+    larnum_free(&x);
+    larnum_free(&t);
+    larnum_free(&one);
+    return status;
+}
+
+int larnum_divmod(Larnum* q, Larnum* r, const Larnum* a, const Larnum* b) {
+    LARNUM_BACKEND_CALL(divmod, a->size, q, r, a, b);
+    if (b->size == 0) {
+        clrl_error(CLRL_ERROR_DIVISION_BY_ZERO, "Error: Division by zero\n");
+        return -1;
+    }
+
+    int q_negative = a->negative != b->negative;
+    int r_negative = a->negative;
+
+    // |a| < |b|: quotient is zero and the remainder is the dividend
+    if (larnum_cmp_abs(a, b) < 0) {
+        if (r != NULL && larnum_copy(r, a) != 0) return -1;
+        if (q != NULL) {
+            q->size = 0;
+            q->negative = 0;
+        }
+        return 0;
+    }
+
+    // Native path: |b| <= |a| < 2^64
+    if (a->size <= LIMBS_SMALL) {
+        uint64_t x = larnum_get_small(a);
+        uint64_t y = larnum_get_small(b);
+        uint64_t quotient = x / y;
+        uint64_t remainder = x % y;
+        if (q != NULL && larnum_set_small(q, quotient, 0, q_negative) != 0) return -1;
+        if (r != NULL && larnum_set_small(r, remainder, 0, r_negative) != 0) return -1;
+        return 0;
+    }
+    // Single-limb divisor: the quotient is produced in place
+    if (b->size == 1) return divmod_limb(q, r, a, b->limbs[0], q_negative, r_negative);
+
+    // Work on magnitudes through shallow views of the operands
+    Larnum abs_a = *a;
+    Larnum abs_b = *b;
+    abs_a.negative = 0;
+    abs_b.negative = 0;
+
+    Larnum quot, rem;
+    larnum_init(&quot);
+    larnum_init(&rem);
+    size_t qn = a->size - b->size + 1;
+    int status;
+    int newton = b->size >= div_newton_threshold && qn >= div_newton_threshold;
+    uint64_t started = clrl_profiling() ? clrl_profile_now() : 0;
+    if (newton) {
+        status = divmod_newton(&quot, &rem, &abs_a, &abs_b);
+    } else {
+        status = divmod_schoolbook(&quot, &rem, &abs_a, &abs_b);
+    }
+    if (started != 0) {
+        clrl_profile_op(newton ? CLRL_PROFILE_DIV_NEWTON : CLRL_PROFILE_DIV_SCHOOLBOOK, a->size, b->size, started);
+    }
+    if (status != 0) {
+        larnum_free(&quot);
+        larnum_free(&rem);
+        return -1;
+    }
+
+    quot.negative = (quot.size > 0) ? q_negative : 0;
+    rem.negative = (rem.size > 0) ? r_negative : 0;
+
+    // Assign results only after both are computed (q/r may alias a/b)
+    if (q != NULL) {
+        larnum_free(q);
+        *q = quot;
+    } else {
+        larnum_free(&quot);
+    }
+    if (r != NULL) {
+        larnum_free(r);
+        *r = rem;
+    } else {
+        larnum_free(&rem);
+    }
+    return 0;
+}
+
+int larnum_div_scaled(Larnum* q, const Larnum* a, const Larnum* b, size_t digits) {
+    if (b->size == 0) {
+        clrl_error(CLRL_ERROR_DIVISION_BY_ZERO, "Error: Division by zero\n");
+        return -1;
+    }
+    if (digits == 0) return larnum_divmod(q, NULL, a, b);
+
+    // q = trunc(a * 10^digits / b)
+    Larnum scaled;
+    larnum_init(&scaled);
+    if (larnum_pow10(&scaled, digits) != 0 ||
+        larnum_mul(&scaled, &scaled, a) != 0 ||
+        larnum_divmod(q, NULL, &scaled, b) != 0) {
+        larnum_free(&scaled);
+        return -1;
+    }
+    larnum_free(&scaled);
+    return 0;
+}
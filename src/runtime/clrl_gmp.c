@@ -0,0 +1,194 @@
+#include "../../include/clrl/clrl_larnum.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_backend.h"
+#include "clrl_limbs.h"
+#include <gmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * GMP backend (CMake option CLRL_WITH_GMP, selected with CLRL_BACKEND=gmp)
+ *
+ * Operands are imported into mpz_t values, the GMP function runs, and the
+ * result is exported back into the larnum's limbs (from the runtime heap
+ * pool, like every other result). The two copies are linear, so only
+ * operations that cost more than linear time go through GMP: parsing,
+ * printing, multiplication, division, powers and roots, and only from
+ * GMP_MIN_LIMBS limbs up. Addition, subtraction and comparison are a
+ * single pass over the limbs either way and keep the built-in kernels.
+ *
+ * GMP's own temporaries use its default allocator: mp_set_memory_functions
+ * is process-wide and would also change how a program embedding the
+ * library uses GMP.
+ */
+
+// Operands below this size are cheaper to compute than to copy into GMP
+#define GMP_MIN_LIMBS 32
+
+/**
+ * @brief z = x
+ */
+static void mpz_from_larnum(mpz_t z, const Larnum* x) {
+    mpz_import(z, x->size, -1, sizeof(LarnumLimb), 0, 0, x->limbs);
+    if (x->negative) mpz_neg(z, z);
+}
+
+/**
+ * @brief x = z (x may be one of the operands z was computed from)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+static int mpz_to_larnum(Larnum* x, const mpz_t z) {
+    if (mpz_sgn(z) == 0) {
+        x->size = 0;
+        x->negative = 0;
+        return 0;
+    }
+    size_t count = (mpz_sizeinbase(z, 2) + LARNUM_LIMB_BITS - 1) / LARNUM_LIMB_BITS;
+    if (larnum_reserve(x, count) != 0) return -1;
+    mpz_export(x->limbs, &count, -1, sizeof(LarnumLimb), 0, 0, z);
+    x->size = count;
+    x->negative = mpz_sgn(z) < 0;
+    return 0;
+}
+
+static int gmp_from_string(Larnum* x, const char* str, size_t len) {
+    // Invalid text is reported by the built-in parser
+    size_t pos = (len > 0 && (str[0] == '+' || str[0] == '-')) ? 1 : 0;
+    if (pos == len || decimal_span(str + pos, len - pos) != len - pos) return LARNUM_BACKEND_DECLINED;
+
+    // mpz_set_str wants a NUL-terminated string without '+'
+    char* text = (char*)malloc(len - pos + 2);
+    if (text == NULL) return -1;
+    size_t used = 0;
+    if (str[0] == '-') text[used++] = '-';
+    memcpy(text + used, str + pos, len - pos);
+    text[used + len - pos] = '\0';
+
+    mpz_t z;
+    mpz_init(z);
+    int status = (mpz_set_str(z, text, 10) == 0) ? mpz_to_larnum(x, z) : -1;
+    mpz_clear(z);
+    free(text);
+    return status;
+}
+
+static char* gmp_to_string(const Larnum* x) {
+    mpz_t z;
+    mpz_init(z);
+    mpz_from_larnum(z, x);
+    // Sign, digits (mpz_sizeinbase may overestimate by one) and NUL
+    char* text = (char*)malloc(mpz_sizeinbase(z, 10) + 2);
+    if (text == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while printing larnum\n");
+    } else {
+        mpz_get_str(text, 10, z);
+    }
+    mpz_clear(z);
+    return text;
+}
+
+static int gmp_mul(Larnum* r, const Larnum* a, const Larnum* b) {
+    mpz_t x, y;
+    mpz_init(x);
+    mpz_from_larnum(x, a);
+    if (a == b) {
+        mpz_mul(x, x, x);
+        mpz_init(y);
+    } else {
+        mpz_init(y);
+        mpz_from_larnum(y, b);
+        mpz_mul(x, x, y);
+    }
+    int status = mpz_to_larnum(r, x);
+    mpz_clear(x);
+    mpz_clear(y);
+    return status;
+}
+
+static int gmp_divmod(Larnum* q, Larnum* r, const Larnum* a, const Larnum* b) {
+    // Division by zero is reported by the built-in kernel
+    if (b->size == 0) return LARNUM_BACKEND_DECLINED;
+    mpz_t x, y, quotient, remainder;
+    mpz_init(x);
+    mpz_init(y);
+    mpz_init(quotient);
+    mpz_init(remainder);
+    mpz_from_larnum(x, a);
+    mpz_from_larnum(y, b);
+    // Truncated, like C: the remainder takes the sign of the dividend
+    mpz_tdiv_qr(quotient, remainder, x, y);
+    int status = 0;
+    if (q != NULL) status = mpz_to_larnum(q, quotient);
+    if (status == 0 && r != NULL) status = mpz_to_larnum(r, remainder);
+    mpz_clear(x);
+    mpz_clear(y);
+    mpz_clear(quotient);
+    mpz_clear(remainder);
+    return status;
+}
+
+static int gmp_pow(Larnum* r, const Larnum* a, const Larnum* e) {
+    // Negative and oversized exponents are reported by the built-in kernel
+    if (e->negative || e->size > LIMBS_SMALL) return LARNUM_BACKEND_DECLINED;
+    uint64_t exponent = larnum_get_small(e);
+    size_t bits = larnum_bit_length(a);
+    if (exponent > (uint64_t)(unsigned long)-1 || (bits > 1 && exponent > (uint64_t)(SIZE_MAX / 2) / bits)) {
+        return LARNUM_BACKEND_DECLINED;
+    }
+    mpz_t x;
+    mpz_init(x);
+    mpz_from_larnum(x, a);
+    mpz_pow_ui(x, x, (unsigned long)exponent);
+    int status = mpz_to_larnum(r, x);
+    mpz_clear(x);
+    return status;
+}
+
+static int gmp_powmod(Larnum* r, const Larnum* a, const Larnum* e, const Larnum* m) {
+    if (m->size == 0 || e->negative) return LARNUM_BACKEND_DECLINED;
+    mpz_t x, y, z;
+    mpz_init(x);
+    mpz_init(y);
+    mpz_init(z);
+    mpz_from_larnum(x, a);
+    mpz_from_larnum(y, e);
+    mpz_from_larnum(z, m);
+    mpz_abs(x, x);
+    mpz_abs(z, z);
+    mpz_powm(x, x, y, z);
+    // Same sign as (a ^ e) % m: negative for a negative base and an odd exponent
+    if (a->negative && mpz_odd_p(y)) mpz_neg(x, x);
+    int status = mpz_to_larnum(r, x);
+    mpz_clear(x);
+    mpz_clear(y);
+    mpz_clear(z);
+    return status;
+}
+
+static int gmp_root(Larnum* r, const Larnum* a, const Larnum* n) {
+    // Invalid degrees and even roots of negative numbers are reported by the built-in kernel
+    if (n->negative || n->size != 1 || (a->negative && (n->limbs[0] & 1u) == 0)) return LARNUM_BACKEND_DECLINED;
+    mpz_t x;
+    mpz_init(x);
+    mpz_from_larnum(x, a);
+    mpz_root(x, x, n->limbs[0]);   // Truncated towards zero
+    int status = mpz_to_larnum(r, x);
+    mpz_clear(x);
+    return status;
+}
+
+const LarnumBackend larnum_gmp_backend = {
+    "gmp", GMP_MIN_LIMBS,
+    gmp_from_string,
+    gmp_to_string,
+    NULL,            // add
+    NULL,            // sub
+    gmp_mul,
+    gmp_divmod,
+    gmp_pow,
+    gmp_powmod,
+    gmp_root,
+    NULL             // cmp
+};
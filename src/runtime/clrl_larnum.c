@@ -0,0 +1,418 @@
+#include "../../include/clrl/clrl_larnum.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_backend.h"
+#include "clrl_limbs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ===================== Low-level limb kernels =====================
+
+int limbs_cmp(const LarnumLimb* a, const LarnumLimb* b, size_t n) {
+    while (n > 0) {
+        n--;
+        if (a[n] != b[n]) return (a[n] > b[n]) ? 1 : -1;
+    }
+    return 0;
+}
+
+// limbs_add_n and limbs_sub_n are the vector kernels in clrl_simd.c
+
+LarnumLimb limbs_add(LarnumLimb* r, const LarnumLimb* a, size_t an, const LarnumLimb* b, size_t bn) {
+    LarnumLimb carry = limbs_add_n(r, a, b, bn);
+    size_t i = bn;
+    for (; i < an && carry != 0; i++) {
+        LarnumLimb v = a[i] + carry;
+        carry = (v < carry) ? 1 : 0;
+        r[i] = v;
+    }
+    // Once the carry is absorbed the rest of a is copied unchanged
+    if (r != a && i < an) memmove(r + i, a + i, (an - i) * sizeof(LarnumLimb));
+    return carry;
+}
+
+LarnumLimb limbs_sub(LarnumLimb* r, const LarnumLimb* a, size_t an, const LarnumLimb* b, size_t bn) {
+    LarnumLimb borrow = limbs_sub_n(r, a, b, bn);
+    size_t i = bn;
+    for (; i < an && borrow != 0; i++) {
+        LarnumLimb v = a[i];
+        r[i] = v - borrow;
+        borrow = (v < borrow) ? 1 : 0;
+    }
+    if (r != a && i < an) memmove(r + i, a + i, (an - i) * sizeof(LarnumLimb));
+    return borrow;
+}
+
+LarnumLimb limbs_mul_1(LarnumLimb* r, const LarnumLimb* a, size_t n, LarnumLimb m) {
+    LarnumDoubleLimb carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += (LarnumDoubleLimb)a[i] * m;
+        r[i] = (LarnumLimb)carry;
+        carry >>= LARNUM_LIMB_BITS;
+    }
+    return (LarnumLimb)carry;
+}
+
+LarnumLimb limbs_addmul_1(LarnumLimb* r, const LarnumLimb* a, size_t n, LarnumLimb m) {
+    LarnumDoubleLimb carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += (LarnumDoubleLimb)a[i] * m + r[i];
+        r[i] = (LarnumLimb)carry;
+        carry >>= LARNUM_LIMB_BITS;
+    }
+    return (LarnumLimb)carry;
+}
+
+LarnumLimb limbs_submul_1(LarnumLimb* r, const LarnumLimb* a, size_t n, LarnumLimb m) {
+    LarnumDoubleLimb borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        LarnumDoubleLimb prod = (LarnumDoubleLimb)a[i] * m + borrow;
+        LarnumLimb low = (LarnumLimb)prod;
+        borrow = prod >> LARNUM_LIMB_BITS;
+        if (r[i] < low) borrow++;
+        r[i] -= low;
+    }
+    return (LarnumLimb)borrow;
+}
+
+LarnumLimb limbs_divmod_1(LarnumLimb* q, const LarnumLimb* a, size_t n, LarnumLimb d) {
+    LarnumDoubleLimb rem = 0;
+    while (n > 0) {
+        n--;
+        LarnumDoubleLimb cur = (rem << LARNUM_LIMB_BITS) | a[n];
+        q[n] = (LarnumLimb)(cur / d);
+        rem = cur % d;
+    }
+    return (LarnumLimb)rem;
+}
+
+void limbs_mul_basecase(LarnumLimb* r, const LarnumLimb* a, size_t an, const LarnumLimb* b, size_t bn) {
+    r[an] = limbs_mul_1(r, a, an, b[0]);
+    for (size_t i = 1; i < bn; i++) {
+        r[an + i] = limbs_addmul_1(r + i, a, an, b[i]);
+    }
+}
+
+static int leading_zero_bits(LarnumLimb x) {
+    int n = 0;
+    if (x == 0) return LARNUM_LIMB_BITS;
+    while ((x & 0x80000000u) == 0) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief r[0..n) = a << shift, return the bits shifted out (0 < shift < 32)
+ */
+static LarnumLimb limbs_lshift(LarnumLimb* r, const LarnumLimb* a, size_t n, int shift) {
+    LarnumLimb out = a[n - 1] >> (LARNUM_LIMB_BITS - shift);
+    for (size_t i = n - 1; i > 0; i--) {
+        r[i] = (a[i] << shift) | (a[i - 1] >> (LARNUM_LIMB_BITS - shift));
+    }
+    r[0] = a[0] << shift;
+    return out;
+}
+
+/**
+ * @brief r[0..n) = a >> shift (0 < shift < 32)
+ */
+static void limbs_rshift(LarnumLimb* r, const LarnumLimb* a, size_t n, int shift) {
+    for (size_t i = 0; i + 1 < n; i++) {
+        r[i] = (a[i] >> shift) | (a[i + 1] << (LARNUM_LIMB_BITS - shift));
+    }
+    r[n - 1] = a[n - 1] >> shift;
+}
+
+int limbs_divmod_basecase(LarnumLimb* q, LarnumLimb* r,
+                          const LarnumLimb* a, size_t an,
+                          const LarnumLimb* b, size_t bn) {
+    // Normalize so the top bit of the divisor is set (Knuth Vol.2 4.3.1)
+    int shift = leading_zero_bits(b[bn - 1]);
+    LarnumLimb* buf = (LarnumLimb*)clrl_mem_alloc((an + 1 + bn) * sizeof(LarnumLimb));
+    if (buf == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed in larnum division\n");
+        return -1;
+    }
+    LarnumLimb* un = buf;
+    LarnumLimb* vn = buf + an + 1;
+
+    if (shift > 0) {
+        un[an] = limbs_lshift(un, a, an, shift);
+        limbs_lshift(vn, b, bn, shift);
+    } else {
+        memcpy(un, a, an * sizeof(LarnumLimb));
+        un[an] = 0;
+        memcpy(vn, b, bn * sizeof(LarnumLimb));
+    }
+
+    LarnumDoubleLimb base = (LarnumDoubleLimb)1 << LARNUM_LIMB_BITS;
+    LarnumLimb vtop = vn[bn - 1];
+    LarnumLimb vnext = vn[bn - 2];
+
+    for (size_t jj = an - bn + 1; jj > 0; jj--) {
+        size_t j = jj - 1;
+        LarnumDoubleLimb num = ((LarnumDoubleLimb)un[j + bn] << LARNUM_LIMB_BITS) | un[j + bn - 1];
+        LarnumDoubleLimb qhat = num / vtop;
+        LarnumDoubleLimb rhat = num % vtop;
+
+        // Refine the estimate so it is at most one too large
+        while (qhat >= base ||
+               qhat * vnext > ((rhat << LARNUM_LIMB_BITS) | un[j + bn - 2])) {
+            qhat--;
+            rhat += vtop;
+            if (rhat >= base) break;
+        }
+
+        LarnumLimb borrow = limbs_submul_1(un + j, vn, bn, (LarnumLimb)qhat);
+        LarnumLimb top = un[j + bn];
+        un[j + bn] = top - borrow;
+        if (top < borrow) {
+            // Estimate was one too large: add the divisor back
+            qhat--;
+            un[j + bn] += limbs_add_n(un + j, un + j, vn, bn);
+        }
+        if (q != NULL) q[j] = (LarnumLimb)qhat;
+    }
+
+    if (r != NULL) {
+        if (shift > 0) {
+            limbs_rshift(r, un, bn, shift);
+        } else {
+            memcpy(r, un, bn * sizeof(LarnumLimb));
+        }
+    }
+    clrl_mem_free(buf);
+    return 0;
+}
+
+// ===================== Larnum object management =====================
+
+void larnum_init(Larnum* x) {
+    x->limbs = NULL;
+    x->size = 0;
+    x->capacity = 0;
+    x->negative = 0;
+}
+
+void larnum_free(Larnum* x) {
+    if (x == NULL) return;
+    // Borrowed storage (capacity 0) belongs to someone else
+    if (x->capacity > 0) clrl_mem_free(x->limbs);
+    larnum_init(x);
+}
+
+int larnum_reserve(Larnum* x, size_t limbs) {
+    if (limbs <= x->capacity) return 0;
+    // Grow geometrically so repeated appends stay amortized O(1)
+    size_t new_capacity = (x->capacity * 3) / 2;
+    if (new_capacity < limbs) new_capacity = limbs;
+    LarnumLimb* grown = (LarnumLimb*)clrl_mem_alloc(new_capacity * sizeof(LarnumLimb));
+    if (grown == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for larnum (%zu limbs)\n", limbs);
+        return -1;
+    }
+    // Owned buffers keep their whole contents, borrowed ones only the value
+    size_t keep = (x->capacity > 0) ? x->capacity : x->size;
+    if (keep > 0) memcpy(grown, x->limbs, keep * sizeof(LarnumLimb));
+    if (x->capacity > 0) clrl_mem_free(x->limbs);
+    x->limbs = grown;
+    x->capacity = clrl_mem_usable_size(grown) / sizeof(LarnumLimb);
+    return 0;
+}
+
+int larnum_copy(Larnum* dst, const Larnum* src) {
+    if (dst == src) return 0;
+    if (larnum_reserve(dst, src->size) != 0) return -1;
+    if (src->size > 0) {
+        memcpy(dst->limbs, src->limbs, src->size * sizeof(LarnumLimb));
+    }
+    dst->size = src->size;
+    dst->negative = src->negative;
+    return 0;
+}
+
+int larnum_set_int(Larnum* x, long long value) {
+    unsigned long long magnitude = (value < 0) ? 0ULL - (unsigned long long)value
+                                               : (unsigned long long)value;
+    if (larnum_reserve(x, 2) != 0) return -1;
+    x->limbs[0] = (LarnumLimb)magnitude;
+    x->limbs[1] = (LarnumLimb)(magnitude >> LARNUM_LIMB_BITS);
+    x->size = limbs_normalize(x->limbs, 2);
+    x->negative = (value < 0) ? 1 : 0;
+    return 0;
+}
+
+int larnum_set_small(Larnum* x, uint64_t low, uint64_t high, int negative) {
+    size_t n = (high != 0) ? 4 : 2;
+    if (larnum_reserve(x, n) != 0) return -1;
+    x->limbs[0] = (LarnumLimb)low;
+    x->limbs[1] = (LarnumLimb)(low >> LARNUM_LIMB_BITS);
+    if (n == 4) {
+        x->limbs[2] = (LarnumLimb)high;
+        x->limbs[3] = (LarnumLimb)(high >> LARNUM_LIMB_BITS);
+    }
+    x->size = limbs_normalize(x->limbs, n);
+    x->negative = (x->size > 0) ? negative : 0;
+    return 0;
+}
+
+int larnum_is_zero(const Larnum* x) {
+    return x->size == 0;
+}
+
+// ===================== Signed arithmetic =====================
+
+int larnum_cmp_abs(const Larnum* a, const Larnum* b) {
+    if (a->size != b->size) return (a->size > b->size) ? 1 : -1;
+    return limbs_cmp(a->limbs, b->limbs, a->size);
+}
+
+int larnum_cmp(const Larnum* a, const Larnum* b) {
+    const LarnumBackend* backend = larnum_backend();
+    if (backend->cmp != NULL && a->size >= backend->min_limbs && b->size >= backend->min_limbs) {
+        return backend->cmp(a, b);
+    }
+    if (a->negative != b->negative) return a->negative ? -1 : 1;
+    int cmp = larnum_cmp_abs(a, b);
+    return a->negative ? -cmp : cmp;
+}
+
+/**
+ * @brief r = a + (b_negative ? -|b| : |b|), shared by add and sub
+ */
+static int larnum_add_signed(Larnum* r, const Larnum* a, const Larnum* b, int b_negative) {
+    // Native path: both magnitudes fit 64 bits, the carry becomes the high word
+    if (a->size <= LIMBS_SMALL && b->size <= LIMBS_SMALL) {
+        uint64_t x = larnum_get_small(a);
+        uint64_t y = larnum_get_small(b);
+        if (a->negative == b_negative) {
+            uint64_t sum = x + y;
+            return larnum_set_small(r, sum, (sum < x) ? 1 : 0, b_negative);
+        }
+        if (x >= y) return larnum_set_small(r, x - y, 0, a->negative);
+        return larnum_set_small(r, y - x, 0, b_negative);
+    }
+
+    // Order operands by magnitude so the limb kernels see an >= bn
+    const Larnum* big = a;
+    const Larnum* small = b;
+    int big_negative = a->negative;
+    int small_negative = b_negative;
+    if (larnum_cmp_abs(a, b) < 0) {
+        big = b;
+        small = a;
+        big_negative = b_negative;
+        small_negative = a->negative;
+    }
+    size_t bn = big->size;
+    size_t sn = small->size;
+
+    if (larnum_reserve(r, bn + 1) != 0) return -1;
+    // r may alias a or b; the struct is shared, so re-read pointers after reserve
+    const LarnumLimb* bl = big->limbs;
+    const LarnumLimb* sl = small->limbs;
+
+    if (big_negative == small_negative) {
+        LarnumLimb carry = (bn > 0) ? limbs_add(r->limbs, bl, bn, sl, sn) : 0;
+        r->limbs[bn] = carry;
+        r->size = bn + (carry ? 1 : 0);
+    } else {
+        if (bn > 0) limbs_sub(r->limbs, bl, bn, sl, sn);
+        r->size = limbs_normalize(r->limbs, bn);
+    }
+    r->negative = (r->size > 0) ? big_negative : 0;
+    return 0;
+}
+
+int larnum_add(Larnum* r, const Larnum* a, const Larnum* b) {
+    LARNUM_BACKEND_CALL(add, (a->size > b->size) ? a->size : b->size, r, a, b);
+    return larnum_add_signed(r, a, b, b->negative);
+}
+
+int larnum_sub(Larnum* r, const Larnum* a, const Larnum* b) {
+    LARNUM_BACKEND_CALL(sub, (a->size > b->size) ? a->size : b->size, r, a, b);
+    return larnum_add_signed(r, a, b, (b->size > 0) ? !b->negative : 0);
+}
+
+// ===================== Shifts and powers =====================
+
+size_t larnum_bit_length(const Larnum* x) {
+    if (x->size == 0) return 0;
+    return x->size * LARNUM_LIMB_BITS - (size_t)leading_zero_bits(x->limbs[x->size - 1]);
+}
+
+int larnum_shl(Larnum* r, const Larnum* a, size_t bits) {
+    if (a->size == 0) {
+        r->size = 0;
+        r->negative = 0;
+        return 0;
+    }
+    size_t limb_shift = bits / LARNUM_LIMB_BITS;
+    int bit_shift = (int)(bits % LARNUM_LIMB_BITS);
+    size_t an = a->size;
+    int negative = a->negative;
+
+    if (larnum_reserve(r, an + limb_shift + 1) != 0) return -1;
+    // Work from the top down so r may alias a
+    LarnumLimb* rl = r->limbs;
+    const LarnumLimb* al = a->limbs;
+    if (bit_shift > 0) {
+        rl[an + limb_shift] = limbs_lshift(rl + limb_shift, al, an, bit_shift);
+    } else {
+        memmove(rl + limb_shift, al, an * sizeof(LarnumLimb));
+        rl[an + limb_shift] = 0;
+    }
+    memset(rl, 0, limb_shift * sizeof(LarnumLimb));
+    r->size = limbs_normalize(rl, an + limb_shift + 1);
+    r->negative = negative;
+    return 0;
+}
+
+int larnum_shr(Larnum* r, const Larnum* a, size_t bits) {
+    size_t limb_shift = bits / LARNUM_LIMB_BITS;
+    int bit_shift = (int)(bits % LARNUM_LIMB_BITS);
+    if (limb_shift >= a->size) {
+        r->size = 0;
+        r->negative = 0;
+        return 0;
+    }
+    size_t n = a->size - limb_shift;
+    int negative = a->negative;
+
+    if (larnum_reserve(r, n) != 0) return -1;
+    // Work from the bottom up so r may alias a
+    if (bit_shift > 0) {
+        limbs_rshift(r->limbs, a->limbs + limb_shift, n, bit_shift);
+    } else {
+        memmove(r->limbs, a->limbs + limb_shift, n * sizeof(LarnumLimb));
+    }
+    r->size = limbs_normalize(r->limbs, n);
+    r->negative = (r->size > 0) ? negative : 0;
+    return 0;
+}
+
+int larnum_pow10(Larnum* r, size_t exponent) {
+    // Binary powering: O(M(n)) thanks to the fast squaring kernels
+    Larnum base, result;
+    larnum_init(&base);
+    larnum_init(&result);
+    if (larnum_set_int(&base, 10) != 0 || larnum_set_int(&result, 1) != 0) goto fail;
+    while (exponent > 0) {
+        if (exponent & 1) {
+            if (larnum_mul(&result, &result, &base) != 0) goto fail;
+        }
+        exponent >>= 1;
+        if (exponent > 0 && larnum_sqr(&base, &base) != 0) goto fail;
+    }
+    larnum_free(&base);
+    larnum_free(r);
+    *r = result;
+    return 0;
+
+fail:
+    larnum_free(&base);
+    larnum_free(&result);
+    return -1;
+}
@@ -0,0 +1,126 @@
+#ifndef CLRL_LIMBS_H
+#define CLRL_LIMBS_H
+
+/**
+ * @brief Internal low-level limb kernels shared by the runtime modules
+ *
+ * These functions work on raw little-endian limb arrays and never allocate.
+ * Unless stated otherwise, the result buffer may alias the first operand.
+ */
+
+#include "../../include/clrl/clrl_larnum.h"
+#include "../../include/clrl/clrl_memory.h"
+
+/**
+ * @brief Strip high zero limbs and return the normalized length
+ */
+static inline size_t limbs_normalize(const LarnumLimb* a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) n--;
+    return n;
+}
+
+/**
+ * @brief Compare two n-limb magnitudes (-1, 0, 1)
+ */
+int limbs_cmp(const LarnumLimb* a, const LarnumLimb* b, size_t n);
+
+/**
+ * @brief r[0..n) = a + b, return carry (vector kernel, clrl_simd.c)
+ */
+LarnumLimb limbs_add_n(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n);
+
+/**
+ * @brief r[0..an) = a + b (an >= bn), return carry
+ */
+LarnumLimb limbs_add(LarnumLimb* r, const LarnumLimb* a, size_t an, const LarnumLimb* b, size_t bn);
+
+/**
+ * @brief r[0..n) = a - b, return borrow (vector kernel, clrl_simd.c)
+ */
+LarnumLimb limbs_sub_n(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n);
+
+/**
+ * @brief r[0..an) = a - b (an >= bn), return borrow
+ */
+LarnumLimb limbs_sub(LarnumLimb* r, const LarnumLimb* a, size_t an, const LarnumLimb* b, size_t bn);
+
+/**
+ * @brief Number of leading ASCII digits in str[0..len) (vector scan, clrl_simd.c)
+ */
+size_t decimal_span(const char* str, size_t len);
+
+/**
+ * @brief r[0..n) = a * m, return the high limb
+ */
+LarnumLimb limbs_mul_1(LarnumLimb* r, const LarnumLimb* a, size_t n, LarnumLimb m);
+
+/**
+ * @brief r[0..n) += a * m, return the high limb
+ */
+LarnumLimb limbs_addmul_1(LarnumLimb* r, const LarnumLimb* a, size_t n, LarnumLimb m);
+
+/**
+ * @brief r[0..n) -= a * m, return the borrow limb
+ */
+LarnumLimb limbs_submul_1(LarnumLimb* r, const LarnumLimb* a, size_t n, LarnumLimb m);
+
+/**
+ * @brief q[0..n) = a / d, return a % d (q may alias a)
+ */
+LarnumLimb limbs_divmod_1(LarnumLimb* q, const LarnumLimb* a, size_t n, LarnumLimb d);
+
+/**
+ * @brief Schoolbook product r[0..an+bn) = a * b (r must not alias a or b)
+ */
+void limbs_mul_basecase(LarnumLimb* r, const LarnumLimb* a, size_t an, const LarnumLimb* b, size_t bn);
+
+/**
+ * @brief Product r[0..an+bn) = a * b through the tiered engine (clrl_mul.c)
+ *
+ * r must not alias a or b.
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int limbs_mul(LarnumLimb* r, const LarnumLimb* a, size_t an, const LarnumLimb* b, size_t bn);
+
+/**
+ * @brief Square r[0..2n) = a * a through the tiered engine (r must not alias a)
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int limbs_sqr(LarnumLimb* r, const LarnumLimb* a, size_t n);
+
+/**
+ * @brief Knuth algorithm D: q[0..an-bn+1) = a / b, r[0..bn) = a % b
+ *
+ * Requires an >= bn >= 2 and b[bn-1] != 0. q or r can be NULL.
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+int limbs_divmod_basecase(LarnumLimb* q, LarnumLimb* r,
+                          const LarnumLimb* a, size_t an,
+                          const LarnumLimb* b, size_t bn);
+
+// ===================== Native small values =====================
+
+// Magnitudes of at most this many limbs fit a uint64_t
+#define LIMBS_SMALL 2
+
+/**
+ * @brief Magnitude of x as a native integer (x->size <= LIMBS_SMALL)
+ */
+static inline uint64_t larnum_get_small(const Larnum* x) {
+    uint64_t value = 0;
+    if (x->size > 1) value = (uint64_t)x->limbs[1] << LARNUM_LIMB_BITS;
+    if (x->size > 0) value |= x->limbs[0];
+    return value;
+}
+
+/**
+ * @brief x = (negative ? -1 : 1) * (high * 2^64 + low), no allocation if x has room
+ *
+ * Used by the native fast paths; x may alias the operands they read from.
+ */
+int larnum_set_small(Larnum* x, uint64_t low, uint64_t high, int negative);
+
+#endif // CLRL_LIMBS_H
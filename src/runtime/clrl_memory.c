@@ -0,0 +1,301 @@
+#include "../../include/clrl/clrl_memory.h"
+#include "../../include/clrl/clrl_thread.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Runtime memory subsystem
+ *
+ * The heap pool backs limb and digit buffers. Blocks carry a small header
+ * with their size class, so they can be freed without the caller knowing
+ * the size. Freed blocks are cached on per-thread free lists and reused by
+ * the next allocation of the same class, which removes most malloc/free
+ * traffic from the evaluation loop. Statistics are shared atomics.
+ *
+ * Arenas serve memory whose lifetime is tied to a table or a statement:
+ * bump allocation from geometrically growing blocks, optional size-class
+ * reuse and an O(1)-ish reset that keeps the largest block.
+ */
+
+// ===================== Heap Pool =====================
+
+// Pooled block sizes (header included) are 2^HEAP_MIN_SHIFT .. 2^HEAP_MAX_SHIFT
+#define HEAP_MIN_SHIFT 5
+#define HEAP_MAX_SHIFT 20
+#define HEAP_CLASSES (HEAP_MAX_SHIFT - HEAP_MIN_SHIFT + 1)
+
+// Class index stored in the header of blocks that bypass the pool
+#define HEAP_LARGE_CLASS HEAP_CLASSES
+
+// Upper bound on the bytes one thread keeps cached per class
+#define HEAP_CACHE_BYTES_PER_CLASS (4u << 20)
+
+/**
+ * @brief Header in front of every heap pool block (keeps the payload aligned)
+ */
+typedef union {
+    struct {
+        size_t usable;   // Bytes available to the caller
+        size_t cls;      // Size class, HEAP_LARGE_CLASS for plain malloc blocks
+    } info;
+    void* next;          // Free list link while the block is cached
+    unsigned char align[16];
+} HeapHeader;
+
+static CLRL_THREAD_LOCAL HeapHeader* heap_free_lists[HEAP_CLASSES];
+static CLRL_THREAD_LOCAL size_t heap_cached[HEAP_CLASSES];
+
+static ClrlMemStats heap_stats;
+
+// Allocations of the calling thread, so concurrent threads do not count towards each other
+static CLRL_THREAD_LOCAL size_t thread_alloc_count;
+static CLRL_THREAD_LOCAL size_t thread_alloc_bytes;
+
+static void stats_add_live(ClrlMemStats* stats, size_t bytes) {
+    size_t live = __atomic_add_fetch(&stats->live_bytes, bytes, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&stats->peak_bytes, __ATOMIC_RELAXED);
+    while (live > peak &&
+           !__atomic_compare_exchange_n(&stats->peak_bytes, &peak, live, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * @brief Smallest pooled class whose block holds `bytes` plus the header
+ */
+static size_t heap_class(size_t bytes) {
+    size_t total = bytes + sizeof(HeapHeader);
+    size_t cls = 0;
+    while (((size_t)1 << (cls + HEAP_MIN_SHIFT)) < total) cls++;
+    return cls;
+}
+
+void* clrl_mem_alloc(size_t bytes) {
+    HeapHeader* header;
+    size_t cls = (bytes <= ((size_t)1 << HEAP_MAX_SHIFT) - sizeof(HeapHeader))
+                     ? heap_class(bytes) : HEAP_LARGE_CLASS;
+    size_t usable;
+
+    if (cls < HEAP_CLASSES && heap_free_lists[cls] != NULL) {
+        header = heap_free_lists[cls];
+        heap_free_lists[cls] = (HeapHeader*)header->next;
+        heap_cached[cls]--;
+        usable = ((size_t)1 << (cls + HEAP_MIN_SHIFT)) - sizeof(HeapHeader);
+        __atomic_add_fetch(&heap_stats.reuse_count, 1, __ATOMIC_RELAXED);
+    } else {
+        usable = (cls < HEAP_CLASSES) ? ((size_t)1 << (cls + HEAP_MIN_SHIFT)) - sizeof(HeapHeader) : bytes;
+        header = (HeapHeader*)malloc(sizeof(HeapHeader) + usable);
+        if (header == NULL) return NULL;
+        __atomic_add_fetch(&heap_stats.reserved_bytes, sizeof(HeapHeader) + usable, __ATOMIC_RELAXED);
+    }
+
+    header->info.usable = usable;
+    header->info.cls = cls;
+    __atomic_add_fetch(&heap_stats.alloc_count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&heap_stats.alloc_bytes, usable, __ATOMIC_RELAXED);
+    thread_alloc_count++;
+    thread_alloc_bytes += usable;
+    stats_add_live(&heap_stats, usable);
+    return header + 1;
+}
+
+void clrl_mem_free(void* ptr) {
+    if (ptr == NULL) return;
+    HeapHeader* header = (HeapHeader*)ptr - 1;
+    size_t cls = header->info.cls;
+    size_t usable = header->info.usable;
+    __atomic_sub_fetch(&heap_stats.live_bytes, usable, __ATOMIC_RELAXED);
+
+    size_t block = sizeof(HeapHeader) + usable;
+    if (cls < HEAP_CLASSES && (heap_cached[cls] + 1) * block <= HEAP_CACHE_BYTES_PER_CLASS) {
+        header->next = heap_free_lists[cls];
+        heap_free_lists[cls] = header;
+        heap_cached[cls]++;
+        return;
+    }
+    __atomic_sub_fetch(&heap_stats.reserved_bytes, block, __ATOMIC_RELAXED);
+    free(header);
+}
+
+size_t clrl_mem_usable_size(const void* ptr) {
+    return ((const HeapHeader*)ptr - 1)->info.usable;
+}
+
+void clrl_mem_trim(void) {
+    for (size_t cls = 0; cls < HEAP_CLASSES; cls++) {
+        size_t block = (size_t)1 << (cls + HEAP_MIN_SHIFT);
+        while (heap_free_lists[cls] != NULL) {
+            HeapHeader* header = heap_free_lists[cls];
+            heap_free_lists[cls] = (HeapHeader*)header->next;
+            __atomic_sub_fetch(&heap_stats.reserved_bytes, block, __ATOMIC_RELAXED);
+            free(header);
+        }
+        heap_cached[cls] = 0;
+    }
+}
+
+void clrl_mem_get_stats(ClrlMemStats* stats) {
+    stats->live_bytes = __atomic_load_n(&heap_stats.live_bytes, __ATOMIC_RELAXED);
+    stats->peak_bytes = __atomic_load_n(&heap_stats.peak_bytes, __ATOMIC_RELAXED);
+    stats->reserved_bytes = __atomic_load_n(&heap_stats.reserved_bytes, __ATOMIC_RELAXED);
+    stats->alloc_count = __atomic_load_n(&heap_stats.alloc_count, __ATOMIC_RELAXED);
+    stats->alloc_bytes = __atomic_load_n(&heap_stats.alloc_bytes, __ATOMIC_RELAXED);
+    stats->reuse_count = __atomic_load_n(&heap_stats.reuse_count, __ATOMIC_RELAXED);
+}
+
+void clrl_mem_get_thread_allocs(size_t* count, size_t* bytes) {
+    *count = thread_alloc_count;
+    *bytes = thread_alloc_bytes;
+}
+
+// ===================== Arena =====================
+
+// Size of the first block; later blocks double up to ARENA_MAX_GROWTH
+#define ARENA_FIRST_BLOCK (64 * 1024)
+#define ARENA_MAX_GROWTH (64 * 1024 * 1024)
+
+// Alignment of every arena allocation and smallest pool class (2^4 bytes)
+#define ARENA_ALIGN 16
+#define ARENA_MIN_SHIFT 4
+
+struct ClrlArenaBlock {
+    ClrlArenaBlock* next;   // Older block
+    size_t used;            // Bytes handed out from data
+    size_t size;            // Capacity of data
+    unsigned char* data;    // Payload (follows the header)
+};
+
+static ClrlArenaBlock* arena_new_block(ClrlArena* arena, size_t bytes) {
+    size_t size = ARENA_FIRST_BLOCK;
+    if (arena->blocks != NULL) {
+        size = arena->blocks->size * 2;
+        if (size > ARENA_MAX_GROWTH) size = ARENA_MAX_GROWTH;
+    }
+    if (size < bytes) size = bytes;
+
+    size_t header = (sizeof(ClrlArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ClrlArenaBlock* block = (ClrlArenaBlock*)malloc(header + size);
+    if (block == NULL) return NULL;
+    block->next = arena->blocks;
+    block->used = 0;
+    block->size = size;
+    block->data = (unsigned char*)block + header;
+    arena->blocks = block;
+    arena->stats.reserved_bytes += header + size;
+    return block;
+}
+
+static void arena_free_block(ClrlArena* arena, ClrlArenaBlock* block) {
+    size_t header = (sizeof(ClrlArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    arena->stats.reserved_bytes -= header + block->size;
+    free(block);
+}
+
+void clrl_arena_init(ClrlArena* arena) {
+    memset(arena, 0, sizeof(*arena));
+}
+
+void* clrl_arena_alloc(ClrlArena* arena, size_t bytes) {
+    bytes = (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ClrlArenaBlock* block = arena->blocks;
+    if (block == NULL || block->size - block->used < bytes) {
+        block = arena_new_block(arena, bytes);
+        if (block == NULL) return NULL;
+    }
+    void* ptr = block->data + block->used;
+    block->used += bytes;
+    arena->stats.alloc_count++;
+    arena->stats.alloc_bytes += bytes;
+    arena->stats.live_bytes += bytes;
+    if (arena->stats.live_bytes > arena->stats.peak_bytes) {
+        arena->stats.peak_bytes = arena->stats.live_bytes;
+    }
+    return ptr;
+}
+
+size_t clrl_arena_pool_size(size_t bytes) {
+    size_t shift = ARENA_MIN_SHIFT;
+    while (((size_t)1 << shift) < bytes && shift < ARENA_MIN_SHIFT + CLRL_POOL_CLASSES - 1) shift++;
+    size_t size = (size_t)1 << shift;
+    // Requests beyond the largest class are served exactly and never pooled
+    return (size < bytes) ? bytes : size;
+}
+
+void* clrl_arena_pool_alloc(ClrlArena* arena, size_t bytes) {
+    size_t size = clrl_arena_pool_size(bytes);
+    size_t cls = 0;
+    while (cls < CLRL_POOL_CLASSES && ((size_t)1 << (cls + ARENA_MIN_SHIFT)) != size) cls++;
+
+    if (cls < CLRL_POOL_CLASSES && arena->free_lists[cls] != NULL) {
+        void* ptr = arena->free_lists[cls];
+        arena->free_lists[cls] = *(void**)ptr;
+        arena->stats.alloc_count++;
+        arena->stats.reuse_count++;
+        arena->stats.alloc_bytes += size;
+        arena->stats.live_bytes += size;
+        if (arena->stats.live_bytes > arena->stats.peak_bytes) {
+            arena->stats.peak_bytes = arena->stats.live_bytes;
+        }
+        return ptr;
+    }
+    return clrl_arena_alloc(arena, size);
+}
+
+void clrl_arena_pool_free(ClrlArena* arena, void* ptr, size_t bytes) {
+    if (ptr == NULL) return;
+    size_t size = clrl_arena_pool_size(bytes);
+    arena->stats.live_bytes -= (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    size_t cls = 0;
+    while (cls < CLRL_POOL_CLASSES && ((size_t)1 << (cls + ARENA_MIN_SHIFT)) != size) cls++;
+    if (cls == CLRL_POOL_CLASSES) return;   // Oversized chunks wait for the reset
+    *(void**)ptr = arena->free_lists[cls];
+    arena->free_lists[cls] = ptr;
+}
+
+ClrlArenaMark clrl_arena_mark(const ClrlArena* arena) {
+    ClrlArenaMark mark;
+    mark.block = arena->blocks;
+    mark.used = (arena->blocks != NULL) ? arena->blocks->used : 0;
+    mark.live_bytes = arena->stats.live_bytes;
+    return mark;
+}
+
+void clrl_arena_rewind(ClrlArena* arena, ClrlArenaMark mark) {
+    while (arena->blocks != NULL && arena->blocks != mark.block) {
+        ClrlArenaBlock* next = arena->blocks->next;
+        arena_free_block(arena, arena->blocks);
+        arena->blocks = next;
+    }
+    if (arena->blocks != NULL) arena->blocks->used = mark.used;
+    arena->stats.live_bytes = mark.live_bytes;
+}
+
+void clrl_arena_reset(ClrlArena* arena) {
+    ClrlArenaBlock* keep = arena->blocks;
+    if (keep != NULL) {
+        // Blocks grow geometrically, so the newest one is normally the largest
+        ClrlArenaBlock* block = keep->next;
+        while (block != NULL) {
+            ClrlArenaBlock* next = block->next;
+            arena_free_block(arena, block);
+            block = next;
+        }
+        keep->next = NULL;
+        keep->used = 0;
+    }
+    memset(arena->free_lists, 0, sizeof(arena->free_lists));
+    arena->stats.live_bytes = 0;
+}
+
+void clrl_arena_release(ClrlArena* arena) {
+    clrl_arena_reset(arena);
+    if (arena->blocks != NULL) arena_free_block(arena, arena->blocks);
+    arena->blocks = NULL;
+}
+
+static CLRL_THREAD_LOCAL ClrlArena scratch_arena;
+
+ClrlArena* clrl_scratch_arena(void) {
+    return &scratch_arena;
+}
@@ -0,0 +1,887 @@
+#include "../../include/clrl/clrl_larnum.h"
+#include "../../include/clrl/clrl_thread.h"
+#include "../../include/clrl/clrl_profile.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_backend.h"
+#include "clrl_limbs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Tiered multiplication engine behind the larnum `*` operator
+ *
+ *   schoolbook  <  karatsuba_threshold limbs
+ *   Karatsuba   <  toom3_threshold limbs
+ *   Toom-3      <  ntt_threshold limbs
+ *   NTT         otherwise (two-prime number-theoretic transform)
+ *
+ * Every tier has a squaring variant that is used when both operands are
+ * the same number. Once operands are large enough, the independent
+ * sub-products of Karatsuba and Toom-3, the two NTT primes and the
+ * butterflies of each transform run on the thread pool; smaller products
+ * never touch it.
+ */
+
+// Default crossover points in limbs (tuned on x86-64 with GCC -O2)
+#define DEFAULT_KARATSUBA_THRESHOLD 32
+#define DEFAULT_TOOM3_THRESHOLD     350
+#define DEFAULT_NTT_THRESHOLD       3000
+
+// Smallest sub-product (limbs) worth handing to another thread
+#define PARALLEL_MUL_MIN_LIMBS 1024
+
+// Smallest transform length (coefficients) split across threads, and the
+// butterflies per chunk
+#define NTT_PARALLEL_MIN_LEN (1u << 14)
+#define NTT_PARALLEL_GRAIN   (1u << 12)
+
+static LarnumMulThresholds mul_thresholds = {
+    DEFAULT_KARATSUBA_THRESHOLD,
+    DEFAULT_TOOM3_THRESHOLD,
+    DEFAULT_NTT_THRESHOLD
+};
+
+void larnum_get_mul_thresholds(LarnumMulThresholds* out) {
+    if (out != NULL) *out = mul_thresholds;
+}
+
+int larnum_set_mul_thresholds(const LarnumMulThresholds* thresholds) {
+    if (thresholds == NULL) {
+        mul_thresholds.karatsuba_threshold = DEFAULT_KARATSUBA_THRESHOLD;
+        mul_thresholds.toom3_threshold = DEFAULT_TOOM3_THRESHOLD;
+        mul_thresholds.ntt_threshold = DEFAULT_NTT_THRESHOLD;
+        return 0;
+    }
+    // Karatsuba splits need at least 2 limbs per half; Toom-3 needs 3 pieces
+    if (thresholds->karatsuba_threshold < 4 ||
+        thresholds->toom3_threshold < 9 ||
+        thresholds->ntt_threshold < 2) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Invalid multiplication thresholds\n");
+        return -1;
+    }
+    mul_thresholds = *thresholds;
+    return 0;
+}
+
+static void* mul_alloc(size_t limbs) {
+    void* p = clrl_mem_alloc((limbs > 0 ? limbs : 1) * sizeof(LarnumLimb));
+    if (p == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed in larnum multiplication\n");
+    }
+    return p;
+}
+
+// ===================== Schoolbook squaring =====================
+
+static void limbs_sqr_basecase(LarnumLimb* r, const LarnumLimb* a, size_t n) {
+    memset(r, 0, 2 * n * sizeof(LarnumLimb));
+
+    // Off-diagonal products a[i]*a[j] (i < j), each computed once
+    for (size_t i = 0; i + 1 < n; i++) {
+        r[i + n] = limbs_addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+
+    // Double them
+    LarnumLimb carry = 0;
+    for (size_t i = 0; i < 2 * n; i++) {
+        LarnumLimb v = r[i];
+        r[i] = (v << 1) | carry;
+        carry = v >> (LARNUM_LIMB_BITS - 1);
+    }
+
+    // Add the diagonal squares a[i]^2
+    LarnumDoubleLimb acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        LarnumDoubleLimb sq = (LarnumDoubleLimb)a[i] * a[i];
+        acc += (LarnumDoubleLimb)r[2 * i] + (LarnumLimb)sq;
+        r[2 * i] = (LarnumLimb)acc;
+        acc >>= LARNUM_LIMB_BITS;
+        acc += (LarnumDoubleLimb)r[2 * i + 1] + (LarnumLimb)(sq >> LARNUM_LIMB_BITS);
+        r[2 * i + 1] = (LarnumLimb)acc;
+        acc >>= LARNUM_LIMB_BITS;
+    }
+}
+
+// ===================== Karatsuba =====================
+
+static int limbs_mul_n(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n);
+static int limbs_sqr_n(LarnumLimb* r, const LarnumLimb* a, size_t n);
+
+/**
+ * @brief Balanced sub-product r[0..2n) = a * b (b == NULL squares a)
+ */
+typedef struct {
+    LarnumLimb* r;
+    const LarnumLimb* a;
+    const LarnumLimb* b;
+    size_t n;
+    int status;
+} LimbsProduct;
+
+static void limbs_product_run(void* arg) {
+    LimbsProduct* job = (LimbsProduct*)arg;
+    job->status = (job->b == NULL) ? limbs_sqr_n(job->r, job->a, job->n)
+                                   : limbs_mul_n(job->r, job->a, job->b, job->n);
+}
+
+/**
+ * @brief Run independent sub-products, in parallel when they are large
+ *
+ * @return int 0 if all succeeded, -1 otherwise
+ */
+static int limbs_products_run(LimbsProduct* jobs, size_t count) {
+    ClrlTask tasks[3];
+    int parallel = clrl_parallel_worthwhile(jobs[0].n, PARALLEL_MUL_MIN_LIMBS);
+    for (size_t i = 1; i < count; i++) {
+        if (parallel) {
+            clrl_task_fork(&tasks[i], limbs_product_run, &jobs[i]);
+        } else {
+            limbs_product_run(&jobs[i]);
+        }
+    }
+    limbs_product_run(&jobs[0]);
+    int status = jobs[0].status;
+    for (size_t i = count; i-- > 1;) {
+        if (parallel) clrl_task_join(&tasks[i]);
+        status |= jobs[i].status;
+    }
+    return status;
+}
+
+/**
+ * @brief Add the Karatsuba middle term p = (a0+a1)(b0+b1) - z0 - z2 into r at limb h
+ */
+static void karatsuba_combine(LarnumLimb* r, size_t n, size_t h, size_t l, LarnumLimb* p) {
+    size_t plen = 2 * (l + 1);
+    limbs_sub(p, p, plen, r, 2 * h);          // - z0
+    limbs_sub(p, p, plen, r + 2 * h, 2 * l);  // - z2
+    plen = limbs_normalize(p, plen);
+    if (plen > 0) limbs_add(r + h, r + h, 2 * n - h, p, plen);
+}
+
+/**
+ * @brief r[0..2n) = a * b with one level of Karatsuba
+ *
+ * a = a1*B^h + a0, b = b1*B^h + b0; three half-size products instead of four
+ */
+static int limbs_mul_karatsuba(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n) {
+    size_t h = n / 2;
+    size_t l = n - h;
+    LarnumLimb* tmp = (LarnumLimb*)mul_alloc(4 * (l + 1));
+    if (tmp == NULL) return -1;
+    LarnumLimb* sa = tmp;
+    LarnumLimb* sb = tmp + (l + 1);
+    LarnumLimb* p = tmp + 2 * (l + 1);
+
+    sa[l] = limbs_add(sa, a + h, l, a, h);
+    sb[l] = limbs_add(sb, b + h, l, b, h);
+
+    // z0, z2 and the middle product write disjoint buffers
+    LimbsProduct jobs[3] = {
+        { p, sa, sb, l + 1, 0 },
+        { r, a, b, h, 0 },
+        { r + 2 * h, a + h, b + h, l, 0 }
+    };
+    int status = limbs_products_run(jobs, 3);
+    if (status == 0) karatsuba_combine(r, n, h, l, p);
+    clrl_mem_free(tmp);
+    return status;
+}
+
+static int limbs_sqr_karatsuba(LarnumLimb* r, const LarnumLimb* a, size_t n) {
+    size_t h = n / 2;
+    size_t l = n - h;
+    LarnumLimb* tmp = (LarnumLimb*)mul_alloc(3 * (l + 1));
+    if (tmp == NULL) return -1;
+    LarnumLimb* sa = tmp;
+    LarnumLimb* p = tmp + (l + 1);
+
+    sa[l] = limbs_add(sa, a + h, l, a, h);
+
+    LimbsProduct jobs[3] = {
+        { p, sa, NULL, l + 1, 0 },
+        { r, a, NULL, h, 0 },
+        { r + 2 * h, a + h, NULL, l, 0 }
+    };
+    int status = limbs_products_run(jobs, 3);
+    if (status == 0) karatsuba_combine(r, n, h, l, p);
+    clrl_mem_free(tmp);
+    return status;
+}
+
+// ===================== Toom-3 =====================
+
+/**
+ * @brief Non-owning larnum view of a limb range (must never be freed)
+ */
+static Larnum larnum_view(const LarnumLimb* limbs, size_t n) {
+    Larnum v;
+    v.limbs = (LarnumLimb*)limbs;
+    v.size = limbs_normalize(limbs, n);
+    v.capacity = 0;
+    v.negative = 0;
+    return v;
+}
+
+/**
+ * @brief x = x / d for a small d that is known to divide x exactly
+ */
+static void larnum_divexact_small(Larnum* x, LarnumLimb d) {
+    if (x->size == 0) return;
+    limbs_divmod_1(x->limbs, x->limbs, x->size, d);
+    x->size = limbs_normalize(x->limbs, x->size);
+    if (x->size == 0) x->negative = 0;
+}
+
+/**
+ * @brief Point product r = a * b of Toom-3 (b == NULL squares a)
+ */
+typedef struct {
+    Larnum* r;
+    const Larnum* a;
+    const Larnum* b;
+    int status;
+} PointProduct;
+
+static void point_product_run(void* arg) {
+    PointProduct* job = (PointProduct*)arg;
+    job->status = (job->b == NULL) ? larnum_sqr(job->r, job->a) : larnum_mul(job->r, job->a, job->b);
+}
+
+/**
+ * @brief Evaluate a 3-piece operand at the Toom points 1, -1 and -2
+ */
+static int toom3_evaluate(const Larnum* x0, const Larnum* x1, const Larnum* x2,
+                          Larnum* at1, Larnum* atm1, Larnum* atm2) {
+    Larnum t;
+    larnum_init(&t);
+    int status = 0;
+    if (larnum_add(&t, x0, x2) != 0 ||
+        larnum_add(at1, &t, x1) != 0 ||            // x(1)  = x0 + x1 + x2
+        larnum_sub(atm1, &t, x1) != 0 ||           // x(-1) = x0 - x1 + x2
+        larnum_add(atm2, atm1, x2) != 0 ||
+        larnum_add(atm2, atm2, atm2) != 0 ||
+        larnum_sub(atm2, atm2, x0) != 0) {         // x(-2) = 2(x(-1) + x2) - x0
+        status = -1;
+    }
+    larnum_free(&t);
+    return status;
+}
+
+/**
+ * @brief acc += x * B^shift (x may be negative, the final sum is not)
+ */
+static int toom3_accumulate(Larnum* acc, const Larnum* x, size_t shift) {
+    if (x->size == 0) return 0;
+    Larnum shifted;
+    larnum_init(&shifted);
+    if (larnum_reserve(&shifted, x->size + shift) != 0) return -1;
+    memset(shifted.limbs, 0, shift * sizeof(LarnumLimb));
+    memcpy(shifted.limbs + shift, x->limbs, x->size * sizeof(LarnumLimb));
+    shifted.size = x->size + shift;
+    shifted.negative = x->negative;
+    int status = larnum_add(acc, acc, &shifted);
+    larnum_free(&shifted);
+    return status;
+}
+
+/**
+ * @brief r[0..2n) = a * b with Toom-Cook 3-way splitting
+ *
+ * Evaluation points 0, 1, -1, -2, inf with Bodrato's interpolation sequence.
+ * When square is set, b is ignored and a is squared.
+ */
+static int limbs_mul_toom3(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n, int square) {
+    size_t k = (n + 2) / 3;
+    Larnum a0 = larnum_view(a, k);
+    Larnum a1 = larnum_view(a + k, k);
+    Larnum a2 = larnum_view(a + 2 * k, n - 2 * k);
+    Larnum b0 = a0, b1 = a1, b2 = a2;
+    if (!square) {
+        b0 = larnum_view(b, k);
+        b1 = larnum_view(b + k, k);
+        b2 = larnum_view(b + 2 * k, n - 2 * k);
+    }
+
+    // pa/pb: evaluated operands, v*: point products, acc: recombined result
+    Larnum pa1, pam1, pam2, pb1, pbm1, pbm2;
+    Larnum v0, v1, vm1, vm2, vinf, acc;
+    Larnum* all[] = { &pa1, &pam1, &pam2, &pb1, &pbm1, &pbm2,
+                      &v0, &v1, &vm1, &vm2, &vinf, &acc };
+    size_t count = sizeof(all) / sizeof(all[0]);
+    for (size_t i = 0; i < count; i++) larnum_init(all[i]);
+
+    int status = -1;
+    if (toom3_evaluate(&a0, &a1, &a2, &pa1, &pam1, &pam2) != 0) goto done;
+    if (!square && toom3_evaluate(&b0, &b1, &b2, &pb1, &pbm1, &pbm2) != 0) goto done;
+
+    // The five point products are independent
+    PointProduct jobs[5] = {
+        { &v0, &a0, square ? NULL : &b0, 0 },
+        { &v1, &pa1, square ? NULL : &pb1, 0 },
+        { &vm1, &pam1, square ? NULL : &pbm1, 0 },
+        { &vm2, &pam2, square ? NULL : &pbm2, 0 },
+        { &vinf, &a2, square ? NULL : &b2, 0 }
+    };
+    ClrlTask tasks[5];
+    int parallel = clrl_parallel_worthwhile(k, PARALLEL_MUL_MIN_LIMBS);
+    for (int i = 1; i < 5; i++) {
+        if (parallel) {
+            clrl_task_fork(&tasks[i], point_product_run, &jobs[i]);
+        } else {
+            point_product_run(&jobs[i]);
+        }
+    }
+    point_product_run(&jobs[0]);
+    int products_status = jobs[0].status;
+    for (int i = 4; i >= 1; i--) {
+        if (parallel) clrl_task_join(&tasks[i]);
+        products_status |= jobs[i].status;
+    }
+    if (products_status != 0) goto done;
+
+    // Interpolation: r0 = v0, r4 = vinf, (r1, r2, r3) rebuilt in place
+    //   r3 = (v(-2) - v(1)) / 3        -> vm2
+    //   r1 = (v(1) - v(-1)) / 2        -> v1
+    //   r2 = v(-1) - v(0)              -> vm1
+    //   r3 = (r2 - r3) / 2 + 2 vinf    -> vm2
+    //   r2 = r2 + r1 - r4              -> vm1
+    //   r1 = r1 - r3                   -> v1
+    if (larnum_sub(&vm2, &vm2, &v1) != 0) goto done;
+    larnum_divexact_small(&vm2, 3);
+    if (larnum_sub(&v1, &v1, &vm1) != 0) goto done;
+    larnum_divexact_small(&v1, 2);
+    if (larnum_sub(&vm1, &vm1, &v0) != 0) goto done;
+    if (larnum_sub(&vm2, &vm1, &vm2) != 0) goto done;
+    larnum_divexact_small(&vm2, 2);
+    if (larnum_add(&vm2, &vm2, &vinf) != 0 || larnum_add(&vm2, &vm2, &vinf) != 0) goto done;
+    if (larnum_add(&vm1, &vm1, &v1) != 0 || larnum_sub(&vm1, &vm1, &vinf) != 0) goto done;
+    if (larnum_sub(&v1, &v1, &vm2) != 0) goto done;
+
+    if (larnum_copy(&acc, &v0) != 0 ||
+        toom3_accumulate(&acc, &v1, k) != 0 ||
+        toom3_accumulate(&acc, &vm1, 2 * k) != 0 ||
+        toom3_accumulate(&acc, &vm2, 3 * k) != 0 ||
+        toom3_accumulate(&acc, &vinf, 4 * k) != 0) goto done;
+
+    if (acc.size > 0) memcpy(r, acc.limbs, acc.size * sizeof(LarnumLimb));
+    memset(r + acc.size, 0, (2 * n - acc.size) * sizeof(LarnumLimb));
+    status = 0;
+
+done:
+    for (size_t i = 0; i < count; i++) larnum_free(all[i]);
+    return status;
+}
+
+// ===================== Number-theoretic transform =====================
+
+/**
+ * Two NTT-friendly primes p = c*2^k + 1 with primitive root 3.
+ * Operands are split into 16-bit coefficients; a convolution term is at most
+ * 2^22 * (2^16-1)^2 < 2^54 < p0*p1, so two CRT residues recover it exactly.
+ */
+#define NTT_COEFF_BITS 16
+#define NTT_MAX_LOG    23
+
+typedef struct {
+    uint32_t p;        // Prime modulus (< 2^30)
+    uint32_t p_neg_inv;// -p^{-1} mod 2^32 (Montgomery)
+    uint32_t r2;       // 2^64 mod p
+    uint32_t g;        // Primitive root
+} NttPrime;
+
+// Montgomery constants are precomputed so worker threads only ever read them
+static const NttPrime ntt_primes[2] = {
+    { 998244353u, 0x3B7FFFFFu, 932051910u, 3 },
+    { 469762049u, 0x1BFFFFFFu, 460175152u, 3 }
+};
+
+static uint32_t pow_mod(uint32_t base, uint64_t e, uint32_t p) {
+    uint64_t result = 1, b = base % p;
+    while (e > 0) {
+        if (e & 1) result = (result * b) % p;
+        b = (b * b) % p;
+        e >>= 1;
+    }
+    return (uint32_t)result;
+}
+
+static inline uint32_t mont_mul(uint32_t a, uint32_t b, const NttPrime* P) {
+    uint64_t t = (uint64_t)a * b;
+    uint32_t m = (uint32_t)t * P->p_neg_inv;
+    uint32_t u = (uint32_t)((t + (uint64_t)m * P->p) >> 32);
+    return (u >= P->p) ? u - P->p : u;
+}
+
+static inline uint32_t mod_add(uint32_t a, uint32_t b, uint32_t p) {
+    uint32_t s = a + b;
+    return (s >= p) ? s - p : s;
+}
+
+static inline uint32_t mod_sub(uint32_t a, uint32_t b, uint32_t p) {
+    return (a >= b) ? a - b : a + p - b;
+}
+
+/**
+ * @brief Fill root tables for a size-n transform (Montgomery form)
+ *
+ * roots[len/2 + j] = w_len^j for every power-of-two len <= n
+ */
+static void ntt_build_roots(uint32_t* roots, uint32_t* inv_roots, size_t n, const NttPrime* P) {
+    for (size_t half = 1; half < n; half <<= 1) {
+        uint32_t w = pow_mod(P->g, (P->p - 1) / (2 * half), P->p);
+        uint32_t wi = pow_mod(w, P->p - 2, P->p);
+        uint32_t wm = mont_mul(w, P->r2, P);
+        uint32_t wim = mont_mul(wi, P->r2, P);
+        uint32_t cur = mont_mul(1, P->r2, P);
+        uint32_t cur_i = cur;
+        for (size_t j = 0; j < half; j++) {
+            roots[half + j] = cur;
+            inv_roots[half + j] = cur_i;
+            cur = mont_mul(cur, wm, P);
+            cur_i = mont_mul(cur_i, wim, P);
+        }
+    }
+}
+
+/**
+ * @brief Forward transform (decimation in frequency, output in bit-reversed order)
+ */
+static void ntt_forward(uint32_t* a, size_t n, const uint32_t* roots, const NttPrime* P) {
+    uint32_t p = P->p;
+    for (size_t len = n; len >= 2; len >>= 1) {
+        size_t half = len >> 1;
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t j = 0; j < half; j++) {
+                uint32_t u = a[i + j];
+                uint32_t v = a[i + j + half];
+                a[i + j] = mod_add(u, v, p);
+                a[i + j + half] = mont_mul(mod_sub(u, v, p), roots[half + j], P);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Inverse transform (decimation in time, bit-reversed input), unscaled
+ */
+static void ntt_inverse(uint32_t* a, size_t n, const uint32_t* inv_roots, const NttPrime* P) {
+    uint32_t p = P->p;
+    for (size_t len = 2; len <= n; len <<= 1) {
+        size_t half = len >> 1;
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t j = 0; j < half; j++) {
+                uint32_t u = a[i + j];
+                uint32_t v = mont_mul(a[i + j + half], inv_roots[half + j], P);
+                a[i + j] = mod_add(u, v, p);
+                a[i + j + half] = mod_sub(u, v, p);
+            }
+        }
+    }
+}
+
+/**
+ * @brief One transform (or sub-transform) of length n over a[0..n)
+ *
+ * Large transforms are split recursively: the outermost butterfly stage is
+ * spread over the pool, then both halves are independent transforms of
+ * length n/2 and run in parallel.
+ */
+typedef struct {
+    uint32_t* a;
+    size_t n;
+    const uint32_t* roots;     // roots for forward, inv_roots for inverse
+    const NttPrime* P;
+} NttJob;
+
+static void ntt_dif_stage(void* ctx, size_t begin, size_t end) {
+    const NttJob* job = (const NttJob*)ctx;
+    size_t half = job->n >> 1;
+    uint32_t p = job->P->p;
+    for (size_t j = begin; j < end; j++) {
+        uint32_t u = job->a[j];
+        uint32_t v = job->a[j + half];
+        job->a[j] = mod_add(u, v, p);
+        job->a[j + half] = mont_mul(mod_sub(u, v, p), job->roots[half + j], job->P);
+    }
+}
+
+static void ntt_dit_stage(void* ctx, size_t begin, size_t end) {
+    const NttJob* job = (const NttJob*)ctx;
+    size_t half = job->n >> 1;
+    uint32_t p = job->P->p;
+    for (size_t j = begin; j < end; j++) {
+        uint32_t u = job->a[j];
+        uint32_t v = mont_mul(job->a[j + half], job->roots[half + j], job->P);
+        job->a[j] = mod_add(u, v, p);
+        job->a[j + half] = mod_sub(u, v, p);
+    }
+}
+
+static void ntt_forward_job(void* arg) {
+    NttJob* job = (NttJob*)arg;
+    if (!clrl_parallel_worthwhile(job->n, NTT_PARALLEL_MIN_LEN)) {
+        ntt_forward(job->a, job->n, job->roots, job->P);
+        return;
+    }
+    size_t half = job->n >> 1;
+    clrl_parallel_for(half, NTT_PARALLEL_GRAIN, ntt_dif_stage, job);
+    NttJob upper = { job->a + half, half, job->roots, job->P };
+    NttJob lower = { job->a, half, job->roots, job->P };
+    ClrlTask task;
+    clrl_task_fork(&task, ntt_forward_job, &upper);
+    ntt_forward_job(&lower);
+    clrl_task_join(&task);
+}
+
+static void ntt_inverse_job(void* arg) {
+    NttJob* job = (NttJob*)arg;
+    if (!clrl_parallel_worthwhile(job->n, NTT_PARALLEL_MIN_LEN)) {
+        ntt_inverse(job->a, job->n, job->roots, job->P);
+        return;
+    }
+    size_t half = job->n >> 1;
+    NttJob upper = { job->a + half, half, job->roots, job->P };
+    NttJob lower = { job->a, half, job->roots, job->P };
+    ClrlTask task;
+    clrl_task_fork(&task, ntt_inverse_job, &upper);
+    ntt_inverse_job(&lower);
+    clrl_task_join(&task);
+    clrl_parallel_for(half, NTT_PARALLEL_GRAIN, ntt_dit_stage, job);
+}
+
+/**
+ * @brief Elementwise fa[i] = mont_mul(fa[i], fb[i]) over a range
+ */
+typedef struct {
+    uint32_t* fa;
+    const uint32_t* fb;
+    uint32_t scale;            // Used when fb is NULL: fa[i] = mont_mul(fa[i], scale)
+    const NttPrime* P;
+} NttPointwise;
+
+static void ntt_pointwise_range(void* ctx, size_t begin, size_t end) {
+    const NttPointwise* job = (const NttPointwise*)ctx;
+    if (job->fb != NULL) {
+        for (size_t i = begin; i < end; i++) job->fa[i] = mont_mul(job->fa[i], job->fb[i], job->P);
+    } else {
+        for (size_t i = begin; i < end; i++) job->fa[i] = mont_mul(job->fa[i], job->scale, job->P);
+    }
+}
+
+static void ntt_split_coeffs(uint32_t* dst, size_t n, const LarnumLimb* src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        dst[2 * i] = src[i] & 0xFFFFu;
+        dst[2 * i + 1] = src[i] >> NTT_COEFF_BITS;
+    }
+    memset(dst + 2 * len, 0, (n - 2 * len) * sizeof(uint32_t));
+}
+
+/**
+ * @brief Check whether an (an + bn)-limb product fits the NTT size limit
+ */
+static int ntt_fits(size_t an, size_t bn) {
+    return 2 * (an + bn) <= ((size_t)1 << NTT_MAX_LOG);
+}
+
+/**
+ * @brief Convolution of the operands modulo one prime (res = a * b mod P)
+ */
+typedef struct {
+    uint32_t* res;             // Result coefficients (n)
+    uint32_t* fb;              // Transform of b (n, NULL when squaring)
+    uint32_t* roots;           // n
+    uint32_t* inv_roots;       // n
+    size_t n;
+    const LarnumLimb* a;
+    size_t an;
+    const LarnumLimb* b;
+    size_t bn;
+    const NttPrime* P;
+} NttConvolution;
+
+static void ntt_convolution_run(void* arg) {
+    NttConvolution* job = (NttConvolution*)arg;
+    const NttPrime* P = job->P;
+    size_t n = job->n;
+    uint32_t* fa = job->res;
+
+    ntt_build_roots(job->roots, job->inv_roots, n, P);
+    ntt_split_coeffs(fa, n, job->a, job->an);
+    NttJob forward_a = { fa, n, job->roots, P };
+    if (job->fb == NULL) {
+        ntt_forward_job(&forward_a);
+    } else {
+        // Both operand transforms only share the read-only root table
+        ntt_split_coeffs(job->fb, n, job->b, job->bn);
+        NttJob forward_b = { job->fb, n, job->roots, P };
+        ClrlTask task;
+        clrl_task_fork(&task, ntt_forward_job, &forward_b);
+        ntt_forward_job(&forward_a);
+        clrl_task_join(&task);
+    }
+
+    NttPointwise product = { fa, (job->fb != NULL) ? job->fb : fa, 0, P };
+    clrl_parallel_for(n, NTT_PARALLEL_GRAIN, ntt_pointwise_range, &product);
+
+    NttJob inverse = { fa, n, job->inv_roots, P };
+    ntt_inverse_job(&inverse);
+
+    // Undo the pointwise Montgomery factor and the transform length at once:
+    // mont_mul(x, n^-1 * R^2) == x * n^-1 * R
+    uint32_t n_inv = pow_mod((uint32_t)(n % P->p), P->p - 2, P->p);
+    NttPointwise scale = { fa, NULL, mont_mul(mont_mul(n_inv, P->r2, P), P->r2, P), P };
+    clrl_parallel_for(n, NTT_PARALLEL_GRAIN, ntt_pointwise_range, &scale);
+}
+
+/**
+ * @brief r[0..an+bn) = a * b via two-prime NTT convolution (b ignored when squaring)
+ */
+static int limbs_mul_ntt(LarnumLimb* r, const LarnumLimb* a, size_t an,
+                         const LarnumLimb* b, size_t bn, int square) {
+    size_t coeffs = 2 * (an + bn);
+    size_t n = 1;
+    while (n < coeffs) n <<= 1;
+
+    // Per prime: result, root tables and (unless squaring) the transform of b
+    size_t per_prime = square ? 3 : 4;
+    uint32_t* buf = (uint32_t*)clrl_mem_alloc(2 * per_prime * n * sizeof(uint32_t));
+    if (buf == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed in larnum multiplication\n");
+        return -1;
+    }
+    NttConvolution jobs[2];
+    for (int k = 0; k < 2; k++) {
+        uint32_t* base = buf + (size_t)k * per_prime * n;
+        NttConvolution job = { base, square ? NULL : base + 3 * n, base + n, base + 2 * n,
+                               n, a, an, b, bn, &ntt_primes[k] };
+        jobs[k] = job;
+    }
+
+    // The two primes are independent convolutions
+    ClrlTask task;
+    int parallel = clrl_parallel_worthwhile(n, NTT_PARALLEL_MIN_LEN);
+    if (parallel) {
+        clrl_task_fork(&task, ntt_convolution_run, &jobs[1]);
+    } else {
+        ntt_convolution_run(&jobs[1]);
+    }
+    ntt_convolution_run(&jobs[0]);
+    if (parallel) clrl_task_join(&task);
+    uint32_t* res[2] = { jobs[0].res, jobs[1].res };
+
+    // CRT (Garner) back to integers and 16-bit carry propagation
+    uint32_t p0 = ntt_primes[0].p;
+    uint32_t p1 = ntt_primes[1].p;
+    uint64_t p0_inv_mod_p1 = pow_mod(p0 % p1, p1 - 2, p1);
+    uint64_t carry = 0;
+    size_t out_limbs = an + bn;
+    for (size_t i = 0; i < out_limbs; i++) {
+        uint32_t halves[2];
+        for (int h = 0; h < 2; h++) {
+            size_t idx = 2 * i + h;
+            uint64_t r0 = res[0][idx];
+            uint64_t r1 = res[1][idx];
+            uint64_t t = ((r1 + p1 - (r0 % p1)) % p1) * p0_inv_mod_p1 % p1;
+            carry += r0 + t * p0;
+            halves[h] = (uint32_t)(carry & 0xFFFFu);
+            carry >>= NTT_COEFF_BITS;
+        }
+        r[i] = halves[0] | (halves[1] << NTT_COEFF_BITS);
+    }
+
+    clrl_mem_free(buf);
+    return 0;
+}
+
+// ===================== Dispatch =====================
+
+/**
+ * @brief Balanced n x n product, choosing the algorithm by size
+ */
+static int limbs_mul_n(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n) {
+    if (n < mul_thresholds.karatsuba_threshold) {
+        if (n > 0) limbs_mul_basecase(r, a, n, b, n);
+        return 0;
+    }
+    if (n < mul_thresholds.toom3_threshold) return limbs_mul_karatsuba(r, a, b, n);
+    if (n < mul_thresholds.ntt_threshold || !ntt_fits(n, n)) return limbs_mul_toom3(r, a, b, n, 0);
+    return limbs_mul_ntt(r, a, n, b, n, 0);
+}
+
+static int limbs_sqr_n(LarnumLimb* r, const LarnumLimb* a, size_t n) {
+    if (n < mul_thresholds.karatsuba_threshold) {
+        if (n > 0) limbs_sqr_basecase(r, a, n);
+        return 0;
+    }
+    if (n < mul_thresholds.toom3_threshold) return limbs_sqr_karatsuba(r, a, n);
+    if (n < mul_thresholds.ntt_threshold || !ntt_fits(n, n)) return limbs_mul_toom3(r, a, a, n, 1);
+    return limbs_mul_ntt(r, a, n, a, n, 1);
+}
+
+int limbs_mul(LarnumLimb* r, const LarnumLimb* a, size_t an, const LarnumLimb* b, size_t bn) {
+    if (an < bn) {
+        const LarnumLimb* t = a; a = b; b = t;
+        size_t tn = an; an = bn; bn = tn;
+    }
+    if (bn < mul_thresholds.karatsuba_threshold) {
+        limbs_mul_basecase(r, a, an, b, bn);
+        return 0;
+    }
+    if (an == bn) return limbs_mul_n(r, a, b, bn);
+    if (bn >= mul_thresholds.ntt_threshold && ntt_fits(an, bn)) {
+        return limbs_mul_ntt(r, a, an, b, bn, 0);
+    }
+
+    // Unbalanced: multiply bn-sized slices of a by b and accumulate
+    LarnumLimb* tmp = (LarnumLimb*)mul_alloc(2 * bn);
+    if (tmp == NULL) return -1;
+    if (limbs_mul_n(r, a, b, bn) != 0) {
+        clrl_mem_free(tmp);
+        return -1;
+    }
+    size_t filled = 2 * bn;
+    for (size_t offset = bn; offset < an; offset += bn) {
+        size_t chunk = (an - offset < bn) ? an - offset : bn;
+        if (limbs_mul(tmp, a + offset, chunk, b, bn) != 0) {
+            clrl_mem_free(tmp);
+            return -1;
+        }
+        // Overlap of bn limbs with what is already in r, the rest is fresh
+        size_t end = offset + chunk + bn;
+        memset(r + filled, 0, (end - filled) * sizeof(LarnumLimb));
+        limbs_add(r + offset, r + offset, end - offset, tmp, chunk + bn);
+        filled = end;
+    }
+    clrl_mem_free(tmp);
+    return 0;
+}
+
+int limbs_sqr(LarnumLimb* r, const LarnumLimb* a, size_t n) {
+    return limbs_sqr_n(r, a, n);
+}
+
+/**
+ * @brief Tier limbs_mul/limbs_sqr picks for an an x bn product (for the profiler)
+ */
+static ClrlProfileOp mul_algorithm(size_t an, size_t bn, int square) {
+    size_t n = (an < bn) ? an : bn;
+    size_t m = (an < bn) ? bn : an;
+    int base = square ? CLRL_PROFILE_SQR_SCHOOLBOOK : CLRL_PROFILE_MUL_SCHOOLBOOK;
+    if (n < mul_thresholds.karatsuba_threshold) return (ClrlProfileOp)base;
+    if (m != n && n >= mul_thresholds.ntt_threshold && ntt_fits(m, n)) return (ClrlProfileOp)(base + 3);
+    // Unbalanced products are built from balanced n x n pieces
+    if (n < mul_thresholds.toom3_threshold) return (ClrlProfileOp)(base + 1);
+    if (n < mul_thresholds.ntt_threshold || !ntt_fits(n, n)) return (ClrlProfileOp)(base + 2);
+    return (ClrlProfileOp)(base + 3);
+}
+
+// ===================== Larnum operators =====================
+
+/**
+ * @brief 128-bit product of two native magnitudes
+ */
+static inline void mul_64x64(uint64_t x, uint64_t y, uint64_t* low, uint64_t* high) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)x * y;
+    *low = (uint64_t)product;
+    *high = (uint64_t)(product >> 64);
+#else
+    uint64_t x0 = (uint32_t)x, x1 = x >> 32;
+    uint64_t y0 = (uint32_t)y, y1 = y >> 32;
+    uint64_t p00 = x0 * y0, p01 = x0 * y1, p10 = x1 * y0, p11 = x1 * y1;
+    uint64_t middle = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+    *low = (middle << 32) | (uint32_t)p00;
+    *high = p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32);
+#endif
+}
+
+/**
+ * @brief r = big * m for a single-limb multiplier, computed in place
+ */
+static int larnum_mul_limb(Larnum* r, const Larnum* big, LarnumLimb m, int negative) {
+    size_t n = big->size;
+    uint64_t started = clrl_profiling() ? clrl_profile_now() : 0;
+    if (larnum_reserve(r, n + 1) != 0) return -1;
+    // r may be big itself: reserve keeps the value, so re-read the limbs after it
+    r->limbs[n] = limbs_mul_1(r->limbs, big->limbs, n, m);
+    if (started != 0) clrl_profile_op(CLRL_PROFILE_MUL_SCHOOLBOOK, n, 1, started);
+    r->size = limbs_normalize(r->limbs, n + 1);
+    r->negative = negative;
+    return 0;
+}
+
+int larnum_mul(Larnum* r, const Larnum* a, const Larnum* b) {
+    // The smaller operand decides: one short factor keeps the product linear
+    LARNUM_BACKEND_CALL(mul, (a->size < b->size) ? a->size : b->size, r, a, b);
+    if (a == b || (a->limbs == b->limbs && a->size == b->size)) {
+        return larnum_sqr(r, a);
+    }
+    if (a->size == 0 || b->size == 0) {
+        r->size = 0;
+        r->negative = 0;
+        return 0;
+    }
+
+    int negative = a->negative != b->negative;
+    if (a->size <= LIMBS_SMALL && b->size <= LIMBS_SMALL) {
+        uint64_t low, high;
+        mul_64x64(larnum_get_small(a), larnum_get_small(b), &low, &high);
+        return larnum_set_small(r, low, high, negative);
+    }
+    // Mixed small/big: one limb times n limbs needs no scratch product
+    if (b->size == 1) return larnum_mul_limb(r, a, b->limbs[0], negative);
+    if (a->size == 1) return larnum_mul_limb(r, b, a->limbs[0], negative);
+
+    size_t n = a->size + b->size;
+
+    // The product kernels cannot work in place, so build into a fresh buffer
+    Larnum product;
+    larnum_init(&product);
+    if (larnum_reserve(&product, n) != 0) return -1;
+    uint64_t started = clrl_profiling() ? clrl_profile_now() : 0;
+    if (limbs_mul(product.limbs, a->limbs, a->size, b->limbs, b->size) != 0) {
+        larnum_free(&product);
+        return -1;
+    }
+    if (started != 0) clrl_profile_op(mul_algorithm(a->size, b->size, 0), a->size, b->size, started);
+    product.size = limbs_normalize(product.limbs, n);
+    product.negative = negative;
+
+    larnum_free(r);
+    *r = product;
+    return 0;
+}
+
+int larnum_sqr(Larnum* r, const Larnum* a) {
+    LARNUM_BACKEND_CALL(mul, a->size, r, a, a);
+    if (a->size == 0) {
+        r->size = 0;
+        r->negative = 0;
+        return 0;
+    }
+    if (a->size <= LIMBS_SMALL) {
+        uint64_t x = larnum_get_small(a);
+        uint64_t low, high;
+        mul_64x64(x, x, &low, &high);
+        return larnum_set_small(r, low, high, 0);
+    }
+
+    size_t n = 2 * a->size;
+    Larnum product;
+    larnum_init(&product);
+    if (larnum_reserve(&product, n) != 0) return -1;
+    uint64_t started = clrl_profiling() ? clrl_profile_now() : 0;
+    if (limbs_sqr(product.limbs, a->limbs, a->size) != 0) {
+        larnum_free(&product);
+        return -1;
+    }
+    if (started != 0) clrl_profile_op(mul_algorithm(a->size, a->size, 1), a->size, a->size, started);
+    product.size = limbs_normalize(product.limbs, n);
+    product.negative = 0;
+
+    larnum_free(r);
+    *r = product;
+    return 0;
+}
@@ -0,0 +1,802 @@
+#include "../../include/clrl/clrl_vm.h"
+#include "../../include/clrl/clrl_context.h"
+
+/**
+ * Bytecode optimizer
+ *
+ * Runs between clrl_compile and execution (interpreter or generated C).
+ * A forward pass numbers every value the program computes: the same
+ * operation on the same values gets the same number, across statements
+ * too, and a variable read yields the number of the value last stored to
+ * it. Each definition is then re-emitted from the value its STORE needs:
+ * - values whose inputs are all literals become one constant, computed
+ *   only when a statement that survives needs it;
+ * - a value computed earlier in the statement is reused from its register,
+ *   and one a variable already holds is read from that variable;
+ * - a store of the value the variable already holds is dropped.
+ * A backward pass then removes stores that nothing reads before the
+ * variable is overwritten (or, for closed programs, at all).
+ *
+ * Errors stay where they were: a rewrite only drops a variable check that
+ * is known to pass, and only statements that cannot fail are removed.
+ * Whether a value can fail to compute is tracked in Value.certain.
+ */
+
+// Marks "none" in the value and index tables
+#define NO_INDEX UINT32_MAX
+
+// Value kinds besides the arithmetic opcodes
+#define VALUE_CONST      0x80u   // Program constant a
+#define VALUE_INPUT      0x81u   // Whatever a slot held before the program (or after a store that may fail)
+#define VALUE_READ       0x82u   // Checked read of slot a holding value b (precision = larnum_only)
+#define VALUE_TO_PRECISE 0x83u   // Value a as stored into a precise variable
+
+// Value type when it depends on run-time state (next to VAR_LARNUM / VAR_PRECISE)
+#define TYPE_UNKNOWN 2
+
+/**
+ * @brief One numbered value
+ */
+typedef struct {
+    uint8_t op;              // Arithmetic opcode or VALUE_*
+    uint8_t type;            // VAR_LARNUM, VAR_PRECISE or TYPE_UNKNOWN
+    uint8_t certain;         // Cannot fail: inputs are defined and no divisor can be zero
+    uint8_t foldable;        // Inputs are all literals (implies certain)
+    uint8_t folded;          // Optimizer.folded holds the computed value
+    uint32_t a, b;           // Operand values (see VALUE_* for the other kinds)
+    uint32_t precision;      // Fractional digits of a division, power or root (CLRL_PRECISION_GLOBAL = session's),
+                             // the modulus value of a powmod
+    uint32_t holder;         // Slot it was last stored to or read from (NO_INDEX = none)
+    uint32_t reg_statement;  // Statement that computed it into register reg
+    uint32_t reg;
+    uint32_t constant;       // Index in the optimized constant table (NO_INDEX = none yet)
+} Value;
+
+/**
+ * @brief Optimizer state
+ */
+typedef struct {
+    ClrlProgram* program;
+    Value* values;
+    size_t value_count;
+    size_t value_capacity;
+    uint32_t* index;             // Open-addressing map key -> value (NO_INDEX = empty)
+    size_t index_capacity;
+    uint32_t* slot_value;        // Value each slot holds before the current statement
+    uint32_t* reg_value;         // Value of each register of the original statement
+    uint32_t precision;          // Last system:precision so far (CLRL_PRECISION_GLOBAL = none)
+    uint32_t statement;          // Original statement being rewritten
+    uint8_t flags;               // CLRL_FLAG_LARNUM_ONLY of the statement being rewritten
+    uint32_t register_count;     // Registers of the statement being rewritten
+    ClrlInsn* code;              // Rewritten code (CONST operands name values until the end)
+    size_t code_count;
+    size_t code_capacity;
+    ClrlStatement* statements;   // Rewritten statements
+    uint8_t* infallible;         // Rewritten statement cannot fail
+    size_t statement_count;
+    ClrlValue* folded;           // Computed constant of each folded value
+    ClrlValue* constants;        // Optimized constant table
+    size_t constant_count;
+    size_t constant_capacity;
+} Optimizer;
+
+static void optimize_error(void) {
+    clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while optimizing\n");
+}
+
+// ===================== Value numbering =====================
+
+static uint64_t hash_mix(uint64_t h, uint64_t x) {
+    h ^= x;
+    h *= 0x100000001b3ULL;
+    return h ^ (h >> 29);
+}
+
+static uint64_t value_hash(const Optimizer* opt, const Value* x) {
+    uint64_t h = hash_mix(0xcbf29ce484222325ULL, x->op);
+    if (x->op != VALUE_CONST) {
+        h = hash_mix(h, x->a);
+        h = hash_mix(h, x->b);
+        return hash_mix(h, x->precision);
+    }
+    // Equal literals share a number however they were written (7 and 007)
+    const ClrlValue* c = &opt->program->constants[x->a];
+    const Larnum* coefficient = &c->value.larnum_val;
+    h = hash_mix(h, c->type);
+    if (c->type == VAR_PRECISE) h = hash_mix(h, (uint64_t)c->value.precise_val.exponent);
+    h = hash_mix(h, (uint64_t)coefficient->negative);
+    for (size_t i = 0; i < coefficient->size; i++) h = hash_mix(h, coefficient->limbs[i]);
+    return h;
+}
+
+static int value_equal(const Optimizer* opt, const Value* x, const Value* y) {
+    if (x->op != y->op) return 0;
+    if (x->op != VALUE_CONST) return x->a == y->a && x->b == y->b && x->precision == y->precision;
+    const ClrlValue* c = &opt->program->constants[x->a];
+    const ClrlValue* d = &opt->program->constants[y->a];
+    if (c->type != d->type) return 0;
+    if (c->type == VAR_PRECISE && c->value.precise_val.exponent != d->value.precise_val.exponent) return 0;
+    return larnum_cmp(&c->value.larnum_val, &d->value.larnum_val) == 0;
+}
+
+/**
+ * @brief Append a value (not entered in the index)
+ */
+static int add_value(Optimizer* opt, const Value* proto, uint32_t* out) {
+    if (opt->value_count == opt->value_capacity) {
+        size_t capacity = (opt->value_capacity == 0) ? 256 : opt->value_capacity * 2;
+        Value* values = (Value*)realloc(opt->values, capacity * sizeof(Value));
+        if (values == NULL) return -1;
+        opt->values = values;
+        opt->value_capacity = capacity;
+    }
+    Value* x = &opt->values[opt->value_count];
+    *x = *proto;
+    x->folded = 0;
+    x->holder = NO_INDEX;
+    x->reg_statement = NO_INDEX;
+    x->constant = NO_INDEX;
+    *out = (uint32_t)opt->value_count++;
+    return 0;
+}
+
+/**
+ * @brief Rebuild the index so one more value keeps it at most half full
+ */
+static int reserve_index(Optimizer* opt) {
+    if ((opt->value_count + 1) * 2 <= opt->index_capacity) return 0;
+    size_t capacity = (opt->index_capacity == 0) ? 1024 : opt->index_capacity * 2;
+    uint32_t* index = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    if (index == NULL) return -1;
+    memset(index, 0xFF, capacity * sizeof(uint32_t));
+    for (size_t v = 0; v < opt->value_count; v++) {
+        if (opt->values[v].op == VALUE_INPUT) continue;
+        size_t i = value_hash(opt, &opt->values[v]) & (capacity - 1);
+        while (index[i] != NO_INDEX) i = (i + 1) & (capacity - 1);
+        index[i] = (uint32_t)v;
+    }
+    free(opt->index);
+    opt->index = index;
+    opt->index_capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief Number of the value described by key (added on first use)
+ */
+static int intern_value(Optimizer* opt, const Value* key, uint32_t* out) {
+    if (reserve_index(opt) != 0) return -1;
+    size_t mask = opt->index_capacity - 1;
+    size_t i = value_hash(opt, key) & mask;
+    for (; opt->index[i] != NO_INDEX; i = (i + 1) & mask) {
+        if (value_equal(opt, &opt->values[opt->index[i]], key)) {
+            *out = opt->index[i];
+            return 0;
+        }
+    }
+    if (add_value(opt, key, out) != 0) return -1;
+    opt->index[i] = *out;
+    return 0;
+}
+
+static int constant_value(Optimizer* opt, uint32_t constant, uint32_t* out) {
+    Value key = { 0 };
+    key.op = VALUE_CONST;
+    key.a = constant;
+    key.type = (uint8_t)opt->program->constants[constant].type;
+    key.certain = 1;
+    key.foldable = 1;
+    return intern_value(opt, &key, out);
+}
+
+/**
+ * @brief Whether value v is a literal larnum that is not negative and fits in a limb
+ */
+static int small_exponent(const Optimizer* opt, uint32_t v) {
+    const Value* x = &opt->values[v];
+    if (x->op != VALUE_CONST || x->type != VAR_LARNUM) return 0;
+    const Larnum* e = &opt->program->constants[x->a].value.larnum_val;
+    return !e->negative && e->size <= 1;
+}
+
+/**
+ * @brief Value of a <op> b, with its type and whether it can fail
+ *
+ * For CLRL_OP_POWMOD, precision is the value of the modulus.
+ */
+static int arith_value(Optimizer* opt, uint8_t op, uint32_t a, uint32_t b, uint32_t precision, uint32_t* out) {
+    // a + b and b + a are one value, unless swapping would reorder their error checks
+    if ((op == CLRL_OP_ADD || op == CLRL_OP_MUL) && b < a &&
+        opt->values[a].certain && opt->values[b].certain) {
+        uint32_t t = a;
+        a = b;
+        b = t;
+    }
+    const Value* x = &opt->values[a];
+    const Value* y = &opt->values[b];
+    int larnums = x->type == VAR_LARNUM && y->type == VAR_LARNUM;
+    int any_precise = x->type == VAR_PRECISE || y->type == VAR_PRECISE;
+    // Only a literal divisor is known not to be zero before anything runs
+    int safe_divisor = y->op == VALUE_CONST && opt->program->constants[y->a].value.larnum_val.size > 0;
+
+    Value key = { 0 };
+    key.op = op;
+    key.a = a;
+    key.b = b;
+    key.precision = (op == CLRL_OP_DIV || op == CLRL_OP_ROOT || op == CLRL_OP_POWMOD) ? precision : 0;
+    switch (op) {
+        case CLRL_OP_NEG:
+            key.b = a;
+            key.type = x->type;
+            key.certain = x->certain;
+            key.foldable = x->foldable;
+            break;
+        case CLRL_OP_DIV:
+            if (larnums) {
+                key.type = (precision == CLRL_PRECISION_GLOBAL) ? TYPE_UNKNOWN
+                         : (precision == 0) ? VAR_LARNUM : VAR_PRECISE;
+            } else {
+                key.type = any_precise ? VAR_PRECISE : TYPE_UNKNOWN;
+            }
+            key.certain = x->certain && y->certain && safe_divisor;
+            // The session precision is only known once the program runs
+            key.foldable = x->foldable && y->foldable && safe_divisor && precision != CLRL_PRECISION_GLOBAL;
+            break;
+        case CLRL_OP_POW: {
+            // Only a negative exponent divides, so only then does the precision matter
+            int safe_exponent = small_exponent(opt, b);
+            if (!safe_exponent) key.precision = precision;
+            key.type = safe_exponent ? x->type : (x->type == VAR_PRECISE) ? VAR_PRECISE : TYPE_UNKNOWN;
+            key.certain = x->certain && safe_exponent;
+            key.foldable = x->foldable && safe_exponent;
+            break;
+        }
+        case CLRL_OP_ROOT: {
+            // A literal degree and either an odd degree or a literal radicand that is not negative
+            int safe_degree = small_exponent(opt, b) && opt->program->constants[y->a].value.larnum_val.size > 0;
+            const ClrlValue* radicand = (x->op == VALUE_CONST) ? &opt->program->constants[x->a] : NULL;
+            int safe_radicand = safe_degree &&
+                ((opt->program->constants[y->a].value.larnum_val.limbs[0] & 1u) ||
+                 (radicand != NULL && !((radicand->type == VAR_LARNUM) ? radicand->value.larnum_val.negative
+                                                                        : radicand->value.precise_val.coefficient.negative)));
+            if (x->type == VAR_LARNUM) {
+                key.type = (precision == CLRL_PRECISION_GLOBAL) ? TYPE_UNKNOWN
+                         : (precision == 0) ? VAR_LARNUM : VAR_PRECISE;
+            } else {
+                key.type = (x->type == VAR_PRECISE) ? VAR_PRECISE : TYPE_UNKNOWN;
+            }
+            key.certain = x->certain && safe_radicand;
+            key.foldable = x->foldable && safe_radicand && precision != CLRL_PRECISION_GLOBAL;
+            break;
+        }
+        case CLRL_OP_POWMOD: {
+            const Value* z = &opt->values[precision];
+            int safe_modulus = z->op == VALUE_CONST && opt->program->constants[z->a].value.larnum_val.size > 0;
+            int safe_exponent = y->op == VALUE_CONST && !opt->program->constants[y->a].value.larnum_val.negative;
+            int all_larnums = larnums && z->type == VAR_LARNUM;
+            key.type = VAR_LARNUM;
+            key.certain = x->certain && y->certain && z->certain && all_larnums && safe_exponent && safe_modulus;
+            key.foldable = x->foldable && y->foldable && z->foldable && all_larnums && safe_exponent && safe_modulus;
+            break;
+        }
+        case CLRL_OP_IDIV:
+        case CLRL_OP_MOD:
+            key.type = VAR_LARNUM;
+            key.certain = x->certain && y->certain && larnums && safe_divisor;
+            key.foldable = x->foldable && y->foldable && larnums && safe_divisor;
+            break;
+        default:
+            key.type = larnums ? VAR_LARNUM : any_precise ? VAR_PRECISE : TYPE_UNKNOWN;
+            key.certain = x->certain && y->certain;
+            key.foldable = x->foldable && y->foldable;
+            break;
+    }
+    return intern_value(opt, &key, out);
+}
+
+/**
+ * @brief Value a precise store leaves in its variable
+ */
+static int precise_value(Optimizer* opt, uint32_t v, uint32_t* out) {
+    const Value* x = &opt->values[v];
+    if (x->type == VAR_PRECISE) {
+        *out = v;
+        return 0;
+    }
+    Value key = { 0 };
+    key.op = VALUE_TO_PRECISE;
+    key.a = v;
+    key.type = VAR_PRECISE;
+    key.certain = x->certain;
+    key.foldable = x->foldable;
+    return intern_value(opt, &key, out);
+}
+
+/**
+ * @brief Unknown contents of a slot
+ */
+static int input_value(Optimizer* opt, uint32_t* out) {
+    Value proto = { 0 };
+    proto.op = VALUE_INPUT;
+    proto.type = TYPE_UNKNOWN;
+    return add_value(opt, &proto, out);
+}
+
+/**
+ * @brief Value of an instruction operand
+ *
+ * A variable read whose check is known to pass yields the variable's value
+ * itself; any other read stays a VALUE_READ, which keeps the check.
+ */
+static int operand_value(Optimizer* opt, uint32_t operand, int larnum_only, uint32_t* out) {
+    uint32_t index = CLRL_OPERAND_INDEX(operand);
+    switch (CLRL_OPERAND_KIND(operand)) {
+        case CLRL_OPERAND_REG:
+            *out = opt->reg_value[index];
+            return 0;
+        case CLRL_OPERAND_CONST:
+            return constant_value(opt, index, out);
+        default:
+            break;
+    }
+    if (opt->slot_value[index] == NO_INDEX && input_value(opt, &opt->slot_value[index]) != 0) return -1;
+    uint32_t v = opt->slot_value[index];
+    Value* x = &opt->values[v];
+    if (x->certain && (!larnum_only || x->type == VAR_LARNUM)) {
+        x->holder = index;
+        *out = v;
+        return 0;
+    }
+    Value key = { 0 };
+    key.op = VALUE_READ;
+    key.a = index;
+    key.b = v;
+    key.precision = (uint32_t)larnum_only;
+    // A read that passes its larnum check yields a larnum
+    key.type = larnum_only ? VAR_LARNUM : x->type;
+    return intern_value(opt, &key, out);
+}
+
+// ===================== Statement rewriting =====================
+
+static int emit(Optimizer* opt, const ClrlInsn* insn) {
+    if (opt->code_count == opt->code_capacity) {
+        size_t capacity = (opt->code_capacity == 0) ? 256 : opt->code_capacity * 2;
+        ClrlInsn* code = (ClrlInsn*)realloc(opt->code, capacity * sizeof(ClrlInsn));
+        if (code == NULL) return -1;
+        opt->code = code;
+        opt->code_capacity = capacity;
+    }
+    opt->code[opt->code_count++] = *insn;
+    return 0;
+}
+
+/**
+ * @brief Operand that yields value v in the statement being rewritten
+ *
+ * In order of preference: a constant, a register computed earlier in the
+ * statement, a variable that holds it, or new code computing it (which
+ * gets a fresh virtual register; see allocate_registers).
+ */
+static int materialize(Optimizer* opt, uint32_t v, uint32_t* operand) {
+    const Value* x = &opt->values[v];
+    if (x->foldable) {
+        *operand = CLRL_OPERAND(CLRL_OPERAND_CONST, v);   // Value number until fold_constants
+        return 0;
+    }
+    if (x->reg_statement == opt->statement) {
+        *operand = CLRL_OPERAND(CLRL_OPERAND_REG, x->reg);
+        return 0;
+    }
+    if (x->op == VALUE_READ) {
+        *operand = CLRL_OPERAND(CLRL_OPERAND_VAR, x->a);
+        return 0;
+    }
+    if (x->certain && x->holder != NO_INDEX && opt->slot_value[x->holder] == v &&
+        (!(opt->flags & CLRL_FLAG_LARNUM_ONLY) || x->type == VAR_LARNUM)) {
+        *operand = CLRL_OPERAND(CLRL_OPERAND_VAR, x->holder);
+        return 0;
+    }
+    if (x->op > CLRL_OP_ROOT) return -1;   // Every other value has one of the forms above
+
+    ClrlInsn insn;
+    insn.op = x->op;
+    insn.flags = opt->flags;
+    insn.imm = (x->op == CLRL_OP_NEG) ? 0
+             : (x->op == CLRL_OP_DIV || x->op == CLRL_OP_POW || x->op == CLRL_OP_ROOT) ? x->precision
+             : CLRL_PRECISION_GLOBAL;
+    if (materialize(opt, x->a, &insn.a) != 0) return -1;
+    if (x->op == CLRL_OP_NEG) {
+        insn.b = insn.a;
+    } else if (materialize(opt, x->b, &insn.b) != 0) {
+        return -1;
+    }
+    if (x->op == CLRL_OP_POWMOD && materialize(opt, x->precision, &insn.imm) != 0) return -1;
+    insn.dst = opt->register_count++;
+    if (emit(opt, &insn) != 0) return -1;
+    opt->values[v].reg_statement = opt->statement;
+    opt->values[v].reg = insn.dst;
+    *operand = CLRL_OPERAND(CLRL_OPERAND_REG, insn.dst);
+    return 0;
+}
+
+/**
+ * @brief Operands of an instruction
+ *
+ * @return size_t Number of operand pointers stored
+ */
+static size_t insn_operands(ClrlInsn* insn, uint32_t* operands[3]) {
+    switch (insn->op) {
+        case CLRL_OP_SET_PRECISION:
+            return 0;
+        case CLRL_OP_POWMOD:
+            operands[0] = &insn->a;
+            operands[1] = &insn->b;
+            operands[2] = &insn->imm;
+            return 3;
+        case CLRL_OP_NEG:     // b repeats a
+        case CLRL_OP_STORE:
+        case CLRL_OP_RETURN:
+            operands[0] = &insn->a;
+            return 1;
+        default:
+            operands[0] = &insn->a;
+            operands[1] = &insn->b;
+            return 2;
+    }
+}
+
+/**
+ * @brief Map the virtual registers of code[first..] onto as few registers as possible
+ *
+ * Each virtual register is written once; its register is released after
+ * its last read, so an instruction may write the register it reads.
+ */
+static int allocate_registers(Optimizer* opt, size_t first, size_t* max_registers) {
+    size_t count = opt->register_count;
+    if (count == 0) return 0;
+    uint32_t* last_use = (uint32_t*)malloc(2 * count * sizeof(uint32_t));
+    uint8_t* busy = (uint8_t*)calloc(count, 1);
+    if (last_use == NULL || busy == NULL) {
+        free(last_use);
+        free(busy);
+        return -1;
+    }
+    uint32_t* physical = last_use + count;
+
+    for (size_t i = first; i < opt->code_count; i++) {
+        uint32_t* operands[3];
+        size_t n = insn_operands(&opt->code[i], operands);
+        for (size_t k = 0; k < n; k++) {
+            if (CLRL_OPERAND_KIND(*operands[k]) == CLRL_OPERAND_REG) last_use[CLRL_OPERAND_INDEX(*operands[k])] = (uint32_t)i;
+        }
+    }
+
+    size_t used = 0;
+    for (size_t i = first; i < opt->code_count; i++) {
+        ClrlInsn* insn = &opt->code[i];
+        uint32_t* operands[3];
+        size_t n = insn_operands(insn, operands);
+        uint32_t released[3];
+        size_t release_count = 0;
+        for (size_t k = 0; k < n; k++) {
+            if (CLRL_OPERAND_KIND(*operands[k]) != CLRL_OPERAND_REG) continue;
+            uint32_t virtual_reg = CLRL_OPERAND_INDEX(*operands[k]);
+            *operands[k] = CLRL_OPERAND(CLRL_OPERAND_REG, physical[virtual_reg]);
+            if (last_use[virtual_reg] == i) released[release_count++] = physical[virtual_reg];
+        }
+        if (insn->op == CLRL_OP_STORE || insn->op == CLRL_OP_NEG) insn->b = insn->a;
+        for (size_t k = 0; k < release_count; k++) busy[released[k]] = 0;
+        if (insn->op <= CLRL_OP_ROOT) {
+            uint32_t reg = 0;
+            while (busy[reg]) reg++;
+            busy[reg] = 1;
+            physical[insn->dst] = reg;
+            insn->dst = reg;
+            if (reg + 1 > used) used = reg + 1;
+        }
+    }
+    if (used > *max_registers) *max_registers = used;
+    free(last_use);
+    free(busy);
+    return 0;
+}
+
+/**
+ * @brief Rewrite one statement of the original program
+ */
+static int rewrite_statement(Optimizer* opt, size_t index, size_t* max_registers) {
+    const ClrlProgram* program = opt->program;
+    const ClrlStatement* statement = &program->statements[index];
+    size_t first = opt->code_count;
+    int keep = 1;
+    int infallible = 0;
+    opt->statement = (uint32_t)index;
+    opt->register_count = 0;
+
+    for (size_t i = 0; i < statement->count; i++) {
+        const ClrlInsn* insn = &program->code[statement->first + i];
+        int larnum_only = (insn->flags & CLRL_FLAG_LARNUM_ONLY) != 0;
+        switch (insn->op) {
+            case CLRL_OP_SET_PRECISION:
+                opt->precision = insn->imm;
+                if (emit(opt, insn) != 0) return -1;
+                break;
+
+            case CLRL_OP_RETURN:
+                if (emit(opt, insn) != 0) return -1;
+                break;
+
+            case CLRL_OP_STORE: {
+                uint32_t v, stored;
+                if (operand_value(opt, insn->a, larnum_only, &v) != 0) return -1;
+                stored = v;
+                if ((insn->flags & CLRL_FLAG_TO_PRECISE) && precise_value(opt, v, &stored) != 0) return -1;
+                int certain = opt->values[v].certain;
+                if (certain && opt->slot_value[insn->dst] == stored) {
+                    keep = 0;   // The variable already holds this value
+                    break;
+                }
+                ClrlInsn store = *insn;
+                opt->flags = insn->flags & CLRL_FLAG_LARNUM_ONLY;
+                if (materialize(opt, v, &store.a) != 0) return -1;
+                store.b = store.a;
+                if (emit(opt, &store) != 0) return -1;
+                // A store that may fail leaves either value behind
+                if (certain) {
+                    opt->slot_value[insn->dst] = stored;
+                    opt->values[stored].holder = insn->dst;
+                } else if (input_value(opt, &opt->slot_value[insn->dst]) != 0) {
+                    return -1;
+                }
+                infallible = certain;
+                break;
+            }
+
+            default: {
+                uint32_t a, b;
+                if (operand_value(opt, insn->a, larnum_only, &a) != 0) return -1;
+                if (insn->op == CLRL_OP_NEG) {
+                    b = a;
+                } else if (operand_value(opt, insn->b, larnum_only, &b) != 0) {
+                    return -1;
+                }
+                uint32_t precision = insn->imm;
+                if (insn->op == CLRL_OP_POWMOD) {
+                    if (operand_value(opt, insn->imm, larnum_only, &precision) != 0) return -1;
+                } else if (precision == CLRL_PRECISION_GLOBAL) {
+                    precision = opt->precision;
+                }
+                if (arith_value(opt, insn->op, a, b, precision, &opt->reg_value[insn->dst]) != 0) return -1;
+                break;
+            }
+        }
+    }
+
+    if (!keep) {
+        opt->code_count = first;
+        return 0;
+    }
+    if (allocate_registers(opt, first, max_registers) != 0) return -1;
+    ClrlStatement* rewritten = &opt->statements[opt->statement_count];
+    rewritten->first = first;
+    rewritten->count = opt->code_count - first;
+    rewritten->line = statement->line;
+    rewritten->profile = statement->profile;
+    opt->infallible[opt->statement_count++] = (uint8_t)infallible;
+    return 0;
+}
+
+// ===================== Dead stores =====================
+
+/**
+ * @brief Mark statements whose store nothing reads
+ *
+ * Walks backwards with the set of slots that are read before their next
+ * store. A statement that stores a slot outside that set is dead if it
+ * cannot fail; a dead statement's own reads do not count.
+ */
+static int find_dead_stores(const Optimizer* opt, unsigned flags, uint8_t* dead) {
+    size_t slot_count = opt->program->slot_count;
+    uint8_t* live = (uint8_t*)malloc(slot_count > 0 ? slot_count : 1);
+    if (live == NULL) return -1;
+    // Outside a closed program every variable may still be read afterwards
+    memset(live, (flags & CLRL_OPTIMIZE_CLOSED) ? 0 : 1, slot_count);
+
+    for (size_t i = opt->statement_count; i-- > 0;) {
+        const ClrlStatement* statement = &opt->statements[i];
+        const ClrlInsn* last = &opt->code[statement->first + statement->count - 1];
+        if (last->op == CLRL_OP_STORE) {
+            if (!live[last->dst] && opt->infallible[i]) {
+                dead[i] = 1;
+                continue;
+            }
+            // If the store may fail, later reads can still see the previous value
+            if (opt->infallible[i]) live[last->dst] = 0;
+        }
+        for (size_t k = 0; k < statement->count; k++) {
+            ClrlInsn* insn = &opt->code[statement->first + k];
+            uint32_t* operands[3];
+            size_t n = insn_operands(insn, operands);
+            for (size_t j = 0; j < n; j++) {
+                if (CLRL_OPERAND_KIND(*operands[j]) == CLRL_OPERAND_VAR) live[CLRL_OPERAND_INDEX(*operands[j])] = 1;
+            }
+        }
+    }
+    free(live);
+    return 0;
+}
+
+// ===================== Constant folding =====================
+
+/**
+ * @brief Compute a foldable value (once; operands first)
+ *
+ * @return const ClrlValue* The value, or NULL on allocation failure
+ */
+static const ClrlValue* fold_value(Optimizer* opt, uint32_t v) {
+    Value* x = &opt->values[v];
+    if (x->op == VALUE_CONST) return &opt->program->constants[x->a];
+    if (x->folded) return &opt->folded[v];
+
+    const ClrlValue* a = fold_value(opt, x->a);
+    if (a == NULL) return NULL;
+    int status;
+    if (x->op == VALUE_TO_PRECISE) {
+        status = clrl_value_assign(&opt->folded[v], a, 1);
+    } else {
+        const ClrlValue* b = (x->op == CLRL_OP_NEG) ? a : fold_value(opt, x->b);
+        if (b == NULL) return NULL;
+        if (x->op == CLRL_OP_POWMOD) {
+            const ClrlValue* m = fold_value(opt, x->precision);
+            if (m == NULL) return NULL;
+            status = clrl_value_powmod(&opt->folded[v], a, b, m);
+        } else {
+            // Foldable divisions and roots have safe literal operands and a known precision
+            status = clrl_value_arith(x->op, &opt->folded[v], a, b, x->precision);
+        }
+    }
+    if (status != 0) return NULL;
+    x->folded = 1;
+    return &opt->folded[v];
+}
+
+/**
+ * @brief Index of value v in the optimized constant table
+ */
+static int fold_constant(Optimizer* opt, uint32_t v, uint32_t* constant) {
+    if (opt->values[v].constant != NO_INDEX) {
+        *constant = opt->values[v].constant;
+        return 0;
+    }
+    const ClrlValue* value = fold_value(opt, v);
+    if (value == NULL) return -1;
+    if (opt->constant_count == opt->constant_capacity) {
+        size_t capacity = (opt->constant_capacity == 0) ? 16 : opt->constant_capacity * 2;
+        ClrlValue* constants = (ClrlValue*)realloc(opt->constants, capacity * sizeof(ClrlValue));
+        if (constants == NULL) return -1;
+        opt->constants = constants;
+        opt->constant_capacity = capacity;
+    }
+    ClrlValue* copy = &opt->constants[opt->constant_count];
+    copy->type = VAR_LARNUM;
+    larnum_init(&copy->value.larnum_val);
+    if (clrl_value_assign(copy, value, 0) != 0) {
+        larnum_free(&copy->value.larnum_val);
+        return -1;
+    }
+    opt->values[v].constant = (uint32_t)opt->constant_count;
+    *constant = (uint32_t)opt->constant_count++;
+    return 0;
+}
+
+// ===================== Driver =====================
+
+/**
+ * @brief Move the live statements into program and give constants their final indices
+ */
+static int finish_program(Optimizer* opt, const uint8_t* dead, size_t register_count) {
+    ClrlProgram* program = opt->program;
+    size_t statement_capacity = program->statement_count;   // Size of opt->statements
+    size_t kept = 0, code_count = 0;
+    for (size_t i = 0; i < opt->statement_count; i++) {
+        if (dead[i]) continue;
+        const ClrlStatement* statement = &opt->statements[i];
+        for (size_t k = 0; k < statement->count; k++) {
+            ClrlInsn insn = opt->code[statement->first + k];
+            uint32_t* operands[3];
+            size_t n = insn_operands(&insn, operands);
+            for (size_t j = 0; j < n; j++) {
+                if (CLRL_OPERAND_KIND(*operands[j]) != CLRL_OPERAND_CONST) continue;
+                uint32_t constant;
+                if (fold_constant(opt, CLRL_OPERAND_INDEX(*operands[j]), &constant) != 0) return -1;
+                *operands[j] = CLRL_OPERAND(CLRL_OPERAND_CONST, constant);
+            }
+            if (insn.op == CLRL_OP_STORE || insn.op == CLRL_OP_NEG) insn.b = insn.a;
+            // Compacting in place: the write position never passes the read position
+            opt->code[code_count + k] = insn;
+        }
+        opt->statements[kept].first = code_count;
+        opt->statements[kept].count = statement->count;
+        opt->statements[kept].line = statement->line;
+        opt->statements[kept].profile = statement->profile;
+        code_count += statement->count;
+        kept++;
+    }
+
+    for (size_t i = 0; i < program->constant_count; i++) {
+        larnum_free(&program->constants[i].value.larnum_val);
+    }
+    free(program->code);
+    free(program->statements);
+    free(program->constants);
+    program->code = opt->code;
+    program->code_count = code_count;
+    program->code_capacity = opt->code_capacity;
+    program->statements = opt->statements;
+    program->statement_count = kept;
+    program->statement_capacity = statement_capacity;
+    program->constants = opt->constants;
+    program->constant_count = opt->constant_count;
+    program->constant_capacity = opt->constant_capacity;
+    program->register_count = register_count;
+    opt->code = NULL;
+    opt->statements = NULL;
+    opt->constants = NULL;
+    opt->constant_count = 0;
+    return 0;
+}
+
+int clrl_optimize(ClrlProgram* program, unsigned flags) {
+    if (program->statement_count == 0) return 0;
+
+    Optimizer opt;
+    memset(&opt, 0, sizeof(opt));
+    opt.program = program;
+    opt.precision = CLRL_PRECISION_GLOBAL;
+    size_t registers = (program->register_count > 0) ? program->register_count : 1;
+    size_t slots = (program->slot_count > 0) ? program->slot_count : 1;
+    opt.slot_value = (uint32_t*)malloc(slots * sizeof(uint32_t));
+    opt.reg_value = (uint32_t*)malloc(registers * sizeof(uint32_t));
+    opt.statements = (ClrlStatement*)malloc(program->statement_count * sizeof(ClrlStatement));
+    opt.infallible = (uint8_t*)malloc(program->statement_count);
+    uint8_t* dead = (uint8_t*)calloc(program->statement_count, 1);
+
+    int status = -1;
+    size_t register_count = 0;
+    if (opt.slot_value != NULL && opt.reg_value != NULL && opt.statements != NULL &&
+        opt.infallible != NULL && dead != NULL) {
+        memset(opt.slot_value, 0xFF, slots * sizeof(uint32_t));
+        status = 0;
+        for (size_t i = 0; i < program->statement_count && status == 0; i++) {
+            status = rewrite_statement(&opt, i, &register_count);
+        }
+        if (status == 0) status = find_dead_stores(&opt, flags, dead);
+        if (status == 0) {
+            // Only constants that live statements use are ever computed
+            opt.folded = (ClrlValue*)calloc(opt.value_count > 0 ? opt.value_count : 1, sizeof(ClrlValue));
+            status = (opt.folded != NULL) ? finish_program(&opt, dead, register_count) : -1;
+        }
+    }
+    if (status != 0) optimize_error();
+
+    if (opt.folded != NULL) {
+        for (size_t v = 0; v < opt.value_count; v++) {
+            if (opt.values[v].folded) clrl_value_free(&opt.folded[v]);
+        }
+    }
+    for (size_t i = 0; i < opt.constant_count; i++) {
+        larnum_free(&opt.constants[i].value.larnum_val);
+    }
+    free(opt.folded);
+    free(opt.constants);
+    free(opt.values);
+    free(opt.index);
+    free(opt.slot_value);
+    free(opt.reg_value);
+    free(opt.code);
+    free(opt.statements);
+    free(opt.infallible);
+    free(dead);
+    return status;
+}
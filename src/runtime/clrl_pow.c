@@ -0,0 +1,348 @@
+#include "../../include/clrl/clrl_larnum.h"
+#include "../../include/clrl/clrl_profile.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_backend.h"
+#include "clrl_limbs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Powers and modular powers
+ *
+ * Both run the same left-to-right sliding-window loop: the odd powers
+ * x, x^3, ..., x^(2^w - 1) are computed once, and every window of up to w
+ * exponent bits then costs w squarings (the squaring kernels of the
+ * multiplication engine) and a single multiplication. For a ^ e the
+ * factor 2^k of a is taken out first and applied as one shift at the end.
+ *
+ * powmod reduces after every product, so no intermediate is longer than
+ * twice the modulus: odd moduli use Montgomery reduction, even moduli and
+ * very long ones (where REDC's quadratic cost loses to two fast products)
+ * use Barrett reduction with a reciprocal computed once per call.
+ */
+
+// Moduli of at least this many limbs use Barrett reduction even when odd
+#define POWMOD_BARRETT_THRESHOLD 128
+
+// Largest sliding window (2^(w-1) precomputed odd powers)
+#define POW_MAX_WINDOW 6
+
+typedef enum {
+    RING_INTEGERS,    // No reduction (a ^ e)
+    RING_MONTGOMERY,  // Values are x * R mod m, R = 2^(32 n)
+    RING_BARRETT      // Values are x mod m
+} RingKind;
+
+/**
+ * @brief Arithmetic the window loop works in
+ */
+typedef struct {
+    RingKind kind;
+    Larnum m;             // |modulus| (view)
+    LarnumLimb m_inv;     // -1 / m mod 2^32 (Montgomery)
+    Larnum mu;            // floor(2^(64 n) / m) (Barrett)
+    Larnum product;       // Unreduced product
+    Larnum scratch;       // Barrett quotient estimate
+} Ring;
+
+static void ring_init(Ring* ring, RingKind kind) {
+    memset(ring, 0, sizeof(*ring));
+    ring->kind = kind;
+    larnum_init(&ring->mu);
+    larnum_init(&ring->product);
+    larnum_init(&ring->scratch);
+}
+
+static void ring_free(Ring* ring) {
+    larnum_free(&ring->mu);
+    larnum_free(&ring->product);
+    larnum_free(&ring->scratch);
+}
+
+/**
+ * @brief REDC: r = t / R mod m for 0 <= t < m * R (t is clobbered)
+ */
+static int montgomery_reduce(Ring* ring, Larnum* r, Larnum* t) {
+    size_t n = ring->m.size;
+    if (larnum_reserve(t, 2 * n + 1) != 0) return -1;
+    if (t->size < 2 * n + 1) memset(t->limbs + t->size, 0, (2 * n + 1 - t->size) * sizeof(LarnumLimb));
+
+    LarnumLimb* tl = t->limbs;
+    for (size_t i = 0; i < n; i++) {
+        // Choose u so that limb i becomes zero, then carry into the upper half
+        LarnumLimb u = tl[i] * ring->m_inv;
+        LarnumLimb carry = limbs_addmul_1(tl + i, ring->m.limbs, n, u);
+        for (size_t j = i + n; carry != 0 && j <= 2 * n; j++) {
+            LarnumLimb v = tl[j] + carry;
+            carry = (v < carry) ? 1 : 0;
+            tl[j] = v;
+        }
+    }
+
+    // The quotient is below 2m, so one subtraction is enough
+    LarnumLimb* high = tl + n;
+    if (high[n] != 0 || limbs_cmp(high, ring->m.limbs, n) >= 0) {
+        limbs_sub_n(high, high, ring->m.limbs, n);
+    }
+    if (larnum_reserve(r, n) != 0) return -1;
+    memcpy(r->limbs, high, n * sizeof(LarnumLimb));
+    r->size = limbs_normalize(r->limbs, n);
+    r->negative = 0;
+    return 0;
+}
+
+/**
+ * @brief r = t mod m for 0 <= t < 2^(64 n), using the precomputed mu
+ */
+static int barrett_reduce(Ring* ring, Larnum* r, const Larnum* t) {
+    size_t n = ring->m.size;
+    Larnum* q = &ring->scratch;
+    // q = floor(floor(t / B^(n-1)) * mu / B^(n+1)) is at most 2 below t / m
+    if (larnum_shr(q, t, (n - 1) * LARNUM_LIMB_BITS) != 0 ||
+        larnum_mul(q, q, &ring->mu) != 0 ||
+        larnum_shr(q, q, (n + 1) * LARNUM_LIMB_BITS) != 0 ||
+        larnum_mul(q, q, &ring->m) != 0 ||
+        larnum_sub(r, t, q) != 0) return -1;
+    while (larnum_cmp_abs(r, &ring->m) >= 0) {
+        if (larnum_sub(r, r, &ring->m) != 0) return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief r = a * b in the ring (r may alias a or b; a == b squares)
+ */
+static int ring_mul(Ring* ring, Larnum* r, const Larnum* a, const Larnum* b) {
+    switch (ring->kind) {
+        case RING_MONTGOMERY:
+            if (larnum_mul(&ring->product, a, b) != 0) return -1;
+            return montgomery_reduce(ring, r, &ring->product);
+        case RING_BARRETT:
+            if (larnum_mul(&ring->product, a, b) != 0) return -1;
+            return barrett_reduce(ring, r, &ring->product);
+        default:
+            return larnum_mul(r, a, b);
+    }
+}
+
+/**
+ * @brief Bit i of |e|
+ */
+static int exponent_bit(const Larnum* e, size_t i) {
+    return (int)((e->limbs[i / LARNUM_LIMB_BITS] >> (i % LARNUM_LIMB_BITS)) & 1u);
+}
+
+/**
+ * @brief Window width for an exponent of `bits` bits
+ */
+static int window_bits(size_t bits) {
+    if (bits <= 8) return 1;
+    if (bits <= 24) return 2;
+    if (bits <= 80) return 3;
+    if (bits <= 240) return 4;
+    if (bits <= 672) return 5;
+    return POW_MAX_WINDOW;
+}
+
+/**
+ * @brief r = x ^ |e| in the ring (e > 0, x already in ring form)
+ */
+static int window_pow(Ring* ring, Larnum* r, const Larnum* x, const Larnum* e) {
+    size_t bits = larnum_bit_length(e);
+    int w = window_bits(bits);
+    size_t table_size = (size_t)1 << (w - 1);
+    Larnum table[1 << (POW_MAX_WINDOW - 1)];
+    Larnum result;
+    larnum_init(&result);
+    for (size_t k = 0; k < table_size; k++) larnum_init(&table[k]);
+
+    // table[k] = x^(2k + 1)
+    int status = larnum_copy(&table[0], x);
+    if (status == 0 && table_size > 1) {
+        Larnum square;
+        larnum_init(&square);
+        status = ring_mul(ring, &square, x, x);
+        for (size_t k = 1; k < table_size && status == 0; k++) {
+            status = ring_mul(ring, &table[k], &table[k - 1], &square);
+        }
+        larnum_free(&square);
+    }
+
+    int started = 0;
+    size_t i = bits;
+    while (status == 0 && i > 0) {
+        if (!exponent_bit(e, i - 1)) {
+            status = ring_mul(ring, &result, &result, &result);
+            i--;
+            continue;
+        }
+        // Longest window of at most w bits that ends in a set bit
+        size_t low = (i > (size_t)w) ? i - (size_t)w : 0;
+        while (!exponent_bit(e, low)) low++;
+        size_t value = 0;
+        for (size_t j = i; j > low; j--) value = (value << 1) | (size_t)exponent_bit(e, j - 1);
+
+        if (!started) {
+            status = larnum_copy(&result, &table[value >> 1]);
+            started = 1;
+        } else {
+            for (size_t j = low; j < i && status == 0; j++) {
+                status = ring_mul(ring, &result, &result, &result);
+            }
+            if (status == 0) status = ring_mul(ring, &result, &result, &table[value >> 1]);
+        }
+        i = low;
+    }
+
+    if (status == 0) {
+        larnum_free(r);
+        *r = result;
+    } else {
+        larnum_free(&result);
+    }
+    for (size_t k = 0; k < table_size; k++) larnum_free(&table[k]);
+    return status;
+}
+
+// ===================== Powers =====================
+
+int larnum_pow(Larnum* r, const Larnum* a, const Larnum* e) {
+    LARNUM_BACKEND_CALL(pow, a->size, r, a, e);
+    if (e->negative) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Negative exponent\n");
+        return -1;
+    }
+    int negative = a->negative && e->size > 0 && (e->limbs[0] & 1u);
+    // 0^0 = 1, and powers of 0 and 1 need no work whatever the exponent
+    if (e->size == 0 || (a->size == 1 && a->limbs[0] == 1)) return larnum_set_small(r, 1, 0, negative);
+    if (a->size == 0) return larnum_set_small(r, 0, 0, 0);
+
+    // |a| = odd * 2^shift, so a^e = odd^e * 2^(shift * e)
+    size_t shift = 0;
+    while (a->limbs[shift / LARNUM_LIMB_BITS] == 0) shift += LARNUM_LIMB_BITS;
+    while (((a->limbs[shift / LARNUM_LIMB_BITS] >> (shift % LARNUM_LIMB_BITS)) & 1u) == 0) shift++;
+
+    // The result has at least (bits(a) - 1) * e bits; refuse sizes no buffer can hold
+    size_t bits = larnum_bit_length(a);
+    uint64_t exponent = (e->size <= LIMBS_SMALL) ? larnum_get_small(e) : UINT64_MAX;
+    if (exponent > (uint64_t)(SIZE_MAX / 2) / bits) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Exponent is too large\n");
+        return -1;
+    }
+
+    Larnum odd;
+    larnum_init(&odd);
+    if (larnum_shr(&odd, a, shift) != 0) return -1;
+    odd.negative = 0;
+
+    int status = 0;
+    if (odd.size == 1 && odd.limbs[0] == 1) {
+        status = larnum_set_small(r, 1, 0, 0);
+    } else {
+        Ring ring;
+        ring_init(&ring, RING_INTEGERS);
+        status = window_pow(&ring, r, &odd, e);
+        ring_free(&ring);
+    }
+    larnum_free(&odd);
+    if (status == 0 && shift > 0) status = larnum_shl(r, r, shift * (size_t)exponent);
+    if (status == 0) r->negative = negative;
+    return status;
+}
+
+// ===================== Modular powers =====================
+
+/**
+ * @brief -1 / m0 mod 2^32 for odd m0 (Newton iteration)
+ */
+static LarnumLimb limb_negative_inverse(LarnumLimb m0) {
+    LarnumLimb inverse = m0;   // Correct to 3 bits for any odd m0; each step doubles that
+    for (int i = 0; i < 4; i++) inverse *= 2 - m0 * inverse;
+    return (LarnumLimb)(0u - inverse);
+}
+
+/**
+ * @brief Set up reduction modulo ring->m and move x into ring form
+ */
+static int ring_enter(Ring* ring, Larnum* x) {
+    size_t n = ring->m.size;
+    if (ring->kind == RING_MONTGOMERY) {
+        ring->m_inv = limb_negative_inverse(ring->m.limbs[0]);
+        // x * R mod m
+        if (larnum_shl(x, x, n * LARNUM_LIMB_BITS) != 0) return -1;
+        return larnum_divmod(NULL, x, x, &ring->m);
+    }
+    // mu = floor(B^(2n) / m)
+    Larnum power;
+    larnum_init(&power);
+    if (larnum_set_small(&power, 1, 0, 0) != 0 || larnum_shl(&power, &power, 2 * n * LARNUM_LIMB_BITS) != 0 ||
+        larnum_divmod(&ring->mu, NULL, &power, &ring->m) != 0) {
+        larnum_free(&power);
+        return -1;
+    }
+    larnum_free(&power);
+    return 0;
+}
+
+int larnum_powmod(Larnum* r, const Larnum* a, const Larnum* e, const Larnum* m) {
+    LARNUM_BACKEND_CALL(powmod, m->size, r, a, e, m);
+    if (m->size == 0) {
+        clrl_error(CLRL_ERROR_DIVISION_BY_ZERO, "Error: Division by zero\n");
+        return -1;
+    }
+    if (e->negative) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Negative exponent\n");
+        return -1;
+    }
+    // Same sign as (a ^ e) % m: negative only for a negative base and an odd exponent
+    int negative = a->negative && e->size > 0 && (e->limbs[0] & 1u);
+
+    Ring ring;
+    ring_init(&ring, (m->limbs[0] & 1u) && m->size < POWMOD_BARRETT_THRESHOLD ? RING_MONTGOMERY : RING_BARRETT);
+    ring.m = *m;
+    ring.m.negative = 0;
+
+    // Work on |a| mod |m|
+    Larnum base;
+    larnum_init(&base);
+    int status = larnum_divmod(NULL, &base, a, &ring.m);
+    base.negative = 0;
+    if (status == 0 && (e->size == 0 || base.size == 0 || (ring.m.size == 1 && ring.m.limbs[0] == 1))) {
+        // x^0 = 1, 0^e = 0, and everything is 0 modulo 1
+        int one = e->size == 0 && !(ring.m.size == 1 && ring.m.limbs[0] == 1);
+        status = larnum_set_small(r, one ? 1 : 0, 0, 0);
+        larnum_free(&base);
+        ring_free(&ring);
+        return status;
+    }
+
+    uint64_t started = clrl_profiling() ? clrl_profile_now() : 0;
+    if (status == 0) status = ring_enter(&ring, &base);
+    Larnum result;
+    larnum_init(&result);
+    if (status == 0) status = window_pow(&ring, &result, &base, e);
+    if (status == 0 && ring.kind == RING_MONTGOMERY) {
+        // Leave Montgomery form: divide by R once more
+        if (larnum_copy(&ring.product, &result) == 0) {
+            status = montgomery_reduce(&ring, &result, &ring.product);
+        } else {
+            status = -1;
+        }
+    }
+    if (started != 0) {
+        clrl_profile_op((ring.kind == RING_MONTGOMERY) ? CLRL_PROFILE_POWMOD_MONTGOMERY : CLRL_PROFILE_POWMOD_BARRETT,
+                        m->size, e->size, started);
+    }
+
+    if (status == 0) {
+        result.negative = (result.size > 0) ? negative : 0;
+        larnum_free(r);
+        *r = result;
+    } else {
+        larnum_free(&result);
+    }
+    larnum_free(&base);
+    ring_free(&ring);
+    return status;
+}
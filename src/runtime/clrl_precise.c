@@ -0,0 +1,319 @@
+#include "../../include/clrl/clrl_precise.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_limbs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Powers of ten that fit in one limb, for cheap small rescaling
+static const LarnumLimb small_pow10[10] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u,
+    1000000u, 10000000u, 100000000u, 1000000000u
+};
+
+void precise_init(Precise* x) {
+    larnum_init(&x->coefficient);
+    x->exponent = 0;
+}
+
+void precise_free(Precise* x) {
+    if (x == NULL) return;
+    larnum_free(&x->coefficient);
+    x->exponent = 0;
+}
+
+int precise_copy(Precise* dst, const Precise* src) {
+    if (dst == src) return 0;
+    if (larnum_copy(&dst->coefficient, &src->coefficient) != 0) return -1;
+    dst->exponent = src->exponent;
+    return 0;
+}
+
+int precise_from_larnum(Precise* x, const Larnum* value) {
+    if (larnum_copy(&x->coefficient, value) != 0) return -1;
+    x->exponent = 0;
+    return 0;
+}
+
+/**
+ * @brief r = a * 10^k (k >= 0, r may alias a)
+ */
+static int larnum_mul_pow10(Larnum* r, const Larnum* a, uint64_t k) {
+    if (k == 0) return larnum_copy(r, a);
+    if (a->size == 0) {
+        r->size = 0;
+        r->negative = 0;
+        return 0;
+    }
+
+    // One limb multiply for small rescales, which is the common case
+    if (k < 10) {
+        size_t n = a->size;
+        int negative = a->negative;
+        if (larnum_reserve(r, n + 1) != 0) return -1;
+        LarnumLimb carry = limbs_mul_1(r->limbs, a->limbs, n, small_pow10[k]);
+        r->limbs[n] = carry;
+        r->size = n + (carry ? 1 : 0);
+        r->negative = negative;
+        return 0;
+    }
+
+    Larnum scale;
+    larnum_init(&scale);
+    int status = -1;
+    if (larnum_pow10(&scale, (size_t)k) == 0 && larnum_mul(r, a, &scale) == 0) status = 0;
+    larnum_free(&scale);
+    return status;
+}
+
+int precise_from_string(Precise* x, const char* str, size_t len) {
+    if (str == NULL || len == 0) return -1;
+
+    // Validate: [+-] digits [ '.' digits ], at least one digit overall
+    size_t pos = (str[0] == '+' || str[0] == '-') ? 1 : 0;
+    size_t dot = pos + decimal_span(str + pos, len - pos);
+    size_t digits = dot - pos;
+    if (dot < len) {
+        if (str[dot] != '.') return -1;
+        size_t frac = decimal_span(str + dot + 1, len - dot - 1);
+        if (dot + 1 + frac != len) return -1;
+        digits += frac;
+    }
+    if (digits == 0) return -1;
+
+    int negative = (str[0] == '-');
+    size_t frac_digits = (dot == len) ? 0 : len - dot - 1;
+
+    if (dot == len) {
+        if (larnum_from_string(&x->coefficient, str + pos, len - pos) != 0) return -1;
+    } else {
+        // Drop the '.' with one scratch copy of the digits; the parse itself is in place
+        ClrlArena* scratch = clrl_scratch_arena();
+        ClrlArenaMark mark = clrl_arena_mark(scratch);
+        char* joined = (char*)clrl_arena_alloc(scratch, digits);
+        if (joined == NULL) {
+            clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for precise value\n");
+            return -1;
+        }
+        size_t int_digits = dot - pos;
+        memcpy(joined, str + pos, int_digits);
+        memcpy(joined + int_digits, str + dot + 1, frac_digits);
+        int status = larnum_from_string(&x->coefficient, joined, digits);
+        clrl_arena_rewind(scratch, mark);
+        if (status != 0) return -1;
+    }
+
+    x->coefficient.negative = (negative && x->coefficient.size > 0) ? 1 : 0;
+    x->exponent = -(int64_t)frac_digits;
+    return 0;
+}
+
+char* precise_to_string(const Precise* x) {
+    Larnum magnitude = x->coefficient;   // shallow view without the sign
+    magnitude.negative = 0;
+    char* digits = larnum_to_string(&magnitude);
+    if (digits == NULL) return NULL;
+
+    size_t len = strlen(digits);
+    int negative = x->coefficient.negative;
+    char* text;
+
+    if (x->exponent >= 0) {
+        // Integer value: append the trailing zeros (none for a zero coefficient)
+        size_t zeros = (magnitude.size > 0) ? (size_t)x->exponent : 0;
+        text = (char*)malloc(len + zeros + 2);
+        if (text != NULL) {
+            char* out = text;
+            if (negative) *out++ = '-';
+            memcpy(out, digits, len);
+            memset(out + len, '0', zeros);
+            out[len + zeros] = '\0';
+        }
+    } else {
+        // Left-pad with zeros so there is at least one integer digit
+        size_t frac = (size_t)(-x->exponent);
+        size_t pad = (len > frac) ? 0 : frac + 1 - len;
+        size_t total = len + pad;
+        size_t int_len = total - frac;
+        text = (char*)malloc(total + 3);
+        if (text != NULL) {
+            char* out = text;
+            if (negative) *out++ = '-';
+            memset(out, '0', pad);
+            memcpy(out + pad, digits, len);
+            // Shift the fractional digits one place right to make room for '.'
+            memmove(out + int_len + 1, out + int_len, frac);
+            out[int_len] = '.';
+            out[total + 1] = '\0';
+        }
+    }
+
+    if (text == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while printing precise\n");
+    }
+    free(digits);
+    return text;
+}
+
+/**
+ * @brief Bring a and b to the common exponent min(ea, eb)
+ *
+ * The operand that needs no rescaling is returned as a shallow view, so at
+ * most one coefficient is touched.
+ */
+static int precise_align(const Precise* a, const Precise* b,
+                         Larnum* ca, Larnum* cb, Larnum* scratch, int64_t* exponent) {
+    if (a->exponent == b->exponent) {
+        *ca = a->coefficient;
+        *cb = b->coefficient;
+        *exponent = a->exponent;
+        return 0;
+    }
+    if (a->exponent > b->exponent) {
+        if (larnum_mul_pow10(scratch, &a->coefficient, (uint64_t)(a->exponent - b->exponent)) != 0) return -1;
+        *ca = *scratch;
+        *cb = b->coefficient;
+        *exponent = b->exponent;
+    } else {
+        if (larnum_mul_pow10(scratch, &b->coefficient, (uint64_t)(b->exponent - a->exponent)) != 0) return -1;
+        *ca = a->coefficient;
+        *cb = *scratch;
+        *exponent = a->exponent;
+    }
+    return 0;
+}
+
+int precise_cmp(const Precise* a, const Precise* b) {
+    Larnum ca, cb, scratch;
+    int64_t exponent;
+    larnum_init(&scratch);
+    if (precise_align(a, b, &ca, &cb, &scratch, &exponent) != 0) return -2;
+    int cmp = larnum_cmp(&ca, &cb);
+    larnum_free(&scratch);
+    return cmp;
+}
+
+/**
+ * @brief Shared add/sub: scale-align, then one integer add into r
+ */
+static int precise_add_sub(Precise* r, const Precise* a, const Precise* b, int subtract) {
+    Larnum ca, cb, scratch;
+    int64_t exponent;
+    larnum_init(&scratch);
+    if (precise_align(a, b, &ca, &cb, &scratch, &exponent) != 0) return -1;
+
+    // ca/cb may be views of r's own buffer, so build the sum separately
+    Larnum sum;
+    larnum_init(&sum);
+    int status = subtract ? larnum_sub(&sum, &ca, &cb) : larnum_add(&sum, &ca, &cb);
+    if (status == 0) {
+        larnum_free(&r->coefficient);
+        r->coefficient = sum;
+        r->exponent = exponent;
+    } else {
+        larnum_free(&sum);
+    }
+    larnum_free(&scratch);
+    return status;
+}
+
+int precise_add(Precise* r, const Precise* a, const Precise* b) {
+    return precise_add_sub(r, a, b, 0);
+}
+
+int precise_sub(Precise* r, const Precise* a, const Precise* b) {
+    return precise_add_sub(r, a, b, 1);
+}
+
+int precise_mul(Precise* r, const Precise* a, const Precise* b) {
+    int64_t exponent = a->exponent + b->exponent;
+    if (larnum_mul(&r->coefficient, &a->coefficient, &b->coefficient) != 0) return -1;
+    r->exponent = exponent;
+    return 0;
+}
+
+int precise_div(Precise* r, const Precise* a, const Precise* b, size_t digits) {
+    if (larnum_is_zero(&b->coefficient)) {
+        clrl_error(CLRL_ERROR_DIVISION_BY_ZERO, "Error: Division by zero\n");
+        return -1;
+    }
+
+    // a/b * 10^digits = ca / cb * 10^(ea - eb + digits)
+    int64_t shift = a->exponent - b->exponent + (int64_t)digits;
+    Larnum scaled, quotient;
+    larnum_init(&scaled);
+    larnum_init(&quotient);
+    int status = -1;
+
+    if (shift >= 0) {
+        if (larnum_mul_pow10(&scaled, &a->coefficient, (uint64_t)shift) == 0 &&
+            larnum_divmod(&quotient, NULL, &scaled, &b->coefficient) == 0) status = 0;
+    } else {
+        if (larnum_mul_pow10(&scaled, &b->coefficient, (uint64_t)(-shift)) == 0 &&
+            larnum_divmod(&quotient, NULL, &a->coefficient, &scaled) == 0) status = 0;
+    }
+
+    if (status == 0) {
+        larnum_free(&r->coefficient);
+        r->coefficient = quotient;
+        r->exponent = -(int64_t)digits;
+    } else {
+        larnum_free(&quotient);
+    }
+    larnum_free(&scaled);
+    return status;
+}
+
+int precise_pow(Precise* r, const Precise* a, const Larnum* e) {
+    // The decimal exponent grows e-fold and has to stay an int64_t
+    int64_t exponent = 0;
+    if (!e->negative && e->size > 0) {
+        uint64_t magnitude = (a->exponent < 0) ? 0ULL - (uint64_t)a->exponent : (uint64_t)a->exponent;
+        uint64_t count = (e->size <= LIMBS_SMALL) ? larnum_get_small(e) : UINT64_MAX;
+        if (larnum_is_zero(&a->coefficient)) {
+            exponent = a->exponent;
+        } else if (magnitude > 0 && count > (uint64_t)INT64_MAX / magnitude) {
+            clrl_error(CLRL_ERROR_ARGUMENT, "Error: Exponent is too large\n");
+            return -1;
+        } else {
+            exponent = a->exponent * (int64_t)count;
+        }
+    }
+    if (larnum_pow(&r->coefficient, &a->coefficient, e) != 0) return -1;
+    r->exponent = exponent;
+    return 0;
+}
+
+int precise_root(Precise* r, const Precise* a, const Larnum* n, size_t digits) {
+    if (n->negative || n->size != 1) return larnum_root(&r->coefficient, &a->coefficient, n);
+
+    // a^(1/n) * 10^digits = (ca * 10^(ea + n * digits))^(1/n), and truncating
+    // the radicand first does not change the truncated root
+    uint64_t degree = n->limbs[0];
+    if (digits > (uint64_t)(INT64_MAX / 4) / degree || a->exponent < -(INT64_MAX / 4)) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Root precision is too large\n");
+        return -1;
+    }
+    int64_t shift = a->exponent + (int64_t)(degree * digits);
+    Larnum scaled, scale;
+    larnum_init(&scaled);
+    larnum_init(&scale);
+    int status = -1;
+    if (shift >= 0) {
+        if (larnum_mul_pow10(&scaled, &a->coefficient, (uint64_t)shift) == 0) status = 0;
+    } else if (larnum_pow10(&scale, (size_t)-shift) == 0 &&
+               larnum_divmod(&scaled, NULL, &a->coefficient, &scale) == 0) {
+        status = 0;
+    }
+    if (status == 0) status = larnum_root(&scaled, &scaled, n);
+
+    if (status == 0) {
+        larnum_free(&r->coefficient);
+        r->coefficient = scaled;
+        r->exponent = -(int64_t)digits;
+    } else {
+        larnum_free(&scaled);
+    }
+    larnum_free(&scale);
+    return status;
+}
@@ -0,0 +1,332 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include "../../include/clrl/clrl_profile.h"
+#include "../../include/clrl/clrl_runtime.h"
+#include "../../include/clrl/clrl_memory.h"
+#include "../../include/clrl/clrl_thread.h"
+#include "../../include/clrl/clrl_context.h"
+
+// Longest statement text kept for the report
+#define PROFILE_TEXT_MAX 72
+
+/**
+ * @brief Collected data of one statement
+ */
+typedef struct {
+    char* origin;         // File name (NULL = REPL input)
+    size_t line;
+    char* text;           // Statement text, clipped to PROFILE_TEXT_MAX
+    uint32_t hash;
+    size_t runs;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    size_t alloc_count;   // Number buffer allocations made by all runs
+    size_t alloc_bytes;
+} ProfileEntry;
+
+/**
+ * @brief Counters of one kernel/algorithm pair
+ */
+typedef struct {
+    size_t calls;
+    uint64_t total_ns;
+    size_t limbs;         // Sum of operand sizes
+    size_t max_limbs;     // Largest single operand
+} ProfileOpStats;
+
+static const char* const op_names[CLRL_PROFILE_OP_COUNT] = {
+    "mul/schoolbook", "mul/karatsuba", "mul/toom3", "mul/ntt",
+    "sqr/schoolbook", "sqr/karatsuba", "sqr/toom3", "sqr/ntt",
+    "div/schoolbook", "div/newton",
+    "powmod/montgomery", "powmod/barrett", "root/newton",
+    "parse/basecase", "parse/recursive",
+    "print/basecase", "print/recursive"
+};
+
+int clrl_profile_enabled = 0;
+
+// Entries are never freed, so ids held by compiled programs stay valid
+static ProfileEntry* entries;
+static size_t entry_count;
+static size_t entry_capacity;
+static uint32_t* buckets;          // Entry id per hash bucket (0 = empty)
+static size_t bucket_count;        // Power of two
+static ClrlLock profile_lock;      // Guards entries and buckets
+
+static ProfileOpStats op_stats[CLRL_PROFILE_OP_COUNT];
+
+// ===================== Control =====================
+
+void clrl_profile_set_enabled(int enabled) {
+    __atomic_store_n(&clrl_profile_enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+void clrl_profile_reset(void) {
+    clrl_lock_acquire(&profile_lock);
+    for (size_t i = 0; i < entry_count; i++) {
+        ProfileEntry* entry = &entries[i];
+        entry->runs = 0;
+        entry->total_ns = 0;
+        entry->max_ns = 0;
+        entry->alloc_count = 0;
+        entry->alloc_bytes = 0;
+    }
+    clrl_lock_release(&profile_lock);
+    for (int op = 0; op < CLRL_PROFILE_OP_COUNT; op++) {
+        __atomic_store_n(&op_stats[op].calls, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&op_stats[op].total_ns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&op_stats[op].limbs, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&op_stats[op].max_limbs, 0, __ATOMIC_RELAXED);
+    }
+}
+
+// ===================== Recording =====================
+
+uint64_t clrl_profile_now(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief FNV-1a over the statement key
+ */
+static uint32_t entry_hash(const char* origin, size_t line, const char* text, size_t len) {
+    uint32_t hash = 2166136261u;
+    if (origin != NULL) {
+        for (const char* p = origin; *p != '\0'; p++) hash = (hash ^ (unsigned char)*p) * 16777619u;
+    }
+    for (size_t i = 0; i < sizeof(line); i++) hash = (hash ^ (unsigned char)(line >> (8 * i))) * 16777619u;
+    for (size_t i = 0; i < len; i++) hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    return hash;
+}
+
+static int entry_matches(const ProfileEntry* entry, uint32_t hash, const char* origin, size_t line,
+                         const char* text, size_t len) {
+    if (entry->hash != hash || entry->line != line) return 0;
+    if ((entry->origin == NULL) != (origin == NULL)) return 0;
+    if (origin != NULL && strcmp(entry->origin, origin) != 0) return 0;
+    return strlen(entry->text) == len && memcmp(entry->text, text, len) == 0;
+}
+
+/**
+ * @brief Double the bucket array and re-insert every entry
+ */
+static int buckets_grow(void) {
+    size_t count = (bucket_count == 0) ? 64 : bucket_count * 2;
+    uint32_t* grown = (uint32_t*)calloc(count, sizeof(uint32_t));
+    if (grown == NULL) return -1;
+    for (size_t i = 0; i < entry_count; i++) {
+        size_t b = entries[i].hash & (count - 1);
+        while (grown[b] != 0) b = (b + 1) & (count - 1);
+        grown[b] = (uint32_t)(i + 1);
+    }
+    free(buckets);
+    buckets = grown;
+    bucket_count = count;
+    return 0;
+}
+
+/**
+ * @brief Append a new entry and return its id (0 on allocation failure)
+ */
+static uint32_t entry_add(uint32_t hash, const char* origin, size_t line, const char* text, size_t len) {
+    if (entry_count == entry_capacity) {
+        size_t capacity = (entry_capacity == 0) ? 64 : entry_capacity * 2;
+        ProfileEntry* grown = (ProfileEntry*)realloc(entries, capacity * sizeof(ProfileEntry));
+        if (grown == NULL) return 0;
+        entries = grown;
+        entry_capacity = capacity;
+    }
+    ProfileEntry* entry = &entries[entry_count];
+    memset(entry, 0, sizeof(*entry));
+    entry->text = (char*)malloc(len + 1);
+    entry->origin = (origin != NULL) ? strdup(origin) : NULL;
+    if (entry->text == NULL || (origin != NULL && entry->origin == NULL)) {
+        free(entry->text);
+        free(entry->origin);
+        return 0;
+    }
+    memcpy(entry->text, text, len);
+    entry->text[len] = '\0';
+    entry->line = line;
+    entry->hash = hash;
+    return (uint32_t)++entry_count;
+}
+
+uint32_t clrl_profile_statement(const char* origin, size_t line, const char* text, size_t len) {
+    if (!clrl_profiling()) return 0;
+
+    // Keep one line of text without trailing blanks
+    while (len > 0 && (text[len - 1] == ' ' || text[len - 1] == '\t' || text[len - 1] == '\r')) len--;
+    if (len > PROFILE_TEXT_MAX) len = PROFILE_TEXT_MAX;
+    uint32_t hash = entry_hash(origin, line, text, len);
+
+    clrl_lock_acquire(&profile_lock);
+    uint32_t id = 0;
+    if (2 * (entry_count + 1) <= bucket_count || buckets_grow() == 0) {
+        size_t b = hash & (bucket_count - 1);
+        while (buckets[b] != 0 && !entry_matches(&entries[buckets[b] - 1], hash, origin, line, text, len)) {
+            b = (b + 1) & (bucket_count - 1);
+        }
+        id = buckets[b];
+        if (id == 0) {
+            id = entry_add(hash, origin, line, text, len);
+            buckets[b] = id;
+        }
+    }
+    clrl_lock_release(&profile_lock);
+    return id;
+}
+
+void clrl_profile_begin(ClrlProfileMark* mark) {
+    // Counted per thread: statements running concurrently do not mix
+    clrl_mem_get_thread_allocs(&mark->alloc_count, &mark->alloc_bytes);
+    mark->start_ns = clrl_profile_now();
+}
+
+void clrl_profile_end(uint32_t id, const ClrlProfileMark* mark) {
+    uint64_t elapsed = clrl_profile_now() - mark->start_ns;
+    size_t alloc_count, alloc_bytes;
+    clrl_mem_get_thread_allocs(&alloc_count, &alloc_bytes);
+
+    clrl_lock_acquire(&profile_lock);
+    if (id != 0 && id <= entry_count) {
+        ProfileEntry* entry = &entries[id - 1];
+        entry->runs++;
+        entry->total_ns += elapsed;
+        if (elapsed > entry->max_ns) entry->max_ns = elapsed;
+        entry->alloc_count += alloc_count - mark->alloc_count;
+        entry->alloc_bytes += alloc_bytes - mark->alloc_bytes;
+    }
+    clrl_lock_release(&profile_lock);
+}
+
+void clrl_profile_op(ClrlProfileOp op, size_t an, size_t bn, uint64_t start_ns) {
+    uint64_t elapsed = clrl_profile_now() - start_ns;
+    ProfileOpStats* stats = &op_stats[op];
+    size_t largest = (an > bn) ? an : bn;
+    __atomic_add_fetch(&stats->calls, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->total_ns, elapsed, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->limbs, an + bn, __ATOMIC_RELAXED);
+    size_t max = __atomic_load_n(&stats->max_limbs, __ATOMIC_RELAXED);
+    while (largest > max &&
+           !__atomic_compare_exchange_n(&stats->max_limbs, &max, largest, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// ===================== Reports =====================
+
+/**
+ * @brief Format nanoseconds as milliseconds with three decimals
+ */
+static void format_ms(char* out, size_t size, uint64_t ns) {
+    snprintf(out, size, "%llu.%03llu", (unsigned long long)(ns / 1000000u),
+             (unsigned long long)(ns / 1000u % 1000u));
+}
+
+// Entries of the report being written, for qsort
+static const ProfileEntry* sort_entries;
+
+static int compare_by_time(const void* x, const void* y) {
+    uint64_t a = sort_entries[*(const size_t*)x].total_ns;
+    uint64_t b = sort_entries[*(const size_t*)y].total_ns;
+    if (a != b) return (a > b) ? -1 : 1;
+    // Equal times keep compile order
+    return (*(const size_t*)x < *(const size_t*)y) ? -1 : 1;
+}
+
+/**
+ * @brief Statements that have run, slowest first
+ */
+static void report_statements(FILE* out) {
+    clrl_lock_acquire(&profile_lock);
+    size_t count = 0;
+    size_t* order = (entry_count > 0) ? (size_t*)malloc(entry_count * sizeof(size_t)) : NULL;
+    if (order != NULL) {
+        for (size_t i = 0; i < entry_count; i++) {
+            if (entries[i].runs > 0) order[count++] = i;
+        }
+        sort_entries = entries;
+        qsort(order, count, sizeof(size_t), compare_by_time);
+    }
+
+    fprintf(out, "Statements (%zu):\n", count);
+    if (count > 0) {
+        fprintf(out, "  %12s %8s %12s %10s %14s  %s\n", "Time (ms)", "Runs", "Max (ms)", "Allocs", "Bytes", "Statement");
+    }
+    for (size_t k = 0; k < count; k++) {
+        const ProfileEntry* entry = &entries[order[k]];
+        char total[32], max[32];
+        format_ms(total, sizeof(total), entry->total_ns);
+        format_ms(max, sizeof(max), entry->max_ns);
+        fprintf(out, "  %12s %8zu %12s %10zu %14zu  %s:%zu: %s\n", total, entry->runs, max,
+                entry->alloc_count, entry->alloc_bytes,
+                (entry->origin != NULL) ? entry->origin : "repl", entry->line, entry->text);
+    }
+    clrl_lock_release(&profile_lock);
+    free(order);
+}
+
+/**
+ * @brief Kernel calls per algorithm
+ */
+static void report_operations(FILE* out) {
+    int header = 0;
+    for (int op = 0; op < CLRL_PROFILE_OP_COUNT; op++) {
+        size_t calls = __atomic_load_n(&op_stats[op].calls, __ATOMIC_RELAXED);
+        if (calls == 0) continue;
+        if (!header) {
+            fprintf(out, "Operations:\n  %-16s %10s %12s %10s %10s\n",
+                    "Kernel", "Calls", "Time (ms)", "Avg limbs", "Max limbs");
+            header = 1;
+        }
+        char total[32];
+        format_ms(total, sizeof(total), __atomic_load_n(&op_stats[op].total_ns, __ATOMIC_RELAXED));
+        fprintf(out, "  %-16s %10zu %12s %10zu %10zu\n", op_names[op], calls, total,
+                __atomic_load_n(&op_stats[op].limbs, __ATOMIC_RELAXED) / calls,
+                __atomic_load_n(&op_stats[op].max_limbs, __ATOMIC_RELAXED));
+    }
+    if (!header) fprintf(out, "Operations: none\n");
+}
+
+int clrl_profile_report(FILE* out) {
+    fprintf(out, "Profiling: %s\n", clrl_profiling() ? "on" : "off");
+    report_statements(out);
+    report_operations(out);
+
+    ClrlMemStats heap;
+    clrl_mem_get_stats(&heap);
+    const ClrlMemStats* vars = &var_table.arena.stats;
+    fprintf(out, "Number buffers: %zu allocations (%zu reused), %zu bytes allocated, live %zu bytes, peak %zu bytes\n",
+            heap.alloc_count, heap.reuse_count, heap.alloc_bytes, heap.live_bytes, heap.peak_bytes);
+    fprintf(out, "Variable table: %zu variables in %zu slots, live %zu bytes, reserved %zu bytes\n",
+            var_table.count, var_table.capacity, vars->live_bytes, vars->reserved_bytes);
+    return ferror(out) ? -1 : 0;
+}
+
+int clrl_profile_dump(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        clrl_error(CLRL_ERROR_IO, "Error: Cannot write '%s'\n", path);
+        return -1;
+    }
+    int status = clrl_profile_report(out);
+    if (fclose(out) != 0) status = -1;
+    if (status != 0) clrl_error(CLRL_ERROR_IO, "Error: Cannot write '%s'\n", path);
+    return status;
+}
@@ -0,0 +1,415 @@
+#include "../../include/clrl/clrl_larnum.h"
+#include "../../include/clrl/clrl_thread.h"
+#include "../../include/clrl/clrl_profile.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_backend.h"
+#include "clrl_limbs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Larnum radix conversion subsystem
+ *
+ * Small numbers are converted 9 digits at a time with single-limb
+ * multiply/divide (quadratic, but fast for short inputs). Large numbers
+ * are split recursively at 10^(9*2^k) using a table of repeated squares,
+ * so parsing costs one multiply and printing one divide per level:
+ * O(M(n) log n) on top of the fast multiplication and Newton division.
+ * Large independent subtrees are converted on the thread pool.
+ */
+
+// Largest power of 10 that fits in one limb, used to move 9 digits at a time
+#define DECIMAL_CHUNK_DIGITS 9
+#define DECIMAL_CHUNK_BASE   1000000000u
+
+// Size (in limbs) above which conversion splits recursively
+#define DEFAULT_RADIX_THRESHOLD 60
+
+// Smallest subtree (decimal digits) converted on another thread
+#define PARALLEL_RADIX_MIN_DIGITS 20000
+
+static size_t radix_threshold = DEFAULT_RADIX_THRESHOLD;
+
+size_t larnum_get_radix_threshold(void) {
+    return radix_threshold;
+}
+
+int larnum_set_radix_threshold(size_t limbs) {
+    if (limbs < 2) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Invalid radix conversion threshold\n");
+        return -1;
+    }
+    radix_threshold = limbs;
+    return 0;
+}
+
+// ===================== Power table =====================
+
+/**
+ * @brief pow[k] = 10^(9 * 2^k), k = 0 .. count-1
+ */
+typedef struct {
+    Larnum pow[64];
+    size_t count;
+} PowerTable;
+
+static void power_table_free(PowerTable* table) {
+    for (size_t k = 0; k < table->count; k++) larnum_free(&table->pow[k]);
+    table->count = 0;
+}
+
+/**
+ * @brief Build squares until the split digit count reaches digits / 2
+ *
+ * A table of this height lets every split point of a number with
+ * `digits` decimal digits land near its middle.
+ */
+static int power_table_build(PowerTable* table, size_t digits) {
+    table->count = 0;
+    larnum_init(&table->pow[0]);
+    if (larnum_set_int(&table->pow[0], DECIMAL_CHUNK_BASE) != 0) return -1;
+    table->count = 1;
+    while (table->count < 64 && ((size_t)DECIMAL_CHUNK_DIGITS << table->count) <= digits / 2) {
+        Larnum* next = &table->pow[table->count];
+        larnum_init(next);
+        if (larnum_sqr(next, &table->pow[table->count - 1]) != 0) {
+            larnum_free(next);
+            return -1;
+        }
+        table->count++;
+    }
+    return 0;
+}
+
+// ===================== Parsing =====================
+
+/**
+ * @brief Value of the 8 decimal digits at str
+ *
+ * On little-endian targets the digits are combined pairwise inside one
+ * 64-bit word (8 -> 4 -> 2 -> 1 values) instead of one digit at a time.
+ */
+static LarnumLimb decimal_eight(const char* str) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint64_t v;
+    memcpy(&v, str, sizeof(v));
+    v -= 0x3030303030303030ull;
+    v = v * 10 + (v >> 8);   // Two-digit values in bytes 0, 2, 4, 6
+    v = ((v & 0x000000FF000000FFull) * (100 + (1000000ull << 32)) +
+         ((v >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32))) >> 32;
+    return (LarnumLimb)v;
+#else
+    LarnumLimb value = 0;
+    for (int k = 0; k < 8; k++) value = value * 10 + (LarnumLimb)(str[k] - '0');
+    return value;
+#endif
+}
+
+/**
+ * @brief |x| = decimal digits str[0..len), 9 digits per step
+ */
+static int parse_basecase(Larnum* x, const char* str, size_t len) {
+    // log2(10) / 32 < 0.104 limbs per decimal digit
+    if (larnum_reserve(x, len / 9 + 2) != 0) return -1;
+    x->size = 0;
+    x->negative = 0;
+
+    // Consume the leading partial chunk first so all later chunks are full
+    size_t first = len % DECIMAL_CHUNK_DIGITS;
+    if (first == 0) first = DECIMAL_CHUNK_DIGITS;
+    size_t pos = 0;
+    while (pos < len) {
+        LarnumLimb chunk = 0;
+        LarnumLimb scale = DECIMAL_CHUNK_BASE;
+        if (first == DECIMAL_CHUNK_DIGITS) {
+            chunk = (LarnumLimb)(str[pos] - '0') * 100000000u + decimal_eight(str + pos + 1);
+            pos += DECIMAL_CHUNK_DIGITS;
+        } else {
+            scale = 1;
+            for (size_t k = 0; k < first; k++) {
+                chunk = chunk * 10 + (LarnumLimb)(str[pos++] - '0');
+                scale *= 10;
+            }
+        }
+        first = DECIMAL_CHUNK_DIGITS;
+
+        // x = x * 10^k + chunk
+        LarnumLimb carry = limbs_mul_1(x->limbs, x->limbs, x->size, scale);
+        if (carry != 0) x->limbs[x->size++] = carry;
+        LarnumDoubleLimb acc = chunk;
+        for (size_t i = 0; i < x->size && acc != 0; i++) {
+            acc += x->limbs[i];
+            x->limbs[i] = (LarnumLimb)acc;
+            acc >>= LARNUM_LIMB_BITS;
+        }
+        if (acc != 0) x->limbs[x->size++] = (LarnumLimb)acc;
+    }
+    return 0;
+}
+
+static int parse_recursive(Larnum* x, const char* str, size_t len, const PowerTable* table);
+
+/**
+ * @brief Parse of one subtree (run on the pool)
+ */
+typedef struct {
+    Larnum* x;
+    const char* str;
+    size_t len;
+    const PowerTable* table;
+    int status;
+} ParseJob;
+
+static void parse_job_run(void* arg) {
+    ParseJob* job = (ParseJob*)arg;
+    job->status = parse_recursive(job->x, job->str, job->len, job->table);
+}
+
+/**
+ * @brief |x| = str[0..len) by splitting off the low 9*2^k digits
+ */
+static int parse_recursive(Larnum* x, const char* str, size_t len, const PowerTable* table) {
+    if (len <= radix_threshold * DECIMAL_CHUNK_DIGITS) return parse_basecase(x, str, len);
+
+    // Largest split that leaves a non-empty high part
+    size_t k = table->count - 1;
+    while (k > 0 && ((size_t)DECIMAL_CHUNK_DIGITS << k) >= len) k--;
+    size_t low_len = (size_t)DECIMAL_CHUNK_DIGITS << k;
+
+    // x = high * 10^low_len + low
+    Larnum high, low;
+    larnum_init(&high);
+    larnum_init(&low);
+    ParseJob high_job = { &high, str, len - low_len, table, 0 };
+    ParseJob low_job = { &low, str + len - low_len, low_len, table, 0 };
+    if (clrl_parallel_worthwhile(len, PARALLEL_RADIX_MIN_DIGITS)) {
+        ClrlTask task;
+        clrl_task_fork(&task, parse_job_run, &high_job);
+        parse_job_run(&low_job);
+        clrl_task_join(&task);
+    } else {
+        parse_job_run(&high_job);
+        parse_job_run(&low_job);
+    }
+
+    int status = -1;
+    if (high_job.status == 0 && low_job.status == 0 &&
+        larnum_mul(x, &high, &table->pow[k]) == 0 &&
+        larnum_add(x, x, &low) == 0) {
+        status = 0;
+    }
+    larnum_free(&high);
+    larnum_free(&low);
+    return status;
+}
+
+int larnum_from_string(Larnum* x, const char* str, size_t len) {
+    // A limb holds a little over 9 decimal digits
+    if (str != NULL) LARNUM_BACKEND_CALL(from_string, len / 9, x, str, len);
+    size_t pos = 0;
+    int negative = 0;
+
+    if (str == NULL || len == 0) return -1;
+    if (str[0] == '+' || str[0] == '-') {
+        negative = (str[0] == '-');
+        pos = 1;
+    }
+    if (pos == len) return -1;
+    if (decimal_span(str + pos, len - pos) != len - pos) return -1;
+
+    // Leading zeros would only make the recursion deeper
+    while (pos + 1 < len && str[pos] == '0') pos++;
+    size_t digits = len - pos;
+
+    int status;
+    int basecase = digits <= radix_threshold * DECIMAL_CHUNK_DIGITS;
+    uint64_t started = clrl_profiling() ? clrl_profile_now() : 0;
+    if (basecase) {
+        status = parse_basecase(x, str + pos, digits);
+    } else {
+        PowerTable table;
+        status = power_table_build(&table, digits);
+        if (status == 0) status = parse_recursive(x, str + pos, digits, &table);
+        power_table_free(&table);
+    }
+    if (status != 0) return -1;
+    if (started != 0) {
+        clrl_profile_op(basecase ? CLRL_PROFILE_PARSE_BASECASE : CLRL_PROFILE_PARSE_RECURSIVE, x->size, 0, started);
+    }
+
+    x->negative = (negative && x->size > 0) ? 1 : 0;
+    return 0;
+}
+
+// ===================== Printing =====================
+
+/**
+ * @brief Write v as exactly 9 digits (with leading zeros)
+ */
+static void write_chunk(char* out, LarnumLimb v) {
+    for (int i = DECIMAL_CHUNK_DIGITS - 1; i >= 0; i--) {
+        out[i] = (char)('0' + v % 10);
+        v /= 10;
+    }
+}
+
+/**
+ * @brief Print |x| (< 10^width if width > 0) by repeated single-limb division
+ *
+ * width == 0 prints without leading zeros; otherwise exactly width digits.
+ *
+ * @return int 0 on success, -1 on allocation failure
+ */
+static int print_basecase(const Larnum* x, size_t width, char** out) {
+    size_t n = x->size;
+    size_t chunk_count = 0;
+    LarnumLimb* work = (LarnumLimb*)clrl_mem_alloc((n + 1) * sizeof(LarnumLimb));
+    LarnumLimb* chunks = (LarnumLimb*)clrl_mem_alloc((n * 10 / DECIMAL_CHUNK_DIGITS + 2) * sizeof(LarnumLimb));
+    if (work == NULL || chunks == NULL) {
+        clrl_mem_free(work);
+        clrl_mem_free(chunks);
+        return -1;
+    }
+
+    // Peel off base-10^9 chunks from the least significant end
+    if (n > 0) memcpy(work, x->limbs, n * sizeof(LarnumLimb));
+    while (n > 0) {
+        chunks[chunk_count++] = limbs_divmod_1(work, work, n, DECIMAL_CHUNK_BASE);
+        n = limbs_normalize(work, n);
+    }
+
+    char* p = *out;
+    if (width == 0) {
+        if (chunk_count == 0) {
+            *p++ = '0';
+        } else {
+            p += sprintf(p, "%u", (unsigned)chunks[chunk_count - 1]);
+            chunk_count--;
+        }
+    } else {
+        // Zero-fill whatever the chunks do not cover (x < 10^width)
+        size_t covered = chunk_count * DECIMAL_CHUNK_DIGITS;
+        if (covered < width) {
+            memset(p, '0', width - covered);
+            p += width - covered;
+        } else if (covered > width) {
+            // The top chunk has leading zeros beyond width: print it short
+            char top[DECIMAL_CHUNK_DIGITS];
+            size_t keep = DECIMAL_CHUNK_DIGITS - (covered - width);
+            write_chunk(top, chunks[--chunk_count]);
+            memcpy(p, top + DECIMAL_CHUNK_DIGITS - keep, keep);
+            p += keep;
+        }
+    }
+    for (size_t i = chunk_count; i > 0; i--) {
+        write_chunk(p, chunks[i - 1]);
+        p += DECIMAL_CHUNK_DIGITS;
+    }
+    *out = p;
+
+    clrl_mem_free(work);
+    clrl_mem_free(chunks);
+    return 0;
+}
+
+static int print_recursive(const Larnum* x, size_t width, const PowerTable* table, char** out);
+
+/**
+ * @brief Print of one fixed-width subtree (run on the pool)
+ */
+typedef struct {
+    const Larnum* x;
+    size_t width;
+    const PowerTable* table;
+    char* out;
+    int status;
+} PrintJob;
+
+static void print_job_run(void* arg) {
+    PrintJob* job = (PrintJob*)arg;
+    job->status = print_recursive(job->x, job->width, job->table, &job->out);
+}
+
+/**
+ * @brief Print |x| by dividing by 10^(9*2^k) and printing both halves
+ *
+ * With a fixed width both halves have known positions and can be printed
+ * in parallel; without one the high half goes first so the low half knows
+ * where to start.
+ */
+static int print_recursive(const Larnum* x, size_t width, const PowerTable* table, char** out) {
+    if (x->size <= radix_threshold) return print_basecase(x, width, out);
+
+    size_t k = table->count - 1;
+    if (width > 0) {
+        // Split the fixed width so the low part gets 9*2^k digits
+        while (k > 0 && ((size_t)DECIMAL_CHUNK_DIGITS << k) >= width) k--;
+    } else {
+        // Largest power not above x, so the quotient is non-zero
+        while (k > 0 && larnum_cmp_abs(&table->pow[k], x) > 0) k--;
+    }
+    size_t low_width = (size_t)DECIMAL_CHUNK_DIGITS << k;
+
+    Larnum magnitude = *x;   // Shallow view without the sign
+    magnitude.negative = 0;
+    Larnum high, low;
+    larnum_init(&high);
+    larnum_init(&low);
+    int status = -1;
+    if (larnum_divmod(&high, &low, &magnitude, &table->pow[k]) == 0) {
+        if (width > 0 && clrl_parallel_worthwhile(width, PARALLEL_RADIX_MIN_DIGITS)) {
+            PrintJob high_job = { &high, width - low_width, table, *out, 0 };
+            PrintJob low_job = { &low, low_width, table, *out + (width - low_width), 0 };
+            ClrlTask task;
+            clrl_task_fork(&task, print_job_run, &high_job);
+            print_job_run(&low_job);
+            clrl_task_join(&task);
+            *out = low_job.out;
+            status = high_job.status | low_job.status;
+        } else if (print_recursive(&high, (width > 0) ? width - low_width : 0, table, out) == 0 &&
+                   print_recursive(&low, low_width, table, out) == 0) {
+            status = 0;
+        }
+    }
+    larnum_free(&high);
+    larnum_free(&low);
+    return status;
+}
+
+char* larnum_to_string(const Larnum* x) {
+    const LarnumBackend* backend = larnum_backend();
+    if (backend->to_string != NULL && x->size >= backend->min_limbs) return backend->to_string(x);
+
+    // 32 bits < 9.64 decimal digits, so 10 digits per limb is an upper bound
+    size_t max_digits = x->size * 10 + 2;
+    char* text = (char*)malloc(max_digits + 1);
+    if (text == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while printing larnum\n");
+        return NULL;
+    }
+
+    char* out = text;
+    if (x->negative && x->size > 0) *out++ = '-';
+    int status;
+    int basecase = x->size <= radix_threshold;
+    uint64_t started = clrl_profiling() ? clrl_profile_now() : 0;
+    if (basecase) {
+        status = print_basecase(x, 0, &out);
+    } else {
+        PowerTable table;
+        status = power_table_build(&table, max_digits);
+        if (status == 0) status = print_recursive(x, 0, &table, &out);
+        power_table_free(&table);
+    }
+    if (started != 0) {
+        clrl_profile_op(basecase ? CLRL_PROFILE_PRINT_BASECASE : CLRL_PROFILE_PRINT_RECURSIVE, x->size, 0, started);
+    }
+    if (status != 0) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while printing larnum\n");
+        free(text);
+        return NULL;
+    }
+    *out = '\0';
+    return text;
+}
@@ -0,0 +1,170 @@
+#include "../../include/clrl/clrl_larnum.h"
+#include "../../include/clrl/clrl_profile.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_backend.h"
+#include "clrl_limbs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Integer roots
+ *
+ * floor(a^(1/n)) is found by Newton iteration with precision doubling:
+ * the root of a with its low n*k bits dropped (k = half the bits of the
+ * root) is computed first, recursively, and shifted up by k bits. That
+ * estimate has the top half of the root right and is never too large, so
+ * a single Newton step
+ *
+ *     y = ((n - 1) x + a / x^(n-1)) / n
+ *
+ * gets (nearly) all of it right. The integer step never lands below the
+ * root, so at most a few corrections downwards follow. Every level costs
+ * one division and one n-th power at its own size, and the sizes halve,
+ * so a root costs a small multiple of one division of the full operand
+ * (which is a Newton reciprocal on the fast multiplication for long ones).
+ */
+
+// Radicands up to this many bits are handled with native arithmetic
+#define ROOT_NATIVE_BITS 64
+
+/**
+ * @brief y^k, or UINT64_MAX if it does not fit
+ */
+static uint64_t native_pow(uint64_t y, size_t k) {
+    uint64_t p = 1;
+    for (size_t i = 0; i < k; i++) {
+        if (y != 0 && p > UINT64_MAX / y) return UINT64_MAX;
+        p *= y;
+    }
+    return p;
+}
+
+/**
+ * @brief floor(a^(1/n)) for a native a (2 <= n < 64)
+ */
+static uint64_t native_root(uint64_t a, size_t n) {
+    if (a < 2) return a;
+    // Start above the root (2^ceil(bits / n)) and step down until Newton stops decreasing
+    size_t bits = 0;
+    while (bits < 64 && (a >> bits) != 0) bits++;
+    uint64_t y = (uint64_t)1 << ((bits + n - 1) / n);
+    for (;;) {
+        uint64_t q = native_pow(y, n - 1);
+        uint64_t z = ((uint64_t)(n - 1) * y + a / q) / n;
+        if (z >= y) return y;
+        y = z;
+    }
+}
+
+/**
+ * @brief y = ((n - 1) x + a / x^(n-1)) / n with x^(n-1) already in q
+ */
+static int newton_step(Larnum* y, const Larnum* x, const Larnum* a, const Larnum* q, const Larnum* n,
+                       Larnum* scratch) {
+    Larnum factor;
+    LarnumLimb factor_limb = n->limbs[0] - 1;
+    factor.limbs = &factor_limb;
+    factor.size = (factor_limb != 0);
+    factor.capacity = 0;
+    factor.negative = 0;
+    if (larnum_divmod(scratch, NULL, a, q) != 0) return -1;
+    if (larnum_mul(y, x, &factor) != 0) return -1;
+    if (larnum_add(y, y, scratch) != 0) return -1;
+    return larnum_divmod(y, NULL, y, n);
+}
+
+/**
+ * @brief r = floor(a^(1/n)) for a > 0 (r must not alias a)
+ */
+static int root_floor(Larnum* r, const Larnum* a, const Larnum* n) {
+    size_t degree = n->limbs[0];
+    size_t bits = larnum_bit_length(a);
+    if (degree == 1) return larnum_copy(r, a);
+    // a < 2^bits <= 2^n, so the root is 1
+    if (degree >= bits) return larnum_set_small(r, 1, 0, 0);
+    if (bits <= ROOT_NATIVE_BITS) return larnum_set_small(r, native_root(larnum_get_small(a), degree), 0, 0);
+
+    // Half of the root's bits from a with its low degree * k bits dropped
+    size_t root_bits = (bits + degree - 1) / degree;
+    size_t k = root_bits / 2;
+    Larnum top, x, q, scratch;
+    larnum_init(&top);
+    larnum_init(&x);
+    larnum_init(&q);
+    larnum_init(&scratch);
+    int status = larnum_shr(&top, a, degree * k);
+    if (status == 0) status = root_floor(&x, &top, n);
+    if (status == 0) status = larnum_shl(&x, &x, k);
+
+    // One step from below lands at or above the root
+    Larnum power;
+    LarnumLimb power_limb = (LarnumLimb)(degree - 1);
+    power.limbs = &power_limb;
+    power.size = 1;
+    power.capacity = 0;
+    power.negative = 0;
+    if (status == 0) status = larnum_pow(&q, &x, &power);
+    if (status == 0) status = newton_step(r, &x, a, &q, n, &scratch);
+
+    // Step down until r^n <= a
+    while (status == 0) {
+        if (degree == 2) {
+            // r^2 - a falls by 2r - 1 per step: one square, then additions
+            status = larnum_mul(&q, r, r);
+            if (status == 0) status = larnum_sub(&q, &q, a);
+            while (status == 0 && q.size > 0 && !q.negative) {
+                status = larnum_add(&scratch, r, r);
+                if (status == 0) status = larnum_sub(&q, &q, &scratch);
+                if (status == 0) status = larnum_set_small(&scratch, 1, 0, 0);
+                if (status == 0) status = larnum_sub(r, r, &scratch);
+                if (status == 0) status = larnum_add(&q, &q, &scratch);
+            }
+            break;
+        }
+        status = larnum_pow(&q, r, &power);
+        if (status == 0) status = larnum_mul(&scratch, &q, r);
+        if (status != 0 || larnum_cmp(&scratch, a) <= 0) break;
+        if (larnum_copy(&x, r) != 0) {
+            status = -1;
+            break;
+        }
+        status = newton_step(r, &x, a, &q, n, &scratch);
+    }
+
+    larnum_free(&top);
+    larnum_free(&x);
+    larnum_free(&q);
+    larnum_free(&scratch);
+    return status;
+}
+
+int larnum_root(Larnum* r, const Larnum* a, const Larnum* n) {
+    LARNUM_BACKEND_CALL(root, a->size, r, a, n);
+    if (n->negative || n->size != 1) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Root degree must be a positive integer below 2^32\n");
+        return -1;
+    }
+    if (a->negative && (n->limbs[0] & 1u) == 0) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Even root of a negative number\n");
+        return -1;
+    }
+    if (a->size == 0) return larnum_set_small(r, 0, 0, 0);
+
+    uint64_t started = clrl_profiling() ? clrl_profile_now() : 0;
+    Larnum magnitude = *a;
+    magnitude.negative = 0;
+    Larnum result;
+    larnum_init(&result);
+    int status = root_floor(&result, &magnitude, n);
+    if (started != 0) clrl_profile_op(CLRL_PROFILE_ROOT_NEWTON, a->size, 0, started);
+    if (status == 0) {
+        // Truncated towards zero, like //
+        result.negative = a->negative;
+        larnum_free(r);
+        *r = result;
+    } else {
+        larnum_free(&result);
+    }
+    return status;
+}
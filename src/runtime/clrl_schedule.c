@@ -0,0 +1,355 @@
+#include "../../include/clrl/clrl_vm.h"
+#include "../../include/clrl/clrl_thread.h"
+#include "../../include/clrl/clrl_context.h"
+
+/**
+ * Statement scheduling
+ *
+ * Statements only interact through the variables they read and write, so
+ * a script is a DAG: an edge i -> j for every later statement j that
+ * reads what i wrote, overwrites what i read, or overwrites what i wrote.
+ * Statements whose predecessors have all finished are forked onto the
+ * thread pool; a finished statement releases its successors. The calling
+ * thread walks the statements in source order, helping with pending work
+ * while it waits, and writes each statement's captured output as soon as
+ * that statement is done.
+ */
+
+// Marks "no statement" in the build tables
+#define NO_STATEMENT SIZE_MAX
+
+// Roots are forked at most this many statements ahead of the output cursor
+#define SCHEDULE_WINDOW 256
+
+// ===================== DAG construction =====================
+
+/**
+ * @brief Edge list and per-slot access history while building a schedule
+ */
+typedef struct {
+    uint32_t (*edges)[2];     // (from, to) pairs
+    size_t edge_count;
+    size_t edge_capacity;
+    size_t* last_writer;      // Last statement that wrote each slot
+    size_t* reader_head;      // Readers since that write (index into readers)
+    size_t (*readers)[2];     // (statement, next) list nodes
+    size_t reader_count;
+    size_t reader_capacity;
+    size_t* added_by;         // Statement that last added an edge from each statement
+} ScheduleBuilder;
+
+/**
+ * @brief Add edge from -> to (ignores self edges and duplicates)
+ */
+static int add_edge(ScheduleBuilder* builder, size_t from, size_t to) {
+    if (from == NO_STATEMENT || from == to || builder->added_by[from] == to) return 0;
+    if (builder->edge_count == builder->edge_capacity) {
+        size_t capacity = (builder->edge_capacity == 0) ? 256 : builder->edge_capacity * 2;
+        uint32_t (*edges)[2] = (uint32_t (*)[2])realloc(builder->edges, capacity * sizeof(*edges));
+        if (edges == NULL) return -1;
+        builder->edges = edges;
+        builder->edge_capacity = capacity;
+    }
+    builder->edges[builder->edge_count][0] = (uint32_t)from;
+    builder->edges[builder->edge_count][1] = (uint32_t)to;
+    builder->edge_count++;
+    builder->added_by[from] = to;
+    return 0;
+}
+
+/**
+ * @brief Statement reads slot: depends on its last writer
+ */
+static int note_read(ScheduleBuilder* builder, size_t slot, size_t statement) {
+    if (add_edge(builder, builder->last_writer[slot], statement) != 0) return -1;
+    if (builder->reader_count == builder->reader_capacity) {
+        size_t capacity = (builder->reader_capacity == 0) ? 256 : builder->reader_capacity * 2;
+        size_t (*readers)[2] = (size_t (*)[2])realloc(builder->readers, capacity * sizeof(*readers));
+        if (readers == NULL) return -1;
+        builder->readers = readers;
+        builder->reader_capacity = capacity;
+    }
+    builder->readers[builder->reader_count][0] = statement;
+    builder->readers[builder->reader_count][1] = builder->reader_head[slot];
+    builder->reader_head[slot] = builder->reader_count++;
+    return 0;
+}
+
+/**
+ * @brief Statement writes slot: depends on its last writer and every reader since
+ */
+static int note_write(ScheduleBuilder* builder, size_t slot, size_t statement) {
+    if (add_edge(builder, builder->last_writer[slot], statement) != 0) return -1;
+    for (size_t r = builder->reader_head[slot]; r != NO_STATEMENT; r = builder->readers[r][1]) {
+        if (add_edge(builder, builder->readers[r][0], statement) != 0) return -1;
+    }
+    builder->last_writer[slot] = statement;
+    builder->reader_head[slot] = NO_STATEMENT;
+    return 0;
+}
+
+/**
+ * @brief Record the variable accesses of one instruction
+ *
+ * @param precision_slot Pseudo slot written by system:precision
+ */
+static int note_insn(ScheduleBuilder* builder, const ClrlInsn* insn, size_t statement, size_t precision_slot) {
+    switch (insn->op) {
+        case CLRL_OP_SET_PRECISION:
+            return note_write(builder, precision_slot, statement);
+        case CLRL_OP_STORE:
+            if (CLRL_OPERAND_KIND(insn->a) == CLRL_OPERAND_VAR &&
+                note_read(builder, CLRL_OPERAND_INDEX(insn->a), statement) != 0) return -1;
+            return note_write(builder, insn->dst, statement);
+        case CLRL_OP_RETURN:
+        case CLRL_OP_NEG:
+            if (CLRL_OPERAND_KIND(insn->a) != CLRL_OPERAND_VAR) return 0;
+            return note_read(builder, CLRL_OPERAND_INDEX(insn->a), statement);
+        case CLRL_OP_POWMOD:
+            if (CLRL_OPERAND_KIND(insn->imm) == CLRL_OPERAND_VAR &&
+                note_read(builder, CLRL_OPERAND_INDEX(insn->imm), statement) != 0) return -1;
+            // fallthrough
+        default:
+            if (CLRL_OPERAND_KIND(insn->a) == CLRL_OPERAND_VAR &&
+                note_read(builder, CLRL_OPERAND_INDEX(insn->a), statement) != 0) return -1;
+            if (CLRL_OPERAND_KIND(insn->b) == CLRL_OPERAND_VAR &&
+                note_read(builder, CLRL_OPERAND_INDEX(insn->b), statement) != 0) return -1;
+            return 0;
+    }
+}
+
+int clrl_schedule_build(ClrlSchedule* schedule, const ClrlProgram* program) {
+    size_t count = program->statement_count;
+    size_t slots = program->slot_count + 1;
+    memset(schedule, 0, sizeof(*schedule));
+    if (count >= UINT32_MAX) return -1;
+
+    ScheduleBuilder builder;
+    memset(&builder, 0, sizeof(builder));
+    builder.last_writer = (size_t*)malloc(slots * sizeof(size_t));
+    builder.reader_head = (size_t*)malloc(slots * sizeof(size_t));
+    builder.added_by = (size_t*)malloc((count + 1) * sizeof(size_t));
+    uint32_t* precision = (uint32_t*)malloc((count + 1) * sizeof(uint32_t));
+    uint32_t* predecessor_count = (uint32_t*)calloc(count + 1, sizeof(uint32_t));
+    uint32_t* successor_start = (uint32_t*)calloc(count + 2, sizeof(uint32_t));
+    uint32_t* successors = NULL;
+
+    int status = (builder.last_writer != NULL && builder.reader_head != NULL && builder.added_by != NULL &&
+                  precision != NULL && predecessor_count != NULL && successor_start != NULL) ? 0 : -1;
+    if (status == 0) {
+        for (size_t s = 0; s < slots; s++) {
+            builder.last_writer[s] = NO_STATEMENT;
+            builder.reader_head[s] = NO_STATEMENT;
+        }
+        for (size_t i = 0; i < count; i++) builder.added_by[i] = NO_STATEMENT;
+
+        // Divisions get the precision in effect at their position directly,
+        // so only the precision statements themselves need ordering
+        uint32_t current = CLRL_PRECISION_GLOBAL;
+        for (size_t i = 0; i < count && status == 0; i++) {
+            const ClrlStatement* statement = &program->statements[i];
+            precision[i] = current;
+            for (size_t k = 0; k < statement->count && status == 0; k++) {
+                const ClrlInsn* insn = &program->code[statement->first + k];
+                status = note_insn(&builder, insn, i, slots - 1);
+                if (insn->op == CLRL_OP_SET_PRECISION) current = insn->imm;
+            }
+        }
+    }
+
+    // Edge list -> CSR successor lists
+    if (status == 0) {
+        successors = (uint32_t*)malloc((builder.edge_count + 1) * sizeof(uint32_t));
+        if (successors == NULL) status = -1;
+    }
+    if (status == 0) {
+        for (size_t e = 0; e < builder.edge_count; e++) {
+            successor_start[builder.edges[e][0] + 1]++;
+            predecessor_count[builder.edges[e][1]]++;
+        }
+        for (size_t i = 0; i < count; i++) successor_start[i + 1] += successor_start[i];
+        // added_by is free again: reuse it as the fill cursor of each list
+        for (size_t i = 0; i < count; i++) builder.added_by[i] = successor_start[i];
+        for (size_t e = 0; e < builder.edge_count; e++) {
+            successors[builder.added_by[builder.edges[e][0]]++] = builder.edges[e][1];
+        }
+    }
+
+    free(builder.edges);
+    free(builder.last_writer);
+    free(builder.reader_head);
+    free(builder.readers);
+    free(builder.added_by);
+    if (status != 0) {
+        free(precision);
+        free(predecessor_count);
+        free(successor_start);
+        free(successors);
+        return -1;
+    }
+
+    schedule->statement_count = count;
+    schedule->register_count = program->register_count;
+    schedule->precision = precision;
+    schedule->predecessor_count = predecessor_count;
+    schedule->successor_start = successor_start;
+    schedule->successors = successors;
+    return 0;
+}
+
+void clrl_schedule_free(ClrlSchedule* schedule) {
+    free((void*)schedule->precision);
+    free((void*)schedule->predecessor_count);
+    free((void*)schedule->successor_start);
+    free((void*)schedule->successors);
+    memset(schedule, 0, sizeof(*schedule));
+}
+
+// ===================== Execution =====================
+
+typedef struct ScheduleRun ScheduleRun;
+
+/**
+ * @brief State of one statement during a parallel run
+ */
+typedef struct {
+    ScheduleRun* run;
+    size_t index;
+    int failed;
+    ClrlOutputCapture output;
+    ClrlErrorLog errors;
+} ScheduledStatement;
+
+struct ScheduleRun {
+    const ClrlSchedule* schedule;
+    ClrlStatementFn body;
+    void* ctx;
+    size_t initial_precision;         // Session precision when the run started
+    uint32_t* remaining;              // Unfinished predecessors of each statement (atomic)
+    ClrlTask* tasks;
+    ScheduledStatement* statements;
+};
+
+static ClrlValue* registers_new(size_t count) {
+    ClrlValue* registers = (ClrlValue*)malloc(((count > 0) ? count : 1) * sizeof(ClrlValue));
+    if (registers == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for statement registers\n");
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        registers[i].type = VAR_LARNUM;
+        larnum_init(&registers[i].value.larnum_val);
+    }
+    return registers;
+}
+
+static void registers_free(ClrlValue* registers, size_t count) {
+    if (registers == NULL) return;
+    for (size_t i = 0; i < count; i++) larnum_free(&registers[i].value.larnum_val);
+    free(registers);
+}
+
+/**
+ * @brief Run statement index; its temporaries die with it
+ */
+static int execute(const ScheduleRun* run, size_t index, ClrlValue* registers) {
+    uint32_t precision = run->schedule->precision[index];
+    ClrlArena* scratch = clrl_scratch_arena();
+    ClrlArenaMark mark = clrl_arena_mark(scratch);
+    int status = run->body(run->ctx, index, registers,
+                           (precision == CLRL_PRECISION_GLOBAL) ? run->initial_precision : precision);
+    clrl_arena_rewind(scratch, mark);
+    return status;
+}
+
+static void statement_task(void* arg);
+
+static void release(ScheduleRun* run, size_t index) {
+    clrl_task_fork(&run->tasks[index], statement_task, &run->statements[index]);
+}
+
+static void statement_task(void* arg) {
+    ScheduledStatement* statement = (ScheduledStatement*)arg;
+    ScheduleRun* run = statement->run;
+    const ClrlSchedule* schedule = run->schedule;
+
+    ClrlOutputCapture* previous = clrl_output_capture(&statement->output);
+    ClrlErrorLog* previous_errors = clrl_error_capture(&statement->errors);
+    ClrlValue* registers = registers_new(schedule->register_count);
+    statement->failed = (registers == NULL) || execute(run, statement->index, registers) != 0;
+    clrl_error_capture(previous_errors);
+    clrl_output_capture(previous);
+    registers_free(registers, schedule->register_count);
+
+    // Successors whose last predecessor this was can start now
+    for (uint32_t e = schedule->successor_start[statement->index]; e < schedule->successor_start[statement->index + 1]; e++) {
+        uint32_t next = schedule->successors[e];
+        if (__atomic_sub_fetch(&run->remaining[next], 1, __ATOMIC_ACQ_REL) == 0) release(run, next);
+    }
+}
+
+static int run_serial(const ScheduleRun* run) {
+    size_t count = run->schedule->register_count;
+    ClrlValue* registers = registers_new(count);
+    if (registers == NULL) return -1;
+    int failed = 0;
+    for (size_t i = 0; i < run->schedule->statement_count; i++) {
+        if (execute(run, i, registers) != 0) failed = 1;
+        clrl_output_flush();
+    }
+    registers_free(registers, count);
+    return failed ? -1 : 0;
+}
+
+int clrl_schedule_run(const ClrlSchedule* schedule, ClrlStatementFn body, void* ctx) {
+    size_t count = schedule->statement_count;
+    ScheduleRun run;
+    run.schedule = schedule;
+    run.body = body;
+    run.ctx = ctx;
+    run.initial_precision = get_division_precision();
+    run.remaining = NULL;
+    run.tasks = NULL;
+    run.statements = NULL;
+
+    if (!clrl_parallel_worthwhile(count, 2)) return run_serial(&run);
+
+    run.remaining = (uint32_t*)malloc(count * sizeof(uint32_t));
+    run.tasks = (ClrlTask*)calloc(count, sizeof(ClrlTask));
+    run.statements = (ScheduledStatement*)calloc(count, sizeof(ScheduledStatement));
+    if (run.remaining == NULL || run.tasks == NULL || run.statements == NULL) {
+        free(run.remaining);
+        free(run.tasks);
+        free(run.statements);
+        return run_serial(&run);
+    }
+    memcpy(run.remaining, schedule->predecessor_count, count * sizeof(uint32_t));
+    for (size_t i = 0; i < count; i++) {
+        run.statements[i].run = &run;
+        run.statements[i].index = i;
+    }
+
+    // Waiting in source order keeps the output order of a serial run;
+    // joining helps with whatever is ready in the meantime
+    int failed = 0;
+    size_t next_root = 0;
+    for (size_t i = 0; i < count; i++) {
+        for (; next_root < count && next_root <= i + SCHEDULE_WINDOW; next_root++) {
+            if (schedule->predecessor_count[next_root] == 0) release(&run, next_root);
+        }
+        clrl_task_join(&run.tasks[i]);
+
+        ScheduledStatement* statement = &run.statements[i];
+        if (statement->output.len > 0) clrl_output_write(statement->output.text, statement->output.len);
+        free(statement->output.text);
+        clrl_output_flush();
+        clrl_error_replay(&statement->errors);
+        clrl_error_log_free(&statement->errors);
+        if (statement->failed) failed = 1;
+    }
+
+    free(run.remaining);
+    free(run.tasks);
+    free(run.statements);
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,629 @@
+#include "../../include/clrl/clrl_context.h"
+#include "../../include/clrl/clrl_thread.h"
+#include "clrl_buffer.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#define read _read
+#define write _write
+#else
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Evaluation server (clrlc --serve)
+ *
+ * Requests and responses are frames of one header line and a raw payload:
+ *
+ *   request    <id> <length>\n <length bytes of CLRL source>
+ *   response   <id> <status> <output length> <error length>\n <output> <errors>
+ *
+ * The id is any word of up to SERVE_MAX_ID bytes chosen by the client and
+ * echoed back; status is the ClrlStatus of the evaluation, output is what
+ * its return statements wrote and errors are its "Error: ..." lines. A
+ * broken stream (malformed header, oversized request, input ending inside
+ * a request) is answered with one last response of id '*' carrying the
+ * error, after the requests before it, and the connection is closed.
+ *
+ * Every connection evaluates in its own context, so variables carry over
+ * from one request to the next and no connection sees another's. Clients
+ * may send any number of requests without waiting; those of a connection
+ * are evaluated and answered in order.
+ *
+ * The calling thread only moves bytes: it waits for input on the listening
+ * socket and the connections and queues every connection that has whole
+ * requests for a fixed pool of workers. A worker evaluates all requests
+ * that arrived for its connection and sends their responses with a single
+ * write, then puts the connection back at the end of the queue if more
+ * requests came in meanwhile. A connection with SERVE_MAX_BUFFERED bytes
+ * received but not yet taken by a worker is not read from until a worker
+ * takes them, so a client that sends faster than it is served waits in
+ * its socket instead of growing the server's memory.
+ */
+
+#define SERVE_MAX_ID 64
+#define SERVE_MAX_HEADER (SERVE_MAX_ID + 24)   // id, space, 20 digits, newline
+#define SERVE_READ_SIZE (64u << 10)
+#define SERVE_POLL_MS 200                      // How often a quiet server checks for clrl_serve_stop
+#define SERVE_MAX_BUFFERED (64u << 20)         // Unserved bytes per connection (also the largest request)
+#define SERVE_FAILURE_ID "*"                   // Id of the response reporting a broken stream
+
+typedef struct ServeConnection {
+    int in_fd;
+    int out_fd;
+    int is_socket;                   // Owns its descriptor (closed with the connection)
+    int broken;                      // Sending failed; further responses are dropped (worker only)
+    ClrlContext* context;
+    ClrlBuffer input;               // Received bytes not yet forming a whole request (poll thread only)
+    ClrlBuffer pending;             // Whole requests waiting for a worker (guarded by lock)
+    ClrlErrorLog failure;            // Why the stream broke, answered after pending (guarded by lock)
+    pthread_mutex_t lock;
+    pthread_cond_t drained;          // Signalled when a worker takes the requests of a paused connection
+    int queued;                      // Waiting in the queue or being served (guarded by lock)
+    int closed;                      // No more requests will arrive (guarded by lock)
+    int paused;                      // Not read from until a worker takes pending (guarded by lock)
+    struct ServeConnection* next;        // Next connection polled for input (poll thread only)
+    struct ServeConnection* next_ready;  // Next connection in the work queue
+} ServeConnection;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    ServeConnection* head;           // Connections with requests, oldest first
+    ServeConnection* tail;
+    int stopping;                    // Workers exit once the queue is empty
+    int drain_pipe[2];               // Workers wake poll() through it when a paused connection drains (-1 = none)
+} ServeQueue;
+
+// Set by clrl_serve_stop (possibly from a signal handler)
+static int stop_requested = 0;
+
+// ===================== Framing =====================
+
+/**
+ * @brief Size of the request at the start of data
+ *
+ * @param size Receives the size of the whole frame (header and payload)
+ * @return int 1 if a whole request is there, 0 if more bytes are needed,
+ *         -1 if the header is malformed, -2 if the request is larger than
+ *         SERVE_MAX_BUFFERED
+ */
+static int frame_size(const char* data, size_t len, size_t* size) {
+    const char* newline = (const char*)memchr(data, '\n', (len < SERVE_MAX_HEADER) ? len : SERVE_MAX_HEADER);
+    if (newline == NULL) return (len < SERVE_MAX_HEADER) ? 0 : -1;
+    const char* space = (const char*)memchr(data, ' ', (size_t)(newline - data));
+    if (space == NULL || space == data || space - data > SERVE_MAX_ID || space + 1 == newline) return -1;
+
+    size_t payload = 0;
+    for (const char* p = space + 1; p < newline; p++) {
+        if (!isdigit((unsigned char)*p) || payload > (SIZE_MAX - 9) / 10) return -1;
+        payload = payload * 10 + (size_t)(*p - '0');
+    }
+    size_t header = (size_t)(newline - data) + 1;
+    if (payload > SERVE_MAX_BUFFERED - header) return -2;
+    if (len - header < payload) return 0;
+    *size = header + payload;
+    return 1;
+}
+
+// ===================== Connections =====================
+
+static ServeConnection* connection_new(int in_fd, int out_fd, int is_socket) {
+    ServeConnection* conn = (ServeConnection*)calloc(1, sizeof(ServeConnection));
+    if (conn == NULL) return NULL;
+    conn->context = clrl_context_create();
+    if (conn->context == NULL) {
+        free(conn);
+        return NULL;
+    }
+    conn->in_fd = in_fd;
+    conn->out_fd = out_fd;
+    conn->is_socket = is_socket;
+    pthread_mutex_init(&conn->lock, NULL);
+    pthread_cond_init(&conn->drained, NULL);
+    return conn;
+}
+
+static void connection_free(ServeConnection* conn) {
+#ifndef _WIN32
+    if (conn->is_socket) close(conn->in_fd);
+#endif
+    clrl_context_destroy(conn->context);
+    free(conn->input.data);
+    free(conn->pending.data);
+    clrl_error_log_free(&conn->failure);
+    pthread_cond_destroy(&conn->drained);
+    pthread_mutex_destroy(&conn->lock);
+    free(conn);
+}
+
+static void queue_push(ServeQueue* queue, ServeConnection* conn) {
+    pthread_mutex_lock(&queue->lock);
+    conn->next_ready = NULL;
+    if (queue->tail != NULL) {
+        queue->tail->next_ready = conn;
+    } else {
+        queue->head = conn;
+    }
+    queue->tail = conn;
+    pthread_cond_signal(&queue->wake);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+/**
+ * @brief Next connection to serve (NULL once stopping and nothing is left)
+ */
+static ServeConnection* queue_pop(ServeQueue* queue) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->head == NULL && !queue->stopping) pthread_cond_wait(&queue->wake, &queue->lock);
+    ServeConnection* conn = queue->head;
+    if (conn != NULL) {
+        queue->head = conn->next_ready;
+        if (queue->head == NULL) queue->tail = NULL;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return conn;
+}
+
+/**
+ * @brief Stop reading from a connection; it is freed once its requests are answered
+ */
+static void connection_close(ServeConnection* conn) {
+    pthread_mutex_lock(&conn->lock);
+    conn->closed = 1;
+    int idle = !conn->queued;
+    pthread_mutex_unlock(&conn->lock);
+    if (idle) connection_free(conn);
+}
+
+/**
+ * @brief Check whether a connection has too much unserved input to be read from
+ *
+ * A paused connection is resumed by the worker that takes its requests.
+ */
+static int connection_pause(ServeConnection* conn) {
+    pthread_mutex_lock(&conn->lock);
+    conn->paused = (conn->input.len + conn->pending.len >= SERVE_MAX_BUFFERED);
+    int paused = conn->paused;
+    pthread_mutex_unlock(&conn->lock);
+    return paused;
+}
+
+/**
+ * @brief Queue the answer to a broken stream behind the connection's requests
+ *
+ * @param failure Messages of the error (taken over and emptied)
+ */
+static void connection_fail(ServeQueue* queue, ServeConnection* conn, ClrlErrorLog* failure) {
+    pthread_mutex_lock(&conn->lock);
+    clrl_error_log_free(&conn->failure);
+    conn->failure = *failure;
+    memset(failure, 0, sizeof(*failure));
+    int wake = !conn->queued;
+    conn->queued = 1;
+    pthread_mutex_unlock(&conn->lock);
+    if (wake) queue_push(queue, conn);
+}
+
+/**
+ * @brief Read what a connection has sent and queue its whole requests
+ *
+ * @return int 0 while the connection stays open, 1 once its input ended
+ *         after a whole request, -1 if it has to be closed on an error
+ *         (read error, malformed header, oversized request or a request
+ *         cut off by the end of input; message reported)
+ */
+static int connection_receive(ServeQueue* queue, ServeConnection* conn) {
+    ClrlBuffer* input = &conn->input;
+    if (clrl_buffer_reserve(input, SERVE_READ_SIZE) != 0) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for request input\n");
+        return -1;
+    }
+    long received;
+#ifdef _WIN32
+    received = read(conn->in_fd, input->data + input->len, SERVE_READ_SIZE);
+#else
+    received = conn->is_socket ? (long)recv(conn->in_fd, input->data + input->len, SERVE_READ_SIZE, 0)
+                               : (long)read(conn->in_fd, input->data + input->len, SERVE_READ_SIZE);
+    if (received < 0 && (errno == EINTR || errno == EAGAIN)) return 0;
+#endif
+    if (received < 0) {
+        clrl_error(CLRL_ERROR_IO, "Error: Reading requests failed (%s), closing the connection\n", strerror(errno));
+        return -1;
+    }
+    if (received == 0) {
+        if (input->len == 0) return 1;
+        clrl_error(CLRL_ERROR_IO, "Error: Input ended inside a request (%zu bytes unanswered)\n", input->len);
+        return -1;
+    }
+    input->len += (size_t)received;
+
+    size_t whole = 0;
+    size_t size;
+    int framed;
+    while ((framed = frame_size(input->data + whole, input->len - whole, &size)) == 1) whole += size;
+    if (whole > 0) {
+        pthread_mutex_lock(&conn->lock);
+        int appended = clrl_buffer_append(&conn->pending, input->data, whole);
+        int wake = (appended == 0 && !conn->queued);
+        if (wake) conn->queued = 1;
+        pthread_mutex_unlock(&conn->lock);
+        if (appended != 0) {
+            clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for pending requests\n");
+            return -1;
+        }
+        memmove(input->data, input->data + whole, input->len - whole);
+        input->len -= whole;
+        if (wake) queue_push(queue, conn);
+    }
+    if (framed == -2) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Request is larger than %u bytes, closing the connection\n", SERVE_MAX_BUFFERED);
+        return -1;
+    }
+    if (framed < 0) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Malformed request header (expected '<id> <length>'), closing the connection\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief connection_receive, answering a broken stream on the connection itself
+ *
+ * The messages are also printed on the server's stderr.
+ */
+static int connection_read(ServeQueue* queue, ServeConnection* conn) {
+    ClrlErrorLog failure;
+    memset(&failure, 0, sizeof(failure));
+    ClrlErrorLog* previous = clrl_error_capture(&failure);
+    int received = connection_receive(queue, conn);
+    clrl_error_capture(previous);
+    clrl_error_replay(&failure);
+    if (received < 0) connection_fail(queue, conn, &failure);
+    clrl_error_log_free(&failure);
+    return received;
+}
+
+// ===================== Workers =====================
+
+/**
+ * @brief Append one response frame
+ *
+ * @return int 0 on success, -1 on allocation failure (message printed,
+ *         connection marked broken)
+ */
+static int serve_respond(ServeConnection* conn, ClrlBuffer* responses, const char* id, size_t id_len,
+                         ClrlStatus status, const char* output, size_t output_len, const char* errors, size_t errors_len) {
+    char header[SERVE_MAX_HEADER + 48];
+    int header_len = snprintf(header, sizeof(header), "%.*s %d %zu %zu\n",
+                              (int)id_len, id, (int)status, output_len, errors_len);
+    if (clrl_buffer_reserve(responses, (size_t)header_len + output_len + errors_len) != 0) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for a response, closing the connection\n");
+        conn->broken = 1;
+        return -1;
+    }
+    clrl_buffer_append(responses, header, (size_t)header_len);
+    clrl_buffer_append(responses, output, output_len);
+    clrl_buffer_append(responses, errors, errors_len);
+    return 0;
+}
+
+/**
+ * @brief Evaluate every request of batch and append the responses
+ */
+static void serve_batch(ServeConnection* conn, const ClrlBuffer* batch, ClrlBuffer* responses) {
+    size_t offset = 0;
+    size_t size;
+    while (offset < batch->len && frame_size(batch->data + offset, batch->len - offset, &size) == 1) {
+        const char* frame = batch->data + offset;
+        const char* space = (const char*)memchr(frame, ' ', size);
+        const char* payload = (const char*)memchr(frame, '\n', size) + 1;
+        offset += size;
+
+        ClrlStatus status = clrl_context_eval(conn->context, payload, (size_t)(frame + size - payload));
+        size_t output_len;
+        const char* output = clrl_context_output(conn->context, &output_len);
+        const char* errors = clrl_context_error(conn->context);
+        if (serve_respond(conn, responses, frame, (size_t)(space - frame), status,
+                          output, output_len, errors, strlen(errors)) != 0) {
+            return;
+        }
+    }
+}
+
+static void serve_send(ServeConnection* conn, const ClrlBuffer* responses) {
+    size_t sent = 0;
+    while (!conn->broken && sent < responses->len) {
+        long written;
+#ifdef _WIN32
+        written = write(conn->out_fd, responses->data + sent, (unsigned)(responses->len - sent));
+#else
+        written = conn->is_socket ? (long)send(conn->out_fd, responses->data + sent, responses->len - sent, MSG_NOSIGNAL)
+                                  : (long)write(conn->out_fd, responses->data + sent, responses->len - sent);
+        if (written < 0 && errno == EINTR) continue;
+#endif
+        if (written <= 0) {
+            conn->broken = 1;   // The client went away; its remaining requests are still drained
+            break;
+        }
+        sent += (size_t)written;
+    }
+}
+
+static void* serve_worker(void* arg) {
+    ServeQueue* queue = (ServeQueue*)arg;
+    ClrlBuffer batch = { NULL, 0, 0 };
+    ClrlBuffer responses = { NULL, 0, 0 };
+    ServeConnection* conn;
+    while ((conn = queue_pop(queue)) != NULL) {
+        // Take everything that has arrived; the poll thread keeps adding to an empty buffer
+        pthread_mutex_lock(&conn->lock);
+        ClrlBuffer taken = conn->pending;
+        batch.len = 0;
+        conn->pending = batch;
+        batch = taken;
+        ClrlErrorLog failure = conn->failure;
+        memset(&conn->failure, 0, sizeof(conn->failure));
+        int resumed = conn->paused;
+        conn->paused = 0;
+        if (resumed) pthread_cond_signal(&conn->drained);
+        pthread_mutex_unlock(&conn->lock);
+#ifndef _WIN32
+        if (resumed && queue->drain_pipe[1] >= 0) {
+            ssize_t woken = write(queue->drain_pipe[1], "", 1);   // A full pipe already wakes the poll thread
+            (void)woken;
+        }
+#endif
+
+        responses.len = 0;
+        if (!conn->broken) serve_batch(conn, &batch, &responses);
+        if (!conn->broken && failure.len > 0) {
+            serve_respond(conn, &responses, SERVE_FAILURE_ID, strlen(SERVE_FAILURE_ID), failure.status,
+                          NULL, 0, failure.text, failure.len);
+        }
+        clrl_error_log_free(&failure);
+        serve_send(conn, &responses);
+
+        pthread_mutex_lock(&conn->lock);
+        int more = conn->pending.len > 0 || conn->failure.len > 0;
+        int closed = conn->closed;
+        if (!more) conn->queued = 0;
+        pthread_mutex_unlock(&conn->lock);
+        if (more) {
+            queue_push(queue, conn);     // Behind the connections that waited meanwhile
+        } else if (closed) {
+            connection_free(conn);
+        }
+    }
+    free(batch.data);
+    free(responses.data);
+    clrl_context_thread_release();
+    return NULL;
+}
+
+// ===================== Server =====================
+
+#ifndef _WIN32
+/**
+ * @brief Listen on a Unix domain socket (a stale socket file is replaced)
+ *
+ * @return int Listening descriptor, -1 on error (message printed)
+ */
+static int serve_listen(const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Socket path '%s' is too long\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    struct stat info;
+    if (stat(path, &info) == 0 && S_ISSOCK(info.st_mode)) unlink(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 64) != 0) {
+        clrl_error(CLRL_ERROR_IO, "Error: Cannot listen on '%s' (%s)\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Accept clients and read their requests until clrl_serve_stop
+ *
+ * @return int 0 once stopped, -1 if the server itself failed (a client's
+ *         broken stream only closes that connection)
+ */
+static int serve_socket(ServeQueue* queue, const char* path) {
+    int listen_fd = serve_listen(path);
+    if (listen_fd < 0) return -1;
+
+    ServeConnection* connections = NULL;
+    size_t count = 0;
+    struct pollfd* fds = NULL;
+    ServeConnection** polled = NULL;
+    size_t capacity = 0;
+    int status = 0;
+
+    while (!__atomic_load_n(&stop_requested, __ATOMIC_RELAXED)) {
+        if (count + 2 > capacity) {
+            size_t grown_capacity = (capacity == 0) ? 64 : capacity * 2;
+            struct pollfd* grown_fds = (struct pollfd*)realloc(fds, grown_capacity * sizeof(struct pollfd));
+            if (grown_fds != NULL) fds = grown_fds;
+            ServeConnection** grown_polled = (ServeConnection**)realloc(polled, grown_capacity * sizeof(ServeConnection*));
+            if (grown_polled != NULL) polled = grown_polled;
+            if (grown_fds == NULL || grown_polled == NULL) {
+                clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for the connection list\n");
+                status = -1;
+                break;
+            }
+            capacity = grown_capacity;
+        }
+        fds[0].fd = listen_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = queue->drain_pipe[0];
+        fds[1].events = POLLIN;
+        size_t n = 2;
+        for (ServeConnection* conn = connections; conn != NULL; conn = conn->next) {
+            if (connection_pause(conn)) continue;
+            fds[n].fd = conn->in_fd;
+            fds[n].events = POLLIN;
+            polled[n++] = conn;
+        }
+
+        int ready = poll(fds, (nfds_t)n, SERVE_POLL_MS);
+        if (ready < 0 && errno != EINTR) {
+            clrl_error(CLRL_ERROR_IO, "Error: Waiting for requests failed (%s)\n", strerror(errno));
+            status = -1;
+            break;
+        }
+        if (ready <= 0) continue;
+
+        if (fds[1].revents != 0) {
+            char drain[64];
+            while (read(queue->drain_pipe[0], drain, sizeof(drain)) > 0) {}
+        }
+        for (size_t i = 2; i < n; i++) {
+            if (fds[i].revents == 0) continue;
+            ServeConnection* conn = polled[i];
+            if (connection_read(queue, conn) == 0) continue;
+            ServeConnection** link = &connections;
+            while (*link != conn) link = &(*link)->next;
+            *link = conn->next;
+            count--;
+            connection_close(conn);
+        }
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, NULL, NULL);
+            ServeConnection* conn = (fd >= 0) ? connection_new(fd, fd, 1) : NULL;
+            if (conn != NULL) {
+                conn->next = connections;
+                connections = conn;
+                count++;
+            } else if (fd >= 0) {
+                clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for a new connection\n");
+                close(fd);
+            }
+        }
+    }
+
+    while (connections != NULL) {
+        ServeConnection* conn = connections;
+        connections = conn->next;
+        connection_close(conn);
+    }
+    free(fds);
+    free(polled);
+    close(listen_fd);
+    unlink(path);
+    return status;
+}
+#endif
+
+int clrl_serve(const char* socket_path, size_t workers) {
+#ifdef _WIN32
+    if (socket_path != NULL) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Serving on a socket is not supported on this platform (use stdin/stdout)\n");
+        return -1;
+    }
+#endif
+    if (workers == 0) workers = clrl_get_thread_count();
+    __atomic_store_n(&stop_requested, 0, __ATOMIC_RELAXED);
+
+    ServeQueue queue;
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.wake, NULL);
+    queue.head = NULL;
+    queue.tail = NULL;
+    queue.stopping = 0;
+    queue.drain_pipe[0] = -1;
+    queue.drain_pipe[1] = -1;
+#ifndef _WIN32
+    if (socket_path != NULL) {
+        if (pipe(queue.drain_pipe) != 0) {
+            clrl_error(CLRL_ERROR_IO, "Error: Cannot create the server's wake-up pipe (%s)\n", strerror(errno));
+            pthread_cond_destroy(&queue.wake);
+            pthread_mutex_destroy(&queue.lock);
+            return -1;
+        }
+        fcntl(queue.drain_pipe[0], F_SETFL, fcntl(queue.drain_pipe[0], F_GETFL) | O_NONBLOCK);
+        fcntl(queue.drain_pipe[1], F_SETFL, fcntl(queue.drain_pipe[1], F_GETFL) | O_NONBLOCK);
+    }
+#endif
+
+    pthread_t* threads = (pthread_t*)malloc(workers * sizeof(pthread_t));
+    size_t started = 0;
+    if (threads != NULL) {
+        for (; started < workers; started++) {
+            if (pthread_create(&threads[started], NULL, serve_worker, &queue) != 0) break;
+        }
+    }
+    int status = 0;
+    if (started == 0) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Cannot start the server's worker threads\n");
+        status = -1;
+    } else if (socket_path != NULL) {
+#ifndef _WIN32
+        status = serve_socket(&queue, socket_path);
+#endif
+    } else {
+        // One client on stdin/stdout, served until its input ends
+#ifdef _WIN32
+        // Payload lengths count bytes; text mode would translate line endings
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        ServeConnection* conn = connection_new(0, 1, 0);
+        if (conn == NULL) {
+            clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for the connection\n");
+            status = -1;
+        } else {
+            int received;
+            do {
+                // Wait for a worker to take the requests of a connection that is too far ahead
+                pthread_mutex_lock(&conn->lock);
+                while (conn->input.len + conn->pending.len >= SERVE_MAX_BUFFERED) {
+                    conn->paused = 1;
+                    pthread_cond_wait(&conn->drained, &conn->lock);
+                }
+                pthread_mutex_unlock(&conn->lock);
+            } while ((received = connection_read(&queue, conn)) == 0);
+            if (received < 0) status = -1;
+            connection_close(conn);
+        }
+    }
+
+    // Workers answer everything still queued before they exit
+    pthread_mutex_lock(&queue.lock);
+    queue.stopping = 1;
+    pthread_cond_broadcast(&queue.wake);
+    pthread_mutex_unlock(&queue.lock);
+    for (size_t i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    free(threads);
+#ifndef _WIN32
+    if (queue.drain_pipe[0] >= 0) {
+        close(queue.drain_pipe[0]);
+        close(queue.drain_pipe[1]);
+    }
+#endif
+    pthread_cond_destroy(&queue.wake);
+    pthread_mutex_destroy(&queue.lock);
+    return status;
+}
+
+void clrl_serve_stop(void) {
+    __atomic_store_n(&stop_requested, 1, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,272 @@
+#include "../../include/clrl/clrl_larnum.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_limbs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Vector kernels for the linear limb and decimal text loops
+ *
+ * Addition adds 8 (AVX2) or 4 (SSE4.1) limbs per step without carries and
+ * then resolves the carries of the whole block at once: a lane generates a
+ * carry if its sum wrapped and propagates an incoming one if its sum is all
+ * ones, so with one bit per lane the carries into the lanes are
+ * ((generate << 1 | carry_in) + propagate) ^ propagate, and the bit above
+ * the block is its carry out. Subtraction does the same with borrows.
+ * Decimal text is validated 32 or 16 bytes at a time.
+ *
+ * The instruction set is picked once, at first use, from what the CPU
+ * supports ($CLRL_SIMD or larnum_set_simd can restrict it); builds for
+ * other targets, or with CLRL_NO_SIMD defined, use the scalar loops only.
+ */
+
+#if !defined(CLRL_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CLRL_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+// Operands shorter than this stay on the scalar loop
+#define SIMD_MIN_LIMBS 16
+#define SIMD_MIN_DIGITS 32
+
+typedef enum {
+    SIMD_SCALAR,
+    SIMD_SSE41,
+    SIMD_AVX2
+} SimdLevel;
+
+static const char* const simd_names[] = { "scalar", "sse4.1", "avx2" };
+
+static int simd_level = -1;   // SimdLevel in use, -1 until detected
+
+/**
+ * @brief Best level the CPU supports
+ */
+static SimdLevel simd_supported(void) {
+#ifdef CLRL_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SIMD_SSE41;
+#endif
+    return SIMD_SCALAR;
+}
+
+static int simd_parse(const char* name) {
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX2; level++) {
+        if (strcmp(name, simd_names[level]) == 0) return level;
+    }
+    return -1;
+}
+
+static SimdLevel simd_get(void) {
+    int level = __atomic_load_n(&simd_level, __ATOMIC_RELAXED);
+    if (level < 0) {
+        level = simd_supported();
+        const char* env = getenv("CLRL_SIMD");
+        int wanted = (env != NULL) ? simd_parse(env) : -1;
+        if (wanted >= 0 && wanted < level) level = wanted;
+        __atomic_store_n(&simd_level, level, __ATOMIC_RELAXED);
+    }
+    return (SimdLevel)level;
+}
+
+const char* larnum_get_simd(void) {
+    return simd_names[simd_get()];
+}
+
+int larnum_set_simd(const char* name) {
+    int level = simd_parse(name);
+    if (level < 0) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Unknown instruction set '%s' (expected avx2, sse4.1 or scalar)\n", name);
+        return -1;
+    }
+    if (level > (int)simd_supported()) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: This CPU does not support %s\n", name);
+        return -1;
+    }
+    __atomic_store_n(&simd_level, level, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// ===================== Scalar kernels =====================
+
+static LarnumLimb add_n_scalar(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n,
+                               LarnumLimb carry_in) {
+    LarnumDoubleLimb carry = carry_in;
+    for (size_t i = 0; i < n; i++) {
+        carry += (LarnumDoubleLimb)a[i] + b[i];
+        r[i] = (LarnumLimb)carry;
+        carry >>= LARNUM_LIMB_BITS;
+    }
+    return (LarnumLimb)carry;
+}
+
+static LarnumLimb sub_n_scalar(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n,
+                               LarnumLimb borrow) {
+    for (size_t i = 0; i < n; i++) {
+        LarnumDoubleLimb diff = (LarnumDoubleLimb)a[i] - b[i] - borrow;
+        r[i] = (LarnumLimb)diff;
+        borrow = (LarnumLimb)((diff >> LARNUM_LIMB_BITS) & 1);
+    }
+    return borrow;
+}
+
+static size_t decimal_span_scalar(const char* str, size_t len) {
+    size_t i = 0;
+    while (i < len && str[i] >= '0' && str[i] <= '9') i++;
+    return i;
+}
+
+// ===================== x86 kernels =====================
+
+#ifdef CLRL_SIMD_X86
+
+__attribute__((target("avx2")))
+static LarnumLimb add_n_avx2(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n) {
+    const __m256i ones = _mm256_set1_epi32(-1);
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    unsigned carry = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i s = _mm256_add_epi32(x, y);
+        __m256i no_wrap = _mm256_cmpeq_epi32(_mm256_max_epu32(s, x), s);
+        unsigned generate = ~(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(no_wrap)) & 0xFFu;
+        unsigned propagate = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(s, ones)));
+        unsigned chain = ((generate << 1) | carry) + propagate;
+        carry = chain >> 8;
+        // Lanes that receive a carry become -1 and are subtracted
+        __m256i in = _mm256_and_si256(_mm256_set1_epi32((int)((chain ^ propagate) & 0xFFu)), lane_bits);
+        _mm256_storeu_si256((__m256i*)(r + i), _mm256_sub_epi32(s, _mm256_cmpeq_epi32(in, lane_bits)));
+    }
+    return add_n_scalar(r + i, a + i, b + i, n - i, carry);
+}
+
+__attribute__((target("avx2")))
+static LarnumLimb sub_n_avx2(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    unsigned borrow = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i d = _mm256_sub_epi32(x, y);
+        __m256i no_borrow = _mm256_cmpeq_epi32(_mm256_max_epu32(x, y), x);
+        unsigned generate = ~(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(no_borrow)) & 0xFFu;
+        unsigned propagate = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(d, zero)));
+        unsigned chain = ((generate << 1) | borrow) + propagate;
+        borrow = chain >> 8;
+        // Lanes that receive a borrow add -1
+        __m256i in = _mm256_and_si256(_mm256_set1_epi32((int)((chain ^ propagate) & 0xFFu)), lane_bits);
+        _mm256_storeu_si256((__m256i*)(r + i), _mm256_add_epi32(d, _mm256_cmpeq_epi32(in, lane_bits)));
+    }
+    return sub_n_scalar(r + i, a + i, b + i, n - i, borrow);
+}
+
+__attribute__((target("avx2")))
+static size_t decimal_span_avx2(const char* str, size_t len) {
+    const __m256i zero_char = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i*)(str + i)), zero_char);
+        unsigned digits = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(v, nine), v));
+        if (digits != 0xFFFFFFFFu) return i + (size_t)__builtin_ctz(~digits);
+    }
+    return i + decimal_span_scalar(str + i, len - i);
+}
+
+__attribute__((target("sse4.1")))
+static LarnumLimb add_n_sse41(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n) {
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+    unsigned carry = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i s = _mm_add_epi32(x, y);
+        __m128i no_wrap = _mm_cmpeq_epi32(_mm_max_epu32(s, x), s);
+        unsigned generate = ~(unsigned)_mm_movemask_ps(_mm_castsi128_ps(no_wrap)) & 0xFu;
+        unsigned propagate = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(s, ones)));
+        unsigned chain = ((generate << 1) | carry) + propagate;
+        carry = chain >> 4;
+        __m128i in = _mm_and_si128(_mm_set1_epi32((int)((chain ^ propagate) & 0xFu)), lane_bits);
+        _mm_storeu_si128((__m128i*)(r + i), _mm_sub_epi32(s, _mm_cmpeq_epi32(in, lane_bits)));
+    }
+    return add_n_scalar(r + i, a + i, b + i, n - i, carry);
+}
+
+__attribute__((target("sse4.1")))
+static LarnumLimb sub_n_sse41(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+    unsigned borrow = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i d = _mm_sub_epi32(x, y);
+        __m128i no_borrow = _mm_cmpeq_epi32(_mm_max_epu32(x, y), x);
+        unsigned generate = ~(unsigned)_mm_movemask_ps(_mm_castsi128_ps(no_borrow)) & 0xFu;
+        unsigned propagate = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(d, zero)));
+        unsigned chain = ((generate << 1) | borrow) + propagate;
+        borrow = chain >> 4;
+        __m128i in = _mm_and_si128(_mm_set1_epi32((int)((chain ^ propagate) & 0xFu)), lane_bits);
+        _mm_storeu_si128((__m128i*)(r + i), _mm_add_epi32(d, _mm_cmpeq_epi32(in, lane_bits)));
+    }
+    return sub_n_scalar(r + i, a + i, b + i, n - i, borrow);
+}
+
+__attribute__((target("sse4.1")))
+static size_t decimal_span_sse41(const char* str, size_t len) {
+    const __m128i zero_char = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(str + i)), zero_char);
+        unsigned digits = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, nine), v));
+        if (digits != 0xFFFFu) return i + (size_t)__builtin_ctz(~digits);
+    }
+    return i + decimal_span_scalar(str + i, len - i);
+}
+
+#endif // CLRL_SIMD_X86
+
+// ===================== Dispatch =====================
+
+LarnumLimb limbs_add_n(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n) {
+#ifdef CLRL_SIMD_X86
+    if (n >= SIMD_MIN_LIMBS) {
+        SimdLevel level = simd_get();
+        if (level == SIMD_AVX2) return add_n_avx2(r, a, b, n);
+        if (level == SIMD_SSE41) return add_n_sse41(r, a, b, n);
+    }
+#endif
+    return add_n_scalar(r, a, b, n, 0);
+}
+
+LarnumLimb limbs_sub_n(LarnumLimb* r, const LarnumLimb* a, const LarnumLimb* b, size_t n) {
+#ifdef CLRL_SIMD_X86
+    if (n >= SIMD_MIN_LIMBS) {
+        SimdLevel level = simd_get();
+        if (level == SIMD_AVX2) return sub_n_avx2(r, a, b, n);
+        if (level == SIMD_SSE41) return sub_n_sse41(r, a, b, n);
+    }
+#endif
+    return sub_n_scalar(r, a, b, n, 0);
+}
+
+size_t decimal_span(const char* str, size_t len) {
+#ifdef CLRL_SIMD_X86
+    if (len >= SIMD_MIN_DIGITS) {
+        SimdLevel level = simd_get();
+        if (level == SIMD_AVX2) return decimal_span_avx2(str, len);
+        if (level == SIMD_SSE41) return decimal_span_sse41(str, len);
+    }
+#endif
+    return decimal_span_scalar(str, len);
+}
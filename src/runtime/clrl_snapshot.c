@@ -0,0 +1,387 @@
+#include "../../include/clrl/clrl_vm.h"
+#include "../../include/clrl/clrl_context.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Binary snapshots of the variable table
+ *
+ * Layout (native byte order, checked when loading):
+ *
+ *   SnapshotHeader           magic, version, byte order, limb size, count
+ *   SnapshotEntry[count]     one per variable, in definition order
+ *   names                    name bytes of all entries, back to back
+ *   payloads                 limbs of each value, 8-byte aligned
+ *
+ * The index at the front is all the loader reads. Values are attached to
+ * their variables as borrowed limbs pointing into a private read-only
+ * mapping, so their pages are only read when a value is first used, and
+ * redefining a variable copies nothing out of the file.
+ */
+
+#define SNAPSHOT_MAGIC "CLRLSNAP"
+#define SNAPSHOT_VERSION 1u
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+// Decimal places a precise value may have beyond its own digits (leading
+// zeros of a tiny fraction); printing costs one byte per place
+#define SNAPSHOT_MAX_EXTRA_PLACES ((uint64_t)1 << 20)
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;     // SNAPSHOT_BYTE_ORDER as stored by the saving machine
+    uint32_t limb_bits;      // LARNUM_LIMB_BITS
+    uint32_t entry_size;     // sizeof(SnapshotEntry)
+    uint64_t count;          // Number of entries
+} SnapshotHeader;
+
+typedef struct {
+    uint64_t name_offset;    // File offset of the name (not NUL-terminated)
+    uint64_t limbs_offset;   // File offset of the limbs (8-byte aligned)
+    uint64_t limb_count;     // Normalized: the top limb is non-zero
+    int64_t exponent;        // Decimal exponent (0 for larnum)
+    uint32_t name_len;
+    uint8_t type;            // VarType
+    uint8_t negative;
+    uint16_t reserved;
+} SnapshotEntry;
+
+struct VarSnapshot {
+    ClrlSourceFile file;     // Mapping (or heap copy) of the snapshot file
+    size_t references;       // Variables whose limbs point into file
+    VarSnapshot* next;
+};
+
+// ===================== References =====================
+
+void var_snapshot_release(VarTable* table, VarSnapshot* snapshot) {
+    if (--snapshot->references > 0) return;
+    VarSnapshot** link = &table->snapshots;
+    while (*link != snapshot) link = &(*link)->next;
+    *link = snapshot->next;
+    clrl_source_close(&snapshot->file);
+    free(snapshot);
+}
+
+void var_snapshot_release_all(VarTable* table) {
+    while (table->snapshots != NULL) {
+        VarSnapshot* snapshot = table->snapshots;
+        table->snapshots = snapshot->next;
+        clrl_source_close(&snapshot->file);
+        free(snapshot);
+    }
+}
+
+// ===================== Saving =====================
+
+static uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+/**
+ * @brief Check that a precise value's exponent fits the digits it stores
+ *
+ * |exponent| may exceed the coefficient's decimal digits (at most 10 per
+ * limb) by SNAPSHOT_MAX_EXTRA_PLACES, so a damaged exponent cannot make
+ * printing a small value allocate gigabytes.
+ */
+static int exponent_in_range(int64_t exponent, uint64_t limb_count) {
+    uint64_t places = (exponent < 0) ? (uint64_t)0 - (uint64_t)exponent : (uint64_t)exponent;
+    return limb_count <= (UINT64_MAX - SNAPSHOT_MAX_EXTRA_PLACES) / 10
+        && places <= limb_count * 10 + SNAPSHOT_MAX_EXTRA_PLACES;
+}
+
+static const Larnum* node_limbs(const VarNode* node) {
+    return (node->type == VAR_LARNUM) ? &node->value.larnum_val : &node->value.precise_val.coefficient;
+}
+
+/**
+ * @brief Write zero bytes until *offset reaches target
+ */
+static void write_padding(FILE* out, uint64_t* offset, uint64_t target) {
+    static const char zeros[8] = { 0 };
+    if (target > *offset) fwrite(zeros, 1, (size_t)(target - *offset), out);
+    *offset = target;
+}
+
+/**
+ * @brief Move the finished file over path (replacing an older snapshot)
+ */
+static int replace_file(const char* from, const char* to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+    return rename(from, to);
+#endif
+}
+
+int clrl_snapshot_save(VarTable* table, const char* path) {
+    // Stored values must be current: stale ones are recomputed first
+    for (VarNode* node = table->head; node != NULL; node = node->next) {
+        if (node->stale && clrl_vm_refresh(table, node) != 0) return -1;
+        // Would be refused by clrl_snapshot_load
+        if (node->type == VAR_PRECISE
+            && !exponent_in_range(node->value.precise_val.exponent, node->value.precise_val.coefficient.size)) {
+            clrl_error(CLRL_ERROR_ARGUMENT, "Error: Cannot save '%s': '%s' has too many decimal places\n", path, node->name);
+            return -1;
+        }
+    }
+
+    size_t path_len = strlen(path);
+    char* temp = (char*)malloc(path_len + 5);
+    if (temp == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while saving '%s'\n", path);
+        return -1;
+    }
+    memcpy(temp, path, path_len);
+    memcpy(temp + path_len, ".tmp", 5);
+    FILE* out = fopen(temp, "wb");
+    if (out == NULL) {
+        clrl_error(CLRL_ERROR_IO, "Error: Cannot write '%s'\n", path);
+        free(temp);
+        return -1;
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.limb_bits = LARNUM_LIMB_BITS;
+    header.entry_size = sizeof(SnapshotEntry);
+    header.count = table->count;
+    fwrite(&header, sizeof(header), 1, out);
+
+    // Names follow the index; payloads start at the next aligned offset
+    uint64_t name_offset = sizeof(SnapshotHeader) + (uint64_t)table->count * sizeof(SnapshotEntry);
+    uint64_t limbs_offset = name_offset;
+    for (VarNode* node = table->head; node != NULL; node = node->next) limbs_offset += strlen(node->name);
+    limbs_offset = align8(limbs_offset);
+
+    for (VarNode* node = table->head; node != NULL; node = node->next) {
+        const Larnum* limbs = node_limbs(node);
+        SnapshotEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.name_len = (uint32_t)strlen(node->name);
+        entry.name_offset = name_offset;
+        entry.limbs_offset = limbs_offset;
+        entry.limb_count = limbs->size;
+        entry.exponent = (node->type == VAR_PRECISE) ? node->value.precise_val.exponent : 0;
+        entry.type = (uint8_t)node->type;
+        entry.negative = (uint8_t)(limbs->size > 0 && limbs->negative);
+        fwrite(&entry, sizeof(entry), 1, out);
+        name_offset += entry.name_len;
+        limbs_offset = align8(limbs_offset + limbs->size * sizeof(LarnumLimb));
+    }
+
+    uint64_t offset = sizeof(SnapshotHeader) + (uint64_t)table->count * sizeof(SnapshotEntry);
+    for (VarNode* node = table->head; node != NULL; node = node->next) {
+        size_t len = strlen(node->name);
+        fwrite(node->name, 1, len, out);
+        offset += len;
+    }
+    for (VarNode* node = table->head; node != NULL && !ferror(out); node = node->next) {
+        const Larnum* limbs = node_limbs(node);
+        write_padding(out, &offset, align8(offset));
+        if (limbs->size > 0) fwrite(limbs->limbs, sizeof(LarnumLimb), limbs->size, out);
+        offset += limbs->size * sizeof(LarnumLimb);
+    }
+
+    int status = ferror(out) ? -1 : 0;
+    if (fclose(out) != 0) status = -1;
+    if (status == 0) status = replace_file(temp, path);
+    if (status != 0) {
+        clrl_error(CLRL_ERROR_IO, "Error: Cannot write '%s'\n", path);
+        remove(temp);
+    }
+    free(temp);
+    return status;
+}
+
+// ===================== Loading =====================
+
+/**
+ * @brief Map a snapshot read-only (copy-on-write), or read it if it cannot be mapped
+ */
+static int snapshot_map(ClrlSourceFile* file, const char* path) {
+    file->data = NULL;
+    file->len = 0;
+    file->mapped = 0;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (handle != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size;
+        HANDLE mapping = NULL;
+        if (GetFileSizeEx(handle, &size) && size.QuadPart > 0) {
+            mapping = CreateFileMappingA(handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        }
+        const char* view = (mapping != NULL) ? (const char*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) : NULL;
+        if (mapping != NULL) CloseHandle(mapping);   // The view keeps the mapping alive
+        CloseHandle(handle);
+        if (view != NULL) {
+            file->data = view;
+            file->len = (size_t)size.QuadPart;
+            file->mapped = 1;
+            return 0;
+        }
+    }
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) {
+                close(fd);
+                file->data = (const char*)view;
+                file->len = (size_t)info.st_size;
+                file->mapped = 1;
+                return 0;
+            }
+        }
+        close(fd);
+    }
+#endif
+
+    // Not mappable (empty, special file, no address space): read it whole
+    FILE* stream = fopen(path, "rb");
+    if (stream == NULL) {
+        clrl_error(CLRL_ERROR_IO, "Error: Cannot open snapshot '%s'\n", path);
+        return -1;
+    }
+    size_t capacity = 64 * 1024;
+    size_t used = 0;
+    char* data = (char*)malloc(capacity);
+    while (data != NULL) {
+        used += fread(data + used, 1, capacity - used, stream);
+        if (used < capacity) break;
+        char* grown = (char*)realloc(data, capacity * 2);
+        if (grown == NULL) {
+            free(data);
+            data = NULL;
+            break;
+        }
+        data = grown;
+        capacity *= 2;
+    }
+    fclose(stream);
+    if (data == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while reading '%s'\n", path);
+        return -1;
+    }
+    file->data = data;
+    file->len = used;
+    return 0;
+}
+
+static int is_name(const char* name, size_t len) {
+    if (len == 0) return 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)name[i];
+        int start = isalpha(c) || c == '_' || c >= 0x80;
+        if (!start && (i == 0 || !isdigit(c))) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Check that an entry lies inside the file and describes a valid value
+ */
+static int entry_valid(const SnapshotEntry* entry, const ClrlSourceFile* file) {
+    uint64_t len = file->len;
+    if (entry->type != VAR_LARNUM && entry->type != VAR_PRECISE) return 0;
+    if (entry->type == VAR_LARNUM && entry->exponent != 0) return 0;
+    if (!exponent_in_range(entry->exponent, entry->limb_count)) return 0;
+    if (entry->name_offset > len || entry->name_len > len - entry->name_offset) return 0;
+    if (!is_name(file->data + entry->name_offset, entry->name_len)) return 0;
+    if (entry->limbs_offset % 8 != 0 || entry->limbs_offset > len) return 0;
+    if (entry->limb_count > (len - entry->limbs_offset) / sizeof(LarnumLimb)) return 0;
+    if (entry->limb_count == 0) return entry->negative == 0;
+    const LarnumLimb* limbs = (const LarnumLimb*)(file->data + entry->limbs_offset);
+    return entry->negative <= 1 && limbs[entry->limb_count - 1] != 0;
+}
+
+int clrl_snapshot_load(VarTable* table, const char* path) {
+    VarSnapshot* snapshot = (VarSnapshot*)calloc(1, sizeof(VarSnapshot));
+    if (snapshot == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while loading '%s'\n", path);
+        return -1;
+    }
+    if (snapshot_map(&snapshot->file, path) != 0) {
+        free(snapshot);
+        return -1;
+    }
+
+    // Validate the whole index before any variable changes
+    const ClrlSourceFile* file = &snapshot->file;
+    const SnapshotHeader* header = (const SnapshotHeader*)file->data;
+    const SnapshotEntry* entries = (const SnapshotEntry*)(file->data + sizeof(SnapshotHeader));
+    const char* problem = NULL;
+    if (file->len < sizeof(SnapshotHeader) || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        problem = "not a CLRL snapshot";
+    } else if (header->version != SNAPSHOT_VERSION || header->entry_size != sizeof(SnapshotEntry)) {
+        problem = "unsupported snapshot version";
+    } else if (header->byte_order != SNAPSHOT_BYTE_ORDER || header->limb_bits != LARNUM_LIMB_BITS) {
+        problem = "written on a machine with a different number layout";
+    } else if (header->count > (file->len - sizeof(SnapshotHeader)) / sizeof(SnapshotEntry)) {
+        problem = "file is truncated";
+    } else {
+        for (uint64_t i = 0; i < header->count; i++) {
+            if (!entry_valid(&entries[i], file)) {
+                problem = "file is damaged";
+                break;
+            }
+        }
+    }
+    if (problem != NULL) {
+        clrl_error(CLRL_ERROR_IO, "Error: Cannot load '%s': %s\n", path, problem);
+        clrl_source_close(&snapshot->file);
+        free(snapshot);
+        return -1;
+    }
+
+    // The loader holds one reference until every variable is attached
+    snapshot->references = 1;
+    snapshot->next = table->snapshots;
+    table->snapshots = snapshot;
+
+    int status = 0;
+    for (uint64_t i = 0; i < header->count && status == 0; i++) {
+        const SnapshotEntry* entry = &entries[i];
+        const char* name = file->data + entry->name_offset;
+        VarNode* node = var_table_find(table, name, entry->name_len);
+        if (node == NULL) node = var_table_insert(table, name, entry->name_len);
+        if (node == NULL) {
+            clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for new variable '%.*s'\n", (int)entry->name_len, name);
+            status = -1;
+            break;
+        }
+
+        Precise value;
+        value.coefficient.limbs = (entry->limb_count > 0) ? (LarnumLimb*)(file->data + entry->limbs_offset) : NULL;
+        value.coefficient.size = (size_t)entry->limb_count;
+        value.coefficient.capacity = 0;   // Borrowed: the limbs belong to the mapping
+        value.coefficient.negative = entry->negative;
+        value.exponent = entry->exponent;
+
+        snapshot->references++;
+        var_table_attach(table, node, (VarType)entry->type,
+                         (entry->type == VAR_LARNUM) ? (const void*)&value.coefficient : (const void*)&value, snapshot);
+        // Like any plain definition: the formula goes, dependents go stale
+        var_table_set_formula(table, node, NULL, 0, NULL, 0);
+        if (var_table_invalidate(table, node) != 0) {
+            clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for variable '%s'\n", node->name);
+            status = -1;
+        }
+    }
+    var_snapshot_release(table, snapshot);
+    return status;
+}
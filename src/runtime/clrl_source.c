@@ -0,0 +1,128 @@
+#include "../../include/clrl/clrl_vm.h"
+#include "../../include/clrl/clrl_context.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Script file access
+ *
+ * Scripts are mapped read-only into memory and handed to the compiler as
+ * one (pointer, length) span. Tokens point into the mapping and numeric
+ * literals are converted straight from it, so neither lines nor literals
+ * are ever copied into fixed-size buffers.
+ */
+
+/**
+ * @brief Fallback for files that cannot be mapped (pipes, special files)
+ */
+static int read_stream(ClrlSourceFile* file, FILE* stream) {
+    size_t capacity = 64 * 1024;
+    size_t used = 0;
+    char* text = (char*)malloc(capacity);
+    while (text != NULL) {
+        used += fread(text + used, 1, capacity - used, stream);
+        if (used < capacity) break;
+        char* grown = (char*)realloc(text, capacity * 2);
+        if (grown == NULL) {
+            free(text);
+            text = NULL;
+            break;
+        }
+        text = grown;
+        capacity *= 2;
+    }
+    if (text == NULL) return -1;
+    file->data = text;
+    file->len = used;
+    file->mapped = 0;
+    return 0;
+}
+
+int clrl_source_open(ClrlSourceFile* file, const char* path) {
+    file->data = NULL;
+    file->len = 0;
+    file->mapped = 0;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(handle, &size) && size.QuadPart == 0) {
+            CloseHandle(handle);
+            return 0;
+        }
+        HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        const char* view = (mapping != NULL) ? (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (mapping != NULL) CloseHandle(mapping);   // The view keeps the mapping alive
+        CloseHandle(handle);
+        if (view != NULL) {
+            file->data = view;
+            file->len = (size_t)size.QuadPart;
+            file->mapped = 1;
+            return 0;
+        }
+    }
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            if (info.st_size == 0) {
+                close(fd);
+                return 0;
+            }
+            void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) {
+                // The compiler reads the script front to back exactly once
+                madvise(view, (size_t)info.st_size, MADV_SEQUENTIAL);
+                close(fd);
+                file->data = (const char*)view;
+                file->len = (size_t)info.st_size;
+                file->mapped = 1;
+                return 0;
+            }
+        }
+        close(fd);
+    }
+#endif
+
+    FILE* stream = fopen(path, "rb");
+    if (stream == NULL) {
+        clrl_error(CLRL_ERROR_IO, "Error: Cannot open script '%s'\n", path);
+        return -1;
+    }
+    int status = read_stream(file, stream);
+    fclose(stream);
+    if (status != 0) clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while reading '%s'\n", path);
+    return status;
+}
+
+void clrl_source_close(ClrlSourceFile* file) {
+    if (file->mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile(file->data);
+#else
+        munmap((void*)file->data, file->len);
+#endif
+    } else {
+        free((void*)file->data);
+    }
+    file->data = NULL;
+    file->len = 0;
+    file->mapped = 0;
+}
+
+int clrl_execute_file(const char* path, unsigned flags) {
+    ClrlSourceFile file;
+    if (clrl_source_open(&file, path) != 0) return -1;
+    int status = clrl_execute_source(file.data, file.len, path, flags);
+    clrl_source_close(&file);
+    return status;
+}
@@ -0,0 +1,366 @@
+#include "../../include/clrl/clrl_thread.h"
+#include "../../include/clrl/clrl_memory.h"
+#include "../../include/clrl/clrl_context.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * Work-stealing thread pool
+ *
+ * Every worker owns a deque: it pushes and pops forked tasks at the bottom
+ * (LIFO, cache-friendly), idle threads steal from the top of other deques
+ * (FIFO, so they take the largest pending subproblems). Threads that are
+ * not pool workers share deque 0. A thread waiting in clrl_task_join only
+ * runs tasks of its own: the joined task if nobody took it yet and, on a
+ * worker, what it forked onto its deque. A task forked by another thread
+ * would report its errors and output into this thread's context. A joined
+ * task that was stolen is being run by the thief, so nested fork/join
+ * inside recursive kernels cannot deadlock. Idle workers sleep on a
+ * condition variable until new tasks are forked.
+ */
+
+// Capacity of each deque; when full, forked tasks simply run inline
+#define DEQUE_CAPACITY 1024
+
+// Upper bound on configurable threads
+#define MAX_THREADS 256
+
+/**
+ * @brief Task deque (mutex-protected ring buffer)
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    ClrlTask* items[DEQUE_CAPACITY];
+    size_t top;        // Next index to steal from
+    size_t bottom;     // Next index to push to
+} TaskDeque;
+
+typedef struct {
+    TaskDeque* deques;          // deques[0] for external threads, [1..] for workers
+    pthread_t* workers;
+    size_t worker_count;        // Background threads (thread_count - 1)
+    size_t started;             // Threads actually created
+    int running;
+
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t wake;
+    size_t pending;             // Tasks sitting in deques (atomic)
+    size_t sleepers;            // Workers waiting on wake (atomic)
+    int stopping;
+} ThreadPool;
+
+static ThreadPool pool = {
+    .sleep_lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER
+};
+static pthread_mutex_t pool_start_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t thread_count = 0;                 // 0 = not yet configured
+
+// Deque index of the current thread (0 for threads outside the pool)
+static CLRL_THREAD_LOCAL size_t worker_index = 0;
+
+// ===================== Configuration =====================
+
+static size_t online_cpus(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (info.dwNumberOfProcessors > 0) ? (size_t)info.dwNumberOfProcessors : 1;
+#else
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus > 0) ? (size_t)cpus : 1;
+#endif
+}
+
+size_t clrl_get_thread_count(void) {
+    size_t threads = __atomic_load_n(&thread_count, __ATOMIC_ACQUIRE);
+    if (threads == 0) {
+        const char* env = getenv("CLRL_THREADS");
+        threads = (env != NULL) ? (size_t)strtoul(env, NULL, 10) : 0;
+        if (threads == 0) threads = online_cpus();
+        if (threads > MAX_THREADS) threads = MAX_THREADS;
+        __atomic_store_n(&thread_count, threads, __ATOMIC_RELEASE);
+    }
+    return threads;
+}
+
+int clrl_set_thread_count(size_t threads) {
+    if (threads == 0) threads = online_cpus();
+    if (threads > MAX_THREADS) {
+        clrl_error(CLRL_ERROR_ARGUMENT, "Error: Thread count must be at most %d\n", MAX_THREADS);
+        return -1;
+    }
+    // Workers are sized at start-up, so a running pool has to be rebuilt
+    clrl_thread_shutdown();
+    __atomic_store_n(&thread_count, threads, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// ===================== Deques =====================
+
+static void deque_push(TaskDeque* deque, ClrlTask* task, int* pushed) {
+    pthread_mutex_lock(&deque->lock);
+    *pushed = (deque->bottom - deque->top) < DEQUE_CAPACITY;
+    if (*pushed) {
+        deque->items[deque->bottom % DEQUE_CAPACITY] = task;
+        __atomic_store_n(&deque->bottom, deque->bottom + 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&deque->lock);
+}
+
+static ClrlTask* deque_pop(TaskDeque* deque) {
+    ClrlTask* task = NULL;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        __atomic_store_n(&deque->bottom, deque->bottom - 1, __ATOMIC_RELAXED);
+        task = deque->items[deque->bottom % DEQUE_CAPACITY];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+/**
+ * @brief Remove one particular task if it is still queued (the ones above it move down)
+ */
+static int deque_take(TaskDeque* deque, ClrlTask* task) {
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    for (size_t i = deque->bottom; i > deque->top; i--) {
+        if (deque->items[(i - 1) % DEQUE_CAPACITY] != task) continue;
+        for (size_t j = i; j < deque->bottom; j++) {
+            deque->items[(j - 1) % DEQUE_CAPACITY] = deque->items[j % DEQUE_CAPACITY];
+        }
+        __atomic_store_n(&deque->bottom, deque->bottom - 1, __ATOMIC_RELAXED);
+        found = 1;
+        break;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static ClrlTask* deque_steal(TaskDeque* deque) {
+    ClrlTask* task = NULL;
+    // Peek without the lock first: most deques are empty most of the time
+    if (__atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) == __atomic_load_n(&deque->top, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom > deque->top) {
+        task = deque->items[deque->top % DEQUE_CAPACITY];
+        __atomic_store_n(&deque->top, deque->top + 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return task;
+}
+
+/**
+ * @brief Take a task: own deque first, then steal round-robin from the others
+ */
+static ClrlTask* find_task(void) {
+    size_t count = pool.worker_count + 1;
+    ClrlTask* task = deque_pop(&pool.deques[worker_index]);
+    for (size_t i = 1; task == NULL && i < count; i++) {
+        task = deque_steal(&pool.deques[(worker_index + i) % count]);
+    }
+    if (task != NULL) __atomic_sub_fetch(&pool.pending, 1, __ATOMIC_SEQ_CST);
+    return task;
+}
+
+static void run_task(ClrlTask* task) {
+    task->run(task->arg);
+    __atomic_store_n(&task->done, 1, __ATOMIC_RELEASE);
+}
+
+// ===================== Workers =====================
+
+static void* worker_main(void* arg) {
+    worker_index = (size_t)(uintptr_t)arg;
+    for (;;) {
+        ClrlTask* task = find_task();
+        if (task != NULL) {
+            run_task(task);
+            continue;
+        }
+        pthread_mutex_lock(&pool.sleep_lock);
+        __atomic_add_fetch(&pool.sleepers, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&pool.pending, __ATOMIC_SEQ_CST) == 0 && !pool.stopping) {
+            pthread_cond_wait(&pool.wake, &pool.sleep_lock);
+        }
+        __atomic_sub_fetch(&pool.sleepers, 1, __ATOMIC_SEQ_CST);
+        int stopping = pool.stopping;
+        pthread_mutex_unlock(&pool.sleep_lock);
+        if (stopping) break;
+    }
+    // Buffers cached by this thread would be unreachable once it exits
+    clrl_mem_trim();
+    clrl_arena_release(clrl_scratch_arena());
+    return NULL;
+}
+
+/**
+ * @brief Start the workers on first use
+ *
+ * @return int 1 if the pool is running, 0 if kernels should stay serial
+ */
+static int pool_start(void) {
+    if (__atomic_load_n(&pool.running, __ATOMIC_ACQUIRE)) return 1;
+    size_t threads = clrl_get_thread_count();
+    if (threads <= 1) return 0;
+
+    pthread_mutex_lock(&pool_start_lock);
+    if (!pool.running) {
+        size_t workers = threads - 1;
+        pool.deques = (TaskDeque*)calloc(workers + 1, sizeof(TaskDeque));
+        pool.workers = (pthread_t*)calloc(workers, sizeof(pthread_t));
+        if (pool.deques == NULL || pool.workers == NULL) {
+            free(pool.deques);
+            free(pool.workers);
+            pool.deques = NULL;
+            pool.workers = NULL;
+            pthread_mutex_unlock(&pool_start_lock);
+            return 0;
+        }
+        for (size_t i = 0; i <= workers; i++) pthread_mutex_init(&pool.deques[i].lock, NULL);
+        pool.stopping = 0;
+        pool.pending = 0;
+        pool.worker_count = workers;
+        pool.started = 0;
+        // A worker that fails to start leaves an empty deque behind, which is harmless
+        for (size_t i = 0; i < workers; i++) {
+            if (pthread_create(&pool.workers[pool.started], NULL, worker_main, (void*)(uintptr_t)(i + 1)) == 0) {
+                pool.started++;
+            }
+        }
+        __atomic_store_n(&pool.running, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&pool_start_lock);
+    return 1;
+}
+
+void clrl_thread_shutdown(void) {
+    pthread_mutex_lock(&pool_start_lock);
+    if (pool.running) {
+        pthread_mutex_lock(&pool.sleep_lock);
+        pool.stopping = 1;
+        pthread_cond_broadcast(&pool.wake);
+        pthread_mutex_unlock(&pool.sleep_lock);
+        for (size_t i = 0; i < pool.started; i++) pthread_join(pool.workers[i], NULL);
+        for (size_t i = 0; i <= pool.worker_count; i++) pthread_mutex_destroy(&pool.deques[i].lock);
+        free(pool.deques);
+        free(pool.workers);
+        pool.deques = NULL;
+        pool.workers = NULL;
+        pool.worker_count = 0;
+        pool.started = 0;
+        __atomic_store_n(&pool.running, 0, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&pool_start_lock);
+}
+
+// ===================== Tasks =====================
+
+int clrl_parallel_worthwhile(size_t work, size_t min_work) {
+    return work >= min_work && clrl_get_thread_count() > 1;
+}
+
+void clrl_task_fork(ClrlTask* task, void (*run)(void* arg), void* arg) {
+    task->run = run;
+    task->arg = arg;
+    // The joining thread may already be polling the flag
+    __atomic_store_n(&task->done, 0, __ATOMIC_RELAXED);
+
+    int pushed = 0;
+    if (pool_start()) deque_push(&pool.deques[worker_index], task, &pushed);
+    if (!pushed) {
+        run_task(task);
+        return;
+    }
+    __atomic_add_fetch(&pool.pending, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool.sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pool.sleep_lock);
+        pthread_cond_signal(&pool.wake);
+        pthread_mutex_unlock(&pool.sleep_lock);
+    }
+}
+
+void clrl_task_join(ClrlTask* task) {
+    if (__atomic_load_n(&task->done, __ATOMIC_ACQUIRE)) return;   // Also covers tasks run inline
+    if (deque_take(&pool.deques[worker_index], task)) {
+        __atomic_sub_fetch(&pool.pending, 1, __ATOMIC_SEQ_CST);
+        run_task(task);
+        return;
+    }
+    // Stolen: while the thief runs it, a worker works through its own deque
+    unsigned spins = 0;
+    while (!__atomic_load_n(&task->done, __ATOMIC_ACQUIRE)) {
+        ClrlTask* own = (worker_index != 0) ? deque_pop(&pool.deques[worker_index]) : NULL;
+        if (own != NULL) {
+            __atomic_sub_fetch(&pool.pending, 1, __ATOMIC_SEQ_CST);
+            run_task(own);
+            spins = 0;
+        } else if (++spins > 64) {
+            sched_yield();
+        }
+    }
+}
+
+/**
+ * @brief Range split in halves: one half forked, the other recursed inline
+ */
+typedef struct {
+    size_t begin;
+    size_t end;
+    size_t grain;
+    ClrlRangeFn body;
+    void* ctx;
+} RangeTask;
+
+static void range_run(void* arg) {
+    RangeTask* range = (RangeTask*)arg;
+    if (range->end - range->begin <= range->grain) {
+        range->body(range->ctx, range->begin, range->end);
+        return;
+    }
+    size_t mid = range->begin + (range->end - range->begin) / 2;
+    RangeTask upper = { mid, range->end, range->grain, range->body, range->ctx };
+    RangeTask lower = { range->begin, mid, range->grain, range->body, range->ctx };
+    ClrlTask task;
+    clrl_task_fork(&task, range_run, &upper);
+    range_run(&lower);
+    clrl_task_join(&task);
+}
+
+void clrl_parallel_for(size_t count, size_t grain, ClrlRangeFn body, void* ctx) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    if (count <= grain || clrl_get_thread_count() <= 1) {
+        body(ctx, 0, count);
+        return;
+    }
+    RangeTask range = { 0, count, grain, body, ctx };
+    range_run(&range);
+}
+
+// ===================== Locks =====================
+
+void clrl_lock_acquire(ClrlLock* lock) {
+    unsigned spins = 0;
+    while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE) != 0) {
+        while (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED) != 0) {
+            if (++spins > 64) sched_yield();
+        }
+    }
+}
+
+void clrl_lock_release(ClrlLock* lock) {
+    __atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+}
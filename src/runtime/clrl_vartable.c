@@ -0,0 +1,350 @@
+#include "../../include/clrl/clrl_runtime.h"
+
+/**
+ * Hash-indexed variable table
+ *
+ * Variable nodes live in open-addressed slots (linear probing, load factor
+ * at most 1/2) and are chained in definition order for listing. Nodes,
+ * interned names and value limbs are carved out of the table's arena, so
+ * there are no per-variable heap allocations and clearing the table is an
+ * arena reset plus freeing the slot array. Values of up to VAR_SMALL_LIMBS
+ * limbs sit in the node itself and do not touch the arena pool at all.
+ */
+
+// Initial number of hash slots (power of two)
+#define VAR_TABLE_MIN_CAPACITY 64
+
+/**
+ * @brief FNV-1a hash of a variable name
+ */
+size_t var_table_hash(const char* name, size_t len) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211ULL;
+    }
+    return (size_t)(hash ^ (hash >> 32));
+}
+
+/**
+ * @brief Double the slot array and reinsert every node
+ */
+static int var_table_grow(VarTable* table) {
+    size_t capacity = (table->capacity == 0) ? VAR_TABLE_MIN_CAPACITY : table->capacity * 2;
+    VarNode** slots = (VarNode**)calloc(capacity, sizeof(VarNode*));
+    if (slots == NULL) return -1;
+
+    // Walking the definition-order chain visits every node exactly once
+    for (VarNode* node = table->head; node != NULL; node = node->next) {
+        size_t i = node->hash & (capacity - 1);
+        while (slots[i] != NULL) i = (i + 1) & (capacity - 1);
+        slots[i] = node;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief Copy src into borrowed storage: the node's own limbs, or the arena
+ */
+static int store_larnum(VarTable* table, VarNode* node, Larnum* dst, const Larnum* src) {
+    larnum_init(dst);
+    if (src->size == 0) return 0;
+    LarnumLimb* limbs = node->small;
+    if (src->size > VAR_SMALL_LIMBS) {
+        limbs = (LarnumLimb*)clrl_arena_pool_alloc(&table->arena, src->size * sizeof(LarnumLimb));
+        if (limbs == NULL) return -1;
+    }
+    // src may be the node's current value, already sitting in node->small
+    memmove(limbs, src->limbs, src->size * sizeof(LarnumLimb));
+    dst->limbs = limbs;
+    dst->size = src->size;
+    dst->negative = src->negative;
+    return 0;
+}
+
+/**
+ * @brief Give a stored larnum's limbs back to the arena pool
+ */
+static void release_larnum(VarTable* table, VarNode* node, Larnum* x) {
+    if (x->capacity > 0) {
+        larnum_free(x);   // Heap-owned value
+    } else if (x->limbs != NULL && x->limbs != node->small) {
+        // Stored values are never resized, so size still selects the chunk class
+        clrl_arena_pool_free(&table->arena, x->limbs, x->size * sizeof(LarnumLimb));
+    }
+    larnum_init(x);
+}
+
+/**
+ * @brief Give up a variable's current value (arena limbs or snapshot reference)
+ */
+static void release_value(VarTable* table, VarNode* node) {
+    if (node->snapshot != NULL) {
+        // Snapshot limbs are only referenced, never freed one by one
+        var_snapshot_release(table, node->snapshot);
+        node->snapshot = NULL;
+        larnum_init(&node->value.larnum_val);
+    } else if (node->type == VAR_LARNUM) {
+        release_larnum(table, node, &node->value.larnum_val);
+    } else {
+        release_larnum(table, node, &node->value.precise_val.coefficient);
+    }
+}
+
+void var_table_init(VarTable* table) {
+    table->visit_stamp = 0;
+    table->snapshots = NULL;
+    table->slots = NULL;
+    table->capacity = 0;
+    table->count = 0;
+    table->head = NULL;
+    table->tail = NULL;
+    clrl_arena_init(&table->arena);
+}
+
+void var_table_clear(VarTable* table) {
+    var_snapshot_release_all(table);
+    free(table->slots);
+    table->slots = NULL;
+    table->capacity = 0;
+    table->count = 0;
+    table->head = NULL;
+    table->tail = NULL;
+    clrl_arena_reset(&table->arena);
+}
+
+void var_table_release(VarTable* table) {
+    var_table_clear(table);
+    clrl_arena_release(&table->arena);
+}
+
+VarNode* var_table_find(const VarTable* table, const char* name, size_t len) {
+    if (table->count == 0) return NULL;
+    size_t hash = var_table_hash(name, len);
+    size_t mask = table->capacity - 1;
+    for (size_t i = hash & mask; table->slots[i] != NULL; i = (i + 1) & mask) {
+        VarNode* node = table->slots[i];
+        if (node->hash == hash && strncmp(node->name, name, len) == 0 && node->name[len] == '\0') {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+VarNode* var_table_insert(VarTable* table, const char* name, size_t len) {
+    // Keep the load factor at or below 1/2 so probe chains stay short
+    if ((table->count + 1) * 2 > table->capacity && var_table_grow(table) != 0) return NULL;
+
+    VarNode* node = (VarNode*)clrl_arena_alloc(&table->arena, sizeof(VarNode));
+    char* interned = (node != NULL) ? (char*)clrl_arena_alloc(&table->arena, len + 1) : NULL;
+    if (interned == NULL) return NULL;
+    memcpy(interned, name, len);
+    interned[len] = '\0';
+
+    node->name = interned;
+    node->hash = var_table_hash(name, len);
+    node->type = VAR_LARNUM;
+    larnum_init(&node->value.larnum_val);
+    node->next = NULL;
+    node->formula = NULL;
+    node->formula_len = 0;
+    node->inputs = NULL;
+    node->input_count = 0;
+    node->dependents = NULL;
+    node->dependent_count = 0;
+    node->dependent_capacity = 0;
+    node->stale = 0;
+    node->visited = 0;
+    node->snapshot = NULL;
+
+    size_t mask = table->capacity - 1;
+    size_t i = node->hash & mask;
+    while (table->slots[i] != NULL) i = (i + 1) & mask;
+    table->slots[i] = node;
+
+    if (table->tail != NULL) {
+        table->tail->next = node;
+    } else {
+        table->head = node;
+    }
+    table->tail = node;
+    table->count++;
+    return node;
+}
+
+int var_table_assign(VarTable* table, VarNode* node, VarType type, const void* value) {
+    // Build the new value first: value may point into the old one
+    Precise stored;
+    if (type == VAR_LARNUM) {
+        if (store_larnum(table, node, &stored.coefficient, (const Larnum*)value) != 0) return -1;
+    } else {
+        const Precise* precise = (const Precise*)value;
+        if (store_larnum(table, node, &stored.coefficient, &precise->coefficient) != 0) return -1;
+        stored.exponent = precise->exponent;
+    }
+
+    release_value(table, node);
+
+    node->type = type;
+    if (type == VAR_LARNUM) {
+        node->value.larnum_val = stored.coefficient;
+    } else {
+        node->value.precise_val = stored;
+    }
+    node->stale = 0;
+    return 0;
+}
+
+void var_table_attach(VarTable* table, VarNode* node, VarType type, const void* value, VarSnapshot* snapshot) {
+    release_value(table, node);
+    node->type = type;
+    if (type == VAR_LARNUM) {
+        node->value.larnum_val = *(const Larnum*)value;
+    } else {
+        node->value.precise_val = *(const Precise*)value;
+    }
+    node->snapshot = snapshot;
+    node->stale = 0;
+}
+
+// ===================== Formula dependencies =====================
+
+/**
+ * @brief Remove node from the dependents of input (order does not matter)
+ */
+static void unlink_dependent(VarNode* input, const VarNode* node) {
+    for (size_t i = 0; i < input->dependent_count; i++) {
+        if (input->dependents[i] == node) {
+            input->dependents[i] = input->dependents[--input->dependent_count];
+            return;
+        }
+    }
+}
+
+static int link_dependent(VarTable* table, VarNode* input, VarNode* node) {
+    if (input->dependent_count == input->dependent_capacity) {
+        size_t capacity = (input->dependent_capacity == 0) ? 4 : input->dependent_capacity * 2;
+        VarNode** dependents = (VarNode**)clrl_arena_pool_alloc(&table->arena, capacity * sizeof(VarNode*));
+        if (dependents == NULL) return -1;
+        if (input->dependent_count > 0) memcpy(dependents, input->dependents, input->dependent_count * sizeof(VarNode*));
+        clrl_arena_pool_free(&table->arena, input->dependents, input->dependent_capacity * sizeof(VarNode*));
+        input->dependents = dependents;
+        input->dependent_capacity = capacity;
+    }
+    input->dependents[input->dependent_count++] = node;
+    return 0;
+}
+
+/**
+ * @brief Growable stack of nodes for graph walks
+ */
+typedef struct {
+    VarNode** items;
+    size_t count;
+    size_t capacity;
+} NodeStack;
+
+static int stack_push(NodeStack* stack, VarNode* node) {
+    if (stack->count == stack->capacity) {
+        size_t capacity = (stack->capacity == 0) ? 64 : stack->capacity * 2;
+        VarNode** items = (VarNode**)realloc(stack->items, capacity * sizeof(VarNode*));
+        if (items == NULL) return -1;
+        stack->items = items;
+        stack->capacity = capacity;
+    }
+    stack->items[stack->count++] = node;
+    return 0;
+}
+
+/**
+ * @brief Check whether any of inputs is target or is computed from it
+ *
+ * Walks forward from target through its dependents, so a definition
+ * nothing reads yet (the common case: chains are built front to back)
+ * costs only a look at its own inputs.
+ *
+ * @return int 1 if so (or if the walk ran out of memory), 0 otherwise
+ */
+static int reaches(VarTable* table, VarNode* const* inputs, size_t input_count, VarNode* target) {
+    for (size_t i = 0; i < input_count; i++) {
+        if (inputs[i] == target) return 1;
+    }
+    if (input_count == 0 || target->dependent_count == 0) return 0;
+
+    size_t stamp = ++table->visit_stamp;
+    NodeStack stack = { NULL, 0, 0 };
+    int found = stack_push(&stack, target) != 0;
+    target->visited = stamp;
+    while (!found && stack.count > 0) {
+        VarNode* node = stack.items[--stack.count];
+        for (size_t i = 0; i < node->dependent_count && !found; i++) {
+            VarNode* dependent = node->dependents[i];
+            if (dependent->visited == stamp) continue;
+            dependent->visited = stamp;
+            for (size_t k = 0; k < input_count && !found; k++) {
+                if (inputs[k] == dependent) found = 1;
+            }
+            if (!found && stack_push(&stack, dependent) != 0) found = 1;
+        }
+    }
+    free(stack.items);
+    return found;
+}
+
+int var_table_set_formula(VarTable* table, VarNode* node, const char* formula, size_t len,
+                          VarNode* const* inputs, size_t input_count) {
+    for (size_t i = 0; i < node->input_count; i++) unlink_dependent(node->inputs[i], node);
+    clrl_arena_pool_free(&table->arena, node->inputs, node->input_count * sizeof(VarNode*));
+    clrl_arena_pool_free(&table->arena, node->formula, node->formula_len + 1);
+    node->formula = NULL;
+    node->formula_len = 0;
+    node->inputs = NULL;
+    node->input_count = 0;
+
+    // A cycle could never be brought up to date, so such a value stays plain
+    if (formula == NULL || reaches(table, inputs, input_count, node)) return 0;
+
+    char* text = (char*)clrl_arena_pool_alloc(&table->arena, len + 1);
+    VarNode** copy = (input_count > 0) ? (VarNode**)clrl_arena_pool_alloc(&table->arena, input_count * sizeof(VarNode*)) : NULL;
+    if (text == NULL || (input_count > 0 && copy == NULL)) {
+        clrl_arena_pool_free(&table->arena, text, len + 1);
+        clrl_arena_pool_free(&table->arena, copy, input_count * sizeof(VarNode*));
+        return -1;
+    }
+    memcpy(text, formula, len);
+    text[len] = '\0';
+    for (size_t i = 0; i < input_count; i++) {
+        if (link_dependent(table, inputs[i], node) != 0) {
+            while (i-- > 0) unlink_dependent(inputs[i], node);
+            clrl_arena_pool_free(&table->arena, text, len + 1);
+            clrl_arena_pool_free(&table->arena, copy, input_count * sizeof(VarNode*));
+            return -1;
+        }
+        copy[i] = inputs[i];
+    }
+    node->formula = text;
+    node->formula_len = len;
+    node->inputs = copy;
+    node->input_count = input_count;
+    return 0;
+}
+
+int var_table_invalidate(VarTable* table, VarNode* node) {
+    NodeStack stack = { NULL, 0, 0 };
+    int status = stack_push(&stack, node);
+    while (status == 0 && stack.count > 0) {
+        VarNode* current = stack.items[--stack.count];
+        for (size_t i = 0; i < current->dependent_count && status == 0; i++) {
+            VarNode* dependent = current->dependents[i];
+            // Everything computed from a stale value is already stale
+            if (dependent->stale) continue;
+            dependent->stale = 1;
+            status = stack_push(&stack, dependent);
+        }
+    }
+    free(stack.items);
+    return status;
+}
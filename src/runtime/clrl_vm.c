@@ -0,0 +1,780 @@
+#include "../../include/clrl/clrl_vm.h"
+#include "../../include/clrl/clrl_thread.h"
+#include "../../include/clrl/clrl_profile.h"
+#include "../../include/clrl/clrl_context.h"
+#include "clrl_buffer.h"
+
+/**
+ * Register VM for compiled CLRL programs
+ *
+ * Values are tagged larnum/precise. Mixed operations view the larnum side
+ * as a precise value with exponent 0 (no copy), so a precise result only
+ * appears when a precise operand or a fractional division asks for it.
+ */
+
+/**
+ * @brief Resolved operand: type plus a pointer to the payload
+ */
+typedef struct {
+    VarType type;
+    const VarValue* value;
+} Operand;
+
+/**
+ * @brief Program being run by clrl_schedule_run (shared by all statements)
+ */
+typedef struct {
+    const ClrlProgram* program;
+    VarTable* table;
+    VarNode** bindings;
+    size_t* precision;
+    ClrlLock table_lock;          // Guards updates of table by concurrently running statements
+} VmRun;
+
+// ===================== Output =====================
+
+// Results are collected here and written in large blocks
+#define OUTPUT_BUFFER_SIZE (1u << 20)
+
+static char* output_buffer = NULL;
+static size_t output_used = 0;
+
+// Statements run by the scheduler write here instead (see clrl_schedule_run)
+static CLRL_THREAD_LOCAL ClrlOutputCapture* output_capture = NULL;
+
+ClrlOutputCapture* clrl_output_capture(ClrlOutputCapture* capture) {
+    ClrlOutputCapture* previous = output_capture;
+    output_capture = capture;
+    return previous;
+}
+
+/**
+ * @brief Append to the active capture (falls back to stdout if it cannot grow)
+ */
+static void capture_write(ClrlOutputCapture* capture, const char* text, size_t len) {
+    if (clrl_buffer_grow(&capture->text, &capture->capacity, capture->len + len) != 0) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for statement output\n");
+        return;
+    }
+    memcpy(capture->text + capture->len, text, len);
+    capture->len += len;
+}
+
+void clrl_output_flush(void) {
+    if (output_capture != NULL || output_used == 0) return;
+    fwrite(output_buffer, 1, output_used, stdout);
+    output_used = 0;
+    fflush(stdout);
+}
+
+void clrl_output_write(const char* text, size_t len) {
+    if (output_capture != NULL) {
+        capture_write(output_capture, text, len);
+        return;
+    }
+    if (output_buffer == NULL) {
+        output_buffer = (char*)malloc(OUTPUT_BUFFER_SIZE);
+        if (output_buffer == NULL) {
+            fwrite(text, 1, len, stdout);
+            return;
+        }
+    }
+    if (output_used + len > OUTPUT_BUFFER_SIZE) {
+        fwrite(output_buffer, 1, output_used, stdout);
+        output_used = 0;
+    }
+    if (len >= OUTPUT_BUFFER_SIZE) {
+        // Huge values go straight out instead of through the buffer
+        fwrite(text, 1, len, stdout);
+        return;
+    }
+    memcpy(output_buffer + output_used, text, len);
+    output_used += len;
+}
+
+// ===================== Interpreter =====================
+
+void clrl_vm_init(ClrlVm* vm) {
+    memset(vm, 0, sizeof(*vm));
+}
+
+void clrl_vm_free(ClrlVm* vm) {
+    for (size_t i = 0; i < vm->register_count; i++) {
+        larnum_free(&vm->registers[i].value.larnum_val);
+    }
+    free(vm->registers);
+    free(vm->bindings);
+    clrl_vm_init(vm);
+}
+
+/**
+ * @brief Make room for the registers and slots of a program
+ */
+static int vm_prepare(ClrlVm* vm, const ClrlProgram* program) {
+    if (program->register_count > vm->register_count) {
+        ClrlValue* registers = (ClrlValue*)realloc(vm->registers, program->register_count * sizeof(ClrlValue));
+        if (registers == NULL) return -1;
+        for (size_t i = vm->register_count; i < program->register_count; i++) {
+            registers[i].type = VAR_LARNUM;
+            larnum_init(&registers[i].value.larnum_val);
+        }
+        vm->registers = registers;
+        vm->register_count = program->register_count;
+    }
+    if (program->slot_count > vm->binding_count) {
+        VarNode** bindings = (VarNode**)realloc(vm->bindings, program->slot_count * sizeof(VarNode*));
+        if (bindings == NULL) return -1;
+        vm->bindings = bindings;
+        vm->binding_count = program->slot_count;
+    }
+    return 0;
+}
+
+/**
+ * @brief Check that a variable can be used as an operand
+ *
+ * @return int 0 if usable, -1 (error printed) if it is undefined or a
+ *         precise value where only larnum is allowed
+ */
+static int check_variable(const char* name, int defined, VarType type, int larnum_only) {
+    if (!defined || (larnum_only && type != VAR_LARNUM)) {
+        // Keep the error after the results printed before it
+        clrl_output_flush();
+    }
+    if (!defined) {
+        clrl_error(CLRL_ERROR_UNDEFINED, "Error: Variable '%s' is not defined\n", name);
+        return -1;
+    }
+    if (larnum_only && type != VAR_LARNUM) {
+        clrl_error(CLRL_ERROR_TYPE, "Error: Variable '%s' is not a larnum\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Decode a tagged operand
+ *
+ * @return int 0 on success, -1 if it names an unusable variable
+ */
+static int vm_operand(const ClrlVm* vm, const ClrlProgram* program, uint32_t x, int larnum_only, Operand* out) {
+    uint32_t index = CLRL_OPERAND_INDEX(x);
+    switch (CLRL_OPERAND_KIND(x)) {
+        case CLRL_OPERAND_REG:
+            out->type = vm->registers[index].type;
+            out->value = &vm->registers[index].value;
+            return 0;
+        case CLRL_OPERAND_CONST:
+            out->type = program->constants[index].type;
+            out->value = &program->constants[index].value;
+            return 0;
+        default: {
+            const VarNode* node = vm->bindings[index];
+            if (check_variable(program->slot_names[index], node != NULL,
+                               (node != NULL) ? node->type : VAR_LARNUM, larnum_only) != 0) return -1;
+            out->type = node->type;
+            out->value = &node->value;
+            return 0;
+        }
+    }
+}
+
+/**
+ * @brief View a larnum or precise operand as precise (larnum gets exponent 0)
+ */
+static Precise as_precise(const Operand* x) {
+    if (x->type == VAR_PRECISE) return x->value->precise_val;
+    Precise view;
+    view.coefficient = x->value->larnum_val;
+    view.exponent = 0;
+    return view;
+}
+
+static int vm_pow(ClrlValue* dst, const Operand* a, const Operand* b, size_t precision);
+static int vm_root(ClrlValue* dst, const Operand* a, const Operand* b, size_t precision);
+
+/**
+ * @brief dst = a <op> b
+ *
+ * dst may be one of the operand registers: every kernel below accepts an
+ * aliased result, and the larnum payload sits at the start of both union
+ * members, so switching dst between larnum and precise keeps its buffer.
+ */
+static int vm_arith(uint8_t op, ClrlValue* dst, const Operand* a, const Operand* b, size_t precision) {
+    if (op == CLRL_OP_POW) return vm_pow(dst, a, b, precision);
+    if (op == CLRL_OP_ROOT) return vm_root(dst, a, b, precision);
+    if (a->type == VAR_LARNUM && b->type == VAR_LARNUM) {
+        const Larnum* x = &a->value->larnum_val;
+        const Larnum* y = &b->value->larnum_val;
+        Larnum* r = &dst->value.larnum_val;
+        int status;
+        switch (op) {
+            case CLRL_OP_ADD: status = larnum_add(r, x, y); break;
+            case CLRL_OP_SUB: status = larnum_sub(r, x, y); break;
+            case CLRL_OP_MUL: status = larnum_mul(r, x, y); break;
+            case CLRL_OP_IDIV: status = larnum_divmod(r, NULL, x, y); break;
+            case CLRL_OP_MOD: status = larnum_divmod(NULL, r, x, y); break;
+            default:
+                if (precision == 0) {
+                    status = larnum_divmod(r, NULL, x, y);
+                    break;
+                }
+                // Fractional quotient: coefficient trunc(x * 10^p / y), exponent -p
+                if (larnum_div_scaled(r, x, y, precision) != 0) return -1;
+                dst->value.precise_val.exponent = -(int64_t)precision;
+                dst->type = VAR_PRECISE;
+                return 0;
+        }
+        if (status != 0) return -1;
+        dst->type = VAR_LARNUM;
+        return 0;
+    }
+
+    if (op == CLRL_OP_IDIV || op == CLRL_OP_MOD) {
+        clrl_error(CLRL_ERROR_TYPE, "Error: Operator '%s' requires larnum operands\n", (op == CLRL_OP_IDIV) ? "//" : "%");
+        return -1;
+    }
+
+    Precise x = as_precise(a);
+    Precise y = as_precise(b);
+    Precise* r = &dst->value.precise_val;
+    int status;
+    switch (op) {
+        case CLRL_OP_ADD: status = precise_add(r, &x, &y); break;
+        case CLRL_OP_SUB: status = precise_sub(r, &x, &y); break;
+        case CLRL_OP_MUL: status = precise_mul(r, &x, &y); break;
+        default: status = precise_div(r, &x, &y, precision); break;
+    }
+    if (status != 0) return -1;
+    dst->type = VAR_PRECISE;
+    return 0;
+}
+
+/**
+ * @brief dst = a ^ b; a negative exponent gives 1 / a^|b| with the precision of '/'
+ */
+static int vm_pow(ClrlValue* dst, const Operand* a, const Operand* b, size_t precision) {
+    if (b->type != VAR_LARNUM) {
+        clrl_error(CLRL_ERROR_TYPE, "Error: Exponent must be an integer\n");
+        return -1;
+    }
+    Larnum exponent = b->value->larnum_val;
+    int reciprocal = exponent.negative;
+    exponent.negative = 0;
+
+    // dst may be an operand register, so a reciprocal's power is built aside
+    ClrlValue power;
+    ClrlValue* target = reciprocal ? &power : dst;
+    if (reciprocal) larnum_init(&power.value.larnum_val);
+    int status;
+    if (a->type == VAR_LARNUM) {
+        status = larnum_pow(&target->value.larnum_val, &a->value->larnum_val, &exponent);
+    } else {
+        status = precise_pow(&target->value.precise_val, &a->value->precise_val, &exponent);
+    }
+    target->type = a->type;
+    if (status == 0 && reciprocal) {
+        LarnumLimb one_limb = 1;
+        VarValue one_value;
+        one_value.larnum_val.limbs = &one_limb;
+        one_value.larnum_val.size = 1;
+        one_value.larnum_val.capacity = 0;
+        one_value.larnum_val.negative = 0;
+        Operand one = { VAR_LARNUM, &one_value };
+        Operand divisor = { power.type, &power.value };
+        status = vm_arith(CLRL_OP_DIV, dst, &one, &divisor, precision);
+    }
+    if (reciprocal) larnum_free(&power.value.larnum_val);
+    return status;
+}
+
+/**
+ * @brief dst = b-th root of a, with the precision of '/' (an integer root for larnums at precision 0)
+ */
+static int vm_root(ClrlValue* dst, const Operand* a, const Operand* b, size_t precision) {
+    if (b->type != VAR_LARNUM) {
+        clrl_error(CLRL_ERROR_TYPE, "Error: Root degree must be an integer\n");
+        return -1;
+    }
+    if (a->type == VAR_LARNUM && precision == 0) {
+        if (larnum_root(&dst->value.larnum_val, &a->value->larnum_val, &b->value->larnum_val) != 0) return -1;
+        dst->type = VAR_LARNUM;
+        return 0;
+    }
+    Precise x = as_precise(a);
+    if (precise_root(&dst->value.precise_val, &x, &b->value->larnum_val, precision) != 0) return -1;
+    dst->type = VAR_PRECISE;
+    return 0;
+}
+
+/**
+ * @brief dst = powmod(a, e, m)
+ */
+static int vm_powmod(ClrlValue* dst, const Operand* a, const Operand* e, const Operand* m) {
+    if (a->type != VAR_LARNUM || e->type != VAR_LARNUM || m->type != VAR_LARNUM) {
+        clrl_error(CLRL_ERROR_TYPE, "Error: powmod requires larnum operands\n");
+        return -1;
+    }
+    if (larnum_powmod(&dst->value.larnum_val, &a->value->larnum_val,
+                      &e->value->larnum_val, &m->value->larnum_val) != 0) return -1;
+    dst->type = VAR_LARNUM;
+    return 0;
+}
+
+/**
+ * @brief dst = -a
+ */
+static int vm_neg(ClrlValue* dst, const Operand* a) {
+    // The coefficient sits at the start of both union members
+    if (larnum_copy(&dst->value.larnum_val, &a->value->larnum_val) != 0) return -1;
+    if (dst->value.larnum_val.size > 0) dst->value.larnum_val.negative ^= 1;
+    if (a->type == VAR_PRECISE) dst->value.precise_val.exponent = a->value->precise_val.exponent;
+    dst->type = a->type;
+    return 0;
+}
+
+/**
+ * @brief Print "name: value" for a return statement
+ */
+static void print_value(const char* name, VarType type, const VarValue* value) {
+    char* text = (type == VAR_LARNUM) ? larnum_to_string(&value->larnum_val)
+                                      : precise_to_string(&value->precise_val);
+    clrl_output_write(name, strlen(name));
+    clrl_output_write(": ", 2);
+    if (text != NULL) clrl_output_write(text, strlen(text));
+    clrl_output_write("\n", 1);
+    free(text);
+}
+
+/**
+ * @brief Execute one instruction
+ *
+ * @param precision Session division precision in effect for this statement
+ * @return int 0 on success, -1 if the statement has to be abandoned
+ */
+static int vm_step(ClrlVm* vm, const ClrlProgram* program, VarTable* table, const ClrlInsn* insn, size_t precision) {
+    int larnum_only = (insn->flags & CLRL_FLAG_LARNUM_ONLY) != 0;
+    Operand a, b;
+
+    switch (insn->op) {
+        case CLRL_OP_ADD:
+        case CLRL_OP_SUB:
+        case CLRL_OP_MUL:
+        case CLRL_OP_DIV:
+        case CLRL_OP_IDIV:
+        case CLRL_OP_MOD:
+        case CLRL_OP_POW:
+        case CLRL_OP_ROOT: {
+            if (vm_operand(vm, program, insn->a, larnum_only, &a) != 0 ||
+                vm_operand(vm, program, insn->b, larnum_only, &b) != 0) return -1;
+            if (insn->imm != CLRL_PRECISION_GLOBAL) precision = insn->imm;
+            return vm_arith(insn->op, &vm->registers[insn->dst], &a, &b, precision);
+        }
+
+        case CLRL_OP_NEG: {
+            if (vm_operand(vm, program, insn->a, larnum_only, &a) != 0) return -1;
+            return vm_neg(&vm->registers[insn->dst], &a);
+        }
+
+        case CLRL_OP_POWMOD: {
+            Operand m;
+            if (vm_operand(vm, program, insn->a, larnum_only, &a) != 0 ||
+                vm_operand(vm, program, insn->b, larnum_only, &b) != 0 ||
+                vm_operand(vm, program, insn->imm, larnum_only, &m) != 0) return -1;
+            return vm_powmod(&vm->registers[insn->dst], &a, &b, &m);
+        }
+
+        case CLRL_OP_STORE: {
+            if (vm_operand(vm, program, insn->a, larnum_only, &a) != 0) return -1;
+            // Concurrent statements share the table's slots and arena
+            if (vm->table_lock != NULL) clrl_lock_acquire(vm->table_lock);
+            VarNode* node = vm->bindings[insn->dst];
+            if (node == NULL) {
+                const char* name = program->slot_names[insn->dst];
+                node = var_table_insert(table, name, strlen(name));
+                if (node == NULL) {
+                    if (vm->table_lock != NULL) clrl_lock_release(vm->table_lock);
+                    clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for new variable '%s'\n", name);
+                    return -1;
+                }
+                vm->bindings[insn->dst] = node;
+            }
+            int status;
+            if ((insn->flags & CLRL_FLAG_TO_PRECISE) && a.type == VAR_LARNUM) {
+                Precise view = as_precise(&a);
+                status = var_table_assign(table, node, VAR_PRECISE, &view);
+            } else {
+                status = var_table_assign(table, node, a.type, a.value);
+            }
+            if (status == 0 && !vm->recomputing) {
+                // A plain store replaces the formula; values computed from it go stale
+                var_table_set_formula(table, node, NULL, 0, NULL, 0);
+                status = var_table_invalidate(table, node);
+            }
+            if (vm->table_lock != NULL) clrl_lock_release(vm->table_lock);
+            if (status != 0) {
+                clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for variable '%s'\n", node->name);
+                return -1;
+            }
+            return 0;
+        }
+
+        case CLRL_OP_RETURN:
+            // A missing name is reported but does not stop the other names
+            if (vm_operand(vm, program, insn->a, 0, &a) == 0) {
+                print_value(program->slot_names[CLRL_OPERAND_INDEX(insn->a)], a.type, a.value);
+            }
+            return 0;
+
+        case CLRL_OP_SET_PRECISION:
+            if (vm->precision != NULL) {
+                *vm->precision = insn->imm;
+            } else {
+                set_division_precision(insn->imm);
+            }
+            return 0;
+
+        default:
+            clrl_error(CLRL_ERROR_RUNTIME, "Error: Invalid instruction %u\n", (unsigned)insn->op);
+            return -1;
+    }
+}
+
+/**
+ * @brief Statement body for clrl_schedule_run
+ *
+ * Each run gets its own registers; variable bindings are shared, and the
+ * schedule orders every pair of statements that touch the same slot.
+ */
+static int vm_run_statement(void* ctx, size_t index, ClrlValue* registers, size_t precision) {
+    VmRun* run = (VmRun*)ctx;
+    const ClrlProgram* program = run->program;
+    const ClrlStatement* statement = &program->statements[index];
+    ClrlVm view = { registers, program->register_count, run->bindings, program->slot_count, 0,
+                    run->precision, &run->table_lock };
+    int profiled = statement->profile != 0 && clrl_profiling();
+    ClrlProfileMark mark;
+    if (profiled) clrl_profile_begin(&mark);
+    int status = 0;
+    for (size_t i = 0; i < statement->count; i++) {
+        if (vm_step(&view, program, run->table, &program->code[statement->first + i], precision) != 0) {
+            status = -1;
+            break;
+        }
+    }
+    if (profiled) clrl_profile_end(statement->profile, &mark);
+    return status;
+}
+
+// ===================== Formulas =====================
+
+static int refresh_variable(VarTable* table, VarNode* node, size_t* precision);
+
+/**
+ * @brief Visit the variable operands an instruction reads
+ *
+ * @return int Number of slots written to reads (0..3)
+ */
+static size_t insn_reads(const ClrlInsn* insn, uint32_t reads[3]) {
+    size_t count = 0;
+    switch (insn->op) {
+        case CLRL_OP_SET_PRECISION:
+            return 0;
+        case CLRL_OP_POWMOD:
+            if (CLRL_OPERAND_KIND(insn->imm) == CLRL_OPERAND_VAR) reads[count++] = CLRL_OPERAND_INDEX(insn->imm);
+            // fallthrough
+        case CLRL_OP_ADD:
+        case CLRL_OP_SUB:
+        case CLRL_OP_MUL:
+        case CLRL_OP_DIV:
+        case CLRL_OP_IDIV:
+        case CLRL_OP_MOD:
+        case CLRL_OP_POW:
+        case CLRL_OP_ROOT:
+            if (CLRL_OPERAND_KIND(insn->b) == CLRL_OPERAND_VAR) reads[count++] = CLRL_OPERAND_INDEX(insn->b);
+            // fallthrough
+        default:
+            if (CLRL_OPERAND_KIND(insn->a) == CLRL_OPERAND_VAR) reads[count++] = CLRL_OPERAND_INDEX(insn->a);
+            return count;
+    }
+}
+
+/**
+ * @brief Recompute the stale variables a program reads before writing them
+ */
+static int refresh_inputs(const ClrlVm* vm, const ClrlProgram* program, VarTable* table) {
+    unsigned char* written = (unsigned char*)calloc(program->slot_count + 1, 1);
+    if (written == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for the interpreter\n");
+        return -1;
+    }
+    int status = 0;
+    for (size_t i = 0; i < program->code_count && status == 0; i++) {
+        const ClrlInsn* insn = &program->code[i];
+        uint32_t reads[3];
+        size_t count = insn_reads(insn, reads);
+        for (size_t r = 0; r < count && status == 0; r++) {
+            VarNode* node = vm->bindings[reads[r]];
+            if (!written[reads[r]] && node != NULL && node->stale) status = refresh_variable(table, node, vm->precision);
+        }
+        if (insn->op == CLRL_OP_STORE) written[insn->dst] = 1;
+    }
+    free(written);
+    return status;
+}
+
+/**
+ * @brief Recompute one variable whose inputs are all up to date
+ */
+static int recompute_variable(VarTable* table, VarNode* node, size_t* precision) {
+    ClrlProgram program;
+    clrl_program_init(&program);
+    int status = clrl_compile(&program, node->formula, node->formula_len, NULL);
+    if (status == 0) {
+        ClrlVm vm;
+        clrl_vm_init(&vm);
+        vm.recomputing = 1;
+        vm.precision = precision;
+        status = clrl_vm_run(&vm, &program, table);
+        clrl_vm_free(&vm);
+    }
+    clrl_program_free(&program);
+    if (status != 0 || node->stale) {
+        clrl_output_flush();
+        clrl_error(CLRL_ERROR_RUNTIME, "Error: Variable '%s' could not be recomputed from '%s'\n", node->name, node->formula);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Frame of the refresh walk: a node and the next input to look at
+ */
+typedef struct {
+    VarNode* node;
+    size_t next;
+} RefreshFrame;
+
+/**
+ * @brief Bring a stale variable up to date (its stale inputs first)
+ *
+ * Depth-first over the inputs with an explicit stack, so chains of any
+ * length do not grow the C stack. Formulas never form cycles, so the
+ * stack holds one path and a node is recomputed once its inputs are.
+ */
+static int refresh_variable(VarTable* table, VarNode* node, size_t* precision) {
+    if (!node->stale) return 0;
+    RefreshFrame* frames = (RefreshFrame*)malloc(16 * sizeof(RefreshFrame));
+    size_t capacity = 16;
+    size_t depth = 0;
+    if (frames == NULL) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for the interpreter\n");
+        return -1;
+    }
+    frames[depth].node = node;
+    frames[depth++].next = 0;
+
+    int status = 0;
+    while (status == 0 && depth > 0) {
+        RefreshFrame* top = &frames[depth - 1];
+        if (top->next < top->node->input_count) {
+            VarNode* input = top->node->inputs[top->next++];
+            if (!input->stale) continue;
+            if (depth == capacity) {
+                RefreshFrame* grown = (RefreshFrame*)realloc(frames, 2 * capacity * sizeof(RefreshFrame));
+                if (grown == NULL) {
+                    clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for the interpreter\n");
+                    status = -1;
+                    break;
+                }
+                frames = grown;
+                capacity *= 2;
+            }
+            frames[depth].node = input;
+            frames[depth++].next = 0;
+        } else {
+            // Reached through another path since it was pushed: already done
+            if (top->node->stale) status = recompute_variable(table, top->node, precision);
+            depth--;
+        }
+    }
+    free(frames);
+    return status;
+}
+
+int clrl_vm_refresh(VarTable* table, VarNode* node) {
+    return refresh_variable(table, node, NULL);
+}
+
+int clrl_vm_record_formula(const ClrlProgram* program, VarTable* table, const char* source, size_t len) {
+    if (program->statement_count != 1) return 0;
+    const ClrlStatement* statement = &program->statements[0];
+    if (statement->count == 0) return 0;
+    const ClrlInsn* store = &program->code[statement->first + statement->count - 1];
+    if (store->op != CLRL_OP_STORE) return 0;
+
+    const char* name = program->slot_names[store->dst];
+    VarNode* node = var_table_find(table, name, strlen(name));
+    if (node == NULL) return 0;
+
+    // Distinct variables read by the statement (a formula reads only a few)
+    VarNode** inputs = (VarNode**)malloc((2 * statement->count + 1) * sizeof(VarNode*));
+    if (inputs == NULL) return -1;
+    size_t input_count = 0;
+    for (size_t i = 0; i < statement->count; i++) {
+        uint32_t reads[3];
+        size_t count = insn_reads(&program->code[statement->first + i], reads);
+        for (size_t r = 0; r < count; r++) {
+            const char* input_name = program->slot_names[reads[r]];
+            VarNode* input = var_table_find(table, input_name, strlen(input_name));
+            size_t k = 0;
+            while (k < input_count && inputs[k] != input) k++;
+            if (input != NULL && k == input_count) inputs[input_count++] = input;
+        }
+    }
+
+    // Definitions from constants alone never go stale
+    int status = 0;
+    if (input_count > 0) status = var_table_set_formula(table, node, source, len, inputs, input_count);
+    free(inputs);
+    return status;
+}
+
+// ===================== Execution =====================
+
+int clrl_vm_bind(ClrlVm* vm, const ClrlProgram* program, VarTable* table) {
+    if (vm_prepare(vm, program) != 0) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed for the interpreter\n");
+        return -1;
+    }
+    // Later definitions update the binding directly
+    for (size_t s = 0; s < program->slot_count; s++) {
+        const char* name = program->slot_names[s];
+        vm->bindings[s] = var_table_find(table, name, strlen(name));
+    }
+    return 0;
+}
+
+int clrl_vm_run(ClrlVm* vm, const ClrlProgram* program, VarTable* table) {
+    if (clrl_vm_bind(vm, program, table) != 0) return -1;
+    if (!vm->recomputing && refresh_inputs(vm, program, table) != 0) return -1;
+
+    // Independent statements of longer programs run concurrently
+    if (clrl_parallel_worthwhile(program->statement_count, 2)) {
+        ClrlSchedule schedule;
+        if (clrl_schedule_build(&schedule, program) == 0) {
+            if (vm->precision != NULL) {
+                // Statements before the first system:precision divide with the VM's precision
+                uint32_t* precision = (uint32_t*)schedule.precision;
+                uint32_t initial = (*vm->precision < CLRL_PRECISION_GLOBAL) ? (uint32_t)*vm->precision
+                                                                            : CLRL_PRECISION_GLOBAL - 1;
+                for (size_t s = 0; s < schedule.statement_count; s++) {
+                    if (precision[s] == CLRL_PRECISION_GLOBAL) precision[s] = initial;
+                }
+            }
+            VmRun run = { program, table, vm->bindings, vm->precision, { 0 } };
+            int status = clrl_schedule_run(&schedule, vm_run_statement, &run);
+            clrl_schedule_free(&schedule);
+            return status;
+        }
+    }
+    return clrl_vm_run_bound(vm, program, table);
+}
+
+int clrl_vm_run_bound(ClrlVm* vm, const ClrlProgram* program, VarTable* table) {
+    // Temporaries of a statement come from the scratch arena and die with it
+    ClrlArena* scratch = clrl_scratch_arena();
+    int failed = 0;
+    for (size_t i = 0; i < program->statement_count; i++) {
+        const ClrlStatement* statement = &program->statements[i];
+        const ClrlInsn* insn = program->code + statement->first;
+        const ClrlInsn* end = insn + statement->count;
+        ClrlArenaMark mark = clrl_arena_mark(scratch);
+        size_t precision = (vm->precision != NULL) ? *vm->precision : get_division_precision();
+        int profiled = statement->profile != 0 && clrl_profiling();
+        ClrlProfileMark started;
+        if (profiled) clrl_profile_begin(&started);
+        for (; insn < end; insn++) {
+            if (vm_step(vm, program, table, insn, precision) != 0) {
+                failed = 1;
+                break;
+            }
+        }
+        if (profiled) clrl_profile_end(statement->profile, &started);
+        clrl_arena_rewind(scratch, mark);
+        // A return statement's results go out in one write, before any later error
+        clrl_output_flush();
+    }
+    return failed ? -1 : 0;
+}
+
+int clrl_execute_source(const char* source, size_t len, const char* origin, unsigned flags) {
+    ClrlProgram program;
+    clrl_program_init(&program);
+    int status = clrl_compile(&program, source, len, origin);
+    if (status == 0) {
+        clrl_optimize(&program, flags);   // On failure the program runs as compiled
+        ClrlVm vm;
+        clrl_vm_init(&vm);
+        status = clrl_vm_run(&vm, &program, &var_table);
+        clrl_vm_free(&vm);
+    }
+    clrl_program_free(&program);
+    return status;
+}
+
+// ===================== Compiled code support =====================
+
+int clrl_value_parse(ClrlValue* value, VarType type, const char* text) {
+    value->type = type;
+    if (type == VAR_PRECISE) {
+        precise_init(&value->value.precise_val);
+        return precise_from_string(&value->value.precise_val, text, strlen(text));
+    }
+    larnum_init(&value->value.larnum_val);
+    return larnum_from_string(&value->value.larnum_val, text, strlen(text));
+}
+
+void clrl_value_free(ClrlValue* value) {
+    larnum_free(&value->value.larnum_val);
+    value->type = VAR_LARNUM;
+}
+
+int clrl_value_check(const char* name, int defined, const ClrlValue* value, int larnum_only) {
+    return check_variable(name, defined, value->type, larnum_only);
+}
+
+int clrl_value_arith(uint8_t op, ClrlValue* dst, const ClrlValue* a, const ClrlValue* b, size_t precision) {
+    Operand x = { a->type, &a->value };
+    Operand y = { b->type, &b->value };
+    if (op == CLRL_OP_NEG) return vm_neg(dst, &x);
+    return vm_arith(op, dst, &x, &y, precision);
+}
+
+int clrl_value_powmod(ClrlValue* dst, const ClrlValue* a, const ClrlValue* e, const ClrlValue* m) {
+    Operand x = { a->type, &a->value };
+    Operand y = { e->type, &e->value };
+    Operand z = { m->type, &m->value };
+    return vm_powmod(dst, &x, &y, &z);
+}
+
+int clrl_value_assign(ClrlValue* dst, const ClrlValue* src, int to_precise) {
+    if (larnum_copy(&dst->value.larnum_val, &src->value.larnum_val) != 0) {
+        clrl_error(CLRL_ERROR_MEMORY, "Error: Memory allocation failed while storing a value\n");
+        return -1;
+    }
+    if (src->type == VAR_PRECISE) {
+        dst->value.precise_val.exponent = src->value.precise_val.exponent;
+        dst->type = VAR_PRECISE;
+    } else if (to_precise) {
+        dst->value.precise_val.exponent = 0;
+        dst->type = VAR_PRECISE;
+    } else {
+        dst->type = VAR_LARNUM;
+    }
+    return 0;
+}
+
+void clrl_value_print(const char* name, const ClrlValue* value) {
+    print_value(name, value->type, &value->value);
+}